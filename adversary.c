@@ -0,0 +1,297 @@
+/**
+ * @file adversary.c
+ * @version 2.0
+ *
+ * @brief Searches for the fleet placement that a built in shooter needs the most shots against.
+ *
+ * @section DESCRIPTION
+ * The layouts of an iteration are numbered, and the workers take chunks of
+ * ADVERSARY_CHUNK_GAMES consecutive layouts from a shared counter. Every worker keeps a single
+ * game block, drawing its fleet from the table of the iteration, and a single shooter, and
+ * writes the slots of every layout and the shots it took to the slot of the layout, so the
+ * update between two iterations reads them in the order of the layouts.
+ */
+// ------------------------------ includes ------------------------------
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include "adversary.h"
+#include "monotonic.h"
+#include "simulator.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def  TRUE 1
+ * @brief the value returned on success.
+ */
+#define TRUE 1
+
+/**
+ * @def MEMORY_ERROR 2
+ * @brief the integer returned if one of the pointers is NULL .
+ */
+#define MEMORY_ERROR 2
+
+// ------------------------------ structs ----------------------------
+
+/**
+ * a structure holding a generation of layouts, shared by the workers. includes the following
+ * attributes:
+ * config - the search description.
+ * weights - the table the layouts are drawn from.
+ * iteration - the index of the iteration.
+ * slots - the slot of every ship of every layout, fleet->shipsNum per layout.
+ * shots - the number of shots the shooter needed against every layout.
+ * next - the next chunk of layouts to take.
+ */
+typedef struct Generation
+{
+	const AdversaryConfig *config;
+	const FleetWeights *weights;
+	int iteration;
+	uint16_t *slots;
+	int *shots;
+	atomic_long next;
+} Generation;
+
+/**
+ * a structure describing a search worker thread. includes the following attributes:
+ * generation - the generation of layouts.
+ * status - 0, or the error that stopped the worker.
+ * thread - the thread id.
+ * started - 1 if the thread was created.
+ */
+typedef struct AdversaryWorker
+{
+	Generation *generation;
+	int status;
+	pthread_t thread;
+	int started;
+} AdversaryWorker;
+
+/**
+ * a structure holding the rank of a layout. includes the following attributes:
+ * shots - the number of shots the shooter needed against the layout.
+ * index - the index of the layout.
+ */
+typedef struct LayoutRank
+{
+	int shots;
+	int index;
+} LayoutRank;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Plays the layouts of a single chunk.
+ * @param generation The generation.
+ * @param chunk The chunk index.
+ * @param game The worker's game, drawing its fleet from the table of the generation.
+ * @param shooter The worker's shooter.
+ * @return 0 on success, MEMORY_ERROR if a fleet could not be placed.
+ */
+static int playChunk(Generation *generation, long chunk, Game *game, Shooter *shooter)
+{
+	const AdversaryConfig *config = generation->config;
+	long layout, end = (chunk + 1) * ADVERSARY_CHUNK_GAMES;
+	int i, shipsNum = config->fleet->shipsNum;
+	uint16_t *slots;
+	Rng rng;
+	rngSeed(&rng, config->seed, ((uint64_t) generation->iteration << 32) | (uint64_t) chunk);
+	end = end < config->samples ? end : config->samples;
+	for (layout = chunk * ADVERSARY_CHUNK_GAMES; layout < end; layout++)
+	{
+		if (resetGame(game, &rng) != TRUE)
+		{
+			return MEMORY_ERROR;
+		}
+		slots = generation->slots + layout * shipsNum;
+		for (i = 0; i < shipsNum; i++)
+		{
+			slots[i] = (uint16_t) weightsSlot(config->boardSize, game->ships.angle[i],
+											  game->ships.row[i], game->ships.col[i]);
+		}
+		shooterReset(shooter, config->strategy, config->boardSize, config->fleet, &rng);
+		generation->shots[layout] = playGame(game, shooter, NULL);
+	}
+	return 0;
+}
+
+/**
+ * @brief The worker thread: takes chunks of layouts until none is left.
+ * @param arg The worker description.
+ * @return NULL.
+ */
+static void *adversaryWorkerMain(void *arg)
+{
+	AdversaryWorker *worker = (AdversaryWorker *) arg;
+	Generation *generation = worker->generation;
+	const AdversaryConfig *config = generation->config;
+	long chunk, chunks = (config->samples + ADVERSARY_CHUNK_GAMES - 1) / ADVERSARY_CHUNK_GAMES;
+	Game *game = newGame(config->boardSize, config->fleet);
+	Shooter *shooter = (Shooter *) malloc(sizeof(Shooter));
+	worker->status = game == NULL || shooter == NULL ||
+					 useFleetWeights(&game->board, config->fleet, generation->weights) != TRUE ?
+					 MEMORY_ERROR : 0;
+	while (worker->status == 0 &&
+		   (chunk = atomic_fetch_add_explicit(&generation->next, 1, memory_order_relaxed)) < chunks)
+	{
+		worker->status = playChunk(generation, chunk, game, shooter);
+	}
+	freeGame(game);
+	free(shooter);
+	return NULL;
+}
+
+/**
+ * @brief Orders the layouts from the most shots to the fewest, the first layout first on ties.
+ * @param a The first rank.
+ * @param b The second rank.
+ * @return The order, as qsort expects.
+ */
+static int moreShotsFirst(const void *a, const void *b)
+{
+	const LayoutRank *first = (const LayoutRank *) a, *second = (const LayoutRank *) b;
+	if (first->shots != second->shots)
+	{
+		return second->shots - first->shots;
+	}
+	return first->index - second->index;
+}
+
+/**
+ * @brief Plays a generation of layouts drawn from the table on all the worker threads.
+ * @param generation The generation, with everything but next set.
+ * @param count The number of worker threads.
+ * @param workers The workers.
+ * @return 0 on success, MEMORY_ERROR if an allocation failed or a fleet could not be placed.
+ */
+static int playGeneration(Generation *generation, int count, AdversaryWorker *workers)
+{
+	int i, status = 0;
+	atomic_init(&generation->next, 0);
+	for (i = 0; i < count; i++)
+	{
+		workers[i].generation = generation;
+		workers[i].status = 0;
+		workers[i].started = 0;
+	}
+	for (i = 1; i < count; i++)
+	{
+		workers[i].started = pthread_create(&workers[i].thread, NULL, adversaryWorkerMain,
+											&workers[i]) == 0;
+	}
+	adversaryWorkerMain(&workers[0]);
+	for (i = 0; i < count; i++)
+	{
+		if (workers[i].started)
+		{
+			pthread_join(workers[i].thread, NULL);
+		}
+		status = workers[i].status != 0 ? workers[i].status : status;
+	}
+	return status;
+}
+
+/**
+ * @brief Ranks the layouts of a generation, records the results of the iteration and moves the
+ * weights of every ship towards the slots it took in the elite layouts.
+ * @param generation The played generation.
+ * @param weights The table of the generation, filled with the table of the next one.
+ * @param ranks Room for the rank of every layout.
+ * @param step Filled with the results of the iteration.
+ */
+static void updateWeights(const Generation *generation, FleetWeights *weights, LayoutRank *ranks,
+						  AdversaryStep *step)
+{
+	const AdversaryConfig *config = generation->config;
+	int i, j, slot, shipsNum = config->fleet->shipsNum;
+	int eliteNum = (int) (config->elite * config->samples + 0.5);
+	int slotsNum = 2 * config->boardSize * config->boardSize;
+	double hits[WEIGHTS_MAX_SLOTS], total, sum = 0;
+	eliteNum = eliteNum < 1 ? 1 : (eliteNum > config->samples ? config->samples : eliteNum);
+	for (i = 0; i < config->samples; i++)
+	{
+		ranks[i].shots = generation->shots[i];
+		ranks[i].index = i;
+		sum += generation->shots[i];
+	}
+	qsort(ranks, (size_t) config->samples, sizeof(LayoutRank), moreShotsFirst);
+	step->meanShots = sum / config->samples;
+	step->eliteShots = ranks[eliteNum - 1].shots;
+	step->maxShots = ranks[0].shots;
+	for (i = 0; i < shipsNum; i++)
+	{
+		memset(hits, 0, (size_t) slotsNum * sizeof(double));
+		for (j = 0; j < eliteNum; j++)
+		{
+			hits[generation->slots[(long) ranks[j].index * shipsNum + i]]++;
+		}
+		total = 0;
+		for (slot = 0; slot < slotsNum; slot++)
+		{
+			total += weights->weights[i][slot];
+		}
+		for (slot = 0; slot < slotsNum; slot++)
+		{
+			weights->weights[i][slot] = (float) (
+					(1 - config->floor) * (config->smoothing * hits[slot] / eliteNum +
+										   (1 - config->smoothing) * weights->weights[i][slot] /
+										   total) + config->floor / slotsNum);
+		}
+	}
+	buildFleetWeights(weights);
+}
+
+/**
+ * @brief Runs a search on all the worker threads. The results depend only on the master seed
+ * and the starting table.
+ * @param config The search description.
+ * @param weights The table to start from, of the board size and fleet of the search, filled
+ * with the table of the last iteration.
+ * @param stats Filled with the search results.
+ * @return 0 on success, MEMORY_ERROR (2) if an allocation failed or a fleet could not be placed.
+ */
+int runAdversary(const AdversaryConfig *config, FleetWeights *weights, AdversaryStats *stats)
+{
+	int iteration, status = 0, count = config->threads;
+	double start = monotonicSeconds(), stepStart;
+	Generation generation;
+	AdversaryWorker *workers;
+	LayoutRank *ranks;
+	memset(stats, 0, sizeof(AdversaryStats));
+	count = count < 1 ? 1 : (count > MAX_ADVERSARY_THREADS ? MAX_ADVERSARY_THREADS : count);
+	generation.config = config;
+	generation.weights = weights;
+	generation.slots = (uint16_t *) malloc((size_t) config->samples * config->fleet->shipsNum *
+										   sizeof(uint16_t));
+	generation.shots = (int *) malloc((size_t) config->samples * sizeof(int));
+	ranks = (LayoutRank *) malloc((size_t) config->samples * sizeof(LayoutRank));
+	workers = (AdversaryWorker *) calloc(count, sizeof(AdversaryWorker));
+	if (generation.slots == NULL || generation.shots == NULL || ranks == NULL || workers == NULL)
+	{
+		status = MEMORY_ERROR;
+	}
+	for (iteration = 0; status == 0 && iteration < config->iterations &&
+						iteration < MAX_ADVERSARY_ITERATIONS; iteration++)
+	{
+		stepStart = monotonicSeconds();
+		generation.iteration = iteration;
+		status = playGeneration(&generation, count, workers);
+		if (status == 0)
+		{
+			updateWeights(&generation, weights, ranks, &stats->steps[iteration]);
+			stats->steps[iteration].seconds = monotonicSeconds() - stepStart;
+			stats->iterations++;
+			stats->games += config->samples;
+		}
+	}
+	stats->seconds = monotonicSeconds() - start;
+	free(generation.slots);
+	free(generation.shots);
+	free(ranks);
+	free(workers);
+	return status;
+}
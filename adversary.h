@@ -0,0 +1,115 @@
+/**
+ * @file adversary.h
+ * @version 2.0
+ *
+ * @brief Searches for the fleet placement that a built in shooter needs the most shots against.
+ *
+ * @section DESCRIPTION
+ * The search is the cross entropy method over a weighted placement table (see fleet_weights.h):
+ * every iteration draws a generation of layouts from the table, plays a game of the shooter
+ * against each of them on all the worker threads, and moves the weights of every ship towards
+ * the slots it took in the elite layouts, the ones the shooter needed the most shots against.
+ * The weights are mixed with the uniform table by a floor, so no slot is ever ruled out and a
+ * shooter that adapts to the table still faces every layout.
+ */
+#ifndef ADVERSARY_H_
+#define ADVERSARY_H_
+
+// ------------------------------ includes ------------------------------
+#include "fleet_weights.h"
+#include "strategies.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def ADVERSARY_CHUNK_GAMES 64
+ * @brief The number of layouts a worker takes at once. Every chunk has its own random stream,
+ * so the results do not depend on the thread playing it.
+ */
+#define ADVERSARY_CHUNK_GAMES 64
+
+/**
+ * @def MAX_ADVERSARY_THREADS 256
+ * @brief The maximal number of worker threads of a search.
+ */
+#define MAX_ADVERSARY_THREADS 256
+
+/**
+ * @def MAX_ADVERSARY_ITERATIONS 1000
+ * @brief The maximal number of iterations of a search.
+ */
+#define MAX_ADVERSARY_ITERATIONS 1000
+
+// ------------------------------ structs ----------------------------
+
+/**
+ * a structure describing a search. includes the following attributes:
+ * boardSize - the board size.
+ * fleet - the fleet, of at most WEIGHTS_MAX_SHIPS ships.
+ * strategy - the strategy of the shooter.
+ * iterations - the number of iterations.
+ * samples - the number of layouts drawn in every iteration.
+ * elite - the share of the layouts the weights move towards, between 0 and 1.
+ * smoothing - the share of the new weights taken from the elite layouts, between 0 and 1.
+ * floor - the share of the uniform table mixed into the weights, between 0 and 1.
+ * seed - the master seed of the random numbers.
+ * threads - the number of worker threads.
+ */
+typedef struct AdversaryConfig
+{
+	int boardSize;
+	const Fleet *fleet;
+	const ShooterStrategy *strategy;
+	int iterations;
+	int samples;
+	double elite;
+	double smoothing;
+	double floor;
+	uint64_t seed;
+	int threads;
+} AdversaryConfig;
+
+/**
+ * a structure holding the results of a single iteration. includes the following attributes:
+ * meanShots - the mean number of shots the shooter needed against the drawn layouts.
+ * eliteShots - the smallest number of shots of an elite layout.
+ * maxShots - the largest number of shots of a layout.
+ * seconds - the wall clock time the iteration took.
+ */
+typedef struct AdversaryStep
+{
+	double meanShots;
+	int eliteShots;
+	int maxShots;
+	double seconds;
+} AdversaryStep;
+
+/**
+ * a structure holding the results of a search. includes the following attributes:
+ * iterations - the number of iterations run.
+ * games - the total number of games played.
+ * seconds - the wall clock time the search took.
+ * steps - the results of every iteration.
+ */
+typedef struct AdversaryStats
+{
+	int iterations;
+	long games;
+	double seconds;
+	AdversaryStep steps[MAX_ADVERSARY_ITERATIONS];
+} AdversaryStats;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Runs a search on all the worker threads. The results depend only on the master seed
+ * and the starting table.
+ * @param config The search description.
+ * @param weights The table to start from, of the board size and fleet of the search, filled
+ * with the table of the last iteration.
+ * @param stats Filled with the search results.
+ * @return 0 on success, MEMORY_ERROR (2) if an allocation failed or a fleet could not be placed.
+ */
+int runAdversary(const AdversaryConfig *config, FleetWeights *weights, AdversaryStats *stats);
+
+#endif /* ADVERSARY_H_ */
@@ -7,459 +7,796 @@
  * @brief System to keep track of the cooking times.
  *
  * @section DESCRIPTION
- * The system runs a battleships game with a minimal gui.
+ * The game engine: placing the fleet and applying the player moves to the board.
  * Input  : The board game size, and the players moves.
  * Process: managing the game, starting with locating randomly the ships and processing every move
  * received from the player.
- * Output : Each turn the program prints the board an a matching message.
+ * Output : A result code for every move, nothing is printed (see battleships_console.c).
  */
 // ------------------------------ includes ------------------------------
-#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "battleships.h"
+#include "instrument.h"
 
 // -------------------------- const definitions -------------------------
 
 /**
- * @def SUNK_MESSAGE "Hit and sunk.\n"
- * @brief the message printed to the screen when the player hit a ship and it made her sunk.
+ * @def  TRUE 1
+ * @brief the angle of the ship is vertical
  */
-#define SUNK_MESSAGE "Hit and sunk.\n"
+#define TRUE 1
 
 /**
- * @def HIT_MESSAGE "Hit!\n"
- * @brief the message printed to the screen when the player hit a ship.
+ * @def FALSE -1
+ * @brief the angle of the ship is horizontal
  */
-#define HIT_MESSAGE "Hit!\n"
+#define FALSE (-1)
 
 /**
- * @def ALREADY_HIT_MESSAGE "Already been Hit.\n"
- * @brief the message printed to the screen when the player made a move and he already made
- * this move.
+ * @def MAX_FLEET_ATTEMPTS 100
+ * @brief The number of times the fleet is placed from scratch before giving up, when the ships
+ * placed first leave no room for the others.
  */
-#define ALREADY_HIT_MESSAGE "Already been Hit.\n"
+#define MAX_FLEET_ATTEMPTS 100
 
 /**
- * @def INVALID_MOVE_MESSAGE "invalid Move, try again\n"
- * @brief the message printed to the screen when the player made an invalid move.
- * this move.
+ * @def WEIGHTED_DRAWS 64
+ * @brief The number of slots drawn from the weighted placement table for a ship before it falls
+ * back to a uniformly random free slot.
  */
-#define INVALID_MOVE_MESSAGE "invalid Move, try again\n"
+#define WEIGHTED_DRAWS 64
 
+// ------------------------------ functions ----------------------------
 /**
- * @def INVALID_MOVE_MESSAGE "invalid Move, try again\n"
- * @brief the message printed to the screen when the player made a move and did not hit a ship.
- * this move.
+ * @brief Receives a size and creates a board with no ships and no shots.
+ * @param size The board size
+ * @return The new board initialized, NULL if the allocation failed.
  */
-#define MISS_MESSAGE "Miss\n"
+Board *initialBoard(int size)
+{
+	Board *board = (Board *) malloc(sizeof(Board));
+	if (board == NULL)
+	{
+		return NULL;
+	}
+	board->size = size;
+	board->kernels = boardKernels(size);
+	board->placement = placementTable(size);
+	board->weights = NULL;
+	bbClear(&board->ships);
+	bbClear(&board->shots);
+	bbClear(&board->hits);
+	return board;
+}
+
 
 /**
- * @def SHIPS_NUM 5
- * @brief the number of ships participating in the game.
+ * @brief The function receives a ship located in the board bounds and returns the bits it
+ * takes in a single row of the board.
+ * @param ship The ship.
+ * @return The ship bits in each of the rows it spans.
  */
-#define SHIPS_NUM 5
+uint32_t shipRowBits(const Ship *ship)
+{
+	if (ship->angle == VERTICAL)
+	{
+		return 1U << ship->col;
+	}
+	return (uint32_t) (((1ULL << ship->length) - 1) << ship->col);
+}
 
 /**
- * @def VERTICAL 0
- * @brief the angle of the ship is vertical
+ * @brief The function receives a ship located in the board bounds and returns the number of
+ * rows it spans.
+ * @param ship The ship.
+ * @return The number of rows the ship spans.
  */
-#define VERTICAL 0
+int shipRowSpan(const Ship *ship)
+{
+	return ship->angle == VERTICAL ? ship->length : 1;
+}
 
 /**
- * @def HORIZONTAL 1
- * @brief the angle of the ship is horizontal
+ * @brief The function receives a new ship needed to be located in the board and the board
+ * holding all the other ships taken Coordinates. The function mark in the board ships mask
+ * the ship location as taken, and the ship index on every cell of the ship ids.
+ * @param newShip A pointer to the new ship needed to be placed.
+ * @param id The index of the ship in its fleet.
+ * @param board The game board (saving all the ships locations).
  */
-#define HORIZONTAL 1
+void updateManagerBoard(const Ship *newShip, int id, Board *board)
+{
+	int j, span = shipRowSpan(newShip);
+	uint32_t bits = shipRowBits(newShip);
+	for (j = 0; j < span; j++)
+	{
+		bbOrRow(&board->ships, newShip->row + j, bits);
+	}
+	for (j = 0; j < newShip->length; j++)
+	{
+		if (newShip->angle == VERTICAL)
+		{
+			board->shipIds[newShip->row + j][newShip->col] = (uint16_t) id;
+		}
+		else
+		{
+			board->shipIds[newShip->row][newShip->col + j] = (uint16_t) id;
+		}
+	}
+}
 
 /**
- * @def  TRUE 1
- * @brief the angle of the ship is vertical
+ * @brief The function lists every free slot for a ship of the given length, as a mask of the
+ * legal start cells in each row, for both angles. The in range starts come from the placement
+ * table of the board, so an empty board needs no scan at all, and on a board with ships every
+ * start is only tested against the cells the ship would take.
+ * @param board The game board (saving all the ships locations).
+ * @param size The board size, a constant in every kernel.
+ * @param length The length of the ship.
+ * @param vertical Filled with the legal start cells of a vertical ship, one mask per row.
+ * @param horizontal Filled with the legal start cells of a horizontal ship, one mask per row.
+ * @return The total number of legal slots.
  */
-#define TRUE 1
+BITBOARD_KERNEL int legalSlots(const Board *board, int size, int length, uint32_t vertical[],
+							   uint32_t horizontal[])
+{
+	const Bitboard *inRange = board->placement->starts[length];
+	uint32_t freeRows[BITBOARD_MAX_SIZE];
+	int i, k, slots = 0;
+	if (bbEmptyRows(&board->ships, size))
+	{
+		for (i = 0; i < size; i++)
+		{
+			vertical[i] = bbRow(&inRange[PLACEMENT_VERTICAL], i);
+			horizontal[i] = bbRow(&inRange[PLACEMENT_HORIZONTAL], i);
+		}
+		return board->placement->slots[length][PLACEMENT_VERTICAL] +
+			   board->placement->slots[length][PLACEMENT_HORIZONTAL];
+	}
+	for (i = 0; i < size; i++)
+	{
+		freeRows[i] = ~bbRow(&board->ships, i);
+	}
+	for (i = 0; i < size; i++)
+	{
+		horizontal[i] = bbRow(&inRange[PLACEMENT_HORIZONTAL], i) & freeRows[i];
+		vertical[i] = bbRow(&inRange[PLACEMENT_VERTICAL], i) & freeRows[i];
+		for (k = 1; k < length; k++)
+		{
+			horizontal[i] &= freeRows[i] >> k;
+		}
+		for (k = 1; k < length && vertical[i] != 0; k++)
+		{
+			vertical[i] &= freeRows[i + k];
+		}
+		slots += __builtin_popcount(horizontal[i]) + __builtin_popcount(vertical[i]);
+	}
+	return slots;
+}
 
 /**
- * @def FALSE -1
- * @brief the angle of the ship is horizontal
+ * @brief The function finds the slot with the given rank among the masks built by legalSlots
+ * (vertical slots first, row by row, then the horizontal ones) and sets the ship location to it.
+ * @param newShip The ship to locate.
+ * @param size The board size, a constant in every kernel.
+ * @param masks The vertical and the horizontal start masks.
+ * @param rank The rank of the slot, lower then the number of slots.
  */
-#define FALSE (-1)
+BITBOARD_KERNEL void selectSlot(Ship *newShip, int size, uint32_t masks[][BITBOARD_MAX_SIZE],
+								int rank)
+{
+	int angle, i, count;
+	uint32_t bits;
+	for (angle = VERTICAL; angle <= HORIZONTAL; angle++)
+	{
+		for (i = 0; i < size; i++)
+		{
+			bits = masks[angle][i];
+			count = __builtin_popcount(bits);
+			if (rank < count)
+			{
+				while (rank-- > 0)
+				{
+					bits &= bits - 1;
+				}
+				newShip->angle = angle;
+				newShip->row = i;
+				newShip->col = __builtin_ctz(bits);
+				return;
+			}
+			rank -= count;
+		}
+	}
+}
 
 /**
- * @def EMPTY_CELL '_'
- * @brief An empty cell in the board.
+ * @brief The function lists all the free slots for a ship, picks one of them uniformly with a
+ * single random draw and mark it on the board ships mask.
+ * @param newShip A pointer to the new ship needed to be placed.
+ * @param id The index of the ship in its fleet, marked on the board ship ids.
+ * @param board The game board (saving all the ships locations).
+ * @param rng The random numbers generator.
+ * @param size The board size, a constant in every kernel.
+ * @return TRUE if the ship was placed, FALSE if no free slot fits the ship.
  */
-#define EMPTY_CELL '_'
+BITBOARD_KERNEL int placeShipSized(Ship *newShip, int id, Board *board, Rng *rng, int size)
+{
+	uint32_t masks[2][BITBOARD_MAX_SIZE];
+	int slots = legalSlots(board, size, newShip->length, masks[VERTICAL], masks[HORIZONTAL]);
+	if (slots == 0)
+	{
+		return FALSE;
+	}
+	selectSlot(newShip, size, masks, (int) rngBelow(rng, (uint32_t) slots));
+	updateManagerBoard(newShip, id, board);
+	return TRUE;
+}
 
 /**
- * @def MISS_CELL 'o'
- * @brief A mark for a taken cell in the manager board.
+ * The function verifies the move received by the player is valid (is in the board bounds).
+ * @param row The row received from the user.
+ * @param col The column received from the user.
+ * @param boardSize The boardSize (as the height and width are equal)
+ * @return
  */
-#define MISS_CELL 'o'
+int isValidMove(int row, int col, int boardSize)
+{
+	if (row < 0 || row > boardSize-1)
+	{
+		return FALSE;
+	}
+	if (col < 0 || col > boardSize-1)
+	{
+		return FALSE;
+	}
+	return TRUE;
+}
 
 /**
- * @def HIT_CELL 'x'
- * @brief A mark for a taken cell in the manager board.
+ * The function marks a shot on the board, without touching the ships lives.
+ * @param row The row of the shot.
+ * @param col The column of the shot.
+ * @param board The game board.
+ * @param size The board size, a constant in every kernel.
+ * @return SHOT_MISS, SHOT_HIT if the shot hit the ship board->shipIds[row][col], SHOT_ALREADY if
+ * the cell was already shot and SHOT_INVALID if the cell is out of the board bounds.
  */
-#define HIT_CELL 'x'
+BITBOARD_KERNEL int markShotSized(int row, int col, Board *board, int size)
+{
+	if (isValidMove(row, col, size) == FALSE)
+	{
+		return SHOT_INVALID;
+	}
+	if (bbTest(&board->shots, row, col))
+	{
+		return SHOT_ALREADY;
+	}
+	bbSet(&board->shots, row, col);
+	if (!bbTest(&board->ships, row, col))
+	{
+		return SHOT_MISS;
+	}
+	bbSet(&board->hits, row, col);
+	return SHOT_HIT;
+}
 
 /**
- * @def MIN_NUM_ASCII_VALUE 48
- * @brief the ASCII value of the min cell in the ships array cell, converting the value from char
- * to int and vice versa. Helping to match the index of the ship located in the manager board to
- * the ship in the ships array.
+ * @def DEFINE_BOARD_KERNELS(size)
+ * @brief Defines the placement and shot kernels of a single board size.
  */
-#define MIN_NUM_ASCII_VALUE 48
+#define DEFINE_BOARD_KERNELS(size) \
+	static int placeShip##size(Ship *newShip, int id, Board *board, Rng *rng) \
+	{ \
+		return placeShipSized(newShip, id, board, rng, size); \
+	} \
+	static int markShot##size(int row, int col, Board *board) \
+	{ \
+		return markShotSized(row, col, board, size); \
+	}
+
+BITBOARD_KERNEL_SIZES(DEFINE_BOARD_KERNELS)
 
 /**
- * @def START_LETTER 97
- * @brief The first letter to be printed in the boar's row indexes.
+ * @brief The placement kernel of the board sizes with no kernels of their own.
+ * @param newShip A pointer to the new ship needed to be placed.
+ * @param id The index of the ship in its fleet, marked on the board ship ids.
+ * @param board The game board (saving all the ships locations).
+ * @param rng The random numbers generator.
+ * @return TRUE if the ship was placed, FALSE if no free slot fits the ship.
  */
-#define START_LETTER 97
+static int placeShipAnySize(Ship *newShip, int id, Board *board, Rng *rng)
+{
+	return placeShipSized(newShip, id, board, rng, board->size);
+}
 
 /**
- * The length of each ship participating in the game.
+ * @brief The shot kernel of the board sizes with no kernels of their own.
+ * @param row The row of the shot.
+ * @param col The column of the shot.
+ * @param board The game board.
+ * @return The shot mark, as returned by markShotSized.
  */
-enum Ships_VERITY
-		{
-		AIRCRAFT_CARRIER = 5,
-		BATTLE_CRIUSER = 4,
-		MISSILE_SHIP = 3,
-		SUBMARINE = 3,
-		BATTLE_SHIP = 2
-		};
-// ------------------------------ structs ----------------------------
-
-/**
- * a structure describing a ship in the game. includes the following attributes:
- * row - the row index of the ship on the board.
- * col - the column index of the ship on the board.
- * angle - 0 for vertical, 1 for horizontal.
- * size - the length of the ship.
- * lives - the number of cells on the board that were not hit. (the initialization of lives is
- * the size of the ship).
- */
-typedef struct Ship
+static int markShotAnySize(int row, int col, Board *board)
 {
-	int row;
-	int col;
-	int length;
-	int angle;
-	int lives;
-} Ship;
+	return markShotSized(row, col, board, board->size);
+}
 
-// ------------------------------ functions ----------------------------
 /**
- * @brief Receives a size and creates a char board initialized to empty cells.
- * @param size The board size
- * @return The new board initialized.
+ * @def BOARD_KERNELS_ENTRY(size)
+ * @brief The dispatch table entry of a single board size.
+ */
+#define BOARD_KERNELS_ENTRY(size) {size, placeShip##size, markShot##size},
+
+/**
+ * The kernels of every board size from BITBOARD_MIN_KERNEL_SIZE to BITBOARD_MAX_SIZE.
+ */
+static const BoardKernels BOARD_KERNELS[] = {BITBOARD_KERNEL_SIZES(BOARD_KERNELS_ENTRY)};
+
+/**
+ * The kernels reading the size from the board.
  */
-char **initialBoard(int size)
+static const BoardKernels ANY_SIZE_KERNELS = {0, placeShipAnySize, markShotAnySize};
+
+/**
+ * @brief Returns the board functions compiled for a board size, chosen once when a board is
+ * created so the hot loops never read the size at run time.
+ * @param size The board size.
+ * @return The kernels of the size, the kernels reading the size from the board if no kernels
+ * were compiled for it.
+ */
+const BoardKernels *boardKernels(int size)
 {
-	int i, j;
-	char **board = (char **) malloc(size * sizeof(char *));
-	for (i = 0; i < size; i++)
+	if (size < BITBOARD_MIN_KERNEL_SIZE || size > BITBOARD_MAX_SIZE)
 	{
-		board[i] = (char *) malloc(size * sizeof(char));
-		for (j = 0; j < size; j++)
-		{
-			board[i][j] = EMPTY_CELL;
-		}
+		return &ANY_SIZE_KERNELS;
 	}
-	return board;
+	return &BOARD_KERNELS[size - BITBOARD_MIN_KERNEL_SIZE];
 }
 
+/**
+ * @brief The function receives a new ship needed to be located in the board and the board
+ * holding all the other ships taken Coordinates. The function lists all the free slots for the
+ * ship, picks one of them uniformly with a single random draw and mark it on the board ships mask.
+ * @param newShip A pointer to the new ship needed to be placed.
+ * @param id The index of the ship in its fleet, marked on the board ship ids.
+ * @param board The game board (saving all the ships locations).
+ * @param rng The random numbers generator.
+ * @return TRUE if the ship was placed, FALSE if no free slot fits the ship.
+ * */
+int placeShip(Ship *newShip, int id, Board *board, Rng *rng)
+{
+	return board->kernels->placeShip(newShip, id, board, rng);
+}
 
 /**
- * @brief Receives a new ship just placed randomly on the board and return true
- *  if the entire ship coordinates can be placed in the board bounds and false otherwise.
- * @param Ship *newShip the new ship.
- * @param boardS The board Size.
- * @return TRUE if the ship location is in the board bounds FALSE otherwise
+ * @brief The function locates a ship at the position it already holds (a fleet loaded from a
+ * log, for example), if it fits the board bounds and does not touch the other ships.
+ * @param ship The ship, with its row, column, length and angle set.
+ * @param id The index of the ship in its fleet, marked on the board ship ids.
+ * @param board The game board (saving all the ships locations).
+ * @return TRUE if the ship was placed, FALSE otherwise.
  */
-int isInRange(Ship *newShip, int boardS)
+int placeShipAt(Ship *ship, int id, Board *board)
 {
-	if (newShip->angle == VERTICAL)
+	int j, span;
+	uint32_t bits;
+	if (ship->length < 1 || ship->row < 0 || ship->col < 0 ||
+		(ship->angle != VERTICAL && ship->angle != HORIZONTAL) ||
+		ship->row + shipRowSpan(ship) > board->size ||
+		ship->col + (ship->angle == HORIZONTAL ? ship->length : 1) > board->size)
 	{
-		if ((newShip->row + (newShip->length))-1 < boardS)
-		{
-			return TRUE;
-		}
+		return FALSE;
 	}
-	else
+	span = shipRowSpan(ship);
+	bits = shipRowBits(ship);
+	for (j = 0; j < span; j++)
 	{
-		if ((newShip->col + (newShip->length))-1 < boardS)
+		if (bbRow(&board->ships, ship->row + j) & bits)
 		{
-			return TRUE;
+			return FALSE;
 		}
 	}
-	return FALSE;
+	updateManagerBoard(ship, id, board);
+	ship->lives = ship->length;
+	return TRUE;
 }
 
 /**
- * @brief The function receives a new ship needed to be located in the board and the manager
- * board holding all the other ships taken Coordinates.
- * The function return TRUE if the new ship's location is free and FALSE if its taken.
- * @param managerBoard The manager board in the game (saving all the ships locations).
- * @param newShip A pointer to the new ship needed to be placed.
- * @return TRUE If all the ships coordinate are free, FALSE otherwise.
+ * @brief The function draws the slot of a ship from the weighted placement table of the board
+ * until it finds one free of the other ships, and places the ship at a uniformly random free
+ * slot if WEIGHTED_DRAWS slots were all taken.
+ * @param ship The ship to locate, with its length set.
+ * @param id The index of the ship in its fleet, the table of the ship.
+ * @param board The game board, with a weighted placement table.
+ * @param rng The random numbers generator.
+ * @return TRUE if the ship was placed, FALSE if no free slot fits the ship.
  */
-int isEmptyLocation(char **managerBoard, Ship *newShip)
+static int placeWeightedShip(Ship *ship, int id, Board *board, Rng *rng)
 {
-	int j;
-	if (newShip->angle == VERTICAL)
-	{
-		for (j = 0; j < newShip->length; j++)
-		{
-			if (managerBoard[(newShip->row) + j][newShip->col] != EMPTY_CELL)
-			{
-				return FALSE;
-			}
-		}
-	}
-	else
+	int draw, slot, size = board->size;
+	for (draw = 0; draw < WEIGHTED_DRAWS; draw++)
 	{
-		for (j = 0; j < newShip->length; j++)
+		slot = weightedSlot(&board->weights->tables[id], rng);
+		ship->angle = slot / (size * size);
+		ship->row = slot / size % size;
+		ship->col = slot % size;
+		if (placeShipAt(ship, id, board) == TRUE)
 		{
-			if (managerBoard[newShip->row][(newShip->col) + j] != EMPTY_CELL)
-			{
-				return FALSE;
-			}
+			return TRUE;
 		}
 	}
-	return TRUE;
+	return placeShip(ship, id, board, rng);
 }
 
 /**
- * @brief The function receives a new ship needed to be located in the manager board and the
- * manager board holding all the other ships taken Coordinates. The function mark in the manager
- * board the ship location as taken.
- * @param managerBoard The manager board in the game (saving all the ships locations).
- * @param newShip A pointer to the new ship needed to be placed.
- * @param index The index of the ship in the ships array.
+ * @brief The function locates all the ships of a fleet on the board, filling an array of ships,
+ * the ship table of a game, or both.
+ * The ships are drawn from the weighted placement table of the board if it has one. If a ship
+ * does not fit the board that is left, the fleet is placed again from scratch, up to
+ * MAX_FLEET_ATTEMPTS times.
+ * @param board The game board (saving all the ships locations).
+ * @param fleet The fleet.
+ * @param rng The random numbers generator.
+ * @param ships An array of fleet->shipsNum ships filled with the fleet, NULL if not needed.
+ * @param table A ship table filled with the fleet, NULL if not needed.
+ * @return TRUE if the fleet was placed, FALSE otherwise (the board is then left with no ships).
  */
-void updateManagerBoard(Ship *newShip, char **managerBoard, int index)
+static int placeShips(Board *board, const Fleet *fleet, Rng *rng, Ship *ships, ShipTable *table)
 {
-	int j;
-	if (newShip->angle == VERTICAL)
+	Ship ship;
+	int i, attempt;
+	INSTRUMENT_CLOCK(start);
+	for (attempt = 0; attempt < MAX_FLEET_ATTEMPTS; attempt++)
 	{
-		for (j = 0; j < newShip->length; j++)
+		bbClear(&board->ships);
+		for (i = 0; i < fleet->shipsNum; i++)
 		{
-			managerBoard[(newShip->row) + j][newShip->col] = (char) (index + MIN_NUM_ASCII_VALUE);
+			ship.length = fleet->lengths[i];
+			ship.lives = ship.length;
+			if ((board->weights != NULL ? placeWeightedShip(&ship, i, board, rng) :
+				 placeShip(&ship, i, board, rng)) == FALSE)
+			{
+				INSTRUMENT_SHIP_RETRY(i);
+				break;
+			}
+			if (ships != NULL)
+			{
+				ships[i] = ship;
+			}
+			if (table != NULL)
+			{
+				table->row[i] = (uint8_t) ship.row;
+				table->col[i] = (uint8_t) ship.col;
+				table->length[i] = (uint8_t) ship.length;
+				table->angle[i] = (uint8_t) ship.angle;
+				table->lives[i] = (uint8_t) ship.lives;
+			}
 		}
-	}
-	else if (newShip->angle == HORIZONTAL)
-	{
-		for (j = 0; j < newShip->length; j++)
+		if (i == fleet->shipsNum)
 		{
-			managerBoard[(newShip->row)][(newShip->col) + j] = (char) (index + MIN_NUM_ASCII_VALUE);
+			INSTRUMENT_SETUP(start, attempt + 1);
+			return TRUE;
 		}
 	}
+	bbClear(&board->ships);
+	INSTRUMENT_SETUP(start, attempt);
+	return FALSE;
 }
 
 /**
- * The function initial random values to the ship's parameters.
- * @param newShip The new ship to initialize
- * @param boardSize The size of the board.
- * @return A pointer to the new ship with new random parameters.
- */
-Ship *randomizeParams(Ship *newShip, int boardSize)
+* @brief The function receives the game board and an array for the ships, and locates all the
+* ships of the fleet on the board.
+* @param board The game board (saving all the ships locations).
+* @param ships An array of fleet->shipsNum ships, filled with the fleet.
+* @param fleet The fleet.
+* @param rng The random numbers generator.
+* @return TRUE if the fleet was placed, FALSE otherwise (the board is then left with no ships).
+* */
+int placeFleet(Board *board, Ship *ships, const Fleet *fleet, Rng *rng)
 {
-	newShip->angle = rand() % 2;
-	newShip->row = rand() % boardSize;
-	newShip->col = rand() % boardSize;
-	return newShip;
+	return placeShips(board, fleet, rng, ships, NULL);
 }
 
 /**
- * @brief The function receives a new ship needed to be located in the board and the manager
- * board holding all the other ships taken Coordinates. The function picks a random value for
- * the ship, validate it, and mark it on the manager board.
- * @param newShip A pointer to the new ship needed to be placed.
- * @param boardSize The boardSize (as the height and width are equal)
- * @param managerBoard Rhe manager board in the game (saving all the ships locations).
- * @param index The index of the ship in the ships array.
- * */
-void placeShip(Ship *newShip, int boardSize, char **managerBoard, int index)
+ * @brief The function makes the fleet placement of a board draw every ship from a weighted
+ * placement table instead of a uniformly random free slot. A ship whose drawn slots keep
+ * touching the ships placed before it falls back to the uniform placement.
+ * @param board The game board.
+ * @param fleet The fleet placed on the board.
+ * @param weights The table, it must outlive its use by the board, NULL for the uniform placement.
+ * @return TRUE on success, FALSE if the table is not of the board size and fleet (the board is
+ * then left with the uniform placement).
+ */
+int useFleetWeights(Board *board, const Fleet *fleet, const FleetWeights *weights)
 {
-	newShip = randomizeParams(newShip, boardSize);
-	while (isInRange(newShip, boardSize) == FALSE ||
-		   isEmptyLocation(managerBoard, newShip) == FALSE)
+	board->weights = NULL;
+	if (weights == NULL)
 	{
-		newShip = randomizeParams(newShip, boardSize);
+		return TRUE;
 	}
-	updateManagerBoard(newShip, managerBoard, index);
+	if (weights->size != board->size || weights->fleet.shipsNum != fleet->shipsNum ||
+		memcmp(weights->fleet.lengths, fleet->lengths, (size_t) fleet->shipsNum) != 0)
+	{
+		return FALSE;
+	}
+	board->weights = weights;
+	return TRUE;
 }
 
 /**
-* @brief The function receives a the board size and the manager board holding all the other
-* ships taken Coordinates.
-* The function builds and locate all the ships in the game and holds them in an array.
+* @brief The function receives the game board.
+* The function builds and locate all the ships of the default fleet and holds them in an array,
+* drawing them from the weighted placement table of the board if it has one (see useFleetWeights).
 * The function return the array of ships created.
-* @param boardSize The boardSize (as the height and width are equal)
-* @param managerBoard The manager board in the game (saving all the ships locations).
-* @return The function return the array of ships created.
+* @param board The game board (saving all the ships locations).
+* @param rng The random numbers generator.
+* @return The function return the array of ships created, NULL if the allocation failed or
+* the fleet could not be placed.
 * */
-Ship *shipFactory(int boardSize, char **managerBoard)
+Ship *shipFactory(Board *board, Rng *rng)
 {
-	int const arr[SHIPS_NUM] =  {
-								AIRCRAFT_CARRIER,
-							 	BATTLE_CRIUSER,
-							 	MISSILE_SHIP,
-							 	SUBMARINE,
-								BATTLE_SHIP
-								};
 	Ship *shipArr = (Ship *) malloc(SHIPS_NUM * sizeof(Ship));
-	int i;
-	for (i = 0; i < SHIPS_NUM; i++)
+	if (shipArr == NULL)
 	{
-		shipArr[i].length = arr[i];
-		shipArr[i].lives = shipArr[i].length;
-		placeShip(&shipArr[i], boardSize, managerBoard, i);
+		return NULL;
+	}
+	if (placeFleet(board, shipArr, defaultFleet(), rng) == FALSE)
+	{
+		free(shipArr);
+		return NULL;
 	}
 	return shipArr;
 }
 
 /**
- * @brief The function receives a  board size and a pointer to the board and print it.
- * @param board The board to print.
- * @param boardSize The boardSize (as the height and width are equal)
- * */
-void printBoard(char **board, int boardSize)
+ * @brief The function returns the number of bytes of a game block, rounded up to a whole
+ * number of cache lines.
+ * @param shipsNum The number of ships in the game.
+ * @return The block size.
+ */
+size_t gameBlockSize(int shipsNum)
 {
-	int i;
-	for (i = 0; i < boardSize; i++)
+	size_t size = sizeof(Game) + (size_t) shipsNum * sizeof(uint8_t) * 5;
+	return (size + GAME_ALIGNMENT - 1) / GAME_ALIGNMENT * GAME_ALIGNMENT;
+}
+
+/**
+ * @brief The function prepares a block of gameBlockSize(fleet->shipsNum) bytes as a game with
+ * an empty board. The ships arrays follow one another right after the game header.
+ * @param game The game block.
+ * @param size The board size.
+ * @param fleet The fleet placed by resetGame.
+ */
+void initGame(Game *game, int size, const Fleet *fleet)
+{
+	int count = fleet->shipsNum;
+	game->board.size = size;
+	game->board.kernels = boardKernels(size);
+	game->board.placement = placementTable(size);
+	game->board.weights = NULL;
+	game->fleet = fleet;
+	game->shipsNum = count;
+	game->deadShips = 0;
+	game->ships.row = game->shipData;
+	game->ships.col = game->shipData + count;
+	game->ships.length = game->shipData + 2 * count;
+	game->ships.angle = game->shipData + 3 * count;
+	game->ships.lives = game->shipData + 4 * count;
+	bbClear(&game->board.ships);
+	bbClear(&game->board.shots);
+	bbClear(&game->board.hits);
+}
+
+/**
+ * @brief The function creates a game with an empty board, all of it in a single cache aligned
+ * block. The fleet is placed by resetGame.
+ * @param size The board size.
+ * @param fleet The fleet of the game, it must outlive the game.
+ * @return The new game, NULL if the allocation failed.
+ */
+Game *newGame(int size, const Fleet *fleet)
+{
+	Game *game = (Game *) aligned_alloc(GAME_ALIGNMENT, gameBlockSize(fleet->shipsNum));
+	if (game == NULL)
 	{
-		printf(",%d", i + 1);
-	}
-	printf("\n");
-	for (i = 0; i < boardSize; i++)
-	{
-		printf("%c", (char) (START_LETTER + i));
-		for (int j = 0; j < boardSize; j++)
-		{
-			printf(" %c", board[i][j]);
-		}
-		printf("\n");
+		return NULL;
 	}
+	initGame(game, size, fleet);
+	return game;
 }
 
 /**
- * The function handles a case when the user hit a ship on the board. The function updates the
- * hit ship lives and if the ship is dead it will print the correct message and update the counter
- * of the dead ships in the game.
- * @param row The row received from the user.
- * @param col The column received from the user.
- * @param managerBoard The manager board in the game (saving all the ships locations).
- * @param toPrintBoard
- * @param boardSize The boardSize (as the height and width are equal)
+ * @brief The function starts a new game in an existing game block: it clears the board and
+ * places a new fleet, without any allocation.
+ * @param game The game.
+ * @param rng The random numbers generator.
+ * @return TRUE if the fleet was placed, FALSE otherwise.
+ */
+int resetGame(Game *game, Rng *rng)
+{
+	bbClear(&game->board.shots);
+	bbClear(&game->board.hits);
+	game->deadShips = 0;
+	return placeShips(&game->board, game->fleet, rng, NULL, &game->ships);
+}
+
+/**
+ * @brief The function frees a game created by newGame.
+ * @param game The game.
+ */
+void freeGame(Game *game)
+{
+	free(game);
+}
+
+/**
+ * The function finds the ship taking a given cell of the board.
+ * @param board The game board.
+ * @param row The cell row.
+ * @param col The cell column.
+ * @return The index of the ship in its fleet, FALSE if no ship takes the cell.
+ */
+int shipAt(const Board *board, int row, int col)
+{
+	return bbTest(&board->ships, row, col) ? board->shipIds[row][col] : FALSE;
+}
+
+/**
+ * The function fires a single shot at the board without printing anything.
+ * @param row The row of the shot.
+ * @param col The column of the shot.
+ * @param board The game board.
  * @param ships An array holding all the ships participating in the game.
- * @param deadShips The counter counting the number of dead ships in the game.
- * @return The updated number of dead ships in the game according to the last turn.
+ * @return SHOT_MISS, SHOT_HIT, SHOT_SUNK_RESULT of the sunk ship index, SHOT_ALREADY if the cell
+ * was already shot and SHOT_INVALID if the cell is out of the board bounds.
  */
-int hit(int row, int col, char **managerBoard, char **toPrintBoard, Ship *ships, int deadShips)
+int shoot(int row, int col, Board *board, Ship *ships)
 {
-	int index;
-	toPrintBoard[row][col] = HIT_CELL;
-	index = (int) (managerBoard[row][col] - MIN_NUM_ASCII_VALUE);
-	ships[index].lives--;
-	if (ships[index].lives == 0)
+	int index, result;
+	INSTRUMENT_CLOCK(start);
+	result = board->kernels->markShot(row, col, board);
+	if (result == SHOT_HIT)
 	{
-		printf(SUNK_MESSAGE);
-		deadShips++;
+		index = board->shipIds[row][col];
+		result = --ships[index].lives == 0 ? SHOT_SUNK_RESULT(index) : SHOT_HIT;
 	}
-	else
-	{
-		printf(HIT_MESSAGE);
-	}
-	return deadShips;
+	INSTRUMENT_TURN(start, result);
+	return result;
 }
 
 /**
- * The function verifies the move received by the player is valid (is in the board bounds).
- * @param row The row received from the user.
- * @param col The column received from the user.
- * @param boardSize The boardSize (as the height and width are equal)
- * @return
+ * The function fires a single shot in a game and counts the ship it sinks.
+ * @param game The game.
+ * @param row The row of the shot.
+ * @param col The column of the shot.
+ * @return The shot result, as returned by shoot.
  */
-int isValidMove(int row, int col, int boardSize)
+int fireShot(Game *game, int row, int col)
 {
-	if (row > boardSize-1)
+	int index, result;
+	INSTRUMENT_CLOCK(start);
+	result = game->board.kernels->markShot(row, col, &game->board);
+	if (result == SHOT_HIT)
 	{
-		return FALSE;
+		index = game->board.shipIds[row][col];
+		if (--game->ships.lives[index] == 0)
+		{
+			game->deadShips++;
+			result = SHOT_SUNK_RESULT(index);
+		}
 	}
-	if (col > boardSize-1)
+	INSTRUMENT_TURN(start, result);
+	return result;
+}
+
+/**
+ * The function fires a batch of shots in a game, in order, with no output.
+ * @param game The game.
+ * @param shots The shots.
+ * @param count The number of shots.
+ * @param results Filled with the result of every shot, as returned by shoot.
+ * @return The number of sunk ships in the game after the batch.
+ */
+int fireShots(Game *game, const Shot *shots, int count, int *results)
+{
+	int i;
+	for (i = 0; i < count; i++)
 	{
-		return FALSE;
+		results[i] = fireShot(game, shots[i].row, shots[i].col);
 	}
-	return TRUE;
+	return game->deadShips;
 }
 
 /**
- * The function run a whole single turn in the game, receiving the user move.
- * @param row The row received from the user.
- * @param col The column received from the user.
- * @param managerBoard The manager board in the game (saving all the ships locations).
- * @param toPrintBoard The board represented to the user during the game, it holds all the user
- * shots marked as miss ('o') and hit('x').
- * @param boardSize The boardSize (as the height and width are equal)
- * @param ships An array holding all the ships participating in the game.
- * @param deadShips The counter counting the number of dead ships in the game.
- * @return The updated number of dead ships in the game according to the last turn.
+ * The function fires a salvo, one shot for every ship afloat, as a single move. The shots are
+ * validated and set in the shots mask in a single pass, which is undone if a shot is rejected,
+ * and then resolved against the ships mask a word (two rows) at a time, so the hits of the salvo
+ * are set and the ships it sinks are reported together.
+ * @param game The game.
+ * @param shots The shots.
+ * @param count The number of shots, the number of ships afloat.
+ * @param salvo Filled with the outcome of the salvo, if it was fired.
+ * @return SALVO_FIRED, SALVO_WRONG_COUNT, or the result of the first rejected shot: SHOT_INVALID
+ * if it is out of the board bounds, SHOT_ALREADY if its cell was already shot or is shot twice
+ * in the salvo. A rejected salvo leaves the game as it was.
  */
-int singleTurn(int row, int col, char **managerBoard, char **toPrintBoard, int boardSize,
-			   Ship *ships, int deadShips)
+int fireSalvo(Game *game, const Shot *shots, int count, SalvoResult *salvo)
 {
-	if (isValidMove(row, col, boardSize) == FALSE)
+	Board *board = &game->board;
+	uint64_t bits;
+	int i, word, bit, row, col, index, status = SALVO_FIRED;
+	INSTRUMENT_CLOCK(start);
+	if (count != game->shipsNum - game->deadShips)
 	{
-		printf(INVALID_MOVE_MESSAGE);
-		return deadShips;
+		INSTRUMENT_TURN(start, SHOT_INVALID);
+		return SALVO_WRONG_COUNT;
 	}
-
-	if (toPrintBoard[row][col] != EMPTY_CELL)
+	for (i = 0; i < count; i++)
 	{
-		printf(ALREADY_HIT_MESSAGE);
+		if (isValidMove(shots[i].row, shots[i].col, board->size) == FALSE)
+		{
+			status = SHOT_INVALID;
+			break;
+		}
+		if (bbTest(&board->shots, shots[i].row, shots[i].col))
+		{
+			status = SHOT_ALREADY;
+			break;
+		}
+		bbSet(&board->shots, shots[i].row, shots[i].col);
 	}
-	else
+	if (status != SALVO_FIRED)
 	{
-		if (managerBoard[row][col] == EMPTY_CELL)
+		while (--i >= 0)
 		{
-			toPrintBoard[row][col] = MISS_CELL;
-			printf(MISS_MESSAGE);
+			bbUnset(&board->shots, shots[i].row, shots[i].col);
 		}
-		else
+		INSTRUMENT_TURN(start, status);
+		return status;
+	}
+	salvo->hitsNum = 0;
+	salvo->sunkNum = 0;
+	for (i = 0; i < count; i++)
+	{
+		word = shots[i].row >> 1;
+		bits = board->shots.words[word] & board->ships.words[word] & ~board->hits.words[word];
+		board->hits.words[word] |= bits;
+		for (; bits != 0; bits &= bits - 1)
 		{
-			deadShips = hit(row, col, managerBoard, toPrintBoard, ships, deadShips);
+			bit = __builtin_ctzll(bits);
+			row = 2 * word + bit / BITBOARD_ROW_BITS;
+			col = bit % BITBOARD_ROW_BITS;
+			index = board->shipIds[row][col];
+			salvo->hitsNum++;
+			if (--game->ships.lives[index] == 0)
+			{
+				game->deadShips++;
+				salvo->sunk[salvo->sunkNum++] = (uint16_t) index;
+			}
 		}
 	}
-	printBoard(toPrintBoard, boardSize);
-	return deadShips;
+	INSTRUMENT_SALVO(start, count, salvo->hitsNum, salvo->sunkNum);
+	return status;
 }
 
 /**
-* @brief The function receives a two dimension array and free all of its .
-* @param board the board to print.
-* @param boardSize the boardSize (as the height and width are equal)
-* */
-void free2DArray(char **array, int size)
+ * The function checks whether every ship cell on the board was hit.
+ * @param board The game board.
+ * @return TRUE (1) if all the ships are sunk, FALSE otherwise.
+ */
+int isGameOver(const Board *board)
 {
-	int i;
-	for (i = 0; i < size; i++)
-	{
-		free(array[i]);
-	}
-	free(array);
+	return bbEquals(&board->hits, &board->ships) ? TRUE : FALSE;
 }
 
 /**
  * The function free all the space taken by the program using the free function.
- * @param toPrintBoard The board represented to the user during the game, it holds all the user
- * shots marked as miss ('o') and hit('x').
- * @param managerBoard
- * @param shipsArray
- * @param boardSize
+ * @param board The game board, it holds the ships and all the user shots.
+ * @param shipsArray An array holding all the ships participating in the game.
  */
-void freeAllSpace(char **toPrintBoard, char **managerBoard, Ship *shipsArray, int boardSize)
+void freeAllSpace(Board *board, Ship *shipsArray)
 {
-	free2DArray(toPrintBoard, boardSize);
-	free2DArray(managerBoard, boardSize);
+	free(board);
 	free(shipsArray);
-}
\ No newline at end of file
+}
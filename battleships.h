@@ -1,14 +1,113 @@
 #ifndef BATTLESHIPS_H_
 #define BATTLESHIPS_H_
 
+// ------------------------------ includes ------------------------------
+#include <stddef.h>
+#include "bitboard.h"
+#include "fleet.h"
+#include "fleet_weights.h"
+#include "placement.h"
+#include "rng.h"
+
 // -------------------------- const definitions -------------------------
 
 /**
  * @def SHIPS_NUM 5
- * @brief the number of ships participating in the game.
+ * @brief the number of ships of the default fleet.
  */
 #define SHIPS_NUM 5
 
+/**
+ * @def GAME_ALIGNMENT 64
+ * @brief the alignment of a game block (a cache line).
+ */
+#define GAME_ALIGNMENT 64
+
+/**
+ * @def SHOT_MISS 0
+ * @brief the result of a shot that did not hit a ship.
+ */
+#define SHOT_MISS 0
+
+/**
+ * @def SHOT_HIT 1
+ * @brief the result of a shot that hit a ship which is still afloat.
+ */
+#define SHOT_HIT 1
+
+/**
+ * @def SHOT_ALREADY 2
+ * @brief the result of a shot at a cell that was already shot.
+ */
+#define SHOT_ALREADY 2
+
+/**
+ * @def SHOT_INVALID 3
+ * @brief the result of a shot out of the board bounds.
+ */
+#define SHOT_INVALID 3
+
+/**
+ * @def SHOT_SUNK 4
+ * @brief the result of a shot that hit the last live cell of a ship, the index of the sunk ship
+ * is added to it (see SHOT_SUNK_RESULT).
+ */
+#define SHOT_SUNK 4
+
+/**
+ * @def SHOT_SUNK_RESULT(index)
+ * @brief the result of a shot that sunk the ship with the given index.
+ */
+#define SHOT_SUNK_RESULT(index) (SHOT_SUNK + (index))
+
+/**
+ * @def SHOT_IS_SUNK(result)
+ * @brief 1 if the shot result sunk a ship, 0 otherwise.
+ */
+#define SHOT_IS_SUNK(result) ((result) >= SHOT_SUNK)
+
+/**
+ * @def SHOT_SUNK_SHIP(result)
+ * @brief the index of the ship sunk by a shot result.
+ */
+#define SHOT_SUNK_SHIP(result) ((result) - SHOT_SUNK)
+
+/**
+ * @def VERTICAL 0
+ * @brief the angle of the ship is vertical
+ */
+#define VERTICAL 0
+
+/**
+ * @def HORIZONTAL 1
+ * @brief the angle of the ship is horizontal
+ */
+#define HORIZONTAL 1
+
+/**
+ * @def SALVO_FIRED 0
+ * @brief the status of a salvo that was fired.
+ */
+#define SALVO_FIRED 0
+
+/**
+ * @def SALVO_WRONG_COUNT (-2)
+ * @brief the status of a salvo whose number of shots is not the number of ships afloat.
+ */
+#define SALVO_WRONG_COUNT (-2)
+
+/**
+ * The length of each ship participating in the game.
+ */
+enum Ships_VERITY
+		{
+		AIRCRAFT_CARRIER = 5,
+		BATTLE_CRIUSER = 4,
+		MISSILE_SHIP = 3,
+		SUBMARINE = 3,
+		BATTLE_SHIP = 2
+		};
+
 // --------------------------  structs -------------------------
 
 
@@ -21,85 +120,300 @@
  * lives - the number of cells on the board that were not hit. (the initialization of lives is
  * the size of the ship).
  */
-typedef struct Ship Ship;
+typedef struct Ship
+{
+	int row;
+	int col;
+	int length;
+	int angle;
+	int lives;
+} Ship;
+
+typedef struct BoardKernels BoardKernels;
+
+/**
+ * a structure describing the state of a game board. includes the following attributes:
+ * size - the board size (as the height and width are equal).
+ * kernels - the placement and shot functions compiled for the board size.
+ * placement - the in range placements of every ship length on a board of this size.
+ * weights - the weighted placement table the ships are drawn from, NULL for the uniform
+ * placement (see useFleetWeights).
+ * ships - the cells taken by the ships (the manager board).
+ * shots - the cells the player already shot at.
+ * hits - the shots that hit a ship (a subset of both ships and shots).
+ * shipIds - the index of the ship taking every cell, only meaningful on the cells set in ships
+ * (so it is never cleared).
+ */
+typedef struct Board
+{
+	int size;
+	const BoardKernels *kernels;
+	const PlacementTable *placement;
+	const FleetWeights *weights;
+	Bitboard ships;
+	Bitboard shots;
+	Bitboard hits;
+	uint16_t shipIds[BITBOARD_MAX_SIZE][BITBOARD_MAX_SIZE];
+} Board;
+
+/**
+ * a structure holding the hot board functions of a single board size, compiled with the size
+ * as a constant (see BITBOARD_KERNEL_SIZES). includes the following attributes:
+ * size - the board size, 0 for the functions reading the size from the board.
+ * placeShip - places a ship at a uniformly random free slot, as placeShip.
+ * markShot - marks a shot on the board, returning SHOT_MISS, SHOT_HIT, SHOT_ALREADY or
+ * SHOT_INVALID without touching the ships lives.
+ */
+struct BoardKernels
+{
+	int size;
+	int (*placeShip)(Ship *newShip, int id, Board *board, Rng *rng);
+	int (*markShot)(int row, int col, Board *board);
+};
+
+/**
+ * a structure holding the ships of a game, one array per attribute, indexed by the ship index:
+ * row - the row index of every ship on the board.
+ * col - the column index of every ship on the board.
+ * length - the length of every ship.
+ * angle - 0 for vertical, 1 for horizontal.
+ * lives - the number of cells of every ship that were not hit.
+ */
+typedef struct ShipTable
+{
+	uint8_t *row;
+	uint8_t *col;
+	uint8_t *length;
+	uint8_t *angle;
+	uint8_t *lives;
+} ShipTable;
+
+/**
+ * a structure holding a whole game in a single block. includes the following attributes:
+ * board - the game board.
+ * fleet - the fleet placed in every new game.
+ * shipsNum - the number of ships in the game.
+ * deadShips - the number of sunk ships.
+ * ships - the ships participating in the game, their arrays are in shipData.
+ * shipData - the ships arrays, right after the board in the same block.
+ */
+typedef struct Game
+{
+	Board board;
+	const Fleet *fleet;
+	int shipsNum;
+	int deadShips;
+	ShipTable ships;
+	uint8_t shipData[];
+} Game;
+
+/**
+ * a structure describing a single move of the player. includes the following attributes:
+ * row - the row of the shot.
+ * col - the column of the shot.
+ */
+typedef struct Shot
+{
+	int row;
+	int col;
+} Shot;
+
+/**
+ * a structure holding the outcome of a salvo. includes the following attributes:
+ * hitsNum - the number of shots that hit a ship.
+ * sunkNum - the number of ships the salvo sunk.
+ * sunk - the index of every ship the salvo sunk.
+ */
+typedef struct SalvoResult
+{
+	int hitsNum;
+	int sunkNum;
+	uint16_t sunk[MAX_FLEET_SHIPS];
+} SalvoResult;
 
 //----------------- functions--------------------------
 
 /**
- * @brief Receives a size and creates a char board initialized to empty cells.
+ * @brief Returns the board functions compiled for a board size, chosen once when a board is
+ * created so the hot loops never read the size at run time.
+ * @param size the board size.
+ * @return the kernels of the size, the kernels reading the size from the board if no kernels
+ * were compiled for it.
+ */
+const BoardKernels *boardKernels(int size);
+
+/**
+ * @brief Receives a size and creates a board with no ships and no shots.
  * @param size - the board size
- * @return the new board initialized.
+ * @return the new board initialized, NULL if the allocation failed.
  */
-char **initialBoard(int size);
+Board *initialBoard(int size);
 
 
 /**
- * @brief The function receives a new ship needed to be located in the board and the manager
- * board holding all the other ships taken Coordinates. The function picks a random value for the
- * ship, validate it, and mark it on the manager board.
+ * @brief The function receives a new ship needed to be located in the board and the board
+ * holding all the other ships taken Coordinates. The function lists all the free slots for the
+ * ship, picks one of them uniformly with a single random draw and mark it on the board ships mask.
  * @param newShip a pointer to the new ship needed to be placed.
- * @param boardSize the boardSize (as the height and width are equal)
- * @param managerBoard the manager board in the game (saving all the ships locations).
- * @param index the index of the ship in the ships array.
+ * @param id the index of the ship in its fleet, marked on the board ship ids.
+ * @param board the game board (saving all the ships locations).
+ * @param rng the random numbers generator.
+ * @return TRUE (1) if the ship was placed, FALSE if no free slot fits the ship.
  * */
-void placeShip(Ship *newShip, int boardSize, char **managerBoard, int index);
+int placeShip(Ship *newShip, int id, Board *board, Rng *rng);
+
+/**
+ * @brief The function locates a ship at the position it already holds (a fleet loaded from a
+ * log, for example), if it fits the board bounds and does not touch the other ships.
+ * @param ship the ship, with its row, column, length and angle set.
+ * @param id the index of the ship in its fleet, marked on the board ship ids.
+ * @param board the game board (saving all the ships locations).
+ * @return TRUE (1) if the ship was placed, FALSE otherwise.
+ */
+int placeShipAt(Ship *ship, int id, Board *board);
 
 /**
-* @brief The function receives a the board size and the manager board holding all the other ships
-* taken Coordinates.
-* The function builds and locate all the ships in the game and holds them in an array.
+ * @brief The function makes the fleet placement of a board draw every ship from a weighted
+ * placement table instead of a uniformly random free slot. A ship whose drawn slots keep
+ * touching the ships placed before it falls back to the uniform placement.
+ * @param board the game board.
+ * @param fleet the fleet placed on the board.
+ * @param weights the table, it must outlive its use by the board, NULL for the uniform placement.
+ * @return TRUE (1) on success, FALSE if the table is not of the board size and fleet (the board
+ * is then left with the uniform placement).
+ */
+int useFleetWeights(Board *board, const Fleet *fleet, const FleetWeights *weights);
+
+/**
+* @brief The function receives the game board.
+* The function builds and locate all the ships of the default fleet and holds them in an array,
+* drawing them from the weighted placement table of the board if it has one (see useFleetWeights).
 * The function return the array of ships created.
-* @param boardSize the boardSize (as the height and width are equal)
-* @param managerBoard the manager board in the game (saving all the ships locations).
-* @return the function return the array of ships created.
+* @param board the game board (saving all the ships locations).
+* @param rng the random numbers generator.
+* @return the function return the array of ships created, NULL if the allocation failed or the
+* fleet could not be placed.
 * */
-Ship *shipFactory(int boardSize, char **managerBoard);
+Ship *shipFactory(Board *board, Rng *rng);
 
 /**
- * @brief The function receives a  board size and a pointer to the board and print it.
- * @param board the board to print.
- * @param boardSize the boardSize.
- * */
-void printBoard( char **board, int boardSize);
+* @brief The function receives the game board and an array for the ships, and locates all the
+* ships of the fleet on the board.
+* @param board the game board (saving all the ships locations).
+* @param ships an array of fleet->shipsNum ships, filled with the fleet.
+* @param fleet the fleet.
+* @param rng the random numbers generator.
+* @return TRUE (1) if the fleet was placed, FALSE otherwise (the board is then left with no ships).
+* */
+int placeFleet(Board *board, Ship *ships, const Fleet *fleet, Rng *rng);
+
+/**
+ * @brief The function returns the number of bytes of a game block, rounded up to a whole
+ * number of cache lines.
+ * @param shipsNum the number of ships in the game.
+ * @return the block size.
+ */
+size_t gameBlockSize(int shipsNum);
 
+/**
+ * @brief The function prepares a block of gameBlockSize(fleet->shipsNum) bytes as a game with
+ * an empty board.
+ * @param game the game block.
+ * @param size the board size.
+ * @param fleet the fleet placed by resetGame.
+ */
+void initGame(Game *game, int size, const Fleet *fleet);
 
 /**
- * The function handles a case when the user hit a ship on the board. The function updates the
- * hit ship lives and if the ship is dead it will print the correct message and update the counter
- * of the dead ships in the game.
- * @param row The row received from the user.
- * @param col The column received from the user.
- * @param managerBoard The manager board in the game.(saving all the ships locations).
- * @param toPrintBoard The board represented to the user during the game.
- * @param boardSize The boardSize.
- * @param ships An array holding all the ships participating in the game.
- * @param deadShips The counter counting the number of dead ships in the game.
- * @return The updated number of dead ships in the game according to the last turn.
+ * @brief The function creates a game with an empty board, all of it in a single cache aligned
+ * block. The fleet is placed by resetGame.
+ * @param size the board size.
+ * @param fleet the fleet of the game, it must outlive the game.
+ * @return the new game, NULL if the allocation failed.
  */
-int hit(int row, int col, char **managerBoard, char **toPrintBoard, Ship *ships, int deadShips);
+Game *newGame(int size, const Fleet *fleet);
 
+/**
+ * @brief The function starts a new game in an existing game block: it clears the board and
+ * places a new fleet, without any allocation.
+ * @param game the game.
+ * @param rng the random numbers generator.
+ * @return TRUE (1) if the fleet was placed, FALSE otherwise.
+ */
+int resetGame(Game *game, Rng *rng);
+
+/**
+ * @brief The function frees a game created by newGame.
+ * @param game the game.
+ */
+void freeGame(Game *game);
+
+/**
+ * The function finds the ship taking a given cell of the board.
+ * @param board The game board.
+ * @param row The cell row.
+ * @param col The cell column.
+ * @return The index of the ship in its fleet, FALSE if no ship takes the cell.
+ */
+int shipAt(const Board *board, int row, int col);
 
 /**
- * The function run a whole single turn in the game, receiving the user move, and validates it.
- * @param row The row received from the user.
- * @param col The column received from the user.
- * @param managerBoard The manager board in the game (saving all the ships locations).
- * @param toPrintBoard The board represented to the user during the game.
- * @param boardSize The boardSize.
+ * The function fires a single shot at the board without printing anything.
+ * @param row The row of the shot.
+ * @param col The column of the shot.
+ * @param board The game board.
  * @param ships An array holding all the ships participating in the game.
- * @param deadShips The counter counting the number of dead ships in the game.
- * @return The updated number of dead ships in the game according to the last turn.
+ * @return SHOT_MISS, SHOT_HIT, SHOT_SUNK_RESULT of the sunk ship index, SHOT_ALREADY if the cell
+ * was already shot and SHOT_INVALID if the cell is out of the board bounds.
+ */
+int shoot(int row, int col, Board *board, Ship *ships);
+
+/**
+ * The function fires a single shot in a game and counts the ship it sinks.
+ * @param game The game.
+ * @param row The row of the shot.
+ * @param col The column of the shot.
+ * @return The shot result, as returned by shoot.
+ */
+int fireShot(Game *game, int row, int col);
+
+/**
+ * The function fires a batch of shots in a game, in order, with no output.
+ * @param game The game.
+ * @param shots The shots.
+ * @param count The number of shots.
+ * @param results Filled with the result of every shot, as returned by shoot.
+ * @return The number of sunk ships in the game after the batch.
+ */
+int fireShots(Game *game, const Shot *shots, int count, int *results);
+
+/**
+ * The function fires a salvo, one shot for every ship afloat, as a single move. The shots are
+ * validated and set in the shots mask in a single pass, which is undone if a shot is rejected,
+ * and then resolved against the ships mask a word (two rows) at a time, so the hits of the salvo
+ * are set and the ships it sinks are reported together.
+ * @param game The game.
+ * @param shots The shots.
+ * @param count The number of shots, the number of ships afloat.
+ * @param salvo Filled with the outcome of the salvo, if it was fired.
+ * @return SALVO_FIRED, SALVO_WRONG_COUNT, or the result of the first rejected shot: SHOT_INVALID
+ * if it is out of the board bounds, SHOT_ALREADY if its cell was already shot or is shot twice
+ * in the salvo. A rejected salvo leaves the game as it was.
+ */
+int fireSalvo(Game *game, const Shot *shots, int count, SalvoResult *salvo);
+
+/**
+ * The function checks whether every ship cell on the board was hit.
+ * @param board The game board.
+ * @return TRUE (1) if all the ships are sunk, FALSE otherwise.
  */
-int singleTurn(int row, int col, char **managerBoard, char **toPrintBoard, int boardSize,
-			   Ship *ships, int deadShips);
+int isGameOver(const Board *board);
 
 /**
  * The function free all the space taken by the program using the free function.
- * @param toPrintBoard The board represented to the user during the game.
- * @param managerBoard The manager board in the game (saving all the ships locations).
+ * @param board The game board.
  * @param shipsArray An array holding all the ships participating in the game.
- * @param boardSize  The boardSize.
  */
-void freeAllSpace(char **toPrintBoard, char **managerBoard, Ship *shipsArray, int boardSize);
+void freeAllSpace(Board *board, Ship *shipsArray);
 
 #endif /* BATTLESHIPS_H_ */
\ No newline at end of file
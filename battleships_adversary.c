@@ -0,0 +1,359 @@
+/**
+ * @file battleships_adversary.c
+ * @version 2.0
+ *
+ * @brief Searches for the weighted fleet placement a built in shooter needs the most shots
+ * against, and saves it as a placement table.
+ *
+ * @section DESCRIPTION
+ * The program runs the cross entropy search of adversary.h and then plays the shooter against
+ * the uniform placement and against the table it found, with the batch simulator.
+ * Input  : Command line options - the board size (-s), the shooter strategy (-p, density by
+ *          default), the number of iterations (-i), the number of layouts of every iteration
+ *          (-n), the elite share (-e), the smoothing (-a), the uniform floor (-m), the master
+ *          random seed (-r), the number of worker threads (-t, all the cores by default), the
+ *          number of games of the final comparison (-v), the table to start from (-w, the
+ *          uniform table by default) and the path the table is saved to (-o). The fleet is
+ *          described with -F (e.g. "5,4x2,3") or read from a config file with -c (see fleet.h),
+ *          the classic five ships by default.
+ * Process: drawing, playing and ranking the layouts of every iteration on the worker threads.
+ * Output : The results of every iteration, the mean shots of the shooter against the uniform
+ *          placement and against the table, and the table file (see fleet_weights.h).
+ */
+// ------------------------------ includes ------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "adversary.h"
+#include "simulator.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def USAGE_ERROR 1
+ * @brief the integer returned if the command line options are wrong.
+ */
+#define USAGE_ERROR 1
+
+/**
+ * @def MEMORY_ERROR 2
+ * @brief the integer returned if one of the pointers is NULL .
+ */
+#define MEMORY_ERROR 2
+
+/**
+ * @def BOARD_SIZE_ERROR 3
+ * @brief the integer returned if the board size is out of the allowed range.
+ */
+#define BOARD_SIZE_ERROR 3
+
+/**
+ * @def WRONG_BOARD_SIZE_MSG "You've entered a wrong size for the board."
+ * @brief the message printed to the screen when the board size is out of the allowed range.
+ */
+#define WRONG_BOARD_SIZE_MSG "You've entered a wrong size for the board."
+
+/**
+ * @def FLEET_ERROR 5
+ * @brief the integer returned if the fleet description or the starting table is wrong.
+ */
+#define FLEET_ERROR 5
+
+/**
+ * @def WRONG_FLEET_MSG "You've entered a wrong fleet."
+ * @brief the message printed to the screen when the fleet is wrong or does not fit the board.
+ */
+#define WRONG_FLEET_MSG "You've entered a wrong fleet."
+
+/**
+ * @def WRONG_WEIGHTS_MSG "You've entered a wrong placement table."
+ * @brief the message printed to the screen when the starting table can not be read or is not of
+ * the board size and fleet.
+ */
+#define WRONG_WEIGHTS_MSG "You've entered a wrong placement table."
+
+/**
+ * @def WEIGHTS_ERROR 8
+ * @brief the integer returned if the table could not be saved.
+ */
+#define WEIGHTS_ERROR 8
+
+/**
+ * @def MAX_BOARD_SIZE 26
+ * @brief The maximal board size allowed in the game.
+ */
+#define MAX_BOARD_SIZE 26
+
+/**
+ * @def MIN_BOARD_SIZE 5
+ * @brief The minimal board size allowed in the game.
+ */
+#define MIN_BOARD_SIZE 5
+
+/**
+ * @def DEFAULT_BOARD_SIZE 10
+ * @brief The board size used when -s is not given.
+ */
+#define DEFAULT_BOARD_SIZE 10
+
+/**
+ * @def DEFAULT_STRATEGY "density"
+ * @brief The shooter strategy used when -p is not given.
+ */
+#define DEFAULT_STRATEGY "density"
+
+/**
+ * @def DEFAULT_ITERATIONS 40
+ * @brief The number of iterations when -i is not given.
+ */
+#define DEFAULT_ITERATIONS 40
+
+/**
+ * @def DEFAULT_SAMPLES 4000
+ * @brief The number of layouts of every iteration when -n is not given.
+ */
+#define DEFAULT_SAMPLES 4000
+
+/**
+ * @def DEFAULT_ELITE 0.1
+ * @brief The elite share when -e is not given.
+ */
+#define DEFAULT_ELITE 0.1
+
+/**
+ * @def DEFAULT_SMOOTHING 0.5
+ * @brief The smoothing when -a is not given.
+ */
+#define DEFAULT_SMOOTHING 0.5
+
+/**
+ * @def DEFAULT_FLOOR 0.05
+ * @brief The uniform floor when -m is not given.
+ */
+#define DEFAULT_FLOOR 0.05
+
+/**
+ * @def DEFAULT_EVALUATION_GAMES 20000
+ * @brief The number of games of the final comparison when -v is not given.
+ */
+#define DEFAULT_EVALUATION_GAMES 20000
+
+/**
+ * @def DEFAULT_WEIGHTS_PATH "fleet.weights"
+ * @brief The path the table is saved to when -o is not given.
+ */
+#define DEFAULT_WEIGHTS_PATH "fleet.weights"
+
+/**
+ * @def USAGE_MSG
+ * @brief The message printed when the command line options are wrong.
+ */
+#define USAGE_MSG "usage: %s [-s board size] [-p random|hunt|density|book] [-i iterations] " \
+				  "[-n layouts] [-e elite] [-a smoothing] [-m floor] [-r seed] [-t threads] " \
+				  "[-v games] [-w start table] [-o table] [-F fleet | -c fleet file]\n"
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Checks that a share option is between 0 and 1.
+ * @param share The share.
+ * @return Non zero if the share is valid.
+ */
+int validShare(double share)
+{
+	return share >= 0 && share <= 1;
+}
+
+/**
+ * @brief Plays the shooter against a placement with the batch simulator.
+ * @param config The search description.
+ * @param weights The table the fleets are drawn from, NULL for the uniform placement.
+ * @param games The number of games.
+ * @param meanShots Filled with the mean number of shots the shooter needed.
+ * @return 0 on success, an error code of runSimulation otherwise.
+ */
+int evaluate(const AdversaryConfig *config, const FleetWeights *weights, long games,
+			 double *meanShots)
+{
+	SimConfig simConfig = {.boardSize = config->boardSize, .games = games,
+						   .strategy = config->strategy, .fleet = config->fleet,
+						   .seed = config->seed + 1, .threads = config->threads, .logFd = -1,
+						   .batch = 0, .weights = weights};
+	SimStats *stats = (SimStats *) malloc(sizeof(SimStats));
+	int status;
+	if (stats == NULL)
+	{
+		return MEMORY_ERROR;
+	}
+	status = runSimulation(&simConfig, stats);
+	*meanShots = stats->games > 0 ? (double) stats->shots / (double) stats->games : 0.0;
+	free(stats);
+	return status;
+}
+
+/**
+ * @brief Prints the search results.
+ * @param config The search description.
+ * @param stats The search results.
+ */
+void printSearch(const AdversaryConfig *config, const AdversaryStats *stats)
+{
+	int i;
+	printf("strategy: %s\n", config->strategy->name);
+	printf("board size: %d\n", config->boardSize);
+	printf("ships: %d\n", config->fleet->shipsNum);
+	printf("seed: %llu\n", (unsigned long long) config->seed);
+	printf("threads: %d\n", config->threads);
+	printf("games: %ld\n", stats->games);
+	printf("seconds: %.3f\n", stats->seconds);
+	printf("games per second: %.0f\n",
+		   stats->seconds > 0 ? (double) stats->games / stats->seconds : 0.0);
+	printf("iteration,mean shots,elite shots,max shots,seconds\n");
+	for (i = 0; i < stats->iterations; i++)
+	{
+		printf("%d,%.2f,%d,%d,%.3f\n", i + 1, stats->steps[i].meanShots,
+			   stats->steps[i].eliteShots, stats->steps[i].maxShots, stats->steps[i].seconds);
+	}
+}
+
+/**
+ * The main function.
+ * @return 0 on success, an error code otherwise.
+ */
+int main(int argc, char *argv[])
+{
+	static Fleet fleet;
+	static FleetWeights weights;
+	AdversaryConfig config = {DEFAULT_BOARD_SIZE, &fleet, NULL, DEFAULT_ITERATIONS,
+							  DEFAULT_SAMPLES, DEFAULT_ELITE, DEFAULT_SMOOTHING, DEFAULT_FLOOR,
+							  (uint64_t) time(0), (int) sysconf(_SC_NPROCESSORS_ONLN)};
+	const char *strategyName = DEFAULT_STRATEGY, *startPath = NULL;
+	const char *path = DEFAULT_WEIGHTS_PATH;
+	AdversaryStats *stats;
+	long evaluationGames = DEFAULT_EVALUATION_GAMES;
+	double uniformShots, weightedShots;
+	int option, status, fleetStatus = 1, weightsStatus;
+	fleet = *defaultFleet();
+	while ((option = getopt(argc, argv, "s:p:i:n:e:a:m:r:t:v:w:o:F:c:")) != -1)
+	{
+		switch (option)
+		{
+			case 's':
+				config.boardSize = atoi(optarg);
+				break;
+			case 'p':
+				strategyName = optarg;
+				break;
+			case 'i':
+				config.iterations = atoi(optarg);
+				break;
+			case 'n':
+				config.samples = atoi(optarg);
+				break;
+			case 'e':
+				config.elite = atof(optarg);
+				break;
+			case 'a':
+				config.smoothing = atof(optarg);
+				break;
+			case 'm':
+				config.floor = atof(optarg);
+				break;
+			case 'r':
+				config.seed = (uint64_t) strtoull(optarg, NULL, 10);
+				break;
+			case 't':
+				config.threads = atoi(optarg);
+				break;
+			case 'v':
+				evaluationGames = atol(optarg);
+				break;
+			case 'w':
+				startPath = optarg;
+				break;
+			case 'o':
+				path = optarg;
+				break;
+			case 'F':
+				fleetStatus = parseFleet(optarg, &fleet);
+				break;
+			case 'c':
+				fleetStatus = loadFleetFile(optarg, &fleet);
+				break;
+			default:
+				fprintf(stderr, USAGE_MSG, argv[0]);
+				return USAGE_ERROR;
+		}
+	}
+	config.strategy = findStrategy(strategyName);
+	if (config.strategy == NULL || config.iterations < 1 ||
+		config.iterations > MAX_ADVERSARY_ITERATIONS || config.samples < 1 ||
+		config.threads < 1 || evaluationGames < 0 || !validShare(config.elite) ||
+		!validShare(config.smoothing) || !validShare(config.floor))
+	{
+		fprintf(stderr, USAGE_MSG, argv[0]);
+		return USAGE_ERROR;
+	}
+	if (config.boardSize < MIN_BOARD_SIZE || config.boardSize > MAX_BOARD_SIZE)
+	{
+		fprintf(stderr, WRONG_BOARD_SIZE_MSG);
+		return BOARD_SIZE_ERROR;
+	}
+	if (fleetStatus != 1 || fleet.maxLength > config.boardSize ||
+		fleet.cells > config.boardSize * config.boardSize || fleet.shipsNum > WEIGHTS_MAX_SHIPS)
+	{
+		fprintf(stderr, WRONG_FLEET_MSG);
+		return FLEET_ERROR;
+	}
+	if (startPath != NULL)
+	{
+		weightsStatus = loadFleetWeights(startPath, &weights) == 1 &&
+						weights.size == config.boardSize &&
+						weights.fleet.shipsNum == fleet.shipsNum &&
+						memcmp(weights.fleet.lengths, fleet.lengths, (size_t) fleet.shipsNum) == 0;
+	}
+	else
+	{
+		weightsStatus = uniformFleetWeights(&weights, config.boardSize, &fleet) == 1;
+	}
+	if (!weightsStatus)
+	{
+		fprintf(stderr, WRONG_WEIGHTS_MSG);
+		return FLEET_ERROR;
+	}
+	stats = (AdversaryStats *) malloc(sizeof(AdversaryStats));
+	if (stats == NULL)
+	{
+		return MEMORY_ERROR;
+	}
+	status = runAdversary(&config, &weights, stats);
+	if (status == 0)
+	{
+		printSearch(&config, stats);
+		if (saveFleetWeights(path, &weights) != 1)
+		{
+			perror(path);
+			status = WEIGHTS_ERROR;
+		}
+	}
+	if (status == 0 && evaluationGames > 0)
+	{
+		status = evaluate(&config, NULL, evaluationGames, &uniformShots);
+		status = status == 0 ? evaluate(&config, &weights, evaluationGames, &weightedShots) :
+				 status;
+		if (status == 0)
+		{
+			printf("evaluation games: %ld\n", evaluationGames);
+			printf("uniform mean shots: %.2f\n", uniformShots);
+			printf("table mean shots: %.2f\n", weightedShots);
+		}
+	}
+	if (status == 0)
+	{
+		printf("table: %s\n", path);
+	}
+	free(stats);
+	return status;
+}
@@ -0,0 +1,617 @@
+/**
+ * @file battleships_bench.c
+ * @version 2.0
+ *
+ * @brief Micro and macro benchmarks of the game engine and the console, reported as JSON.
+ *
+ * @section DESCRIPTION
+ * The program times initialBoard, shipFactory, placeShip, singleTurn and printBoard on every
+ * board size from MIN_BOARD_SIZE to MAX_BOARD_SIZE, and whole games fired by a scripted shooter,
+ * one shot or one salvo a turn.
+ * Every benchmark is run for BENCH_ROUNDS rounds of the same number of operations and the
+ * fastest round is reported, as the other rounds only add the noise of the machine. The
+ * allocations are counted by wrapping the allocator at link time (see the Makefile), and the
+ * cache misses are read with perf_event_open when the kernel allows it.
+ * Input  : Command line options - a single board size (-s, all the sizes by default), the
+ *          number of rounds (-r) and the minimal time of a round in milliseconds (-m).
+ * Process: calibrating the number of operations of every benchmark and timing its rounds.
+ * Output : A JSON document on the standard output, with the nanoseconds, allocations and cache
+ *          misses per operation of every benchmark and size. The console output of the timed
+ *          functions goes to /dev/null.
+ */
+// ------------------------------ includes ------------------------------
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include "battleships_console.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def USAGE_ERROR 1
+ * @brief the integer returned if the command line options are wrong.
+ */
+#define USAGE_ERROR 1
+
+/**
+ * @def MEMORY_ERROR 2
+ * @brief the integer returned if one of the pointers is NULL .
+ */
+#define MEMORY_ERROR 2
+
+/**
+ * @def MAX_BOARD_SIZE 26
+ * @brief The maximal board size allowed in the game.
+ */
+#define MAX_BOARD_SIZE 26
+
+/**
+ * @def MIN_BOARD_SIZE 5
+ * @brief The minimal board size allowed in the game.
+ */
+#define MIN_BOARD_SIZE 5
+
+/**
+ * @def BENCH_ROUNDS 5
+ * @brief The number of timed rounds of every benchmark when -r is not given.
+ */
+#define BENCH_ROUNDS 5
+
+/**
+ * @def BENCH_ROUND_MS 20
+ * @brief The minimal time of a round in milliseconds when -m is not given.
+ */
+#define BENCH_ROUND_MS 20
+
+/**
+ * @def BENCH_SEED 2018
+ * @brief The seed of the generator placing the fleets, so every run times the same games.
+ */
+#define BENCH_SEED 2018
+
+/**
+ * @def NANOS_PER_SECOND 1e9
+ * @brief The number of nanoseconds in a second.
+ */
+#define NANOS_PER_SECOND 1e9
+
+/**
+ * @def USAGE_MSG
+ * @brief The message printed when the command line options are wrong.
+ */
+#define USAGE_MSG "usage: %s [-s board size] [-r rounds] [-m round milliseconds]\n"
+
+// ------------------------------ structs ----------------------------
+
+/**
+ * a structure holding the state shared by the operations of a benchmark. includes the following
+ * attributes:
+ * size - the board size.
+ * fleet - the fleet placed on the board.
+ * rng - the random numbers generator placing the ships.
+ * board - a board of the size.
+ * ships - the ships placed on the board.
+ * deadShips - the number of sunk ships on the board.
+ * next - the next ship to place or the next cell of the script to shoot.
+ * script - every cell of the board once, in a random order, as row * size + col.
+ * shots - the number of shots fired by the whole game benchmark.
+ */
+typedef struct BenchContext
+{
+	int size;
+	const Fleet *fleet;
+	Rng rng;
+	Board *board;
+	Ship ships[SHIPS_NUM];
+	int deadShips;
+	int next;
+	int script[MAX_BOARD_SIZE * MAX_BOARD_SIZE];
+	long shots;
+} BenchContext;
+
+/**
+ * a structure describing a benchmark. includes the following attributes:
+ * name - the name reported.
+ * prepare - prepares the context before the rounds, NULL if not needed.
+ * op - runs a single operation.
+ */
+typedef struct Benchmark
+{
+	const char *name;
+	void (*prepare)(BenchContext *context);
+	void (*op)(BenchContext *context);
+} Benchmark;
+
+/**
+ * a structure holding the measures of the fastest round of a benchmark. includes the following
+ * attributes:
+ * ops - the number of operations of every round.
+ * nanos - the time of the round in nanoseconds.
+ * allocations - the number of allocations in the round.
+ * misses - the number of cache misses in the round, -1 if they could not be counted.
+ */
+typedef struct BenchResult
+{
+	long ops;
+	double nanos;
+	long allocations;
+	long misses;
+} BenchResult;
+
+// ------------------------------ globals ----------------------------
+
+/**
+ * The number of allocations made through the wrapped allocator.
+ */
+static long gAllocations = 0;
+
+/**
+ * The cache misses counter, -1 if perf_event_open is not available.
+ */
+static int gMissesFd = -1;
+
+// ------------------------------ functions ----------------------------
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t count, size_t size);
+void *__real_realloc(void *pointer, size_t size);
+void *__real_aligned_alloc(size_t alignment, size_t size);
+
+/**
+ * @brief Counts an allocation of the benchmarked code, linked with -Wl,--wrap=malloc.
+ * @param size The number of bytes.
+ * @return The memory, as returned by malloc.
+ */
+void *__wrap_malloc(size_t size)
+{
+	gAllocations++;
+	return __real_malloc(size);
+}
+
+/**
+ * @brief Counts an allocation of the benchmarked code, linked with -Wl,--wrap=calloc.
+ * @param count The number of elements.
+ * @param size The size of an element.
+ * @return The memory, as returned by calloc.
+ */
+void *__wrap_calloc(size_t count, size_t size)
+{
+	gAllocations++;
+	return __real_calloc(count, size);
+}
+
+/**
+ * @brief Counts an allocation of the benchmarked code, linked with -Wl,--wrap=realloc.
+ * @param pointer The memory to resize.
+ * @param size The new number of bytes.
+ * @return The memory, as returned by realloc.
+ */
+void *__wrap_realloc(void *pointer, size_t size)
+{
+	gAllocations++;
+	return __real_realloc(pointer, size);
+}
+
+/**
+ * @brief Counts an allocation of the benchmarked code, linked with -Wl,--wrap=aligned_alloc.
+ * @param alignment The alignment.
+ * @param size The number of bytes.
+ * @return The memory, as returned by aligned_alloc.
+ */
+void *__wrap_aligned_alloc(size_t alignment, size_t size)
+{
+	gAllocations++;
+	return __real_aligned_alloc(alignment, size);
+}
+
+/**
+ * @brief Opens a counter of the cache misses of this process, in user space only.
+ * @return The counter file descriptor, -1 if the kernel does not allow it.
+ */
+static int openMissesCounter(void)
+{
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.size = sizeof(attr);
+	attr.config = PERF_COUNT_HW_CACHE_MISSES;
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+/**
+ * @brief Reads the cache misses counter.
+ * @return The number of cache misses so far, -1 if they are not counted.
+ */
+static long readMisses(void)
+{
+	long long count;
+	if (gMissesFd < 0 || read(gMissesFd, &count, sizeof(count)) != (ssize_t) sizeof(count))
+	{
+		return -1;
+	}
+	return (long) count;
+}
+
+/**
+ * @brief Reads the monotonic clock.
+ * @return The time in nanoseconds.
+ */
+static double nowNanos(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double) now.tv_sec * NANOS_PER_SECOND + (double) now.tv_nsec;
+}
+
+/**
+ * @brief Shuffles the cells of the board into the shooting script.
+ * @param context The context.
+ */
+static void shuffleScript(BenchContext *context)
+{
+	int i, j, cell, cells = context->size * context->size;
+	for (i = 0; i < cells; i++)
+	{
+		context->script[i] = i;
+	}
+	for (i = cells - 1; i > 0; i--)
+	{
+		j = (int) rngBelow(&context->rng, (uint32_t) i + 1);
+		cell = context->script[i];
+		context->script[i] = context->script[j];
+		context->script[j] = cell;
+	}
+}
+
+/**
+ * @brief Clears the board and places the fleet on it, with all the ships afloat and no shots.
+ * @param context The context.
+ */
+static void placeBoard(BenchContext *context)
+{
+	bbClear(&context->board->shots);
+	bbClear(&context->board->hits);
+	placeFleet(context->board, context->ships, context->fleet, &context->rng);
+	context->deadShips = 0;
+	context->next = 0;
+}
+
+/**
+ * @brief Creates a board and frees it.
+ * @param context The context.
+ */
+static void opInitialBoard(BenchContext *context)
+{
+	free(initialBoard(context->size));
+}
+
+/**
+ * @brief Places the default fleet on the board and frees the ships array.
+ * @param context The context.
+ */
+static void opShipFactory(BenchContext *context)
+{
+	free(shipFactory(context->board, &context->rng));
+}
+
+/**
+ * @brief Starts the placement benchmark with an empty board.
+ * @param context The context.
+ */
+static void prepareShips(BenchContext *context)
+{
+	context->next = context->fleet->shipsNum;
+}
+
+/**
+ * @brief Places the next ship of the fleet, clearing the board after the last ship.
+ * @param context The context.
+ */
+static void opPlaceShip(BenchContext *context)
+{
+	Ship ship;
+	if (context->next == context->fleet->shipsNum)
+	{
+		bbClear(&context->board->ships);
+		context->next = 0;
+	}
+	ship.length = context->fleet->lengths[context->next];
+	ship.lives = ship.length;
+	if (placeShip(&ship, context->next, context->board, &context->rng) == 1)
+	{
+		context->next++;
+	}
+	else
+	{
+		context->next = context->fleet->shipsNum;
+	}
+}
+
+/**
+ * @brief Plays the next turn of the script with its message and board, placing a new fleet
+ * once every cell was shot.
+ * @param context The context.
+ */
+static void opSingleTurn(BenchContext *context)
+{
+	int cell;
+	if (context->next == context->size * context->size)
+	{
+		placeBoard(context);
+	}
+	cell = context->script[context->next++];
+	context->deadShips = singleTurn(cell / context->size, cell % context->size, context->board,
+									context->ships, context->deadShips);
+}
+
+/**
+ * @brief Shoots half of the board, so the frames hold both kinds of shots.
+ * @param context The context.
+ */
+static void prepareFrame(BenchContext *context)
+{
+	int i, cell;
+	placeBoard(context);
+	for (i = 0; i < context->size * context->size / 2; i++)
+	{
+		cell = context->script[i];
+		shoot(cell / context->size, cell % context->size, context->board, context->ships);
+	}
+}
+
+/**
+ * @brief Prints the board.
+ * @param context The context.
+ */
+static void opPrintBoard(BenchContext *context)
+{
+	printBoard(context->board);
+}
+
+/**
+ * @brief Plays a whole game as the console does: a new game block, a new fleet and the shots
+ * of the script until every ship is sunk.
+ * @param context The context.
+ */
+static void opGame(BenchContext *context)
+{
+	Game *game = newGame(context->size, context->fleet);
+	int i, cell;
+	if (game == NULL || resetGame(game, &context->rng) != 1)
+	{
+		freeGame(game);
+		return;
+	}
+	for (i = 0; game->deadShips < game->shipsNum; i++)
+	{
+		cell = context->script[i];
+		fireShot(game, cell / context->size, cell % context->size);
+	}
+	context->shots += i;
+	freeGame(game);
+}
+
+/**
+ * @brief Plays a whole salvo game as the console does: a new game block, a new fleet and salvos
+ * of the next cells of the script, one for every ship afloat, until every ship is sunk.
+ * @param context The context.
+ */
+static void opSalvoGame(BenchContext *context)
+{
+	Game *game = newGame(context->size, context->fleet);
+	Shot shots[SHIPS_NUM];
+	SalvoResult salvo;
+	int i, j, count, cell;
+	if (game == NULL || resetGame(game, &context->rng) != 1)
+	{
+		freeGame(game);
+		return;
+	}
+	for (i = 0; game->deadShips < game->shipsNum; i += count)
+	{
+		count = game->shipsNum - game->deadShips;
+		for (j = 0; j < count; j++)
+		{
+			cell = context->script[i + j];
+			shots[j].row = cell / context->size;
+			shots[j].col = cell % context->size;
+		}
+		fireSalvo(game, shots, count, &salvo);
+	}
+	context->shots += i;
+	freeGame(game);
+}
+
+/**
+ * The benchmarks, in the order they are reported.
+ */
+static const Benchmark BENCHMARKS[] = {
+		{"initialBoard", NULL, opInitialBoard},
+		{"shipFactory", NULL, opShipFactory},
+		{"placeShip", prepareShips, opPlaceShip},
+		{"singleTurn", placeBoard, opSingleTurn},
+		{"printBoard", prepareFrame, opPrintBoard},
+		{"game", NULL, opGame},
+		{"salvoGame", NULL, opSalvoGame}};
+
+/**
+ * @brief Runs a single round of a benchmark.
+ * @param benchmark The benchmark.
+ * @param context The context.
+ * @param ops The number of operations.
+ * @param result Filled with the measures of the round.
+ */
+static void runRound(const Benchmark *benchmark, BenchContext *context, long ops,
+					 BenchResult *result)
+{
+	long i, allocations = gAllocations, misses;
+	double start;
+	if (gMissesFd >= 0)
+	{
+		ioctl(gMissesFd, PERF_EVENT_IOC_RESET, 0);
+		ioctl(gMissesFd, PERF_EVENT_IOC_ENABLE, 0);
+	}
+	start = nowNanos();
+	for (i = 0; i < ops; i++)
+	{
+		benchmark->op(context);
+	}
+	result->nanos = nowNanos() - start;
+	if (gMissesFd >= 0)
+	{
+		ioctl(gMissesFd, PERF_EVENT_IOC_DISABLE, 0);
+	}
+	misses = readMisses();
+	result->ops = ops;
+	result->allocations = gAllocations - allocations;
+	result->misses = misses;
+}
+
+/**
+ * @brief Times a benchmark: doubles the number of operations until a round takes the minimal
+ * time, then keeps the fastest of the timed rounds.
+ * @param benchmark The benchmark.
+ * @param context The context.
+ * @param rounds The number of timed rounds.
+ * @param roundNanos The minimal time of a round.
+ * @param best Filled with the measures of the fastest round.
+ */
+static void runBenchmark(const Benchmark *benchmark, BenchContext *context, int rounds,
+						 double roundNanos, BenchResult *best)
+{
+	BenchResult round;
+	long ops = 1;
+	int i;
+	if (benchmark->prepare != NULL)
+	{
+		benchmark->prepare(context);
+	}
+	runRound(benchmark, context, ops, &round);
+	while (round.nanos < roundNanos)
+	{
+		ops *= 2;
+		runRound(benchmark, context, ops, &round);
+	}
+	context->shots = 0;
+	for (i = 0; i < rounds; i++)
+	{
+		runRound(benchmark, context, ops, &round);
+		if (i == 0 || round.nanos < best->nanos)
+		{
+			*best = round;
+		}
+	}
+}
+
+/**
+ * @brief Prints the measures of a benchmark as a JSON object.
+ * @param out The JSON output.
+ * @param name The benchmark name.
+ * @param context The context, after the benchmark.
+ * @param result The measures.
+ * @param rounds The number of timed rounds.
+ * @param first Non zero for the first object of the results array.
+ */
+static void printResult(FILE *out, const char *name, const BenchContext *context,
+						const BenchResult *result, int rounds, int first)
+{
+	double ops = (double) result->ops;
+	fprintf(out, "%s\n    {\"name\": \"%s\", \"size\": %d, \"ops\": %ld, \"ns_per_op\": %.2f, "
+				 "\"allocs_per_op\": %.3f, \"cache_misses_per_op\": ", first ? "" : ",", name,
+			context->size, result->ops, result->nanos / ops, (double) result->allocations / ops);
+	if (result->misses >= 0)
+	{
+		fprintf(out, "%.3f", (double) result->misses / ops);
+	}
+	else
+	{
+		fprintf(out, "null");
+	}
+	if (context->shots > 0)
+	{
+		fprintf(out, ", \"shots_per_game\": %.2f, \"games_per_second\": %.0f",
+				(double) context->shots / (ops * rounds), ops * NANOS_PER_SECOND / result->nanos);
+	}
+	fprintf(out, "}");
+}
+
+/**
+ * The main function.
+ * @return 0 on success, an error code otherwise.
+ */
+int main(int argc, char *argv[])
+{
+	static BenchContext context;
+	BenchResult result;
+	FILE *out;
+	int option, size, i, first = 1, minSize = MIN_BOARD_SIZE, maxSize = MAX_BOARD_SIZE;
+	int rounds = BENCH_ROUNDS, roundMs = BENCH_ROUND_MS, console;
+	while ((option = getopt(argc, argv, "s:r:m:")) != -1)
+	{
+		switch (option)
+		{
+			case 's':
+				minSize = maxSize = atoi(optarg);
+				break;
+			case 'r':
+				rounds = atoi(optarg);
+				break;
+			case 'm':
+				roundMs = atoi(optarg);
+				break;
+			default:
+				fprintf(stderr, USAGE_MSG, argv[0]);
+				return USAGE_ERROR;
+		}
+	}
+	if (minSize < MIN_BOARD_SIZE || maxSize > MAX_BOARD_SIZE || rounds < 1 || roundMs < 1)
+	{
+		fprintf(stderr, USAGE_MSG, argv[0]);
+		return USAGE_ERROR;
+	}
+	out = fdopen(dup(STDOUT_FILENO), "w");
+	console = open("/dev/null", O_WRONLY);
+	if (out == NULL || console < 0)
+	{
+		perror("stdout");
+		return MEMORY_ERROR;
+	}
+	dup2(console, STDOUT_FILENO);
+	close(console);
+	gMissesFd = openMissesCounter();
+	rngSeed(&context.rng, BENCH_SEED, 0);
+	context.fleet = defaultFleet();
+	fprintf(out, "{\n  \"benchmark\": \"battleships\",\n  \"rounds\": %d,\n  \"round_ms\": %d,\n"
+				 "  \"cache_misses\": %s,\n  \"results\": [", rounds, roundMs,
+			gMissesFd >= 0 ? "true" : "false");
+	for (size = minSize; size <= maxSize; size++)
+	{
+		context.size = size;
+		context.board = initialBoard(size);
+		if (context.board == NULL)
+		{
+			return MEMORY_ERROR;
+		}
+		shuffleScript(&context);
+		for (i = 0; i < (int) (sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0])); i++)
+		{
+			runBenchmark(&BENCHMARKS[i], &context, rounds, roundMs * 1e6, &result);
+			fflush(stdout);
+			printResult(out, BENCHMARKS[i].name, &context, &result, rounds, first);
+			first = 0;
+		}
+		free(context.board);
+	}
+	fprintf(out, "\n  ]\n}\n");
+	fclose(out);
+	return 0;
+}
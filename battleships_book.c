@@ -0,0 +1,260 @@
+/**
+ * @file battleships_book.c
+ * @version 2.0
+ *
+ * @brief Computes the opening book of the book shooter (see book.h) offline.
+ *
+ * @section DESCRIPTION
+ * The program walks the tree of the miss and hit results of the first shots of the density
+ * shooter, for every board size from 5 to 26 and every standard fleet that fits the board, and
+ * writes the shot of every node to a book file.
+ * Input  : Command line options - the book path (-o, DEFAULT_BOOK_PATH by default) and the number
+ *          of shots of every tree (-d). The fleet is described with -F (e.g. "5,4x2,3") or read
+ *          from a config file with -c (see fleet.h), replacing the standard fleets: the classic
+ *          "5,4,3,3,2" and "4,3x2,2x3,1x4".
+ * Process: replaying the density shooter along every branch of every tree.
+ * Output : The book file, and the number of trees and nodes written.
+ */
+// ------------------------------ includes ------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "strategies.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def USAGE_ERROR 1
+ * @brief the integer returned if the command line options are wrong.
+ */
+#define USAGE_ERROR 1
+
+/**
+ * @def MEMORY_ERROR 2
+ * @brief the integer returned if one of the pointers is NULL .
+ */
+#define MEMORY_ERROR 2
+
+/**
+ * @def FLEET_ERROR 5
+ * @brief the integer returned if the fleet description is wrong.
+ */
+#define FLEET_ERROR 5
+
+/**
+ * @def WRONG_FLEET_MSG "You've entered a wrong fleet."
+ * @brief the message printed to the screen when the fleet is wrong.
+ */
+#define WRONG_FLEET_MSG "You've entered a wrong fleet."
+
+/**
+ * @def MAX_BOARD_SIZE 26
+ * @brief The maximal board size allowed in the game.
+ */
+#define MAX_BOARD_SIZE 26
+
+/**
+ * @def MIN_BOARD_SIZE 5
+ * @brief The minimal board size allowed in the game.
+ */
+#define MIN_BOARD_SIZE 5
+
+/**
+ * @def DEFAULT_DEPTH 12
+ * @brief The number of shots of every tree when -d is not given.
+ */
+#define DEFAULT_DEPTH 12
+
+/**
+ * @def STANDARD_FLEETS
+ * @brief The fleets of the book when -F and -c are not given.
+ */
+#define STANDARD_FLEETS {"5,4,3,3,2", "4,3x2,2x3,1x4"}
+
+/**
+ * @def MAX_FLEETS 2
+ * @brief The number of standard fleets.
+ */
+#define MAX_FLEETS 2
+
+/**
+ * @def MAX_ENTRIES 44
+ * @brief The maximal number of trees of a book.
+ */
+#define MAX_ENTRIES ((MAX_BOARD_SIZE - MIN_BOARD_SIZE + 1) * MAX_FLEETS)
+
+/**
+ * @def USAGE_MSG
+ * @brief The message printed when the command line options are wrong.
+ */
+#define USAGE_MSG "usage: %s [-o book] [-d shots] [-F fleet | -c fleet file]\n"
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Fills the subtree of a node: the shot of the shooter, and the subtrees of the shooter
+ * learning a miss and a hit there.
+ * @param shooters The shooter at every level, the one of the node set.
+ * @param level The level of the node.
+ * @param depth The number of levels of the tree.
+ * @param node The node index.
+ * @param nodes The tree nodes, all BOOK_NO_SHOT.
+ */
+void fillTree(Shooter *shooters, int level, int depth, int node, uint16_t *nodes)
+{
+	int row, col;
+	if (bestDensityShot(&shooters[level], &row, &col) == 0)
+	{
+		return;
+	}
+	nodes[node] = (uint16_t) (row * BITBOARD_ROW_BITS + col);
+	if (level + 1 == depth)
+	{
+		return;
+	}
+	shooters[level + 1] = shooters[level];
+	shooterObserve(&shooters[level + 1], row, col, SHOT_MISS, 0);
+	fillTree(shooters, level + 1, depth, 2 * node + 1, nodes);
+	shooters[level + 1] = shooters[level];
+	shooterObserve(&shooters[level + 1], row, col, SHOT_HIT, 0);
+	fillTree(shooters, level + 1, depth, 2 * node + 2, nodes);
+}
+
+/**
+ * @brief Writes a book file.
+ * @param path The file path.
+ * @param entries The entries directory, with the offsets set.
+ * @param count The number of trees.
+ * @param trees The nodes of all the trees, one after the other.
+ * @param nodes The total number of nodes.
+ * @return 0 on success, BOOK_ERROR if the file could not be written.
+ */
+int writeBook(const char *path, const BookEntry *entries, int count, const uint16_t *trees,
+			  size_t nodes)
+{
+	BookHeader header = {BOOK_MAGIC, BOOK_VERSION, (uint32_t) count, 0};
+	FILE *file = fopen(path, "wb");
+	int status = 0;
+	if (file == NULL)
+	{
+		return BOOK_ERROR;
+	}
+	if (fwrite(&header, sizeof(header), 1, file) != 1 ||
+		fwrite(entries, sizeof(BookEntry), (size_t) count, file) != (size_t) count ||
+		fwrite(trees, sizeof(uint16_t), nodes, file) != nodes)
+	{
+		status = BOOK_ERROR;
+	}
+	if (fclose(file) != 0)
+	{
+		status = BOOK_ERROR;
+	}
+	return status;
+}
+
+/**
+ * The main function.
+ * @return 0 on success, an error code otherwise.
+ */
+int main(int argc, char *argv[])
+{
+	static const char *standard[MAX_FLEETS] = STANDARD_FLEETS;
+	static Fleet fleets[MAX_FLEETS];
+	static BookEntry entries[MAX_ENTRIES];
+	const char *path = DEFAULT_BOOK_PATH;
+	int option, i, size, counts[MAX_FLEET_LENGTH + 1], fleetsNum = MAX_FLEETS, count = 0;
+	int status = 0, depth = DEFAULT_DEPTH, treeNodes;
+	size_t offset;
+	uint16_t *trees;
+	Shooter *shooters;
+	Rng rng;
+	for (i = 0; i < MAX_FLEETS; i++)
+	{
+		parseFleet(standard[i], &fleets[i]);
+	}
+	while ((option = getopt(argc, argv, "o:d:F:c:")) != -1)
+	{
+		switch (option)
+		{
+			case 'o':
+				path = optarg;
+				break;
+			case 'd':
+				depth = atoi(optarg);
+				break;
+			case 'F':
+				fleetsNum = 1;
+				status = parseFleet(optarg, &fleets[0]) == 1 ? 0 : FLEET_ERROR;
+				break;
+			case 'c':
+				fleetsNum = 1;
+				status = loadFleetFile(optarg, &fleets[0]) == 1 ? 0 : FLEET_ERROR;
+				break;
+			default:
+				fprintf(stderr, USAGE_MSG, argv[0]);
+				return USAGE_ERROR;
+		}
+	}
+	if (depth < 1 || depth > BOOK_MAX_DEPTH)
+	{
+		fprintf(stderr, USAGE_MSG, argv[0]);
+		return USAGE_ERROR;
+	}
+	if (status != 0)
+	{
+		fprintf(stderr, WRONG_FLEET_MSG);
+		return FLEET_ERROR;
+	}
+	treeNodes = (1 << depth) - 1;
+	trees = (uint16_t *) malloc((size_t) MAX_ENTRIES * treeNodes * sizeof(uint16_t));
+	shooters = (Shooter *) malloc((size_t) depth * sizeof(Shooter));
+	if (trees == NULL || shooters == NULL)
+	{
+		free(trees);
+		free(shooters);
+		return MEMORY_ERROR;
+	}
+	memset(trees, 0xff, (size_t) MAX_ENTRIES * treeNodes * sizeof(uint16_t));
+	rngSeed(&rng, 0, 0);
+	offset = sizeof(BookHeader);
+	for (i = 0; i < fleetsNum; i++)
+	{
+		for (size = MIN_BOARD_SIZE; size <= MAX_BOARD_SIZE; size++)
+		{
+			if (fleets[i].maxLength > size || fleets[i].cells > size * size)
+			{
+				continue;
+			}
+			shooterReset(&shooters[0], findStrategy("density"), size, &fleets[i], &rng);
+			fillTree(shooters, 0, depth, 0, trees + (size_t) count * treeNodes);
+			fleetCounts(&fleets[i], counts);
+			entries[count].fleetKey = bookFleetKey(counts, fleets[i].maxLength);
+			entries[count].size = (uint8_t) size;
+			entries[count].depth = (uint8_t) depth;
+			entries[count].reserved = 0;
+			count++;
+		}
+	}
+	offset += (size_t) count * sizeof(BookEntry);
+	for (i = 0; i < count; i++)
+	{
+		entries[i].offset = (uint32_t) (offset + (size_t) i * treeNodes * sizeof(uint16_t));
+	}
+	status = writeBook(path, entries, count, trees, (size_t) count * treeNodes);
+	if (status != 0)
+	{
+		perror(path);
+	}
+	else
+	{
+		printf("book: %s\n", path);
+		printf("trees: %d\n", count);
+		printf("shots per tree: %d\n", depth);
+		printf("nodes: %ld\n", (long) count * treeNodes);
+		printf("bytes: %zu\n", offset + (size_t) count * treeNodes * sizeof(uint16_t));
+	}
+	free(trees);
+	free(shooters);
+	return status;
+}
@@ -0,0 +1,192 @@
+/**
+ * @file battleships_console.c
+ * @version 2.0
+ *
+ * @brief The console front end of the game engine.
+ *
+ * @section DESCRIPTION
+ * Every move is applied with the engine shoot function and its result code is turned into the
+ * message printed to the player, followed by the board.
+ */
+// ------------------------------ includes ------------------------------
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "battleships_console.h"
+#include "move_reader.h"
+#include "renderer.h"
+#include "shot_messages.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def SALVO_MESSAGE "Salvo: %d hit, %d missed.\n"
+ * @brief the message printed to the screen after a salvo, with its number of hits and misses.
+ */
+#define SALVO_MESSAGE "Salvo: %d hit, %d missed.\n"
+
+/**
+ * @def SALVO_SUNK_MESSAGE "Hit and sunk:"
+ * @brief the start of the line printed once after a salvo that sunk ships, followed by the
+ * length of every sunk ship.
+ */
+#define SALVO_SUNK_MESSAGE "Hit and sunk:"
+
+/**
+ * @def WRONG_SALVO_MESSAGE "A salvo is one shot for every ship afloat, try again\n"
+ * @brief the message printed to the screen when a salvo does not have the right number of shots.
+ */
+#define WRONG_SALVO_MESSAGE "A salvo is one shot for every ship afloat, try again\n"
+
+// ------------------------------ globals ----------------------------
+
+/**
+ * The renderer drawing the board after every turn, NULL to print a full frame every time.
+ */
+static Renderer *boardRenderer = NULL;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief The function sets the renderer drawing the board after every turn.
+ * @param renderer The renderer, NULL to print a full frame every time.
+ */
+void setBoardRenderer(Renderer *renderer)
+{
+	boardRenderer = renderer;
+}
+
+/**
+ * @brief The function receives a pointer to the board and print the player's view of it.
+ * The whole frame is built in a buffer and written at once.
+ * @param board The board to print.
+ * */
+void printBoard(const Board *board)
+{
+	char frame[FRAME_MAX_LENGTH];
+	size_t length;
+	if (boardRenderer != NULL)
+	{
+		renderBoard(boardRenderer, board, STDOUT_FILENO);
+		return;
+	}
+	length = formatFrame(frame, board);
+	fwrite(frame, 1, length, stdout);
+}
+
+/**
+ * @brief The function reads a row coordinate typed by the player. A row is either letters, as
+ * printed on the board and going on past 'z' like spreadsheet columns ('aa' follows 'z'), or a
+ * number counting from 1, for boards with more rows than letters.
+ * @param text The row coordinate.
+ * @return The row index, -1 if the text is not a row coordinate.
+ */
+int parseRow(const char *text)
+{
+	return scanRow(text, strlen(text));
+}
+
+/**
+ * @brief The function prints the message matching a shot result.
+ * @param result The shot result, as returned by shoot.
+ */
+void printShotResult(int result)
+{
+	fputs(shotMessage(result), stdout);
+}
+
+/**
+ * The function handles a case when the user hit a ship on the board. The function updates the
+ * hit ship lives and if the ship is dead it will print the correct message and update the counter
+ * of the dead ships in the game.
+ * @param row The row received from the user.
+ * @param col The column received from the user.
+ * @param board The game board.
+ * @param ships An array holding all the ships participating in the game.
+ * @param deadShips The counter counting the number of dead ships in the game.
+ * @return The updated number of dead ships in the game according to the last turn.
+ */
+int hit(int row, int col, Board *board, Ship *ships, int deadShips)
+{
+	int result = shoot(row, col, board, ships);
+	printShotResult(result);
+	return deadShips + SHOT_IS_SUNK(result);
+}
+
+/**
+ * The function run a whole single turn in the game, receiving the user move.
+ * @param row The row received from the user.
+ * @param col The column received from the user.
+ * @param board The game board, it holds the ships and all the user shots, which are printed as
+ * miss ('o') and hit('x').
+ * @param ships An array holding all the ships participating in the game.
+ * @param deadShips The counter counting the number of dead ships in the game.
+ * @return The updated number of dead ships in the game according to the last turn.
+ */
+int singleTurn(int row, int col, Board *board, Ship *ships, int deadShips)
+{
+	int result = shoot(row, col, board, ships);
+	printShotResult(result);
+	if (result == SHOT_INVALID)
+	{
+		return deadShips;
+	}
+	printBoard(board);
+	return deadShips + SHOT_IS_SUNK(result);
+}
+
+/**
+ * The function runs a whole single turn of a game: it fires the player's shot, prints the
+ * matching message and, unless the move is invalid, the board.
+ * @param game The game.
+ * @param row The row received from the user.
+ * @param col The column received from the user.
+ * @return The shot result, as returned by fireShot.
+ */
+int playTurn(Game *game, int row, int col)
+{
+	int result = fireShot(game, row, col);
+	printShotResult(result);
+	if (result != SHOT_INVALID)
+	{
+		printBoard(&game->board);
+	}
+	return result;
+}
+
+/**
+ * The function runs a whole salvo turn of a game: it fires the salvo as a single move, prints a
+ * single line with its hits and misses, a single line with the ships it sunk, and the board. A
+ * rejected salvo prints the matching message and fires nothing.
+ * @param game The game.
+ * @param shots The salvo, one shot for every ship afloat.
+ * @param count The number of shots.
+ * @return The salvo status, as returned by fireSalvo.
+ */
+int playSalvo(Game *game, const Shot *shots, int count)
+{
+	SalvoResult salvo;
+	int i, status = fireSalvo(game, shots, count, &salvo);
+	if (status == SALVO_WRONG_COUNT)
+	{
+		printf(WRONG_SALVO_MESSAGE);
+		return status;
+	}
+	if (status != SALVO_FIRED)
+	{
+		printShotResult(status);
+		return status;
+	}
+	printf(SALVO_MESSAGE, salvo.hitsNum, count - salvo.hitsNum);
+	if (salvo.sunkNum > 0)
+	{
+		printf(SALVO_SUNK_MESSAGE);
+		for (i = 0; i < salvo.sunkNum; i++)
+		{
+			printf("%s %d", i > 0 ? "," : "", game->ships.length[salvo.sunk[i]]);
+		}
+		printf("\n");
+	}
+	printBoard(&game->board);
+	return status;
+}
@@ -0,0 +1,99 @@
+/**
+ * @file battleships_console.h
+ * @version 2.0
+ *
+ * @brief The console front end of the game engine.
+ *
+ * @section DESCRIPTION
+ * The functions here print the messages and the board for the player, on top of the engine in
+ * battleships.h which never writes to the screen.
+ */
+#ifndef BATTLESHIPS_CONSOLE_H_
+#define BATTLESHIPS_CONSOLE_H_
+
+// ------------------------------ includes ------------------------------
+#include "battleships.h"
+
+// ------------------------------ structs ----------------------------
+
+/**
+ * a structure drawing the board to the terminal (see renderer.h).
+ */
+typedef struct Renderer Renderer;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief The function sets the renderer drawing the board after every turn.
+ * @param renderer the renderer, NULL to print a full frame every time.
+ */
+void setBoardRenderer(Renderer *renderer);
+
+/**
+ * @brief The function receives a pointer to the board and print the player's view of it.
+ * The whole frame is built in a buffer and written at once.
+ * @param board the board to print.
+ * */
+void printBoard(const Board *board);
+
+/**
+ * @brief The function reads a row coordinate typed by the player. A row is either letters, as
+ * printed on the board and going on past 'z' like spreadsheet columns ('aa' follows 'z'), or a
+ * number counting from 1, for boards with more rows than letters.
+ * @param text The row coordinate.
+ * @return The row index, -1 if the text is not a row coordinate.
+ */
+int parseRow(const char *text);
+
+/**
+ * @brief The function prints the message matching a shot result.
+ * @param result The shot result, as returned by shoot.
+ */
+void printShotResult(int result);
+
+/**
+ * The function handles a case when the user hit a ship on the board. The function updates the
+ * hit ship lives and if the ship is dead it will print the correct message and update the counter
+ * of the dead ships in the game.
+ * @param row The row received from the user.
+ * @param col The column received from the user.
+ * @param board The game board.
+ * @param ships An array holding all the ships participating in the game.
+ * @param deadShips The counter counting the number of dead ships in the game.
+ * @return The updated number of dead ships in the game according to the last turn.
+ */
+int hit(int row, int col, Board *board, Ship *ships, int deadShips);
+
+/**
+ * The function run a whole single turn in the game, receiving the user move, and validates it.
+ * @param row The row received from the user.
+ * @param col The column received from the user.
+ * @param board The game board.
+ * @param ships An array holding all the ships participating in the game.
+ * @param deadShips The counter counting the number of dead ships in the game.
+ * @return The updated number of dead ships in the game according to the last turn.
+ */
+int singleTurn(int row, int col, Board *board, Ship *ships, int deadShips);
+
+/**
+ * The function runs a whole single turn of a game: it fires the player's shot, prints the
+ * matching message and, unless the move is invalid, the board.
+ * @param game The game.
+ * @param row The row received from the user.
+ * @param col The column received from the user.
+ * @return The shot result, as returned by fireShot.
+ */
+int playTurn(Game *game, int row, int col);
+
+/**
+ * The function runs a whole salvo turn of a game: it fires the salvo as a single move, prints a
+ * single line with its hits and misses, a single line with the ships it sunk, and the board. A
+ * rejected salvo prints the matching message and fires nothing.
+ * @param game The game.
+ * @param shots The salvo, one shot for every ship afloat.
+ * @param count The number of shots.
+ * @return The salvo status, as returned by fireSalvo.
+ */
+int playSalvo(Game *game, const Shot *shots, int count);
+
+#endif /* BATTLESHIPS_CONSOLE_H_ */
@@ -0,0 +1,243 @@
+/**
+ * @file battleships_density.c
+ * @version 2.0
+ *
+ * @brief Check of the density tracker against the bit sliced count of the whole board.
+ *
+ * @section DESCRIPTION
+ * The density shooter follows the placements with a tracker, updated after every shot. The bit
+ * sliced count (densityCount) recounts the whole board from the misses alone and is kept as its
+ * reference. The program plays random shot sequences on random board sizes and, after every
+ * shot, checks that the tracker density of every cell equals the recount, and that the tracker
+ * chooses the same cell and value as densityBest, in hunt mode and in target mode.
+ * Input  : Command line options - the number of games (-n) and the master random seed (-r).
+ * Process: playing the games and comparing the tracker with the recount after every shot.
+ * Output : The number of games and shots checked and the number of shots after which the
+ *          tracker differs. The program fails if any does.
+ */
+// ------------------------------ includes ------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "battleships.h"
+#include "density.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def USAGE_ERROR 1
+ * @brief the integer returned if the command line options are wrong.
+ */
+#define USAGE_ERROR 1
+
+/**
+ * @def MEMORY_ERROR 2
+ * @brief the integer returned if one of the pointers is NULL .
+ */
+#define MEMORY_ERROR 2
+
+/**
+ * @def MISMATCH_ERROR 7
+ * @brief the integer returned if the tracker differs from the recount.
+ */
+#define MISMATCH_ERROR 7
+
+/**
+ * @def  TRUE 1
+ * @brief a true boolean value.
+ */
+#define TRUE 1
+
+/**
+ * @def MIN_BOARD_SIZE 5
+ * @brief The minimal board size allowed in the game.
+ */
+#define MIN_BOARD_SIZE 5
+
+/**
+ * @def DEFAULT_GAMES 200
+ * @brief The number of games when -n is not given.
+ */
+#define DEFAULT_GAMES 200
+
+/**
+ * @def DEFAULT_SEED 2018
+ * @brief The master seed when -r is not given.
+ */
+#define DEFAULT_SEED 2018
+
+/**
+ * @def USAGE_MSG
+ * @brief The message printed when the command line options are wrong.
+ */
+#define USAGE_MSG "usage: %s [-n games] [-r seed]\n"
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Collects the cells of a game a shooter knows of: the misses, the hits of ships still
+ * afloat and the cells not shot yet.
+ * @param game The game.
+ * @param misses Filled with the missed cells.
+ * @param open Filled with the hit cells of the ships afloat.
+ * @param unshot Filled with the cells not shot yet.
+ */
+static void knownCells(const Game *game, Bitboard *misses, Bitboard *open, Bitboard *unshot)
+{
+	const Board *board = &game->board;
+	int i, row, col;
+	for (i = 0; i < BITBOARD_WORDS; i++)
+	{
+		misses->words[i] = board->shots.words[i] & ~board->hits.words[i];
+		unshot->words[i] = ~board->shots.words[i];
+	}
+	bbClear(open);
+	for (row = 0; row < board->size; row++)
+	{
+		for (col = 0; col < board->size; col++)
+		{
+			if (bbTest(&board->hits, row, col) &&
+				game->ships.lives[board->shipIds[row][col]] > 0)
+			{
+				bbSet(open, row, col);
+			}
+		}
+	}
+}
+
+/**
+ * @brief Checks the tracker of a game against the recount of its board.
+ * @param game The game.
+ * @param tracker The tracker, updated with every shot of the game.
+ * @param remaining The number of ships afloat for every length.
+ * @return Non zero if the tracker and the recount agree.
+ */
+static int sameDensity(const Game *game, const DensityTracker *tracker, const int remaining[])
+{
+	Bitboard misses, open, unshot;
+	DensityMap map;
+	int row, col, size = game->board.size, best, expected;
+	int trackerRow = -1, trackerCol = -1, mapRow = -1, mapCol = -1;
+	knownCells(game, &misses, &open, &unshot);
+	densityCount(&map, size, &misses, &open, remaining, game->fleet->maxLength, 0);
+	for (row = 0; row < size; row++)
+	{
+		for (col = 0; col < size; col++)
+		{
+			if (tracker->density[row][col] != densityAt(&map, row, col))
+			{
+				return 0;
+			}
+		}
+	}
+	best = trackerBest(tracker, &unshot, NULL, &trackerRow, &trackerCol);
+	expected = densityBest(&map, size, &unshot, &mapRow, &mapCol);
+	if (best != expected || trackerRow != mapRow || trackerCol != mapCol || bbCount(&open) == 0)
+	{
+		return best == expected && trackerRow == mapRow && trackerCol == mapCol;
+	}
+	densityCount(&map, size, &misses, &open, remaining, game->fleet->maxLength, 1);
+	best = trackerBest(tracker, &unshot, &open, &trackerRow, &trackerCol);
+	expected = densityBest(&map, size, &unshot, &mapRow, &mapCol);
+	return best == expected && trackerRow == mapRow && trackerCol == mapCol;
+}
+
+/**
+ * @brief Plays a game with random shots to the end, checking the tracker after every shot.
+ * @param game The game, with a placed fleet and no shots.
+ * @param rng The random numbers generator.
+ * @param shots Increased by the number of shots fired.
+ * @return The number of shots after which the tracker differs from the recount.
+ */
+static long checkGame(Game *game, Rng *rng, long *shots)
+{
+	static DensityTracker tracker;
+	int remaining[MAX_FLEET_LENGTH + 1];
+	int row, col, result, length, size = game->board.size;
+	long mismatches = 0;
+	fleetCounts(game->fleet, remaining);
+	trackerReset(&tracker, size, remaining, game->fleet->maxLength);
+	mismatches += !sameDensity(game, &tracker, remaining);
+	while (game->deadShips < game->shipsNum)
+	{
+		do
+		{
+			row = (int) rngBelow(rng, (uint32_t) size);
+			col = (int) rngBelow(rng, (uint32_t) size);
+		} while (bbTest(&game->board.shots, row, col));
+		result = fireShot(game, row, col);
+		if (result == SHOT_MISS)
+		{
+			trackerMiss(&tracker, row, col);
+		}
+		else if (SHOT_IS_SUNK(result))
+		{
+			length = game->ships.length[SHOT_SUNK_SHIP(result)];
+			remaining[length]--;
+			trackerSunk(&tracker, length);
+		}
+		mismatches += !sameDensity(game, &tracker, remaining);
+		(*shots)++;
+	}
+	return mismatches;
+}
+
+/**
+ * The main function.
+ * @return 0 if the tracker always agreed with the recount, an error code otherwise.
+ */
+int main(int argc, char *argv[])
+{
+	Game *games[BITBOARD_MAX_SIZE + 1] = {NULL};
+	long i, count = DEFAULT_GAMES, shots = 0, mismatches = 0;
+	uint64_t seed = DEFAULT_SEED;
+	int option, size, status = 0;
+	Rng rng;
+	while ((option = getopt(argc, argv, "n:r:")) != -1)
+	{
+		switch (option)
+		{
+			case 'n':
+				count = atol(optarg);
+				break;
+			case 'r':
+				seed = (uint64_t) strtoull(optarg, NULL, 10);
+				break;
+			default:
+				fprintf(stderr, USAGE_MSG, argv[0]);
+				return USAGE_ERROR;
+		}
+	}
+	if (count < 1)
+	{
+		fprintf(stderr, USAGE_MSG, argv[0]);
+		return USAGE_ERROR;
+	}
+	for (i = 0; i < count && status == 0; i++)
+	{
+		rngSeed(&rng, seed, (uint64_t) i);
+		size = MIN_BOARD_SIZE + (int) rngBelow(&rng, BITBOARD_MAX_SIZE - MIN_BOARD_SIZE + 1);
+		if (games[size] == NULL)
+		{
+			games[size] = newGame(size, defaultFleet());
+		}
+		if (games[size] == NULL || resetGame(games[size], &rng) != TRUE)
+		{
+			status = MEMORY_ERROR;
+			break;
+		}
+		mismatches += checkGame(games[size], &rng, &shots);
+	}
+	for (size = MIN_BOARD_SIZE; size <= BITBOARD_MAX_SIZE; size++)
+	{
+		freeGame(games[size]);
+	}
+	if (status != 0)
+	{
+		return status;
+	}
+	printf("games: %ld\n", count);
+	printf("shots: %ld\n", shots);
+	printf("mismatches: %ld\n", mismatches);
+	return mismatches > 0 ? MISMATCH_ERROR : 0;
+}
@@ -8,7 +8,9 @@
  *
  * @section DESCRIPTION
  * The system runs a battleships game with a minimal gui.
- * Input  : The board game size, and the players moves.
+ * Input  : The board game size, and the players moves, from the standard input or from a script
+ * given with SCRIPT_FLAG. With SALVO_FLAG every turn is a salvo of one move for every ship afloat.
+ * A game left before it is over may be saved with SAVE_FLAG and resumed with RESUME_FLAG.
  * Process: managing the game, starting with locating randomly the ships and processing every move
  * received from the player.
  * Output : Each turn the program prints the board an a matching message.
@@ -16,19 +18,19 @@
 // ------------------------------ includes ------------------------------
 #include <stdio.h>
 #include <stdlib.h>
-#include "battleships.h"
+#include "battleships_console.h"
+#include "game_snapshot.h"
+#include "move_reader.h"
+#include "renderer.h"
+#include "shot_messages.h"
+#include "sparse_board.h"
 #include <time.h>
 #include <string.h>
+#include <unistd.h>
 
 // -------------------------- const definitions -------------------------
 
 
-/**
- * @def EXIT_STR "exit"
- * @brief the number of ships participating in the game.
- */
-#define EXIT_STR "exit"
-
 /**
  * @def MEMORY_ERROR 2
  * @brief the integer returned if one of the pointers is NULL .
@@ -53,36 +55,24 @@
  */
 #define FALSE (-1)
 
-/**
- * @def SHIPS_NUM 5
- * @brief the number of ships participating in the game.
- */
-#define SHIPS_NUM 5
-
-/**
- * @def MIN_CHAR_VALUE 97
- * @brief the ascii value of the minimum letter symbolling the rows in the board.
- */
-#define MIN_CHAR_VALUE 97
-
 /**
  * @def EXIT_GAME 0
  * @brief the integer returned if the user typed exit.
  */
 #define EXIT_GAME 0
 
-/**
- * @def  GAME_OVER_MESSAGE "Game over\n"
- * @brief  The message printed to the console when the game is over.
- */
-#define GAME_OVER_MESSAGE "Game over\n"
-
 /**
  * @def ENTER_COORDINATES_MSG "enter coordinates:"
  * @brief the message printed to the screen when the user is asked to enter his moves.
  */
 #define ENTER_COORDINATES_MSG "enter coordinates:"
 
+/**
+ * @def ENTER_SALVO_MSG "enter %d coordinates:"
+ * @brief the message printed to the screen when the user is asked to enter the moves of a salvo.
+ */
+#define ENTER_SALVO_MSG "enter %d coordinates:"
+
 /**
  * @def WRONG_BOARD_SIZE_MSG "You've entered a wrong size for the board."
  * @brief the message printed to the screen when the user inserted an invalid size for the board,
@@ -92,7 +82,7 @@
 
 /**
  * @def MAX_BOARD_SIZE 26
- * @brief The maximal board size allowed in the game.
+ * @brief The maximal board size printed to the player, larger boards are sparse boards.
  */
 #define MAX_BOARD_SIZE 26
 
@@ -108,10 +98,94 @@
  */
 #define ENTER_BOARD_SIZE_MSG "enter board size: \n"
 /**
- * @def MAX_BOARD_SIZE 26
- * @brief The maximal character that we need to process from the input.
+ * @def DIFF_FLAG "-d"
+ * @brief The command line flag drawing only the changed cells of the board after every turn.
  */
-#define MAX_CHAR_INPUT 5
+#define DIFF_FLAG "-d"
+
+/**
+ * @def FLEETS_FLAG "-f"
+ * @brief The command line flag setting the number of copies of the fleet on a sparse board.
+ */
+#define FLEETS_FLAG "-f"
+
+/**
+ * @def FLEET_FLAG "-F"
+ * @brief The command line flag followed by the fleet description, e.g. "5,4,3x2,2".
+ */
+#define FLEET_FLAG "-F"
+
+/**
+ * @def FLEET_FILE_FLAG "-c"
+ * @brief The command line flag followed by the path of a config file describing the fleet.
+ */
+#define FLEET_FILE_FLAG "-c"
+
+/**
+ * @def WRONG_FLEET_MSG "You've entered a wrong fleet."
+ * @brief The message printed to the screen when the fleet description is wrong or does not fit
+ * the board.
+ */
+#define WRONG_FLEET_MSG "You've entered a wrong fleet."
+
+/**
+ * @def FLEET_ERROR 5
+ * @brief the integer returned if the fleet description is wrong, as in the other tools.
+ */
+#define FLEET_ERROR 5
+
+/**
+ * @def SCRIPT_FLAG "-m"
+ * @brief The command line flag followed by the path of a script holding the board size and the
+ * moves, read instead of the standard input.
+ */
+#define SCRIPT_FLAG "-m"
+
+/**
+ * @def SCRIPT_ERROR 4
+ * @brief the integer returned if the script could not be opened.
+ */
+#define SCRIPT_ERROR 4
+
+/**
+ * @def SALVO_FLAG "-s"
+ * @brief The command line flag turning the salvo mode on: every turn fires one shot for every
+ * ship afloat. Sparse boards are always played one shot at a time.
+ */
+#define SALVO_FLAG "-s"
+
+/**
+ * @def SAVE_FLAG "-S"
+ * @brief The command line flag followed by the path of a snapshot file (see game_snapshot.h) the
+ * game is appended to if the player leaves it before it is over.
+ */
+#define SAVE_FLAG "-S"
+
+/**
+ * @def RESUME_FLAG "-R"
+ * @brief The command line flag followed by the path of a snapshot file, the last game of which
+ * is resumed instead of a new one: its board size and fleet are used and no board size is read.
+ */
+#define RESUME_FLAG "-R"
+
+/**
+ * @def GAME_SAVED_MSG "Game saved.\n"
+ * @brief The message printed to the screen when the game was saved.
+ */
+#define GAME_SAVED_MSG "Game saved.\n"
+
+/**
+ * @def WRONG_SAVED_GAME_MSG "You've entered a wrong saved game."
+ * @brief The message printed to the screen when the game to resume can not be read.
+ */
+#define WRONG_SAVED_GAME_MSG "You've entered a wrong saved game."
+
+/**
+ * @def SHIPS_ON_BOARD_MSG "%d ships on the board.\n"
+ * @brief The message printed to the screen when a sparse board, which is not drawn, is ready.
+ */
+#define SHIPS_ON_BOARD_MSG "%d ships on the board.\n"
+
 
 
 // ------------------------------ functions ----------------------------
@@ -121,19 +195,55 @@
 /**
  * The function running all the turns in the game, using the single turn function.
  * @param boardSize
+ * @param rng The random numbers generator placing the ships.
+ * @param diffMode Non zero to draw only the changed cells of the board after every turn.
+ * @param salvoMode Non zero to fire a salvo, one shot for every ship afloat, every turn.
+ * @param resume The game to resume, NULL to place a new fleet.
+ * @param savePath The snapshot file the game is appended to if it is left, NULL to not save it.
+ * @param reader The reader of the moves.
  * @return
  */
-int run(int boardSize);
+int run(int boardSize, const Fleet *fleet, Rng *rng, int diffMode, int salvoMode,
+		const GameSnapshot *resume, const char *savePath, MoveReader *reader);
+
+/**
+ * The function appends a game to a snapshot file.
+ * @param game The game.
+ * @param rng The random numbers generator of the game.
+ * @param path The snapshot file path.
+ * @return EXIT_GAME on success, SNAPSHOT_ERROR otherwise.
+ */
+int saveGame(const Game *game, const Rng *rng, const char *path);
+
+/**
+ * The function reads the salvo of a single turn, one move for every ship afloat.
+ * @param game The game.
+ * @param reader The reader of the moves.
+ * @param shots Filled with the salvo.
+ * @return The number of shots read, -1 if the user typed exit or the moves ended.
+ */
+int readSalvo(const Game *game, MoveReader *reader, Shot *shots);
+
+/**
+ * The function running all the turns of a game on a sparse board, which is too large to print.
+ * @param boardSize The board size.
+ * @param fleet The fleet.
+ * @param fleets The number of copies of the fleet placed on the board.
+ * @param rng The random numbers generator placing the ships.
+ * @param reader The reader of the moves.
+ * @return EXIT_GAME if the user typed exit, 1 when the game is over, MEMORY_ERROR otherwise.
+ */
+int runSparse(int boardSize, const Fleet *fleet, int fleets, Rng *rng, MoveReader *reader);
 
 /**
  * This function verifies that the size received for the board is valid.
- * meaning the size is bigger then 5 or lower then 26.
+ * meaning the size is bigger then 5 or lower then SPARSE_MAX_SIZE.
  * @param sizeInput The size received for the board
  * @return TRUE (1) if the size is valid, FALSE otherwise.
  */
 int isValidBoarSize(int sizeInput)
 {
-	if (sizeInput <= MAX_BOARD_SIZE && sizeInput >= MIN_BOARD_SIZE)
+	if (sizeInput <= SPARSE_MAX_SIZE && sizeInput >= MIN_BOARD_SIZE)
 	{
 		return TRUE;
 	}
@@ -142,58 +252,268 @@ int isValidBoarSize(int sizeInput)
 
 /**
  * The main function.
+ * @param argc The number of command line arguments.
+ * @param argv The command line arguments, DIFF_FLAG turns the diff mode drawing on,
+ * FLEET_FLAG or FLEET_FILE_FLAG set the fleet and FLEETS_FLAG followed by a number sets the
+ * number of copies of the fleet on a sparse board. SCRIPT_FLAG followed by a path reads the
+ * board size and the moves from a script instead of the standard input. SALVO_FLAG turns the
+ * salvo mode on. SAVE_FLAG and RESUME_FLAG followed by a path save a game left before it is over
+ * and resume the last saved game (a sparse board can not be saved).
  * @return
  */
-int main()
+int main(int argc, char *argv[])
 {
-	srand((unsigned) time(0));
-	int boardSize;
-	printf(ENTER_BOARD_SIZE_MSG);
-	scanf("%d", &boardSize);
-	if (isValidBoarSize(boardSize) == FALSE)
+	static Fleet fleet;
+	MoveReader reader;
+	SnapshotFile saved = {NULL, 0, 0};
+	const GameSnapshot *resume = NULL;
+	Rng rng;
+	rngSeed(&rng, (uint64_t) time(0), 0);
+	const char *script = NULL, *savePath = NULL, *resumePath = NULL;
+	int boardSize = 0, i, diffMode = 0, salvoMode = 0, fleets = 1, status = TRUE;
+	fleet = *defaultFleet();
+	for (i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], DIFF_FLAG) == 0)
+		{
+			diffMode = 1;
+		}
+		else if (strcmp(argv[i], SALVO_FLAG) == 0)
+		{
+			salvoMode = 1;
+		}
+		else if (strcmp(argv[i], FLEETS_FLAG) == 0 && i + 1 < argc)
+		{
+			fleets = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], FLEET_FLAG) == 0 && i + 1 < argc)
+		{
+			status = parseFleet(argv[++i], &fleet);
+		}
+		else if (strcmp(argv[i], FLEET_FILE_FLAG) == 0 && i + 1 < argc)
+		{
+			status = loadFleetFile(argv[++i], &fleet);
+		}
+		else if (strcmp(argv[i], SCRIPT_FLAG) == 0 && i + 1 < argc)
+		{
+			script = argv[++i];
+		}
+		else if (strcmp(argv[i], SAVE_FLAG) == 0 && i + 1 < argc)
+		{
+			savePath = argv[++i];
+		}
+		else if (strcmp(argv[i], RESUME_FLAG) == 0 && i + 1 < argc)
+		{
+			resumePath = argv[++i];
+		}
+	}
+	if (status == FALSE)
+	{
+		fprintf(stderr, WRONG_FLEET_MSG);
+		return FLEET_ERROR;
+	}
+	if (resumePath != NULL)
+	{
+		if (mapSnapshots(resumePath, &saved) != 0 || saved.count == 0 ||
+			snapshotFleet(&saved.snapshots[saved.count - 1], &fleet) == FALSE)
+		{
+			fprintf(stderr, WRONG_SAVED_GAME_MSG);
+			unmapSnapshots(&saved);
+			return SNAPSHOT_ERROR;
+		}
+		resume = &saved.snapshots[saved.count - 1];
+	}
+	if (script != NULL ? openMoveScript(&reader, script) != 0 :
+		openMoveStream(&reader, STDIN_FILENO) != 0)
+	{
+		perror(script != NULL ? script : "stdin");
+		return script != NULL ? SCRIPT_ERROR : MEMORY_ERROR;
+	}
+	if (resume != NULL)
+	{
+		boardSize = resume->size;
+	}
+	else
+	{
+		printf(ENTER_BOARD_SIZE_MSG);
+		readNumber(&reader, &boardSize);
+	}
+	if (isValidBoarSize(boardSize) == FALSE || (resume != NULL && boardSize > MAX_BOARD_SIZE))
 	{
 		fprintf(stderr, WRONG_BOARD_SIZE_MSG);
-		return BOARD_SIZE_ERROR;
+		status = BOARD_SIZE_ERROR;
+	}
+	else if (boardSize > MAX_BOARD_SIZE)
+	{
+		status = runSparse(boardSize, &fleet, fleets < 1 ? 1 : fleets, &rng, &reader);
+	}
+	else if (fleet.maxLength > boardSize || fleet.cells > boardSize * boardSize)
+	{
+		fprintf(stderr, WRONG_FLEET_MSG);
+		status = FLEET_ERROR;
+	}
+	else
+	{
+		status = run(boardSize, &fleet, &rng, diffMode, salvoMode, resume, savePath, &reader);
 	}
-	return run(boardSize);
+	closeMoveReader(&reader);
+	unmapSnapshots(&saved);
+	return status;
 }
 
 /**
- * The function running all the turns in the game, using the single turn function.
+ * The function running all the turns in the game, using the play turn function, or the play
+ * salvo function in the salvo mode.
  * @param boardSize
+ * @param fleet The fleet placed on the board.
+ * @param rng The random numbers generator placing the ships.
+ * @param diffMode Non zero to draw only the changed cells of the board after every turn.
+ * @param salvoMode Non zero to fire a salvo, one shot for every ship afloat, every turn.
+ * @param resume The game to resume, NULL to place a new fleet.
+ * @param savePath The snapshot file the game is appended to if it is left, NULL to not save it.
+ * @param reader The reader of the moves.
  * @return
  */
-int run(int boardSize)
+int run(int boardSize, const Fleet *fleet, Rng *rng, int diffMode, int salvoMode,
+		const GameSnapshot *resume, const char *savePath, MoveReader *reader)
 {
-	char input[MAX_CHAR_INPUT];
-	int col, rowInt, deadShips = 0;
-	char rowChar;
-	char **toPrintBoard = initialBoard(boardSize);
-	char **managerBoard = initialBoard(boardSize);
-	Ship *shipsArray = shipFactory(boardSize, managerBoard);
-	if (managerBoard == NULL || toPrintBoard == NULL || shipsArray == NULL)
-	{
-		freeAllSpace(toPrintBoard, managerBoard, shipsArray, boardSize);
+	int col, rowInt, count, status = 1;
+	Game *game = newGame(boardSize, fleet);
+	Renderer *renderer = newRenderer(boardSize, diffMode);
+	Shot *shots = (Shot *) malloc(fleet->shipsNum * sizeof(Shot));
+	if (game == NULL || renderer == NULL || shots == NULL ||
+		(resume != NULL ? restoreGame(game, rng, resume) : resetGame(game, rng)) == FALSE)
+	{
+		freeGame(game);
+		closeRenderer(renderer, STDOUT_FILENO);
+		free(shots);
 		return MEMORY_ERROR;
 	}
-	printBoard(toPrintBoard, boardSize);
-	while (deadShips < SHIPS_NUM)
+	setBoardRenderer(renderer);
+	printBoard(&game->board);
+	while (isGameOver(&game->board) == FALSE)
 	{
+		if (salvoMode)
+		{
+			printf(ENTER_SALVO_MSG, game->shipsNum - game->deadShips);
+			if ((count = readSalvo(game, reader, shots)) < 0)
+			{
+				status = EXIT_GAME;
+				break;
+			}
+			playSalvo(game, shots, count);
+			continue;
+		}
 		printf(ENTER_COORDINATES_MSG);
-		scanf("%s", input);
-		if (strcmp(input, EXIT_STR) == 0)
+		if (readMove(reader, &rowInt, &col) != MOVE_READ)
 		{
-			freeAllSpace(toPrintBoard, managerBoard, shipsArray, boardSize);
-			return EXIT_GAME;
+			status = EXIT_GAME;
+			break;
 		}
-		scanf("%d", &col);
-		rowChar = input[0];
-		rowInt = (int) (rowChar - MIN_CHAR_VALUE);
-		deadShips = singleTurn(rowInt, col-1, managerBoard, toPrintBoard, boardSize,
-								   shipsArray, deadShips);
-	}
-	freeAllSpace(toPrintBoard, managerBoard, shipsArray, boardSize);
-	printf(GAME_OVER_MESSAGE);
-	return 1;
+		playTurn(game, rowInt, col);
+	}
+	setBoardRenderer(NULL);
+	closeRenderer(renderer, STDOUT_FILENO);
+	if (status == EXIT_GAME && savePath != NULL)
+	{
+		status = saveGame(game, rng, savePath);
+	}
+	freeGame(game);
+	free(shots);
+	if (status != EXIT_GAME && status != SNAPSHOT_ERROR)
+	{
+		printf(GAME_OVER_MESSAGE);
+	}
+	return status;
 }
 
+/**
+ * The function appends a game to a snapshot file.
+ * @param game The game.
+ * @param rng The random numbers generator of the game.
+ * @param path The snapshot file path.
+ * @return EXIT_GAME on success, SNAPSHOT_ERROR otherwise.
+ */
+int saveGame(const Game *game, const Rng *rng, const char *path)
+{
+	GameSnapshot snapshot;
+	int fd, status = SNAPSHOT_ERROR;
+	if (snapshotGame(game, rng, &snapshot) == FALSE)
+	{
+		fprintf(stderr, WRONG_FLEET_MSG);
+		return SNAPSHOT_ERROR;
+	}
+	fd = openSnapshots(path);
+	if (fd >= 0 && writeSnapshots(fd, &snapshot, 1) == 0)
+	{
+		printf(GAME_SAVED_MSG);
+		status = EXIT_GAME;
+	}
+	if (fd < 0 || status != EXIT_GAME)
+	{
+		perror(path);
+	}
+	if (fd >= 0)
+	{
+		close(fd);
+	}
+	return status;
+}
+
+/**
+ * The function reads the salvo of a single turn, one move for every ship afloat.
+ * @param game The game.
+ * @param reader The reader of the moves.
+ * @param shots Filled with the salvo.
+ * @return The number of shots read, -1 if the user typed exit or the moves ended.
+ */
+int readSalvo(const Game *game, MoveReader *reader, Shot *shots)
+{
+	int i, count = game->shipsNum - game->deadShips;
+	for (i = 0; i < count; i++)
+	{
+		if (readMove(reader, &shots[i].row, &shots[i].col) != MOVE_READ)
+		{
+			return -1;
+		}
+	}
+	return count;
+}
+
+/**
+ * The function running all the turns of a game on a sparse board, which is too large to print.
+ * Only the message of every move is printed.
+ * @param boardSize The board size.
+ * @param fleet The fleet.
+ * @param fleets The number of copies of the fleet placed on the board.
+ * @param rng The random numbers generator placing the ships.
+ * @param reader The reader of the moves.
+ * @return EXIT_GAME if the user typed exit, 1 when the game is over, MEMORY_ERROR otherwise.
+ */
+int runSparse(int boardSize, const Fleet *fleet, int fleets, Rng *rng, MoveReader *reader)
+{
+	int col, row, status = 1;
+	SparseBoard *board = newSparseBoard(boardSize);
+	if (board == NULL || sparsePlaceFleets(board, fleet, fleets, rng) == FALSE)
+	{
+		freeSparseBoard(board);
+		return MEMORY_ERROR;
+	}
+	printf(SHIPS_ON_BOARD_MSG, board->shipsNum);
+	while (sparseGameOver(board) == FALSE)
+	{
+		printf(ENTER_COORDINATES_MSG);
+		if (readMove(reader, &row, &col) != MOVE_READ)
+		{
+			status = EXIT_GAME;
+			break;
+		}
+		printShotResult(sparseShoot(board, row, col));
+	}
+	freeSparseBoard(board);
+	if (status != EXIT_GAME)
+	{
+		printf(GAME_OVER_MESSAGE);
+	}
+	return status;
+}
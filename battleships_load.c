@@ -0,0 +1,606 @@
+/**
+ * @file battleships_load.c
+ * @version 2.0
+ *
+ * @brief A load generator for the battleships server.
+ *
+ * @section DESCRIPTION
+ * The program opens many sessions to a running server (ex2_server) and plays them all at once,
+ * every session firing its next move a fixed think time after the answer to the previous one
+ * arrives (at once by default, keeping every session busy).
+ * Input  : Command line options - the server socket path (-u) or TCP port (-p, DEFAULT_PORT by
+ *          default), the number of sessions (-n), the number of threads (-t, one per core by
+ *          default), the run time in seconds (-d), the think time of the sessions in
+ *          milliseconds (-w), the board size of the server (-s) and the random seed (-r).
+ * Process: every session shoots at the cells of its board in a random order, starting over
+ *          when the server announces the game is over.
+ * Output : The throughput in moves per second and the distribution of the move latencies (from
+ *          sending a move to reading its answer).
+ */
+// ------------------------------ includes ------------------------------
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+#include "monotonic.h"
+#include "rng.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def USAGE_ERROR 1
+ * @brief the integer returned if the command line options are wrong.
+ */
+#define USAGE_ERROR 1
+
+/**
+ * @def MEMORY_ERROR 2
+ * @brief the integer returned if one of the pointers is NULL .
+ */
+#define MEMORY_ERROR 2
+
+/**
+ * @def CONNECT_ERROR 4
+ * @brief the integer returned if a session could not connect to the server or lost it.
+ */
+#define CONNECT_ERROR 4
+
+/**
+ * @def MAX_BOARD_SIZE 26
+ * @brief The maximal board size allowed in the game.
+ */
+#define MAX_BOARD_SIZE 26
+
+/**
+ * @def MIN_BOARD_SIZE 5
+ * @brief The minimal board size allowed in the game.
+ */
+#define MIN_BOARD_SIZE 5
+
+/**
+ * @def MAX_LOAD_THREADS 256
+ * @brief The maximal number of threads of the load generator.
+ */
+#define MAX_LOAD_THREADS 256
+
+/**
+ * @def DEFAULT_PORT 7979
+ * @brief The TCP port used when neither -u nor -p is given.
+ */
+#define DEFAULT_PORT 7979
+
+/**
+ * @def DEFAULT_SESSIONS 10000
+ * @brief The number of sessions opened when -n is not given.
+ */
+#define DEFAULT_SESSIONS 10000
+
+/**
+ * @def DEFAULT_SECONDS 5
+ * @brief The run time when -d is not given.
+ */
+#define DEFAULT_SECONDS 5
+
+/**
+ * @def DEFAULT_BOARD_SIZE 10
+ * @brief The board size used when -s is not given.
+ */
+#define DEFAULT_BOARD_SIZE 10
+
+/**
+ * @def LATENCY_BUCKETS 100000
+ * @brief The number of one microsecond latency buckets, longer latencies share the last one.
+ */
+#define LATENCY_BUCKETS 100000
+
+/**
+ * @def MAX_EVENTS 256
+ * @brief The number of events a thread takes from the kernel at once.
+ */
+#define MAX_EVENTS 256
+
+/**
+ * @def WAIT_MS 10
+ * @brief The longest time a thread waits for events before checking the clock.
+ */
+#define WAIT_MS 10
+
+/**
+ * @def ANSWER_SIZE 256
+ * @brief The size of the buffer holding the partial answer line of a session.
+ */
+#define ANSWER_SIZE 256
+
+/**
+ * @def LOOPBACK_ADDRESS 0x7f000001
+ * @brief The loopback address (127.0.0.1) of the TCP server.
+ */
+#define LOOPBACK_ADDRESS 0x7f000001U
+
+/**
+ * @def FIRST_ROW_LETTER 'a'
+ * @brief The letter of the first row.
+ */
+#define FIRST_ROW_LETTER 'a'
+
+/**
+ * @def GAME_OVER_MESSAGE "Game over"
+ * @brief The line the server sends after the answer to the shot sinking the last ship.
+ */
+#define GAME_OVER_MESSAGE "Game over"
+
+/**
+ * @def LOST_SERVER_MSG "A session could not reach the server.\n"
+ * @brief The message printed when a session could not connect or lost the server.
+ */
+#define LOST_SERVER_MSG "A session could not reach the server.\n"
+
+/**
+ * @def USAGE_MSG
+ * @brief The message printed when the command line options are wrong.
+ */
+#define USAGE_MSG "usage: %s [-u socket path | -p port] [-n sessions] [-t threads] [-d seconds] " \
+				  "[-w think ms] [-s board size] [-r seed]\n"
+
+// ------------------------------ structs ----------------------------
+
+/**
+ * a structure describing a load run. includes the following attributes:
+ * path - the server Unix domain socket path, NULL for loopback TCP.
+ * port - the server TCP port.
+ * sessions - the number of sessions.
+ * threads - the number of threads.
+ * seconds - the run time.
+ * think - the time a session waits between an answer and its next move, in seconds.
+ * boardSize - the board size of the server.
+ * seed - the random seed.
+ */
+typedef struct LoadConfig
+{
+	const char *path;
+	int port;
+	int sessions;
+	int threads;
+	double seconds;
+	double think;
+	int boardSize;
+	uint64_t seed;
+} LoadConfig;
+
+/**
+ * a structure describing a session. includes the following attributes:
+ * fd - the connection socket.
+ * cellsLeft - the number of cells not shot yet in the current game.
+ * answerLength - the number of bytes of the partial answer line.
+ * sent - the time the pending move was sent.
+ * due - the time the next move is sent, while the session is thinking.
+ * cells - the cells of the board, the first cellsLeft of them not shot yet.
+ * answer - the partial answer line.
+ */
+typedef struct Session
+{
+	int fd;
+	int cellsLeft;
+	size_t answerLength;
+	double sent;
+	double due;
+	uint16_t cells[MAX_BOARD_SIZE * MAX_BOARD_SIZE];
+	char answer[ANSWER_SIZE];
+} Session;
+
+/**
+ * a structure describing a load thread. includes the following attributes:
+ * config - the run description.
+ * sessions - the sessions of the thread.
+ * count - the number of sessions of the thread.
+ * rng - the random numbers generator picking the moves.
+ * thinking - a queue of the sessions waiting to send their next move, by due time.
+ * thinkingFirst - the index of the first session in the thinking queue.
+ * thinkingNum - the number of sessions in the thinking queue.
+ * moves - the number of answered moves.
+ * games - the number of games won.
+ * histogram - the number of moves answered after every number of microseconds.
+ * status - 0 on success, MEMORY_ERROR or CONNECT_ERROR if the thread failed.
+ * started - non zero if the thread must be joined.
+ * thread - the thread.
+ */
+typedef struct LoadThread
+{
+	const LoadConfig *config;
+	Session *sessions;
+	int count;
+	Rng rng;
+	Session **thinking;
+	int thinkingFirst;
+	int thinkingNum;
+	long moves;
+	long games;
+	long histogram[LATENCY_BUCKETS + 1];
+	int status;
+	int started;
+	pthread_t thread;
+} LoadThread;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Opens a non blocking connection to the server.
+ * @param config The run description.
+ * @return The socket, -1 on failure.
+ */
+int connectServer(const LoadConfig *config)
+{
+	struct sockaddr_un local;
+	struct sockaddr_in inet;
+	int fd, on = 1, status;
+	if (config->path != NULL)
+	{
+		memset(&local, 0, sizeof(local));
+		local.sun_family = AF_UNIX;
+		strncpy(local.sun_path, config->path, sizeof(local.sun_path) - 1);
+		fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		status = fd >= 0 ? connect(fd, (struct sockaddr *) &local, sizeof(local)) : -1;
+	}
+	else
+	{
+		memset(&inet, 0, sizeof(inet));
+		inet.sin_family = AF_INET;
+		inet.sin_port = htons((uint16_t) config->port);
+		inet.sin_addr.s_addr = htonl(LOOPBACK_ADDRESS);
+		fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		status = fd >= 0 ? connect(fd, (struct sockaddr *) &inet, sizeof(inet)) : -1;
+		if (status == 0)
+		{
+			setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+		}
+	}
+	if (status != 0 || fcntl(fd, F_SETFL, O_NONBLOCK) != 0)
+	{
+		if (fd >= 0)
+		{
+			close(fd);
+		}
+		return -1;
+	}
+	return fd;
+}
+
+/**
+ * @brief Starts a new game of a session, with every cell not shot yet.
+ * @param session The session.
+ * @param size The board size.
+ */
+void newBoard(Session *session, int size)
+{
+	int i;
+	session->cellsLeft = size * size;
+	for (i = 0; i < session->cellsLeft; i++)
+	{
+		session->cells[i] = (uint16_t) i;
+	}
+}
+
+/**
+ * @brief Sends the next move of a session, a random cell not shot yet in its game.
+ * @param thread The load thread.
+ * @param session The session.
+ * @return 0 on success, CONNECT_ERROR if the move could not be sent.
+ */
+int sendMove(LoadThread *thread, Session *session)
+{
+	int size = thread->config->boardSize, pick, cell, length;
+	char line[16];
+	if (session->cellsLeft == 0)
+	{
+		newBoard(session, size);
+	}
+	pick = (int) rngBelow(&thread->rng, (uint32_t) session->cellsLeft);
+	cell = session->cells[pick];
+	session->cells[pick] = session->cells[--session->cellsLeft];
+	length = snprintf(line, sizeof(line), "%c %d\n", FIRST_ROW_LETTER + cell / size,
+					  cell % size + 1);
+	session->sent = monotonicSeconds();
+	return write(session->fd, line, (size_t) length) == length ? 0 : CONNECT_ERROR;
+}
+
+/**
+ * @brief Reads the answers of a session, recording the latency of every answered move and
+ * sending the next move.
+ * @param thread The load thread.
+ * @param session The session.
+ * @return 0 on success, CONNECT_ERROR if the server closed the session or broke the protocol.
+ */
+int readAnswers(LoadThread *thread, Session *session)
+{
+	char *line, *end, *newline;
+	double arrival;
+	ssize_t got;
+	long micros;
+	int answered = 0;
+	got = read(session->fd, session->answer + session->answerLength,
+			   ANSWER_SIZE - session->answerLength);
+	if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+	{
+		return 0;
+	}
+	if (got <= 0)
+	{
+		return CONNECT_ERROR;
+	}
+	line = session->answer;
+	end = session->answer + session->answerLength + got;
+	while ((newline = (char *) memchr(line, '\n', (size_t) (end - line))) != NULL)
+	{
+		if ((size_t) (newline - line) == sizeof(GAME_OVER_MESSAGE) - 1 &&
+			memcmp(line, GAME_OVER_MESSAGE, sizeof(GAME_OVER_MESSAGE) - 1) == 0)
+		{
+			newBoard(session, thread->config->boardSize);
+			thread->games++;
+		}
+		else
+		{
+			answered++;
+		}
+		line = newline + 1;
+	}
+	session->answerLength = (size_t) (end - line);
+	memmove(session->answer, line, session->answerLength);
+	if (answered > 1 || session->answerLength == ANSWER_SIZE)
+	{
+		return CONNECT_ERROR;
+	}
+	if (answered == 0)
+	{
+		return 0;
+	}
+	arrival = monotonicSeconds();
+	micros = (long) ((arrival - session->sent) * 1e6);
+	thread->histogram[micros < LATENCY_BUCKETS ? micros : LATENCY_BUCKETS]++;
+	thread->moves++;
+	if (thread->config->think <= 0)
+	{
+		return sendMove(thread, session);
+	}
+	session->due = arrival + thread->config->think;
+	thread->thinking[(thread->thinkingFirst + thread->thinkingNum++) % thread->count] = session;
+	return 0;
+}
+
+/**
+ * @brief Sends the next moves of the sessions whose think time is over. The think time is the
+ * same for all the sessions, so the queue is sorted by due time.
+ * @param thread The load thread.
+ * @param current The current time.
+ * @return The time until the next session is due in milliseconds, rounded up, at most WAIT_MS.
+ */
+int sendDueMoves(LoadThread *thread, double current)
+{
+	Session *session;
+	int wait;
+	while (thread->thinkingNum > 0 && thread->status == 0)
+	{
+		session = thread->thinking[thread->thinkingFirst];
+		if (session->due > current)
+		{
+			wait = (int) ((session->due - current) * 1e3) + 1;
+			return wait < WAIT_MS ? wait : WAIT_MS;
+		}
+		thread->thinkingFirst = (thread->thinkingFirst + 1) % thread->count;
+		thread->thinkingNum--;
+		thread->status = sendMove(thread, session);
+	}
+	return WAIT_MS;
+}
+
+/**
+ * @brief The body of a load thread: connects its sessions and plays them until the run time is
+ * over. The first moves are spread evenly over the think time, so the sessions do not move in
+ * step.
+ * @param arg The load thread.
+ * @return NULL.
+ */
+void *loadMain(void *arg)
+{
+	LoadThread *thread = (LoadThread *) arg;
+	struct epoll_event events[MAX_EVENTS], event;
+	double end, current;
+	int i, ready, wait = WAIT_MS, epoll = epoll_create1(EPOLL_CLOEXEC);
+	for (i = 0; i < thread->count; i++)
+	{
+		thread->sessions[i].fd = -1;
+	}
+	thread->thinking = (Session **) malloc((size_t) thread->count * sizeof(Session *));
+	thread->status = epoll < 0 ? CONNECT_ERROR : (thread->thinking == NULL ? MEMORY_ERROR : 0);
+	for (i = 0; thread->status == 0 && i < thread->count; i++)
+	{
+		thread->sessions[i].fd = connectServer(thread->config);
+		event.events = EPOLLIN;
+		event.data.ptr = &thread->sessions[i];
+		if (thread->sessions[i].fd < 0 ||
+			epoll_ctl(epoll, EPOLL_CTL_ADD, thread->sessions[i].fd, &event) != 0)
+		{
+			thread->status = CONNECT_ERROR;
+		}
+		newBoard(&thread->sessions[i], thread->config->boardSize);
+		thread->sessions[i].answerLength = 0;
+	}
+	current = monotonicSeconds();
+	for (i = 0; thread->status == 0 && i < thread->count; i++)
+	{
+		thread->sessions[i].due = current + thread->config->think * i / thread->count;
+		thread->thinking[i] = &thread->sessions[i];
+	}
+	thread->thinkingNum = thread->count;
+	end = current + thread->config->seconds;
+	while (thread->status == 0 && (current = monotonicSeconds()) < end)
+	{
+		wait = sendDueMoves(thread, current);
+		ready = epoll_wait(epoll, events, MAX_EVENTS, thread->status == 0 ? wait : 0);
+		for (i = 0; i < ready && thread->status == 0; i++)
+		{
+			thread->status = readAnswers(thread, (Session *) events[i].data.ptr);
+		}
+	}
+	for (i = 0; i < thread->count; i++)
+	{
+		if (thread->sessions[i].fd >= 0)
+		{
+			close(thread->sessions[i].fd);
+		}
+	}
+	if (epoll >= 0)
+	{
+		close(epoll);
+	}
+	free(thread->thinking);
+	return NULL;
+}
+
+/**
+ * @brief Finds the smallest latency such that at least the given part of the moves were
+ * answered within it.
+ * @param histogram The number of moves answered after every number of microseconds.
+ * @param moves The number of moves.
+ * @param part The part of the moves, between 0 and 1.
+ * @return The latency in microseconds.
+ */
+long percentile(const long *histogram, long moves, double part)
+{
+	long seen = 0, micros;
+	for (micros = 0; micros <= LATENCY_BUCKETS; micros++)
+	{
+		seen += histogram[micros];
+		if (seen > 0 && (double) seen >= part * (double) moves)
+		{
+			return micros;
+		}
+	}
+	return LATENCY_BUCKETS;
+}
+
+/**
+ * The main function.
+ * @return 0 on success, an error code otherwise.
+ */
+int main(int argc, char *argv[])
+{
+	LoadConfig config = {NULL, DEFAULT_PORT, DEFAULT_SESSIONS, (int) sysconf(_SC_NPROCESSORS_ONLN),
+						 DEFAULT_SECONDS, 0, DEFAULT_BOARD_SIZE, (uint64_t) time(0)};
+	LoadThread *threads;
+	Session *sessions;
+	struct rlimit limit;
+	long moves = 0, games = 0, micros;
+	int option, i, first = 0, status = 0;
+	while ((option = getopt(argc, argv, "u:p:n:t:d:w:s:r:")) != -1)
+	{
+		switch (option)
+		{
+			case 'u':
+				config.path = optarg;
+				break;
+			case 'p':
+				config.port = atoi(optarg);
+				break;
+			case 'n':
+				config.sessions = atoi(optarg);
+				break;
+			case 't':
+				config.threads = atoi(optarg);
+				break;
+			case 'd':
+				config.seconds = atof(optarg);
+				break;
+			case 'w':
+				config.think = atof(optarg) * 1e-3;
+				break;
+			case 's':
+				config.boardSize = atoi(optarg);
+				break;
+			case 'r':
+				config.seed = (uint64_t) strtoull(optarg, NULL, 10);
+				break;
+			default:
+				fprintf(stderr, USAGE_MSG, argv[0]);
+				return USAGE_ERROR;
+		}
+	}
+	if (config.sessions < 1 || config.threads < 1 || config.seconds <= 0 || config.think < 0 ||
+		config.boardSize < MIN_BOARD_SIZE || config.boardSize > MAX_BOARD_SIZE)
+	{
+		fprintf(stderr, USAGE_MSG, argv[0]);
+		return USAGE_ERROR;
+	}
+	config.threads = config.threads > MAX_LOAD_THREADS ? MAX_LOAD_THREADS : config.threads;
+	config.threads = config.threads > config.sessions ? config.sessions : config.threads;
+	if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
+	{
+		limit.rlim_cur = limit.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &limit);
+	}
+	threads = (LoadThread *) calloc((size_t) config.threads, sizeof(LoadThread));
+	sessions = (Session *) calloc((size_t) config.sessions, sizeof(Session));
+	if (threads == NULL || sessions == NULL)
+	{
+		free(threads);
+		free(sessions);
+		return MEMORY_ERROR;
+	}
+	for (i = 0; i < config.threads; i++)
+	{
+		threads[i].config = &config;
+		threads[i].sessions = sessions + first;
+		threads[i].count = (int) ((long) config.sessions * (i + 1) / config.threads) - first;
+		first += threads[i].count;
+		rngSeed(&threads[i].rng, config.seed, (uint64_t) i);
+	}
+	for (i = 1; i < config.threads; i++)
+	{
+		threads[i].started = pthread_create(&threads[i].thread, NULL, loadMain, &threads[i]) == 0;
+	}
+	loadMain(&threads[0]);
+	for (i = 0; i < config.threads; i++)
+	{
+		if (threads[i].started)
+		{
+			pthread_join(threads[i].thread, NULL);
+		}
+		status = threads[i].status != 0 ? threads[i].status : status;
+		moves += threads[i].moves;
+		games += threads[i].games;
+		if (i > 0)
+		{
+			for (micros = 0; micros <= LATENCY_BUCKETS; micros++)
+			{
+				threads[0].histogram[micros] += threads[i].histogram[micros];
+			}
+		}
+	}
+	printf("sessions: %d\n", config.sessions);
+	printf("threads: %d\n", config.threads);
+	printf("seconds: %.3f\n", config.seconds);
+	printf("moves: %ld\n", moves);
+	printf("games: %ld\n", games);
+	printf("moves per second: %.0f\n", (double) moves / config.seconds);
+	printf("p50 latency (us): %ld\n", percentile(threads[0].histogram, moves, 0.5));
+	printf("p90 latency (us): %ld\n", percentile(threads[0].histogram, moves, 0.9));
+	printf("p99 latency (us): %ld\n", percentile(threads[0].histogram, moves, 0.99));
+	printf("p99.9 latency (us): %ld\n", percentile(threads[0].histogram, moves, 0.999));
+	printf("max latency (us): %ld\n", percentile(threads[0].histogram, moves, 1.0));
+	if (status != 0)
+	{
+		fprintf(stderr, LOST_SERVER_MSG);
+	}
+	free(threads);
+	free(sessions);
+	return status;
+}
@@ -0,0 +1,265 @@
+/**
+ * @file battleships_replay.c
+ * @version 2.0
+ *
+ * @brief Fast audit of binary replay logs.
+ *
+ * @section DESCRIPTION
+ * The program maps replay logs written by the simulation (ex2_sim -l) and plays every game in
+ * them again through the game engine, without printing anything.
+ * Input  : The paths of the logs.
+ * Process: checking the checksum of every block, loading the recorded fleet of every game and
+ * firing the recorded shots at it in one batch.
+ * Output : The number of blocks, games and shots, how many games replayed to a correct end and
+ * the replay throughput in shots per second.
+ */
+// ------------------------------ includes ------------------------------
+#include <stdio.h>
+#include "monotonic.h"
+#include "replay_log.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def USAGE_ERROR 1
+ * @brief the integer returned if the command line options are wrong.
+ */
+#define USAGE_ERROR 1
+
+/**
+ * @def MEMORY_ERROR 2
+ * @brief the integer returned if one of the pointers is NULL .
+ */
+#define MEMORY_ERROR 2
+
+/**
+ * @def  TRUE 1
+ * @brief a true boolean value.
+ */
+#define TRUE 1
+
+/**
+ * @def MIN_BOARD_SIZE 5
+ * @brief The minimal board size allowed in the game.
+ */
+#define MIN_BOARD_SIZE 5
+
+/**
+ * @def MAX_REPLAY_SHOTS 676
+ * @brief The maximal number of shots of a game (every cell of the largest board).
+ */
+#define MAX_REPLAY_SHOTS (BITBOARD_MAX_SIZE * BITBOARD_MAX_SIZE)
+
+/**
+ * @def USAGE_MSG
+ * @brief The message printed when the command line options are wrong.
+ */
+#define USAGE_MSG "usage: %s log [log ...]\n"
+
+// ------------------------------ structs ----------------------------
+
+/**
+ * a structure holding the results of a replay. includes the following attributes:
+ * blocks - the number of blocks read.
+ * corruptBlocks - the number of blocks whose checksum did not match.
+ * truncatedLogs - the number of logs that did not end with a whole block.
+ * games - the number of games replayed.
+ * verified - the number of games that ended with the last shot sinking the last ship.
+ * failed - the number of games that could not be loaded or did not end correctly.
+ * shots - the total number of shots replayed.
+ */
+typedef struct ReplayStats
+{
+	long blocks;
+	long corruptBlocks;
+	long truncatedLogs;
+	long games;
+	long verified;
+	long failed;
+	long shots;
+} ReplayStats;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Loads the recorded fleet of a game on a cleared board.
+ * @param game The game block to load into, large enough for MAX_FLEET_SHIPS ships.
+ * @param record The recorded game.
+ * @param fleet Filled with the recorded fleet.
+ * @return TRUE if the fleet was loaded, 0 if it does not fit the game or the board.
+ */
+int loadGame(Game *game, const LogGame *record, Fleet *fleet)
+{
+	const unsigned char *cell = record->ships;
+	Ship ship;
+	int i;
+	if (record->size < MIN_BOARD_SIZE || record->size > BITBOARD_MAX_SIZE ||
+		record->shipsNum < 1 || record->shipsNum > MAX_FLEET_SHIPS ||
+		record->shotsNum > MAX_REPLAY_SHOTS)
+	{
+		return 0;
+	}
+	fleet->shipsNum = record->shipsNum;
+	for (i = 0; i < record->shipsNum; i++)
+	{
+		fleet->lengths[i] = record->ships[LOG_SHIP_SIZE * i + 2];
+	}
+	initGame(game, record->size, fleet);
+	for (i = 0; i < record->shipsNum; i++, cell += LOG_SHIP_SIZE)
+	{
+		ship.row = cell[0];
+		ship.col = cell[1];
+		ship.length = cell[2];
+		ship.angle = cell[3];
+		if (placeShipAt(&ship, i, &game->board) != TRUE)
+		{
+			return 0;
+		}
+		game->ships.row[i] = cell[0];
+		game->ships.col[i] = cell[1];
+		game->ships.length[i] = cell[2];
+		game->ships.angle[i] = cell[3];
+		game->ships.lives[i] = cell[2];
+	}
+	return TRUE;
+}
+
+/**
+ * @brief Replays a single recorded game.
+ * @param game The game block to replay in.
+ * @param record The recorded game.
+ * @param shots A buffer for MAX_REPLAY_SHOTS shots.
+ * @param results A buffer for MAX_REPLAY_SHOTS results.
+ * @param fleet A fleet filled with the recorded fleet.
+ * @return TRUE if every shot was legal and the last one sunk the last ship, 0 otherwise.
+ */
+int replayGame(Game *game, const LogGame *record, Shot *shots, int *results, Fleet *fleet)
+{
+	int i;
+	if (loadGame(game, record, fleet) != TRUE || record->shotsNum == 0)
+	{
+		return 0;
+	}
+	for (i = 0; i < record->shotsNum; i++)
+	{
+		shots[i].row = record->shots[LOG_SHOT_SIZE * i];
+		shots[i].col = record->shots[LOG_SHOT_SIZE * i + 1];
+	}
+	fireShots(game, shots, record->shotsNum, results);
+	for (i = 0; i < record->shotsNum; i++)
+	{
+		if (results[i] == SHOT_ALREADY || results[i] == SHOT_INVALID)
+		{
+			return 0;
+		}
+	}
+	return SHOT_IS_SUNK(results[record->shotsNum - 1]) && game->deadShips == game->shipsNum;
+}
+
+/**
+ * @brief Replays every game of a log.
+ * @param path The log path.
+ * @param game The game block to replay in.
+ * @param shots A buffer for MAX_REPLAY_SHOTS shots.
+ * @param results A buffer for MAX_REPLAY_SHOTS results.
+ * @param fleet A fleet filled with the recorded fleets.
+ * @param stats The replay results, updated.
+ * @return 0 on success, LOG_ERROR if the log could not be mapped.
+ */
+int replayLog(const char *path, Game *game, Shot *shots, int *results, Fleet *fleet,
+			  ReplayStats *stats)
+{
+	LogFile log;
+	LogBlock block;
+	LogGame record;
+	size_t offset = 0, gameOffset;
+	int status, read;
+	if (mapLog(path, &log) != 0)
+	{
+		perror(path);
+		return LOG_ERROR;
+	}
+	while ((status = readBlock(&log, &offset, &block)) != LOG_BLOCK_END)
+	{
+		if (status == LOG_BLOCK_TRUNCATED)
+		{
+			stats->truncatedLogs++;
+			break;
+		}
+		stats->blocks++;
+		if (status == LOG_BLOCK_CORRUPT)
+		{
+			stats->corruptBlocks++;
+			continue;
+		}
+		gameOffset = 0;
+		while ((read = readGame(&block, &gameOffset, &record)) > 0)
+		{
+			stats->games++;
+			stats->shots += record.shotsNum;
+			if (replayGame(game, &record, shots, results, fleet) == TRUE)
+			{
+				stats->verified++;
+			}
+			else
+			{
+				stats->failed++;
+			}
+		}
+		if (read < 0)
+		{
+			stats->corruptBlocks++;
+		}
+	}
+	unmapLog(&log);
+	return 0;
+}
+
+/**
+ * The main function.
+ * @return 0 if every log replayed correctly, an error code otherwise.
+ */
+int main(int argc, char *argv[])
+{
+	static Shot shots[MAX_REPLAY_SHOTS];
+	static int results[MAX_REPLAY_SHOTS];
+	static Fleet fleet = {MAX_FLEET_SHIPS, 1, MAX_FLEET_SHIPS, {1}};
+	ReplayStats stats = {0, 0, 0, 0, 0, 0, 0};
+	Game *game;
+	double start, seconds;
+	int i, status = 0;
+	if (argc < 2)
+	{
+		fprintf(stderr, USAGE_MSG, argv[0]);
+		return USAGE_ERROR;
+	}
+	game = newGame(BITBOARD_MAX_SIZE, &fleet);
+	if (game == NULL)
+	{
+		return MEMORY_ERROR;
+	}
+	start = monotonicSeconds();
+	for (i = 1; i < argc; i++)
+	{
+		if (replayLog(argv[i], game, shots, results, &fleet, &stats) != 0)
+		{
+			status = LOG_ERROR;
+		}
+	}
+	seconds = monotonicSeconds() - start;
+	freeGame(game);
+	printf("blocks: %ld\n", stats.blocks);
+	printf("corrupt blocks: %ld\n", stats.corruptBlocks);
+	printf("truncated logs: %ld\n", stats.truncatedLogs);
+	printf("games: %ld\n", stats.games);
+	printf("verified games: %ld\n", stats.verified);
+	printf("failed games: %ld\n", stats.failed);
+	printf("shots: %ld\n", stats.shots);
+	printf("seconds: %.3f\n", seconds);
+	printf("shots per second: %.0f\n", seconds > 0 ? (double) stats.shots / seconds : 0.0);
+	if (stats.corruptBlocks > 0 || stats.truncatedLogs > 0 || stats.failed > 0)
+	{
+		status = LOG_ERROR;
+	}
+	return status;
+}
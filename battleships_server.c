@@ -0,0 +1,224 @@
+/**
+ * @file battleships_server.c
+ * @version 2.0
+ *
+ * @brief A battleships server hosting many concurrent games.
+ *
+ * @section DESCRIPTION
+ * The program listens on a Unix domain socket or on loopback TCP and plays an independent game
+ * with every connection (see game_server.h for the protocol), until it is interrupted.
+ * Input  : Command line options - the socket path (-u) or the TCP port (-p, DEFAULT_PORT by
+ *          default), the board size (-s), the number of event loops (-t, one per core by
+ *          default), the maximal number of sessions of every loop (-n) and the random seed (-r).
+ *          The fleet is described with -F or read from a config file with -c (see fleet.h).
+ * Process: placing a random fleet for every game and answering the moves of every client.
+ * Output : The number of sessions, moves and games served, printed when the server stops.
+ */
+// ------------------------------ includes ------------------------------
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+#include <unistd.h>
+#include "game_server.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def USAGE_ERROR 1
+ * @brief the integer returned if the command line options are wrong.
+ */
+#define USAGE_ERROR 1
+
+/**
+ * @def BOARD_SIZE_ERROR 3
+ * @brief the integer returned if the board size is out of the allowed range.
+ */
+#define BOARD_SIZE_ERROR 3
+
+/**
+ * @def WRONG_BOARD_SIZE_MSG "You've entered a wrong size for the board."
+ * @brief the message printed to the screen when the board size is out of the allowed range.
+ */
+#define WRONG_BOARD_SIZE_MSG "You've entered a wrong size for the board."
+
+/**
+ * @def FLEET_ERROR 5
+ * @brief the integer returned if the fleet description is wrong or does not fit the board.
+ */
+#define FLEET_ERROR 5
+
+/**
+ * @def WRONG_FLEET_MSG "You've entered a wrong fleet."
+ * @brief the message printed to the screen when the fleet is wrong or does not fit the board.
+ */
+#define WRONG_FLEET_MSG "You've entered a wrong fleet."
+
+/**
+ * @def MAX_BOARD_SIZE 26
+ * @brief The maximal board size allowed in the game.
+ */
+#define MAX_BOARD_SIZE 26
+
+/**
+ * @def MIN_BOARD_SIZE 5
+ * @brief The minimal board size allowed in the game.
+ */
+#define MIN_BOARD_SIZE 5
+
+/**
+ * @def DEFAULT_BOARD_SIZE 10
+ * @brief The board size used when -s is not given.
+ */
+#define DEFAULT_BOARD_SIZE 10
+
+/**
+ * @def DEFAULT_PORT 7979
+ * @brief The TCP port used when neither -u nor -p is given.
+ */
+#define DEFAULT_PORT 7979
+
+/**
+ * @def DEFAULT_SESSIONS 16384
+ * @brief The maximal number of sessions of every event loop when -n is not given.
+ */
+#define DEFAULT_SESSIONS 16384
+
+/**
+ * @def LISTENING_MSG "listening on %s\n"
+ * @brief The message printed once the server accepts connections.
+ */
+#define LISTENING_MSG "listening on %s\n"
+
+/**
+ * @def USAGE_MSG
+ * @brief The message printed when the command line options are wrong.
+ */
+#define USAGE_MSG "usage: %s [-u socket path | -p port] [-s board size] [-t threads] " \
+				  "[-n sessions per thread] [-r seed] [-F fleet | -c fleet file]\n"
+
+// ------------------------------ globals ----------------------------
+
+/**
+ * Set by the signal handler to stop the server.
+ */
+static volatile sig_atomic_t gStop = 0;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Stops the server on SIGINT and SIGTERM.
+ * @param signal The signal number.
+ */
+static void stopServer(int signal)
+{
+	(void) signal;
+	gStop = 1;
+}
+
+/**
+ * @brief Raises the limit of open files to the hard limit, for many sessions.
+ */
+static void raiseFileLimit(void)
+{
+	struct rlimit limit;
+	if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
+	{
+		limit.rlim_cur = limit.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &limit);
+	}
+}
+
+/**
+ * The main function.
+ * @return 0 on success, an error code otherwise.
+ */
+int main(int argc, char *argv[])
+{
+	static Fleet fleet;
+	ServerConfig config = {DEFAULT_BOARD_SIZE, &fleet, (uint64_t) time(0),
+						   (int) sysconf(_SC_NPROCESSORS_ONLN), DEFAULT_SESSIONS, NULL,
+						   DEFAULT_PORT, &gStop};
+	ServerStats stats;
+	struct sigaction action;
+	char address[32];
+	int option, status, listener, fleetStatus = 1;
+	fleet = *defaultFleet();
+	while ((option = getopt(argc, argv, "u:p:s:t:n:r:F:c:")) != -1)
+	{
+		switch (option)
+		{
+			case 'u':
+				config.path = optarg;
+				break;
+			case 'p':
+				config.port = atoi(optarg);
+				break;
+			case 's':
+				config.boardSize = atoi(optarg);
+				break;
+			case 't':
+				config.threads = atoi(optarg);
+				break;
+			case 'n':
+				config.sessions = atoi(optarg);
+				break;
+			case 'r':
+				config.seed = (uint64_t) strtoull(optarg, NULL, 10);
+				break;
+			case 'F':
+				fleetStatus = parseFleet(optarg, &fleet);
+				break;
+			case 'c':
+				fleetStatus = loadFleetFile(optarg, &fleet);
+				break;
+			default:
+				fprintf(stderr, USAGE_MSG, argv[0]);
+				return USAGE_ERROR;
+		}
+	}
+	if (config.threads < 1 || config.sessions < 1 || config.port < 0 || config.port > 65535)
+	{
+		fprintf(stderr, USAGE_MSG, argv[0]);
+		return USAGE_ERROR;
+	}
+	if (config.boardSize < MIN_BOARD_SIZE || config.boardSize > MAX_BOARD_SIZE)
+	{
+		fprintf(stderr, WRONG_BOARD_SIZE_MSG);
+		return BOARD_SIZE_ERROR;
+	}
+	if (fleetStatus != 1 || fleet.maxLength > config.boardSize ||
+		fleet.cells > config.boardSize * config.boardSize)
+	{
+		fprintf(stderr, WRONG_FLEET_MSG);
+		return FLEET_ERROR;
+	}
+	raiseFileLimit();
+	listener = openServerSocket(&config);
+	if (listener < 0)
+	{
+		perror(config.path != NULL ? config.path : "socket");
+		return SERVER_ERROR;
+	}
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = stopServer;
+	sigaction(SIGINT, &action, NULL);
+	sigaction(SIGTERM, &action, NULL);
+	signal(SIGPIPE, SIG_IGN);
+	snprintf(address, sizeof(address), "127.0.0.1:%d", config.port);
+	printf(LISTENING_MSG, config.path != NULL ? config.path : address);
+	fflush(stdout);
+	status = runServer(&config, listener, &stats);
+	close(listener);
+	if (config.path != NULL)
+	{
+		unlink(config.path);
+	}
+	printf("sessions: %ld\n", stats.sessions);
+	printf("rejected sessions: %ld\n", stats.rejected);
+	printf("moves: %ld\n", stats.moves);
+	printf("games: %ld\n", stats.games);
+	return status;
+}
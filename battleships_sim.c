@@ -0,0 +1,270 @@
+/**
+ * @file battleships_sim.c
+ * @version 2.0
+ *
+ * @brief Headless batch simulation of battleships games.
+ *
+ * @section DESCRIPTION
+ * The program plays many complete games with a built in shooter and no console output per turn.
+ * Input  : Command line options - the number of games (-n), the board size (-s), the shooter
+ *          strategy (-p random|hunt|density|book), the master random seed (-r) and the number of
+ *          worker threads (-t, all the cores by default). The fleet is described with -F (e.g.
+ *          "5,4x2,3") or read from a config file with -c (see fleet.h), the classic five ships
+ *          by default. With -l every game is appended to a binary replay log (see replay_log.h),
+ *          with -b every worker plays GAME_BATCH_LANES games at once (see game_batch.h).
+ *          With -w the fleets are drawn from a weighted placement table (see fleet_weights.h),
+ *          whose board size and fleet replace -s, -F and -c.
+ * Process: placing a random fleet for every game and letting the shooter sink it.
+ * Output : The throughput in games per second and the distribution of shots needed to win.
+ */
+// ------------------------------ includes ------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "replay_log.h"
+#include "simulator.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def USAGE_ERROR 1
+ * @brief the integer returned if the command line options are wrong.
+ */
+#define USAGE_ERROR 1
+
+/**
+ * @def MEMORY_ERROR 2
+ * @brief the integer returned if one of the pointers is NULL .
+ */
+#define MEMORY_ERROR 2
+
+/**
+ * @def BOARD_SIZE_ERROR 3
+ * @brief the integer returned if the board size is out of the allowed range.
+ */
+#define BOARD_SIZE_ERROR 3
+
+/**
+ * @def WRONG_BOARD_SIZE_MSG "You've entered a wrong size for the board."
+ * @brief the message printed to the screen when the board size is out of the allowed range.
+ */
+#define WRONG_BOARD_SIZE_MSG "You've entered a wrong size for the board."
+
+/**
+ * @def FLEET_ERROR 5
+ * @brief the integer returned if the fleet description is wrong or does not fit the board.
+ */
+#define FLEET_ERROR 5
+
+/**
+ * @def WRONG_FLEET_MSG "You've entered a wrong fleet."
+ * @brief the message printed to the screen when the fleet is wrong or does not fit the board.
+ */
+#define WRONG_FLEET_MSG "You've entered a wrong fleet."
+
+/**
+ * @def WRONG_WEIGHTS_MSG "You've entered a wrong placement table."
+ * @brief the message printed to the screen when the weighted placement table can not be read.
+ */
+#define WRONG_WEIGHTS_MSG "You've entered a wrong placement table."
+
+/**
+ * @def MAX_BOARD_SIZE 26
+ * @brief The maximal board size allowed in the game.
+ */
+#define MAX_BOARD_SIZE 26
+
+/**
+ * @def MIN_BOARD_SIZE 5
+ * @brief The minimal board size allowed in the game.
+ */
+#define MIN_BOARD_SIZE 5
+
+/**
+ * @def DEFAULT_GAMES 10000
+ * @brief The number of games played when -n is not given.
+ */
+#define DEFAULT_GAMES 10000
+
+/**
+ * @def DEFAULT_BOARD_SIZE 10
+ * @brief The board size used when -s is not given.
+ */
+#define DEFAULT_BOARD_SIZE 10
+
+/**
+ * @def DEFAULT_STRATEGY "hunt"
+ * @brief The shooter strategy used when -p is not given.
+ */
+#define DEFAULT_STRATEGY "hunt"
+
+/**
+ * @def USAGE_MSG
+ * @brief The message printed when the command line options are wrong.
+ */
+#define USAGE_MSG "usage: %s [-n games] [-s board size] [-p random|hunt|density|book] [-r seed] " \
+				  "[-t threads] [-F fleet | -c fleet file] [-l log] [-b] [-w placement table]\n"
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Finds the smallest number of shots such that at least the given part of the games
+ * were won with no more shots.
+ * @param stats The batch results.
+ * @param part The part of the games, between 0 and 1.
+ * @return The number of shots.
+ */
+int percentile(const SimStats *stats, double part)
+{
+	long seen = 0;
+	int shots;
+	for (shots = 0; shots <= MAX_GAME_SHOTS; shots++)
+	{
+		seen += stats->histogram[shots];
+		if (seen > 0 && (double) seen >= part * (double) stats->games)
+		{
+			return shots;
+		}
+	}
+	return MAX_GAME_SHOTS;
+}
+
+/**
+ * @brief Prints the batch results.
+ * @param config The batch description.
+ * @param stats The batch results.
+ */
+void printReport(const SimConfig *config, const SimStats *stats)
+{
+	int shots;
+	printf("strategy: %s\n", config->strategy->name);
+	printf("board size: %d\n", config->boardSize);
+	printf("ships: %d\n", config->fleet->shipsNum);
+	printf("seed: %llu\n", (unsigned long long) config->seed);
+	printf("threads: %d\n", config->threads);
+	printf("games: %ld\n", stats->games);
+	printf("seconds: %.3f\n", stats->seconds);
+	printf("games per second: %.0f\n",
+		   stats->seconds > 0 ? (double) stats->games / stats->seconds : 0.0);
+	printf("mean shots: %.2f\n",
+		   stats->games > 0 ? (double) stats->shots / (double) stats->games : 0.0);
+	printf("min shots: %d\n", percentile(stats, 0.0));
+	printf("median shots: %d\n", percentile(stats, 0.5));
+	printf("p90 shots: %d\n", percentile(stats, 0.9));
+	printf("max shots: %d\n", percentile(stats, 1.0));
+	printf("shots,games\n");
+	for (shots = 0; shots <= MAX_GAME_SHOTS; shots++)
+	{
+		if (stats->histogram[shots] > 0)
+		{
+			printf("%d,%ld\n", shots, stats->histogram[shots]);
+		}
+	}
+}
+
+/**
+ * The main function.
+ * @return 0 on success, an error code otherwise.
+ */
+int main(int argc, char *argv[])
+{
+	static Fleet fleet;
+	static FleetWeights weights;
+	SimConfig config = {.boardSize = DEFAULT_BOARD_SIZE, .games = DEFAULT_GAMES,
+						.strategy = NULL, .fleet = &fleet, .seed = (uint64_t) time(0),
+						.threads = (int) sysconf(_SC_NPROCESSORS_ONLN), .logFd = -1, .batch = 0,
+						.weights = NULL};
+	const char *strategyName = DEFAULT_STRATEGY, *logPath = NULL, *weightsPath = NULL;
+	SimStats *stats;
+	int option, status, fleetStatus = 1;
+	fleet = *defaultFleet();
+	while ((option = getopt(argc, argv, "n:s:p:r:t:F:c:l:bw:")) != -1)
+	{
+		switch (option)
+		{
+			case 'n':
+				config.games = atol(optarg);
+				break;
+			case 's':
+				config.boardSize = atoi(optarg);
+				break;
+			case 'p':
+				strategyName = optarg;
+				break;
+			case 'r':
+				config.seed = (uint64_t) strtoull(optarg, NULL, 10);
+				break;
+			case 't':
+				config.threads = atoi(optarg);
+				break;
+			case 'F':
+				fleetStatus = parseFleet(optarg, &fleet);
+				break;
+			case 'c':
+				fleetStatus = loadFleetFile(optarg, &fleet);
+				break;
+			case 'l':
+				logPath = optarg;
+				break;
+			case 'b':
+				config.batch = 1;
+				break;
+			case 'w':
+				weightsPath = optarg;
+				break;
+			default:
+				fprintf(stderr, USAGE_MSG, argv[0]);
+				return USAGE_ERROR;
+		}
+	}
+	config.strategy = findStrategy(strategyName);
+	if (config.strategy == NULL || config.games < 0 || config.threads < 1)
+	{
+		fprintf(stderr, USAGE_MSG, argv[0]);
+		return USAGE_ERROR;
+	}
+	if (weightsPath != NULL)
+	{
+		if (loadFleetWeights(weightsPath, &weights) != 1)
+		{
+			fprintf(stderr, WRONG_WEIGHTS_MSG);
+			return FLEET_ERROR;
+		}
+		config.boardSize = weights.size;
+		fleet = weights.fleet;
+		config.weights = &weights;
+	}
+	if (config.boardSize < MIN_BOARD_SIZE || config.boardSize > MAX_BOARD_SIZE)
+	{
+		fprintf(stderr, WRONG_BOARD_SIZE_MSG);
+		return BOARD_SIZE_ERROR;
+	}
+	if (fleetStatus != 1 || fleet.maxLength > config.boardSize ||
+		fleet.cells > config.boardSize * config.boardSize)
+	{
+		fprintf(stderr, WRONG_FLEET_MSG);
+		return FLEET_ERROR;
+	}
+	if (logPath != NULL && (config.logFd = openLog(logPath)) < 0)
+	{
+		perror(logPath);
+		return LOG_ERROR;
+	}
+	stats = (SimStats *) malloc(sizeof(SimStats));
+	if (stats == NULL)
+	{
+		return MEMORY_ERROR;
+	}
+	status = runSimulation(&config, stats);
+	if (config.logFd >= 0)
+	{
+		close(config.logFd);
+	}
+	if (status == 0)
+	{
+		printReport(&config, stats);
+	}
+	free(stats);
+	return status;
+}
@@ -0,0 +1,330 @@
+/**
+ * @file battleships_snapshot.c
+ * @version 2.0
+ *
+ * @brief Round trip check of the game snapshots.
+ *
+ * @section DESCRIPTION
+ * The program pauses a batch of games in the middle of play, writes their snapshots to a file
+ * SNAPSHOT_BATCH records at a time, maps the file back and restores every record into a game
+ * block of a pool. Every game is then played again from its seed next to its restored copy: the
+ * two must hold the same board, ships and generator state, and must answer every shot of the
+ * rest of the game the same way.
+ * Input  : Command line options - the board size (-s), the number of games (-n), the master
+ *          random seed (-r) and the path of the snapshot file (-o, removed after the check).
+ * Process: writing, mapping, restoring and continuing the games.
+ * Output : The number of games, the size of the file, the write and restore throughput and the
+ *          number of games whose restored copy differs. The program fails if any does.
+ */
+// ------------------------------ includes ------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "game_pool.h"
+#include "game_snapshot.h"
+#include "monotonic.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def USAGE_ERROR 1
+ * @brief the integer returned if the command line options are wrong.
+ */
+#define USAGE_ERROR 1
+
+/**
+ * @def MEMORY_ERROR 2
+ * @brief the integer returned if one of the pointers is NULL .
+ */
+#define MEMORY_ERROR 2
+
+/**
+ * @def MISMATCH_ERROR 7
+ * @brief the integer returned if a restored game differs from the game it was taken of.
+ */
+#define MISMATCH_ERROR 7
+
+/**
+ * @def  TRUE 1
+ * @brief a true boolean value.
+ */
+#define TRUE 1
+
+/**
+ * @def MIN_BOARD_SIZE 5
+ * @brief The minimal board size allowed in the game.
+ */
+#define MIN_BOARD_SIZE 5
+
+/**
+ * @def DEFAULT_BOARD_SIZE 10
+ * @brief The board size used when -s is not given.
+ */
+#define DEFAULT_BOARD_SIZE 10
+
+/**
+ * @def DEFAULT_GAMES 20000
+ * @brief The number of games when -n is not given.
+ */
+#define DEFAULT_GAMES 20000
+
+/**
+ * @def DEFAULT_SEED 2018
+ * @brief The master seed when -r is not given.
+ */
+#define DEFAULT_SEED 2018
+
+/**
+ * @def DEFAULT_SNAPSHOT_PATH "snapshots.check"
+ * @brief The path of the snapshot file when -o is not given.
+ */
+#define DEFAULT_SNAPSHOT_PATH "snapshots.check"
+
+/**
+ * @def SNAPSHOT_BATCH 1024
+ * @brief The number of snapshots written to the file at once.
+ */
+#define SNAPSHOT_BATCH 1024
+
+/**
+ * @def USAGE_MSG
+ * @brief The message printed when the command line options are wrong.
+ */
+#define USAGE_MSG "usage: %s [-s board size] [-n games] [-r seed] [-o snapshot file]\n"
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Fires a shot at a random cell not shot yet.
+ * @param game The game, not over.
+ * @param rng The random numbers generator of the game.
+ * @return The shot result, as returned by fireShot.
+ */
+static int randomShot(Game *game, Rng *rng)
+{
+	int row, col, size = game->board.size;
+	do
+	{
+		row = (int) rngBelow(rng, (uint32_t) size);
+		col = (int) rngBelow(rng, (uint32_t) size);
+	} while (bbTest(&game->board.shots, row, col));
+	return fireShot(game, row, col);
+}
+
+/**
+ * @brief Starts a game from its seed and plays it up to the point it is paused at, a random
+ * number of shots into the game.
+ * @param pool The pool the game is taken from.
+ * @param seed The master seed.
+ * @param index The index of the game.
+ * @param rng Set to the random numbers generator of the game.
+ * @return The game, NULL if its fleet could not be placed.
+ */
+static Game *pausedGame(GamePool *pool, uint64_t seed, long index, Rng *rng)
+{
+	Game *game;
+	int shots;
+	rngSeed(rng, seed, (uint64_t) index);
+	game = poolAcquire(pool, rng);
+	if (game == NULL)
+	{
+		return NULL;
+	}
+	shots = (int) rngBelow(rng, (uint32_t) (game->board.size * game->board.size));
+	while (shots-- > 0 && game->deadShips < game->shipsNum)
+	{
+		randomShot(game, rng);
+	}
+	return game;
+}
+
+/**
+ * @brief Pauses every game and appends its snapshot to the file.
+ * @param pool The pool of games.
+ * @param seed The master seed.
+ * @param games The number of games.
+ * @param path The snapshot file path.
+ * @return 0 on success, MEMORY_ERROR or SNAPSHOT_ERROR otherwise.
+ */
+static int writeGames(GamePool *pool, uint64_t seed, long games, const char *path)
+{
+	static GameSnapshot snapshots[SNAPSHOT_BATCH];
+	Game *game;
+	Rng rng;
+	long i;
+	int count = 0, status = 0, fd = openSnapshots(path);
+	if (fd < 0)
+	{
+		return SNAPSHOT_ERROR;
+	}
+	for (i = 0; i < games && status == 0; i++)
+	{
+		game = pausedGame(pool, seed, i, &rng);
+		if (game == NULL || snapshotGame(game, &rng, &snapshots[count++]) != TRUE)
+		{
+			status = MEMORY_ERROR;
+		}
+		poolRelease(pool, game);
+		if (status == 0 && (count == SNAPSHOT_BATCH || i == games - 1))
+		{
+			status = writeSnapshots(fd, snapshots, (size_t) count);
+			count = 0;
+		}
+	}
+	if (close(fd) != 0 && status == 0)
+	{
+		status = SNAPSHOT_ERROR;
+	}
+	return status;
+}
+
+/**
+ * @brief Checks that two games hold the same board, ships and generator state.
+ * @param game The game.
+ * @param rng The random numbers generator of the game.
+ * @param copy The restored game.
+ * @param copyRng The restored generator.
+ * @return Non zero if the games are the same.
+ */
+static int sameGame(const Game *game, const Rng *rng, const Game *copy, const Rng *copyRng)
+{
+	int row, col, size = game->board.size;
+	if (!bbEquals(&game->board.ships, &copy->board.ships) ||
+		!bbEquals(&game->board.shots, &copy->board.shots) ||
+		!bbEquals(&game->board.hits, &copy->board.hits) || game->deadShips != copy->deadShips ||
+		memcmp(game->shipData, copy->shipData, (size_t) (SNAPSHOT_SHIP_FIELDS * game->shipsNum)) ||
+		memcmp(rng->state, copyRng->state, sizeof(rng->state)) != 0)
+	{
+		return 0;
+	}
+	for (row = 0; row < size; row++)
+	{
+		for (col = 0; col < size; col++)
+		{
+			if (bbTest(&game->board.ships, row, col) &&
+				game->board.shipIds[row][col] != copy->board.shipIds[row][col])
+			{
+				return 0;
+			}
+		}
+	}
+	return 1;
+}
+
+/**
+ * @brief Restores every snapshot of the file and plays the rest of its game next to the game
+ * played again from its seed.
+ * @param pool The pool of games, of two blocks.
+ * @param seed The master seed.
+ * @param file The mapped snapshot file.
+ * @param restoreSeconds Filled with the time the restores took.
+ * @return The number of games whose restored copy differs, -1 if a game could not be started.
+ */
+static long checkGames(GamePool *pool, uint64_t seed, const SnapshotFile *file,
+					   double *restoreSeconds)
+{
+	Game *game, *copy;
+	Rng rng, copyRng;
+	long i, mismatches = 0;
+	double start;
+	int same;
+	*restoreSeconds = 0;
+	for (i = 0; i < (long) file->count; i++)
+	{
+		game = pausedGame(pool, seed, i, &rng);
+		copy = poolAcquire(pool, &copyRng);
+		if (game == NULL || copy == NULL)
+		{
+			poolRelease(pool, game);
+			poolRelease(pool, copy);
+			return -1;
+		}
+		start = monotonicSeconds();
+		same = restoreGame(copy, &copyRng, &file->snapshots[i]) == TRUE;
+		*restoreSeconds += monotonicSeconds() - start;
+		same = same && sameGame(game, &rng, copy, &copyRng);
+		while (same && game->deadShips < game->shipsNum)
+		{
+			same = randomShot(game, &rng) == randomShot(copy, &copyRng);
+		}
+		mismatches += !same;
+		poolRelease(pool, game);
+		poolRelease(pool, copy);
+	}
+	return mismatches;
+}
+
+/**
+ * The main function.
+ * @return 0 if every game was restored, an error code otherwise.
+ */
+int main(int argc, char *argv[])
+{
+	const char *path = DEFAULT_SNAPSHOT_PATH;
+	int option, size = DEFAULT_BOARD_SIZE, status;
+	long games = DEFAULT_GAMES, mismatches = 0;
+	uint64_t seed = DEFAULT_SEED;
+	double start, writeSeconds, restoreSeconds = 0;
+	SnapshotFile file;
+	GamePool *pool;
+	while ((option = getopt(argc, argv, "s:n:r:o:")) != -1)
+	{
+		switch (option)
+		{
+			case 's':
+				size = atoi(optarg);
+				break;
+			case 'n':
+				games = atol(optarg);
+				break;
+			case 'r':
+				seed = (uint64_t) strtoull(optarg, NULL, 10);
+				break;
+			case 'o':
+				path = optarg;
+				break;
+			default:
+				fprintf(stderr, USAGE_MSG, argv[0]);
+				return USAGE_ERROR;
+		}
+	}
+	if (size < MIN_BOARD_SIZE || size > BITBOARD_MAX_SIZE || games < 1)
+	{
+		fprintf(stderr, USAGE_MSG, argv[0]);
+		return USAGE_ERROR;
+	}
+	pool = newGamePool(size, defaultFleet(), 2);
+	if (pool == NULL)
+	{
+		return MEMORY_ERROR;
+	}
+	unlink(path);
+	start = monotonicSeconds();
+	status = writeGames(pool, seed, games, path);
+	writeSeconds = monotonicSeconds() - start;
+	if (status == 0)
+	{
+		status = mapSnapshots(path, &file);
+	}
+	if (status == 0)
+	{
+		mismatches = file.count == (size_t) games ? checkGames(pool, seed, &file, &restoreSeconds) :
+					 games;
+		status = mismatches < 0 ? MEMORY_ERROR : mismatches > 0 ? MISMATCH_ERROR : 0;
+		printf("games: %ld\n", games);
+		printf("file bytes: %zu\n", file.length);
+		printf("snapshots written per second: %.0f\n", games / writeSeconds);
+		printf("snapshots restored per second: %.0f\n",
+			   restoreSeconds > 0 ? games / restoreSeconds : 0.0);
+		printf("mismatches: %ld\n", mismatches);
+		unmapSnapshots(&file);
+	}
+	else
+	{
+		perror(path);
+	}
+	unlink(path);
+	freeGamePool(pool);
+	return status;
+}
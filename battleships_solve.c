@@ -0,0 +1,295 @@
+/**
+ * @file battleships_solve.c
+ * @version 2.0
+ *
+ * @brief Prints the exact probability of every cell to hold a ship, part way through a game.
+ *
+ * @section DESCRIPTION
+ * The program plays the first shots of a seeded game with a built in shooter and asks the
+ * posterior solver (see posterior.h) where the rest of the fleet may be.
+ * Input  : Command line options - the board size (-s), the shooter strategy
+ *          (-p random|hunt|density|book), the random seed (-r), the number of shots fired before
+ *          the query (-k), the number of solver threads (-t, all the cores by default) and -u to
+ *          count every consistent layout once instead of weighting it by the placement odds. The
+ *          fleet is described with -F (e.g. "5,4x2,3") or read from a config file with -c (see
+ *          fleet.h), the classic five ships by default.
+ * Process: firing the shots, collecting their results and solving the query.
+ * Output : The board as the shooter sees it, the probability of every unknown cell in percents,
+ *          the cell most likely to hold a ship, the number of partial layouts visited and the
+ *          solving time.
+ */
+// ------------------------------ includes ------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "monotonic.h"
+#include "posterior.h"
+#include "strategies.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def USAGE_ERROR 1
+ * @brief the integer returned if the command line options are wrong.
+ */
+#define USAGE_ERROR 1
+
+/**
+ * @def MEMORY_ERROR 2
+ * @brief the integer returned if one of the pointers is NULL .
+ */
+#define MEMORY_ERROR 2
+
+/**
+ * @def BOARD_SIZE_ERROR 3
+ * @brief the integer returned if the board size is out of the allowed range.
+ */
+#define BOARD_SIZE_ERROR 3
+
+/**
+ * @def WRONG_BOARD_SIZE_MSG "You've entered a wrong size for the board."
+ * @brief the message printed to the screen when the board size is out of the allowed range.
+ */
+#define WRONG_BOARD_SIZE_MSG "You've entered a wrong size for the board."
+
+/**
+ * @def FLEET_ERROR 5
+ * @brief the integer returned if the fleet description is wrong or does not fit the board.
+ */
+#define FLEET_ERROR 5
+
+/**
+ * @def WRONG_FLEET_MSG "You've entered a wrong fleet."
+ * @brief the message printed to the screen when the fleet is wrong or does not fit the board.
+ */
+#define WRONG_FLEET_MSG "You've entered a wrong fleet."
+
+/**
+ * @def SOLVE_ERROR 6
+ * @brief the integer returned if the query could not be solved.
+ */
+#define SOLVE_ERROR 6
+
+/**
+ * @def MAX_BOARD_SIZE 26
+ * @brief The maximal board size allowed in the game.
+ */
+#define MAX_BOARD_SIZE 26
+
+/**
+ * @def MIN_BOARD_SIZE 5
+ * @brief The minimal board size allowed in the game.
+ */
+#define MIN_BOARD_SIZE 5
+
+/**
+ * @def DEFAULT_BOARD_SIZE 10
+ * @brief The board size used when -s is not given.
+ */
+#define DEFAULT_BOARD_SIZE 10
+
+/**
+ * @def DEFAULT_SHOTS 40
+ * @brief The number of shots fired before the query when -k is not given.
+ */
+#define DEFAULT_SHOTS 40
+
+/**
+ * @def DEFAULT_STRATEGY "hunt"
+ * @brief The shooter strategy used when -p is not given.
+ */
+#define DEFAULT_STRATEGY "hunt"
+
+/**
+ * @def USAGE_MSG
+ * @brief The message printed when the command line options are wrong.
+ */
+#define USAGE_MSG "usage: %s [-s board size] [-p random|hunt|density|book] [-r seed] [-k shots] " \
+				  "[-t threads] [-F fleet | -c fleet file] [-u]\n"
+
+/**
+ * @def SOLVE_FAILED_MSG
+ * @brief The message printed when the query could not be solved, with the reason.
+ */
+#define SOLVE_FAILED_MSG "The query could not be solved: %s.\n"
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Fires the first shots of a game, adding their results to the query.
+ * @param game The game, with its fleet placed.
+ * @param shooter The shooter.
+ * @param shots The number of shots to fire.
+ * @param query The observations.
+ * @return The number of shots fired, less than asked if the fleet was sunk.
+ */
+static int playShots(Game *game, Shooter *shooter, int shots, PosteriorQuery *query)
+{
+	int row, col, result, length, fired = 0;
+	while (fired < shots && game->deadShips < game->shipsNum)
+	{
+		shooterNextShot(shooter, &row, &col);
+		result = fireShot(game, row, col);
+		length = SHOT_IS_SUNK(result) ? game->ships.length[SHOT_SUNK_SHIP(result)] : 0;
+		shooterObserve(shooter, row, col, SHOT_IS_SUNK(result) ? SHOT_SUNK : result, length);
+		posteriorObserve(query, row, col, result, length);
+		fired++;
+	}
+	return fired;
+}
+
+/**
+ * @brief Prints the board as the shooter sees it next to the probability of every cell: a miss
+ * is 'o', a hit is 'x', and an unknown cell shows its probability in percents.
+ * @param query The observations.
+ * @param posterior The solution.
+ */
+static void printPosterior(const PosteriorQuery *query, const Posterior *posterior)
+{
+	int row, col, bestRow = 0, bestCol = 0;
+	double best = -1.0;
+	for (row = 0; row < query->size; row++)
+	{
+		for (col = 0; col < query->size; col++)
+		{
+			if (bbTest(&query->misses, row, col))
+			{
+				printf("   o");
+			}
+			else if (bbTest(&query->hits, row, col))
+			{
+				printf("   x");
+			}
+			else
+			{
+				printf(" %3.0f", 100.0 * posterior->cells[row][col]);
+				if (posterior->cells[row][col] > best)
+				{
+					best = posterior->cells[row][col];
+					bestRow = row;
+					bestCol = col;
+				}
+			}
+		}
+		printf("\n");
+	}
+	if (best >= 0.0)
+	{
+		printf("best cell: %c%d (%.2f%%)\n", 'a' + bestRow, bestCol + 1, 100.0 * best);
+	}
+}
+
+/**
+ * The main function.
+ * @return 0 on success, an error code otherwise.
+ */
+int main(int argc, char *argv[])
+{
+	static Fleet fleet;
+	static PosteriorQuery query;
+	static Posterior posterior;
+	const char *strategyName = DEFAULT_STRATEGY;
+	const ShooterStrategy *strategy;
+	uint64_t seed = (uint64_t) time(0);
+	int option, fired, status, size = DEFAULT_BOARD_SIZE, shots = DEFAULT_SHOTS, uniform = 0;
+	int fleetStatus = 1, threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+	Shooter *shooter;
+	Game *game;
+	Rng rng, shooterRng;
+	double start, seconds;
+	fleet = *defaultFleet();
+	while ((option = getopt(argc, argv, "s:p:r:k:t:F:c:u")) != -1)
+	{
+		switch (option)
+		{
+			case 's':
+				size = atoi(optarg);
+				break;
+			case 'p':
+				strategyName = optarg;
+				break;
+			case 'r':
+				seed = (uint64_t) strtoull(optarg, NULL, 10);
+				break;
+			case 'k':
+				shots = atoi(optarg);
+				break;
+			case 't':
+				threads = atoi(optarg);
+				break;
+			case 'F':
+				fleetStatus = parseFleet(optarg, &fleet);
+				break;
+			case 'c':
+				fleetStatus = loadFleetFile(optarg, &fleet);
+				break;
+			case 'u':
+				uniform = 1;
+				break;
+			default:
+				fprintf(stderr, USAGE_MSG, argv[0]);
+				return USAGE_ERROR;
+		}
+	}
+	strategy = findStrategy(strategyName);
+	if (strategy == NULL || shots < 0 || threads < 1)
+	{
+		fprintf(stderr, USAGE_MSG, argv[0]);
+		return USAGE_ERROR;
+	}
+	if (size < MIN_BOARD_SIZE || size > MAX_BOARD_SIZE)
+	{
+		fprintf(stderr, WRONG_BOARD_SIZE_MSG);
+		return BOARD_SIZE_ERROR;
+	}
+	if (fleetStatus != 1 || fleet.maxLength > size || fleet.cells > size * size)
+	{
+		fprintf(stderr, WRONG_FLEET_MSG);
+		return FLEET_ERROR;
+	}
+	game = newGame(size, &fleet);
+	shooter = (Shooter *) malloc(sizeof(Shooter));
+	if (game == NULL || shooter == NULL)
+	{
+		freeGame(game);
+		free(shooter);
+		return MEMORY_ERROR;
+	}
+	rngSeed(&rng, seed, 0);
+	rngSeed(&shooterRng, seed, 1);
+	if (resetGame(game, &rng) != 1)
+	{
+		freeGame(game);
+		free(shooter);
+		fprintf(stderr, WRONG_FLEET_MSG);
+		return FLEET_ERROR;
+	}
+	shooterReset(shooter, strategy, size, &fleet, &shooterRng);
+	posteriorReset(&query, size, &fleet, uniform);
+	fired = playShots(game, shooter, shots, &query);
+	start = monotonicSeconds();
+	status = solvePosterior(&query, threads, &posterior);
+	seconds = monotonicSeconds() - start;
+	printf("strategy: %s\n", strategy->name);
+	printf("board size: %d\n", size);
+	printf("seed: %llu\n", (unsigned long long) seed);
+	printf("shots: %d\n", fired);
+	printf("sunk: %d of %d\n", game->deadShips, game->shipsNum);
+	printf("weighting: %s\n", uniform ? "uniform" : "placement");
+	printf("threads: %d\n", threads);
+	printf("states: %ld\n", posterior.states);
+	printf("seconds: %.4f\n", seconds);
+	freeGame(game);
+	free(shooter);
+	if (status != POSTERIOR_OK)
+	{
+		fprintf(stderr, SOLVE_FAILED_MSG, status == POSTERIOR_INCONSISTENT ? "inconsistent shots" :
+										  status == POSTERIOR_TOO_LARGE ? "too many layouts" :
+										  "out of memory");
+		return SOLVE_ERROR;
+	}
+	printf("layouts weight: %g\n", posterior.total);
+	printPosterior(&query, &posterior);
+	return 0;
+}
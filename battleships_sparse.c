@@ -0,0 +1,203 @@
+/**
+ * @file battleships_sparse.c
+ * @version 2.0
+ *
+ * @brief Stress scenarios on huge sparse boards.
+ *
+ * @section DESCRIPTION
+ * The program places many fleets on a sparse board, fires random shots at it and then sinks
+ * every ship, without printing the board.
+ * Input  : Command line options - the board size (-s), the number of fleets (-f), the number of
+ *          random shots (-n) and the random seed (-r).
+ * Process: placing the fleets, firing the random shots and then firing at every ship cell.
+ * Output : The time of every phase, the number of sunk ships and the memory the board holds.
+ */
+// ------------------------------ includes ------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "monotonic.h"
+#include "sparse_board.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def USAGE_ERROR 1
+ * @brief the integer returned if the command line options are wrong.
+ */
+#define USAGE_ERROR 1
+
+/**
+ * @def MEMORY_ERROR 2
+ * @brief the integer returned if one of the pointers is NULL or the fleets could not be placed.
+ */
+#define MEMORY_ERROR 2
+
+/**
+ * @def GAME_ERROR 3
+ * @brief the integer returned if the board is not over after every ship cell was shot.
+ */
+#define GAME_ERROR 3
+
+/**
+ * @def  TRUE 1
+ * @brief a true boolean value.
+ */
+#define TRUE 1
+
+/**
+ * @def MIN_BOARD_SIZE 5
+ * @brief The minimal board size allowed in the game.
+ */
+#define MIN_BOARD_SIZE 5
+
+/**
+ * @def DEFAULT_BOARD_SIZE 1000000
+ * @brief The board size used when -s is not given.
+ */
+#define DEFAULT_BOARD_SIZE SPARSE_MAX_SIZE
+
+/**
+ * @def DEFAULT_FLEETS 1000
+ * @brief The number of fleets placed when -f is not given.
+ */
+#define DEFAULT_FLEETS 1000
+
+/**
+ * @def DEFAULT_SHOTS 1000000
+ * @brief The number of random shots fired when -n is not given.
+ */
+#define DEFAULT_SHOTS 1000000
+
+/**
+ * @def USAGE_MSG
+ * @brief The message printed when the command line options are wrong.
+ */
+#define USAGE_MSG "usage: %s [-s board size] [-f fleets] [-F fleet | -c fleet file] " \
+				  "[-n random shots] [-r seed]\n"
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Fires random shots at the board.
+ * @param board The board.
+ * @param shots The number of shots.
+ * @param rng The random numbers generator.
+ * @return The number of shots that hit a ship.
+ */
+long fireRandomShots(SparseBoard *board, long shots, Rng *rng)
+{
+	long i, hits = 0;
+	int result;
+	for (i = 0; i < shots; i++)
+	{
+		result = sparseShoot(board, (int) rngBelow(rng, (uint32_t) board->size),
+							 (int) rngBelow(rng, (uint32_t) board->size));
+		hits += result == SHOT_HIT || SHOT_IS_SUNK(result);
+	}
+	return hits;
+}
+
+/**
+ * @brief Fires at every cell of every ship of the board.
+ * @param board The board.
+ * @return The number of shots fired.
+ */
+long sinkAll(SparseBoard *board)
+{
+	const Ship *ship;
+	long shots = 0;
+	int i, k;
+	for (i = 0; i < board->shipsNum; i++)
+	{
+		ship = &board->ships[i];
+		for (k = 0; k < ship->length; k++, shots++)
+		{
+			sparseShoot(board, ship->row + (ship->angle == VERTICAL ? k : 0),
+						ship->col + (ship->angle == VERTICAL ? 0 : k));
+		}
+	}
+	return shots;
+}
+
+/**
+ * The main function.
+ * @return 0 on success, an error code otherwise.
+ */
+int main(int argc, char *argv[])
+{
+	static Fleet fleet;
+	int size = DEFAULT_BOARD_SIZE, fleets = DEFAULT_FLEETS, option, status, fleetStatus = TRUE;
+	long shots = DEFAULT_SHOTS, hits, sinkShots;
+	uint64_t seed = (uint64_t) time(0);
+	double start, placed, shot, sunk;
+	SparseBoard *board;
+	Rng rng;
+	fleet = *defaultFleet();
+	while ((option = getopt(argc, argv, "s:f:F:c:n:r:")) != -1)
+	{
+		switch (option)
+		{
+			case 's':
+				size = atoi(optarg);
+				break;
+			case 'f':
+				fleets = atoi(optarg);
+				break;
+			case 'F':
+				fleetStatus = parseFleet(optarg, &fleet);
+				break;
+			case 'c':
+				fleetStatus = loadFleetFile(optarg, &fleet);
+				break;
+			case 'n':
+				shots = atol(optarg);
+				break;
+			case 'r':
+				seed = (uint64_t) strtoull(optarg, NULL, 10);
+				break;
+			default:
+				fprintf(stderr, USAGE_MSG, argv[0]);
+				return USAGE_ERROR;
+		}
+	}
+	if (size < MIN_BOARD_SIZE || size > SPARSE_MAX_SIZE || fleets < 1 || shots < 0 ||
+		fleetStatus != TRUE || fleet.maxLength > size)
+	{
+		fprintf(stderr, USAGE_MSG, argv[0]);
+		return USAGE_ERROR;
+	}
+	rngSeed(&rng, seed, 0);
+	board = newSparseBoard(size);
+	if (board == NULL)
+	{
+		return MEMORY_ERROR;
+	}
+	start = monotonicSeconds();
+	if (sparsePlaceFleets(board, &fleet, fleets, &rng) != TRUE)
+	{
+		freeSparseBoard(board);
+		return MEMORY_ERROR;
+	}
+	placed = monotonicSeconds();
+	hits = fireRandomShots(board, shots, &rng);
+	shot = monotonicSeconds();
+	sinkShots = sinkAll(board);
+	sunk = monotonicSeconds();
+	printf("board size: %d\n", size);
+	printf("seed: %llu\n", (unsigned long long) seed);
+	printf("ships: %d\n", board->shipsNum);
+	printf("placement seconds: %.3f\n", placed - start);
+	printf("random shots: %ld\n", shots);
+	printf("random hits: %ld\n", hits);
+	printf("random shots per second: %.0f\n",
+		   shot > placed ? (double) shots / (shot - placed) : 0.0);
+	printf("sinking shots: %ld\n", sinkShots);
+	printf("sinking seconds: %.3f\n", sunk - shot);
+	printf("sunk ships: %d\n", board->deadShips);
+	printf("memory bytes: %zu\n", sparseMemory(board));
+	status = sparseGameOver(board) == TRUE ? 0 : GAME_ERROR;
+	freeSparseBoard(board);
+	return status;
+}
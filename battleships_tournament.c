@@ -0,0 +1,320 @@
+/**
+ * @file battleships_tournament.c
+ * @version 2.0
+ *
+ * @brief Round robin tournaments between built in players, each with its own fleet.
+ *
+ * @section DESCRIPTION
+ * The program plays the same number of matches between every two players and rates them.
+ * Input  : Command line options - the players (-P, a comma separated list of layout/shooter
+ *          pairs, e.g. "random/hunt,apart/density", every pair of a built in layout and a built
+ *          in shooter by default), the number of matches between every two players (-n), the
+ *          board size (-s), the master random seed (-r) and the number of worker threads (-t,
+ *          all the cores by default). The fleet is described with -F (e.g. "5,4x2,3") or read
+ *          from a config file with -c (see fleet.h), the classic five ships by default.
+ * Process: playing every match on the worker threads and fitting the ratings.
+ * Output : The throughput in matches per minute, the players ranked by their Elo rating with its
+ *          95% confidence interval, and the win rate of every player against every other one.
+ */
+// ------------------------------ includes ------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "tournament.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def USAGE_ERROR 1
+ * @brief the integer returned if the command line options are wrong.
+ */
+#define USAGE_ERROR 1
+
+/**
+ * @def MEMORY_ERROR 2
+ * @brief the integer returned if one of the pointers is NULL .
+ */
+#define MEMORY_ERROR 2
+
+/**
+ * @def BOARD_SIZE_ERROR 3
+ * @brief the integer returned if the board size is out of the allowed range.
+ */
+#define BOARD_SIZE_ERROR 3
+
+/**
+ * @def WRONG_BOARD_SIZE_MSG "You've entered a wrong size for the board."
+ * @brief the message printed to the screen when the board size is out of the allowed range.
+ */
+#define WRONG_BOARD_SIZE_MSG "You've entered a wrong size for the board."
+
+/**
+ * @def FLEET_ERROR 5
+ * @brief the integer returned if the fleet description is wrong or does not fit the board.
+ */
+#define FLEET_ERROR 5
+
+/**
+ * @def WRONG_FLEET_MSG "You've entered a wrong fleet."
+ * @brief the message printed to the screen when the fleet is wrong or does not fit the board.
+ */
+#define WRONG_FLEET_MSG "You've entered a wrong fleet."
+
+/**
+ * @def WRONG_PLAYERS_MSG
+ * @brief the message printed to the screen when the players list is wrong.
+ */
+#define WRONG_PLAYERS_MSG "You've entered a wrong list of players (layout/shooter,...).\n"
+
+/**
+ * @def MAX_BOARD_SIZE 26
+ * @brief The maximal board size allowed in the game.
+ */
+#define MAX_BOARD_SIZE 26
+
+/**
+ * @def MIN_BOARD_SIZE 5
+ * @brief The minimal board size allowed in the game.
+ */
+#define MIN_BOARD_SIZE 5
+
+/**
+ * @def DEFAULT_ROUNDS 2000
+ * @brief The number of matches between every two players when -n is not given.
+ */
+#define DEFAULT_ROUNDS 2000
+
+/**
+ * @def DEFAULT_BOARD_SIZE 10
+ * @brief The board size used when -s is not given.
+ */
+#define DEFAULT_BOARD_SIZE 10
+
+/**
+ * @def MAX_NAME_LENGTH 64
+ * @brief The room for the name of a player.
+ */
+#define MAX_NAME_LENGTH 64
+
+/**
+ * @def USAGE_MSG
+ * @brief The message printed when the command line options are wrong.
+ */
+#define USAGE_MSG "usage: %s [-P layout/shooter,...] [-n matches per pair] [-s board size] " \
+				  "[-r seed] [-t threads] [-F fleet | -c fleet file]\n"
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Reads a comma separated list of layout/shooter pairs.
+ * @param text The list.
+ * @param config Filled with the players.
+ * @return 1 on success, 0 if a pair is wrong or there are too many players.
+ */
+int parsePlayers(const char *text, TournamentConfig *config)
+{
+	char name[MAX_NAME_LENGTH];
+	const char *end;
+	char *slash;
+	size_t length;
+	config->playersNum = 0;
+	while (*text != '\0')
+	{
+		end = strchr(text, ',');
+		length = end != NULL ? (size_t) (end - text) : strlen(text);
+		if (length >= MAX_NAME_LENGTH || config->playersNum == MAX_PLAYERS)
+		{
+			return 0;
+		}
+		memcpy(name, text, length);
+		name[length] = '\0';
+		slash = strchr(name, '/');
+		if (slash == NULL)
+		{
+			return 0;
+		}
+		*slash = '\0';
+		config->players[config->playersNum].layout = findLayout(name);
+		config->players[config->playersNum].shooter = findStrategy(slash + 1);
+		if (config->players[config->playersNum].layout == NULL ||
+			config->players[config->playersNum].shooter == NULL)
+		{
+			return 0;
+		}
+		config->playersNum++;
+		text += length + (end != NULL);
+	}
+	return config->playersNum > 0;
+}
+
+/**
+ * @brief Enters every pair of a built in layout and a built in shooter.
+ * @param config Filled with the players.
+ */
+void allPlayers(TournamentConfig *config)
+{
+	int i, j;
+	config->playersNum = 0;
+	for (i = 0; layoutAt(i) != NULL; i++)
+	{
+		for (j = 0; strategyAt(j) != NULL && config->playersNum < MAX_PLAYERS; j++)
+		{
+			config->players[config->playersNum].layout = layoutAt(i);
+			config->players[config->playersNum].shooter = strategyAt(j);
+			config->playersNum++;
+		}
+	}
+}
+
+/**
+ * @brief Prints the tournament results.
+ * @param config The tournament description.
+ * @param stats The results.
+ * @param ratings The rating of every player.
+ */
+void printStandings(const TournamentConfig *config, const TournamentStats *stats,
+					const Rating *ratings)
+{
+	int order[MAX_PLAYERS], i, j, swap, count = config->playersNum;
+	char name[MAX_NAME_LENGTH];
+	const Rating *rating;
+	long games;
+	printf("board size: %d\n", config->boardSize);
+	printf("ships: %d\n", config->fleet->shipsNum);
+	printf("seed: %llu\n", (unsigned long long) config->seed);
+	printf("threads: %d\n", config->threads);
+	printf("players: %d\n", count);
+	printf("matches: %ld\n", stats->matches);
+	printf("seconds: %.3f\n", stats->seconds);
+	printf("matches per minute: %.0f\n",
+		   stats->seconds > 0 ? 60.0 * (double) stats->matches / stats->seconds : 0.0);
+	printf("mean shots per match: %.2f\n",
+		   stats->matches > 0 ? (double) stats->shots / (double) stats->matches : 0.0);
+	for (i = 0; i < count; i++)
+	{
+		order[i] = i;
+	}
+	for (i = 1; i < count; i++)
+	{
+		for (j = i; j > 0 && ratings[order[j]].elo > ratings[order[j - 1]].elo; j--)
+		{
+			swap = order[j];
+			order[j] = order[j - 1];
+			order[j - 1] = swap;
+		}
+	}
+	printf("rank,player,matches,wins,win rate,elo,elo low,elo high\n");
+	for (i = 0; i < count; i++)
+	{
+		rating = &ratings[order[i]];
+		snprintf(name, MAX_NAME_LENGTH, "%s/%s", config->players[order[i]].layout->name,
+				 config->players[order[i]].shooter->name);
+		printf("%d,%s,%ld,%ld,%.4f,%.1f,%.1f,%.1f\n", i + 1, name, rating->matches, rating->wins,
+			   rating->matches > 0 ? (double) rating->wins / (double) rating->matches : 0.0,
+			   rating->elo, rating->elo - rating->margin, rating->elo + rating->margin);
+	}
+	printf("win rate of the row player against the column player (ranked order):\n");
+	for (i = 0; i < count; i++)
+	{
+		for (j = 0; j < count; j++)
+		{
+			games = stats->wins[order[i]][order[j]] + stats->wins[order[j]][order[i]];
+			if (games > 0)
+			{
+				printf("%s%.3f", j > 0 ? "," : "",
+					   (double) stats->wins[order[i]][order[j]] / (double) games);
+			}
+			else
+			{
+				printf("%s-", j > 0 ? "," : "");
+			}
+		}
+		printf("\n");
+	}
+}
+
+/**
+ * The main function.
+ * @return 0 on success, an error code otherwise.
+ */
+int main(int argc, char *argv[])
+{
+	static Fleet fleet;
+	static TournamentConfig config;
+	TournamentStats *stats;
+	Rating ratings[MAX_PLAYERS];
+	int option, status, fleetStatus = 1, playersStatus = 1;
+	fleet = *defaultFleet();
+	config.boardSize = DEFAULT_BOARD_SIZE;
+	config.fleet = &fleet;
+	config.rounds = DEFAULT_ROUNDS;
+	config.seed = (uint64_t) time(0);
+	config.threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+	allPlayers(&config);
+	while ((option = getopt(argc, argv, "P:n:s:r:t:F:c:")) != -1)
+	{
+		switch (option)
+		{
+			case 'P':
+				playersStatus = parsePlayers(optarg, &config);
+				break;
+			case 'n':
+				config.rounds = atol(optarg);
+				break;
+			case 's':
+				config.boardSize = atoi(optarg);
+				break;
+			case 'r':
+				config.seed = (uint64_t) strtoull(optarg, NULL, 10);
+				break;
+			case 't':
+				config.threads = atoi(optarg);
+				break;
+			case 'F':
+				fleetStatus = parseFleet(optarg, &fleet);
+				break;
+			case 'c':
+				fleetStatus = loadFleetFile(optarg, &fleet);
+				break;
+			default:
+				fprintf(stderr, USAGE_MSG, argv[0]);
+				return USAGE_ERROR;
+		}
+	}
+	if (config.rounds < 1 || config.threads < 1)
+	{
+		fprintf(stderr, USAGE_MSG, argv[0]);
+		return USAGE_ERROR;
+	}
+	if (!playersStatus || config.playersNum < 2)
+	{
+		fprintf(stderr, WRONG_PLAYERS_MSG);
+		return USAGE_ERROR;
+	}
+	if (config.boardSize < MIN_BOARD_SIZE || config.boardSize > MAX_BOARD_SIZE)
+	{
+		fprintf(stderr, WRONG_BOARD_SIZE_MSG);
+		return BOARD_SIZE_ERROR;
+	}
+	if (fleetStatus != 1 || fleet.maxLength > config.boardSize ||
+		fleet.cells > config.boardSize * config.boardSize)
+	{
+		fprintf(stderr, WRONG_FLEET_MSG);
+		return FLEET_ERROR;
+	}
+	stats = (TournamentStats *) malloc(sizeof(TournamentStats));
+	if (stats == NULL)
+	{
+		return MEMORY_ERROR;
+	}
+	status = runTournament(&config, stats);
+	if (status == 0)
+	{
+		ratePlayers(&config, stats, ratings);
+		printStandings(&config, stats, ratings);
+	}
+	free(stats);
+	return status;
+}
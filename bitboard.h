@@ -0,0 +1,239 @@
+/**
+ * @file bitboard.h
+ * @version 2.0
+ *
+ * @brief Packed bit masks describing a whole game board.
+ *
+ * @section DESCRIPTION
+ * A bitboard keeps one bit per board cell for boards up to 26x26. Every row is stored in a
+ * 32 bit lane and two rows share one uint64_t word, so a whole board fits in 13 words and
+ * board wide questions (collision, game over, counting) are a few AND/OR/popcount operations.
+ * Bit j of row i stands for the cell in row i and column j.
+ * The loops over the rows of a board can be instantiated once for every board size with
+ * BITBOARD_KERNEL_SIZES, so each copy runs with a constant size and constant row masks.
+ */
+#ifndef BITBOARD_H_
+#define BITBOARD_H_
+
+// ------------------------------ includes ------------------------------
+#include <stdint.h>
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def BITBOARD_MAX_SIZE 26
+ * @brief The maximal board size (height and width) a bitboard can hold.
+ */
+#define BITBOARD_MAX_SIZE 26
+
+/**
+ * @def BITBOARD_ROW_BITS 32
+ * @brief The number of bits reserved for every row of the board.
+ */
+#define BITBOARD_ROW_BITS 32
+
+/**
+ * @def BITBOARD_WORDS 13
+ * @brief The number of 64 bit words holding a whole board (two rows per word).
+ */
+#define BITBOARD_WORDS ((BITBOARD_MAX_SIZE + 1) / 2)
+
+/**
+ * @def BITBOARD_MIN_KERNEL_SIZE 5
+ * @brief The smallest board size with kernels specialized for it.
+ */
+#define BITBOARD_MIN_KERNEL_SIZE 5
+
+/**
+ * @def BITBOARD_KERNEL_SIZES(X)
+ * @brief Expands the macro X once for every board size with specialized kernels, from
+ * BITBOARD_MIN_KERNEL_SIZE to BITBOARD_MAX_SIZE, in increasing order.
+ */
+#define BITBOARD_KERNEL_SIZES(X) \
+	X(5) X(6) X(7) X(8) X(9) X(10) X(11) X(12) X(13) X(14) X(15) X(16) X(17) X(18) X(19) \
+	X(20) X(21) X(22) X(23) X(24) X(25) X(26)
+
+/**
+ * @def BITBOARD_KERNEL
+ * @brief The storage of a function generic over the board size, always inlined so that every
+ * kernel instantiating it is compiled for its own constant size.
+ */
+#define BITBOARD_KERNEL static inline __attribute__((always_inline))
+
+// ------------------------------ structs ----------------------------
+
+/**
+ * a structure holding one bit for every cell of the board.
+ * words - the board rows, two 32 bit rows in every word (the even row in the low half).
+ */
+typedef struct Bitboard
+{
+	uint64_t words[BITBOARD_WORDS];
+} Bitboard;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Returns a row mask with the first size bits set.
+ * @param size The board size.
+ * @return The mask of the valid columns in a row.
+ */
+static inline uint32_t bbRowMask(int size)
+{
+	return (uint32_t) ((1ULL << size) - 1);
+}
+
+/**
+ * @brief Clears all the bits of the board.
+ * @param bb The bitboard.
+ */
+static inline void bbClear(Bitboard *bb)
+{
+	int i;
+	for (i = 0; i < BITBOARD_WORDS; i++)
+	{
+		bb->words[i] = 0;
+	}
+}
+
+/**
+ * @brief Returns the bits of a single row.
+ * @param bb The bitboard.
+ * @param row The row index.
+ * @return The row bits, bit j standing for column j.
+ */
+static inline uint32_t bbRow(const Bitboard *bb, int row)
+{
+	return (uint32_t) (bb->words[row >> 1] >> ((row & 1) * BITBOARD_ROW_BITS));
+}
+
+/**
+ * @brief Sets the given bits in a single row.
+ * @param bb The bitboard.
+ * @param row The row index.
+ * @param bits The bits to set, bit j standing for column j.
+ */
+static inline void bbOrRow(Bitboard *bb, int row, uint32_t bits)
+{
+	bb->words[row >> 1] |= (uint64_t) bits << ((row & 1) * BITBOARD_ROW_BITS);
+}
+
+/**
+ * @brief Tests a single cell.
+ * @param bb The bitboard.
+ * @param row The row index.
+ * @param col The column index.
+ * @return Non zero if the cell bit is set, 0 otherwise.
+ */
+static inline int bbTest(const Bitboard *bb, int row, int col)
+{
+	return (int) ((bbRow(bb, row) >> col) & 1U);
+}
+
+/**
+ * @brief Sets a single cell.
+ * @param bb The bitboard.
+ * @param row The row index.
+ * @param col The column index.
+ */
+static inline void bbSet(Bitboard *bb, int row, int col)
+{
+	bbOrRow(bb, row, 1U << col);
+}
+
+/**
+ * @brief Clears a single cell.
+ * @param bb The bitboard.
+ * @param row The row index.
+ * @param col The column index.
+ */
+static inline void bbUnset(Bitboard *bb, int row, int col)
+{
+	bb->words[row >> 1] &= ~((uint64_t) 1 << (col + (row & 1) * BITBOARD_ROW_BITS));
+}
+
+/**
+ * @brief Counts the set cells of the board.
+ * @param bb The bitboard.
+ * @return The number of set cells.
+ */
+static inline int bbCount(const Bitboard *bb)
+{
+	int i, count = 0;
+	for (i = 0; i < BITBOARD_WORDS; i++)
+	{
+		count += __builtin_popcountll(bb->words[i]);
+	}
+	return count;
+}
+
+/**
+ * @brief Counts the set cells of a board whose rows from size on are empty, reading only the
+ * words of the first size rows.
+ * @param bb The bitboard.
+ * @param size The board size.
+ * @return The number of set cells.
+ */
+static inline int bbCountRows(const Bitboard *bb, int size)
+{
+	int i, count = 0;
+	for (i = 0; i < (size + 1) / 2; i++)
+	{
+		count += __builtin_popcountll(bb->words[i]);
+	}
+	return count;
+}
+
+/**
+ * @brief Checks whether a board whose rows from size on are empty has no set cell, reading
+ * only the words of the first size rows.
+ * @param bb The bitboard.
+ * @param size The board size.
+ * @return Non zero if no cell is set, 0 otherwise.
+ */
+static inline int bbEmptyRows(const Bitboard *bb, int size)
+{
+	int i;
+	uint64_t any = 0;
+	for (i = 0; i < (size + 1) / 2; i++)
+	{
+		any |= bb->words[i];
+	}
+	return any == 0;
+}
+
+/**
+ * @brief Checks whether two boards share a set cell.
+ * @param a The first bitboard.
+ * @param b The second bitboard.
+ * @return Non zero if the boards intersect, 0 otherwise.
+ */
+static inline int bbIntersects(const Bitboard *a, const Bitboard *b)
+{
+	int i;
+	uint64_t common = 0;
+	for (i = 0; i < BITBOARD_WORDS; i++)
+	{
+		common |= a->words[i] & b->words[i];
+	}
+	return common != 0;
+}
+
+/**
+ * @brief Checks whether two boards hold exactly the same cells.
+ * @param a The first bitboard.
+ * @param b The second bitboard.
+ * @return Non zero if the boards are equal, 0 otherwise.
+ */
+static inline int bbEquals(const Bitboard *a, const Bitboard *b)
+{
+	int i;
+	uint64_t diff = 0;
+	for (i = 0; i < BITBOARD_WORDS; i++)
+	{
+		diff |= a->words[i] ^ b->words[i];
+	}
+	return diff == 0;
+}
+
+#endif /* BITBOARD_H_ */
@@ -0,0 +1,152 @@
+/**
+ * @file book.c
+ * @version 2.0
+ *
+ * @brief A memory mapped book of opening shots, computed offline for every board size and fleet.
+ *
+ * @section DESCRIPTION
+ * Opening a book maps the whole file read only and checks that every tree lies inside it, so
+ * finding a tree is a scan of the small entries directory and following it reads the mapped
+ * nodes in place.
+ */
+// ------------------------------ includes ------------------------------
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "book.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def FNV_OFFSET 0xcbf29ce484222325
+ * @brief The initial value of the 64 bit FNV-1a hash.
+ */
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+
+/**
+ * @def FNV_PRIME 0x100000001b3
+ * @brief The multiplier of the 64 bit FNV-1a hash.
+ */
+#define FNV_PRIME 0x100000001b3ULL
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Computes the key of a fleet from the number of ships of every length, the only part
+ * of the fleet the shooters see.
+ * @param counts The number of ships of every length, from 0 to maxLength.
+ * @param maxLength The length of the longest ship.
+ * @return The key.
+ */
+uint64_t bookFleetKey(const int counts[], int maxLength)
+{
+	uint64_t key = FNV_OFFSET;
+	int length;
+	for (length = 1; length <= maxLength; length++)
+	{
+		key = (key ^ (uint64_t) length) * FNV_PRIME;
+		key = (key ^ (uint64_t) counts[length]) * FNV_PRIME;
+	}
+	return key;
+}
+
+/**
+ * @brief Maps a book file and checks its directory.
+ * @param path The file path.
+ * @param book Filled with the mapping.
+ * @return 0 on success, BOOK_ERROR if the file could not be mapped or is not a valid book.
+ */
+int openBook(const char *path, OpeningBook *book)
+{
+	const BookHeader *header;
+	struct stat info;
+	void *data;
+	size_t nodes, end;
+	int i, fd = open(path, O_RDONLY);
+	book->data = NULL;
+	book->length = 0;
+	book->entriesNum = 0;
+	book->entries = NULL;
+	if (fd < 0)
+	{
+		return BOOK_ERROR;
+	}
+	if (fstat(fd, &info) != 0 || info.st_size < (off_t) sizeof(BookHeader))
+	{
+		close(fd);
+		return BOOK_ERROR;
+	}
+	data = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+	{
+		return BOOK_ERROR;
+	}
+	book->data = (const uint8_t *) data;
+	book->length = (size_t) info.st_size;
+	header = (const BookHeader *) data;
+	if (header->magic != BOOK_MAGIC || header->version != BOOK_VERSION ||
+		sizeof(BookHeader) + (size_t) header->entriesNum * sizeof(BookEntry) > book->length)
+	{
+		closeBook(book);
+		return BOOK_ERROR;
+	}
+	book->entriesNum = (int) header->entriesNum;
+	book->entries = (const BookEntry *) (book->data + sizeof(BookHeader));
+	for (i = 0; i < book->entriesNum; i++)
+	{
+		if (book->entries[i].depth > BOOK_MAX_DEPTH || book->entries[i].offset % 2 != 0)
+		{
+			closeBook(book);
+			return BOOK_ERROR;
+		}
+		nodes = ((size_t) 1 << book->entries[i].depth) - 1;
+		end = (size_t) book->entries[i].offset + nodes * sizeof(uint16_t);
+		if (end > book->length)
+		{
+			closeBook(book);
+			return BOOK_ERROR;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @brief Unmaps a book mapped by openBook.
+ * @param book The book.
+ */
+void closeBook(OpeningBook *book)
+{
+	if (book->data != NULL)
+	{
+		munmap((void *) book->data, book->length);
+	}
+	book->data = NULL;
+	book->length = 0;
+	book->entriesNum = 0;
+	book->entries = NULL;
+}
+
+/**
+ * @brief Finds the tree of a board size and fleet.
+ * @param book The book.
+ * @param size The board size.
+ * @param fleetKey The key of the fleet.
+ * @param nodesNum Filled with the number of nodes of the tree.
+ * @return The tree nodes, NULL if the book has no tree for them.
+ */
+const uint16_t *findOpening(const OpeningBook *book, int size, uint64_t fleetKey, int *nodesNum)
+{
+	int i;
+	for (i = 0; i < book->entriesNum; i++)
+	{
+		if (book->entries[i].size == size && book->entries[i].fleetKey == fleetKey)
+		{
+			*nodesNum = (1 << book->entries[i].depth) - 1;
+			return (const uint16_t *) (book->data + book->entries[i].offset);
+		}
+	}
+	*nodesNum = 0;
+	return NULL;
+}
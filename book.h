@@ -0,0 +1,142 @@
+/**
+ * @file book.h
+ * @version 2.0
+ *
+ * @brief A memory mapped book of opening shots, computed offline for every board size and fleet.
+ *
+ * @section DESCRIPTION
+ * The first shots of the density shooter depend only on the board size, the fleet and the
+ * results of the shots before them, so the book keeps them as a binary tree per board size and
+ * fleet: node 0 is the first shot, and the shot after node n is node 2n + 1 after a miss and
+ * node 2n + 2 after a hit. A sunk ship leaves the book. A tree of depth d holds 2^d - 1 nodes,
+ * each the cell (row * BITBOARD_ROW_BITS + col) of the shot, or BOOK_NO_SHOT where the shooter
+ * would have to draw a random cell.
+ * The file is a BookHeader, the entries directory and the trees, every tree at the offset given
+ * by its entry, so it is used in place after a single mmap. It is kept in the byte order of the
+ * machine that wrote it, and a book of the other byte order fails the magic check.
+ */
+#ifndef BOOK_H_
+#define BOOK_H_
+
+// ------------------------------ includes ------------------------------
+#include <stddef.h>
+#include <stdint.h>
+#include "fleet.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def BOOK_MAGIC 0x424f5342
+ * @brief The first word of a book file ("BSOB" on a little endian machine).
+ */
+#define BOOK_MAGIC 0x424f5342U
+
+/**
+ * @def BOOK_VERSION 1
+ * @brief The version of the book format.
+ */
+#define BOOK_VERSION 1
+
+/**
+ * @def BOOK_MAX_DEPTH 16
+ * @brief The maximal number of shots of a tree.
+ */
+#define BOOK_MAX_DEPTH 16
+
+/**
+ * @def BOOK_NO_SHOT 0xffff
+ * @brief The node value of a history after which the shooter leaves the book.
+ */
+#define BOOK_NO_SHOT 0xffff
+
+/**
+ * @def BOOK_ERROR 7
+ * @brief the integer returned if the book could not be read or written.
+ */
+#define BOOK_ERROR 7
+
+// ------------------------------ structs ----------------------------
+
+/**
+ * a structure holding the header of a book file. includes the following attributes:
+ * magic - BOOK_MAGIC.
+ * version - BOOK_VERSION.
+ * entriesNum - the number of trees.
+ * reserved - 0.
+ */
+typedef struct BookHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t entriesNum;
+	uint32_t reserved;
+} BookHeader;
+
+/**
+ * a structure describing a tree of a book file. includes the following attributes:
+ * fleetKey - the key of the fleet (see bookFleetKey).
+ * size - the board size.
+ * depth - the number of shots of the tree.
+ * reserved - 0.
+ * offset - the offset of the tree nodes from the start of the file.
+ */
+typedef struct BookEntry
+{
+	uint64_t fleetKey;
+	uint8_t size;
+	uint8_t depth;
+	uint16_t reserved;
+	uint32_t offset;
+} BookEntry;
+
+/**
+ * a structure holding a mapped book. includes the following attributes:
+ * data - the mapped file, NULL if no book is mapped.
+ * length - the length of the file.
+ * entriesNum - the number of trees.
+ * entries - the entries directory.
+ */
+typedef struct OpeningBook
+{
+	const uint8_t *data;
+	size_t length;
+	int entriesNum;
+	const BookEntry *entries;
+} OpeningBook;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Computes the key of a fleet from the number of ships of every length, the only part
+ * of the fleet the shooters see.
+ * @param counts The number of ships of every length, from 0 to maxLength.
+ * @param maxLength The length of the longest ship.
+ * @return The key.
+ */
+uint64_t bookFleetKey(const int counts[], int maxLength);
+
+/**
+ * @brief Maps a book file and checks its directory.
+ * @param path The file path.
+ * @param book Filled with the mapping.
+ * @return 0 on success, BOOK_ERROR if the file could not be mapped or is not a valid book.
+ */
+int openBook(const char *path, OpeningBook *book);
+
+/**
+ * @brief Unmaps a book mapped by openBook.
+ * @param book The book.
+ */
+void closeBook(OpeningBook *book);
+
+/**
+ * @brief Finds the tree of a board size and fleet.
+ * @param book The book.
+ * @param size The board size.
+ * @param fleetKey The key of the fleet.
+ * @param nodesNum Filled with the number of nodes of the tree.
+ * @return The tree nodes, NULL if the book has no tree for them.
+ */
+const uint16_t *findOpening(const OpeningBook *book, int size, uint64_t fleetKey, int *nodesNum);
+
+#endif /* BOOK_H_ */
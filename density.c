@@ -0,0 +1,481 @@
+/**
+ * @file density.c
+ * @version 2.0
+ *
+ * @brief Counting, for every cell, the legal placements of the ships still afloat covering it.
+ *
+ * @section DESCRIPTION
+ * The rows of the board are loaded to 32 lane vectors. For a ship of length L the legal
+ * horizontal starts are the free cells AND-ed with the free cells shifted by 1..L-1 columns, and
+ * the vertical starts are the free rows AND-ed with the free rows 1..L-1 below them, so a whole
+ * length is a handful of vector shifts. Every start mask is then shifted over the L cells of the
+ * ship and added to the bit sliced counters.
+ * The tracker keeps plain counters per ship length instead, together with the legal start cells
+ * of every length and angle, both copied from the placement table of the board size when a game
+ * starts. A miss visits only the L starts of each angle that could cross it,
+ * so a shot costs O(fleet x length^2) rather than a new count of the whole board.
+ */
+// ------------------------------ includes ------------------------------
+#include <string.h>
+#include "density.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def LANES 32
+ * @brief The number of lanes (rows) in a row vector.
+ */
+#define LANES BITBOARD_ROW_BITS
+
+/**
+ * @def PADDED_ROWS 96
+ * @brief The size of a rows buffer, holding a zero vector before and after the board rows, so
+ * vectors of rows shifted up or down can be loaded directly.
+ */
+#define PADDED_ROWS (3 * LANES)
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Loads the rows of a padded buffer, starting at a given row, to a vector.
+ * @param v Filled with the rows.
+ * @param rows The padded rows buffer.
+ * @param offset The first row to load, between -LANES and LANES.
+ */
+static inline void loadRows(RowVector *v, const uint32_t rows[PADDED_ROWS], int offset)
+{
+	memcpy(v, rows + LANES + offset, sizeof(RowVector));
+}
+
+/**
+ * @brief Fills a padded rows buffer with the rows of a bitboard.
+ * @param rows The padded rows buffer.
+ * @param bb The bitboard.
+ * @param size The board size.
+ * @param invert Non zero to load the cells which are not set (inside the board).
+ */
+static void fillRows(uint32_t rows[PADDED_ROWS], const Bitboard *bb, int size, int invert)
+{
+	uint32_t rowMask = bbRowMask(size);
+	int i;
+	memset(rows, 0, PADDED_ROWS * sizeof(uint32_t));
+	for (i = 0; i < size; i++)
+	{
+		rows[LANES + i] = (invert ? ~bbRow(bb, i) : bbRow(bb, i)) & rowMask;
+	}
+}
+
+/**
+ * @brief Checks whether any lane of a vector is not zero.
+ * @param v The vector.
+ * @return Non zero if a bit of the vector is set.
+ */
+static inline int anyLane(const RowVector *v)
+{
+	uint32_t lanes[LANES], any = 0;
+	int i;
+	memcpy(lanes, v, sizeof(lanes));
+	for (i = 0; i < LANES; i++)
+	{
+		any |= lanes[i];
+	}
+	return any != 0;
+}
+
+/**
+ * @brief Adds a mask of cells to the counters, a given number of times.
+ * @param map The counters.
+ * @param mask The cells to add to.
+ * @param weight The number to add to the counter of every cell of the mask.
+ * @param planes The number of planes the counters may reach after the addition.
+ */
+static void addMask(DensityMap *map, const RowVector *mask, int weight, int planes)
+{
+	RowVector carry, common;
+	int bit, b;
+	for (bit = 0; weight >> bit; bit++)
+	{
+		if (((weight >> bit) & 1) == 0)
+		{
+			continue;
+		}
+		carry = *mask;
+		for (b = bit; b < planes; b++)
+		{
+			common = map->planes[b] & carry;
+			map->planes[b] ^= carry;
+			carry = common;
+		}
+	}
+}
+
+/**
+ * @brief Returns the number of bits needed to write a number.
+ * @param value The number.
+ * @return The number of bits, at most DENSITY_PLANES.
+ */
+static int bitLength(long value)
+{
+	int bits = 0;
+	while (value >> bits && bits < DENSITY_PLANES)
+	{
+		bits++;
+	}
+	return bits;
+}
+
+/**
+ * @brief Counts for every cell the placements covering it, of all the ships still afloat.
+ * A placement counts if it lies in the board and crosses no blocked cell, in target mode only
+ * if it also covers an open cell. Every placement counts once for every ship of its length.
+ * @param map Filled with the counters.
+ * @param size The board size.
+ * @param blocked The cells no ship can take (the misses).
+ * @param open The cells a placement must cover in target mode (the unsunk hits).
+ * @param remaining The number of ships afloat for every length, from 0 to maxLength.
+ * @param maxLength The length of the longest ship.
+ * @param targetMode Non zero if only placements covering an open cell count.
+ */
+void densityCount(DensityMap *map, int size, const Bitboard *blocked, const Bitboard *open,
+				  const int remaining[], int maxLength, int targetMode)
+{
+	uint32_t freeRows[PADDED_ROWS], openRows[PADDED_ROWS], starts[PADDED_ROWS];
+	RowVector freeCells, opened, h, x, v, y, shifted;
+	long total = 0;
+	int length, k;
+	memset(map, 0, sizeof(DensityMap));
+	memset(starts, 0, sizeof(starts));
+	fillRows(freeRows, blocked, size, 1);
+	fillRows(openRows, open, size, 0);
+	loadRows(&freeCells, freeRows, 0);
+	loadRows(&opened, openRows, 0);
+	for (length = 1; length <= maxLength; length++)
+	{
+		if (remaining[length] == 0)
+		{
+			continue;
+		}
+		total += 2L * length * remaining[length];
+		h = freeCells;
+		x = opened;
+		v = freeCells;
+		y = opened;
+		for (k = 1; k < length; k++)
+		{
+			h &= freeCells >> k;
+			x |= opened >> k;
+			loadRows(&shifted, freeRows, k);
+			v &= shifted;
+			loadRows(&shifted, openRows, k);
+			y |= shifted;
+		}
+		if (targetMode)
+		{
+			h &= x;
+			v &= y;
+		}
+		memcpy(starts + LANES, &v, sizeof(RowVector));
+		for (k = 0; k < length; k++)
+		{
+			shifted = h << k;
+			addMask(map, &shifted, remaining[length], bitLength(total));
+			loadRows(&shifted, starts, -k);
+			addMask(map, &shifted, remaining[length], bitLength(total));
+		}
+	}
+}
+
+/**
+ * @brief Finds the candidate cell with the largest counter, the first one in row order if there
+ * are several.
+ * @param map The counters.
+ * @param size The board size.
+ * @param candidates The cells to choose from.
+ * @param row Filled with the row of the best cell.
+ * @param col Filled with the column of the best cell.
+ * @return The counter of the best cell, 0 if every candidate counter is 0 (row and col are then
+ * left unchanged).
+ */
+int densityBest(const DensityMap *map, int size, const Bitboard *candidates, int *row, int *col)
+{
+	uint32_t rows[PADDED_ROWS];
+	RowVector cand, narrowed;
+	int b, i, best = 0;
+	fillRows(rows, candidates, size, 0);
+	loadRows(&cand, rows, 0);
+	for (b = DENSITY_PLANES - 1; b >= 0; b--)
+	{
+		narrowed = cand & map->planes[b];
+		if (anyLane(&narrowed))
+		{
+			cand = narrowed;
+			best |= 1 << b;
+		}
+	}
+	if (best == 0)
+	{
+		return 0;
+	}
+	for (i = 0; i < size; i++)
+	{
+		if (cand[i] != 0)
+		{
+			*row = i;
+			*col = __builtin_ctz(cand[i]);
+			break;
+		}
+	}
+	return best;
+}
+
+/**
+ * @brief Returns the counter of a single cell.
+ * @param map The counters.
+ * @param row The row of the cell.
+ * @param col The column of the cell.
+ * @return The counter.
+ */
+int densityAt(const DensityMap *map, int row, int col)
+{
+	int b, value = 0;
+	for (b = 0; b < DENSITY_PLANES; b++)
+	{
+		value |= (int) ((map->planes[b][row] >> col) & 1U) << b;
+	}
+	return value;
+}
+
+/**
+ * @brief Starts following a new game, with no shots.
+ * @param tracker The tracker.
+ * @param size The board size.
+ * @param remaining The number of ships of every length, from 0 to maxLength.
+ * @param maxLength The length of the longest ship, at most DENSITY_MAX_LENGTH.
+ */
+void trackerReset(DensityTracker *tracker, int size, const int remaining[], int maxLength)
+{
+	const PlacementTable *table = placementTable(size);
+	int length, r, c;
+	tracker->size = size;
+	tracker->maxLength = maxLength;
+	memset(tracker->remaining, 0, sizeof(tracker->remaining));
+	memset(tracker->density, 0, sizeof(tracker->density));
+	for (length = 1; length <= maxLength; length++)
+	{
+		tracker->remaining[length] = length <= size ? remaining[length] : 0;
+		if (tracker->remaining[length] == 0)
+		{
+			continue;
+		}
+		tracker->starts[length][DENSITY_VERTICAL] = table->starts[length][PLACEMENT_VERTICAL];
+		tracker->starts[length][DENSITY_HORIZONTAL] =
+				table->starts[length][PLACEMENT_HORIZONTAL];
+		memcpy(tracker->counts[length], table->coverage[length], sizeof(tracker->counts[length]));
+		for (r = 0; r < size; r++)
+		{
+			for (c = 0; c < BITBOARD_ROW_BITS; c++)
+			{
+				tracker->density[r][c] += tracker->remaining[length] *
+										  tracker->counts[length][r][c];
+			}
+		}
+	}
+}
+
+/**
+ * @brief Removes a single legal placement, if it is still legal, from the counters.
+ * @param tracker The tracker.
+ * @param length The ship length.
+ * @param angle DENSITY_VERTICAL or DENSITY_HORIZONTAL.
+ * @param row The row of the first cell of the placement.
+ * @param col The column of the first cell of the placement.
+ */
+static void removePlacement(DensityTracker *tracker, int length, int angle, int row, int col)
+{
+	int k, weight = tracker->remaining[length];
+	if (!bbTest(&tracker->starts[length][angle], row, col))
+	{
+		return;
+	}
+	bbUnset(&tracker->starts[length][angle], row, col);
+	for (k = 0; k < length; k++)
+	{
+		if (angle == DENSITY_VERTICAL)
+		{
+			tracker->counts[length][row + k][col]--;
+			tracker->density[row + k][col] -= weight;
+		}
+		else
+		{
+			tracker->counts[length][row][col + k]--;
+			tracker->density[row][col + k] -= weight;
+		}
+	}
+}
+
+/**
+ * @brief Removes every placement crossing a missed cell. Only the placements through the cell
+ * are visited.
+ * @param tracker The tracker.
+ * @param row The row of the miss.
+ * @param col The column of the miss.
+ */
+void trackerMiss(DensityTracker *tracker, int row, int col)
+{
+	int length, start;
+	for (length = 1; length <= tracker->maxLength; length++)
+	{
+		if (tracker->remaining[length] == 0)
+		{
+			continue;
+		}
+		for (start = col - length + 1 > 0 ? col - length + 1 : 0; start <= col; start++)
+		{
+			removePlacement(tracker, length, DENSITY_HORIZONTAL, row, start);
+		}
+		for (start = row - length + 1 > 0 ? row - length + 1 : 0; start <= row; start++)
+		{
+			removePlacement(tracker, length, DENSITY_VERTICAL, start, col);
+		}
+	}
+}
+
+/**
+ * @brief Removes a sunk ship from the fleet, subtracting its length counts in a single pass.
+ * @param tracker The tracker.
+ * @param length The length of the sunk ship.
+ */
+void trackerSunk(DensityTracker *tracker, int length)
+{
+	int r, c;
+	if (length < 1 || length > tracker->maxLength || tracker->remaining[length] == 0)
+	{
+		return;
+	}
+	tracker->remaining[length]--;
+	for (r = 0; r < tracker->size; r++)
+	{
+		for (c = 0; c < tracker->size; c++)
+		{
+			tracker->density[r][c] -= tracker->counts[length][r][c];
+		}
+	}
+}
+
+/**
+ * @brief Finds the candidate cell with the largest value of a map, the first one in row order.
+ * @param map The values of the cells.
+ * @param size The board size.
+ * @param candidates The cells to choose from.
+ * @param row Filled with the row of the best cell.
+ * @param col Filled with the column of the best cell.
+ * @return The value of the best cell, 0 if every candidate value is 0.
+ */
+static int bestCell(const int32_t map[][BITBOARD_ROW_BITS], int size, const Bitboard *candidates,
+					int *row, int *col)
+{
+	int r, c, best = 0;
+	uint32_t bits;
+	for (r = 0; r < size; r++)
+	{
+		bits = bbRow(candidates, r) & bbRowMask(size);
+		while (bits != 0)
+		{
+			c = __builtin_ctz(bits);
+			bits &= bits - 1;
+			if (map[r][c] > best)
+			{
+				best = map[r][c];
+				*row = r;
+				*col = c;
+			}
+		}
+	}
+	return best;
+}
+
+/**
+ * @brief Adds the legal placements of a length through an open cell to a target map. A placement
+ * covering several open cells is added only from the first of them.
+ * @param tracker The tracker.
+ * @param target The target map.
+ * @param open The open cells.
+ * @param length The ship length.
+ * @param row The row of the open cell.
+ * @param col The column of the open cell.
+ */
+static void addTargets(const DensityTracker *tracker, int32_t target[][BITBOARD_ROW_BITS],
+					   const Bitboard *open, int length, int row, int col)
+{
+	int offset, start, k, j, before, weight = tracker->remaining[length];
+	for (offset = 0; offset < length; offset++)
+	{
+		start = col - offset;
+		if (start >= 0 && bbTest(&tracker->starts[length][DENSITY_HORIZONTAL], row, start) &&
+			((bbRow(open, row) >> start) & ((1U << offset) - 1)) == 0)
+		{
+			for (k = 0; k < length; k++)
+			{
+				target[row][start + k] += weight;
+			}
+		}
+		start = row - offset;
+		if (start < 0 || !bbTest(&tracker->starts[length][DENSITY_VERTICAL], start, col))
+		{
+			continue;
+		}
+		for (j = 0, before = 0; j < offset; j++)
+		{
+			before |= bbTest(open, start + j, col);
+		}
+		if (!before)
+		{
+			for (k = 0; k < length; k++)
+			{
+				target[start + k][col] += weight;
+			}
+		}
+	}
+}
+
+/**
+ * @brief Finds the candidate cell with the largest density, the first one in row order if there
+ * are several. If open cells are given, only the legal placements covering at least one of them
+ * count, and they are gathered around the open cells alone.
+ * @param tracker The tracker.
+ * @param candidates The cells to choose from.
+ * @param open The cells a placement must cover (the unsunk hits), NULL to count all placements.
+ * @param row Filled with the row of the best cell.
+ * @param col Filled with the column of the best cell.
+ * @return The density of the best cell, 0 if every candidate density is 0 (row and col are then
+ * left unchanged).
+ */
+int trackerBest(const DensityTracker *tracker, const Bitboard *candidates, const Bitboard *open,
+				int *row, int *col)
+{
+	int32_t target[BITBOARD_MAX_SIZE][BITBOARD_ROW_BITS];
+	int length, r, c;
+	uint32_t bits;
+	if (open == NULL)
+	{
+		return bestCell(tracker->density, tracker->size, candidates, row, col);
+	}
+	memset(target, 0, sizeof(target));
+	for (r = 0; r < tracker->size; r++)
+	{
+		bits = bbRow(open, r);
+		while (bits != 0)
+		{
+			c = __builtin_ctz(bits);
+			bits &= bits - 1;
+			for (length = 1; length <= tracker->maxLength; length++)
+			{
+				if (tracker->remaining[length] > 0)
+				{
+					addTargets(tracker, target, open, length, r, c);
+				}
+			}
+		}
+	}
+	return bestCell(target, tracker->size, candidates, row, col);
+}
@@ -0,0 +1,164 @@
+/**
+ * @file density.h
+ * @version 2.0
+ *
+ * @brief Counting, for every cell, the legal placements of the ships still afloat covering it.
+ *
+ * @section DESCRIPTION
+ * The counters are bit sliced: plane b holds bit b of the counter of every cell, one 32 bit lane
+ * per row, so adding a whole mask of placements to all the counters is a ripple of AND/XOR
+ * operations applied to all the rows at once with SIMD vectors.
+ * A density tracker keeps the same counters between shots instead: it remembers which placements
+ * are still legal and, after every shot, updates only the placements crossing the shot cell.
+ * The shooters use the tracker; the bit sliced count is the reference it is checked against
+ * (ex2_density, run by make check).
+ */
+#ifndef DENSITY_H_
+#define DENSITY_H_
+
+// ------------------------------ includes ------------------------------
+#include "bitboard.h"
+#include "placement.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def DENSITY_PLANES 24
+ * @brief The number of bits of every counter.
+ */
+#define DENSITY_PLANES 24
+
+/**
+ * @def DENSITY_MAX_LENGTH 26
+ * @brief The length of the longest ship a density tracker can follow.
+ */
+#define DENSITY_MAX_LENGTH BITBOARD_MAX_SIZE
+
+/**
+ * @def DENSITY_VERTICAL 0
+ * @brief The index of the vertical placements of a length.
+ */
+#define DENSITY_VERTICAL 0
+
+/**
+ * @def DENSITY_HORIZONTAL 1
+ * @brief The index of the horizontal placements of a length.
+ */
+#define DENSITY_HORIZONTAL 1
+
+// ------------------------------ structs ----------------------------
+
+/**
+ * a vector holding one 32 bit lane for every row of the board.
+ */
+typedef uint32_t RowVector __attribute__((vector_size(BITBOARD_ROW_BITS * sizeof(uint32_t))));
+
+/**
+ * a structure holding a bit sliced counter for every cell of the board.
+ * planes - plane b holds bit b of the counters, lane i stands for row i.
+ */
+typedef struct DensityMap
+{
+	RowVector planes[DENSITY_PLANES];
+} DensityMap;
+
+/**
+ * a structure following the placement density of a fleet between shots. includes the following
+ * attributes:
+ * size - the board size.
+ * maxLength - the length of the longest ship of the fleet.
+ * remaining - the number of ships afloat for every length.
+ * starts - for every length and angle, the start cells of the placements crossing no miss.
+ * counts - for every length, the number of legal placements covering every cell.
+ * density - for every cell, the counts of all the lengths weighted by the ships afloat.
+ */
+typedef struct DensityTracker
+{
+	int size;
+	int maxLength;
+	int remaining[DENSITY_MAX_LENGTH + 1];
+	Bitboard starts[DENSITY_MAX_LENGTH + 1][2];
+	uint16_t counts[DENSITY_MAX_LENGTH + 1][BITBOARD_MAX_SIZE][BITBOARD_ROW_BITS];
+	int32_t density[BITBOARD_MAX_SIZE][BITBOARD_ROW_BITS];
+} DensityTracker;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Counts for every cell the placements covering it, of all the ships still afloat.
+ * A placement counts if it lies in the board and crosses no blocked cell, in target mode only
+ * if it also covers an open cell. Every placement counts once for every ship of its length.
+ * @param map Filled with the counters.
+ * @param size The board size.
+ * @param blocked The cells no ship can take (the misses).
+ * @param open The cells a placement must cover in target mode (the unsunk hits).
+ * @param remaining The number of ships afloat for every length, from 0 to maxLength.
+ * @param maxLength The length of the longest ship.
+ * @param targetMode Non zero if only placements covering an open cell count.
+ */
+void densityCount(DensityMap *map, int size, const Bitboard *blocked, const Bitboard *open,
+				  const int remaining[], int maxLength, int targetMode);
+
+/**
+ * @brief Finds the candidate cell with the largest counter, the first one in row order if there
+ * are several.
+ * @param map The counters.
+ * @param size The board size.
+ * @param candidates The cells to choose from.
+ * @param row Filled with the row of the best cell.
+ * @param col Filled with the column of the best cell.
+ * @return The counter of the best cell, 0 if every candidate counter is 0 (row and col are then
+ * left unchanged).
+ */
+int densityBest(const DensityMap *map, int size, const Bitboard *candidates, int *row, int *col);
+
+/**
+ * @brief Returns the counter of a single cell.
+ * @param map The counters.
+ * @param row The row of the cell.
+ * @param col The column of the cell.
+ * @return The counter.
+ */
+int densityAt(const DensityMap *map, int row, int col);
+
+/**
+ * @brief Starts following a new game, with no shots.
+ * @param tracker The tracker.
+ * @param size The board size.
+ * @param remaining The number of ships of every length, from 0 to maxLength.
+ * @param maxLength The length of the longest ship, at most DENSITY_MAX_LENGTH.
+ */
+void trackerReset(DensityTracker *tracker, int size, const int remaining[], int maxLength);
+
+/**
+ * @brief Removes every placement crossing a missed cell. Only the placements through the cell
+ * are visited.
+ * @param tracker The tracker.
+ * @param row The row of the miss.
+ * @param col The column of the miss.
+ */
+void trackerMiss(DensityTracker *tracker, int row, int col);
+
+/**
+ * @brief Removes a sunk ship from the fleet, subtracting its length counts in a single pass.
+ * @param tracker The tracker.
+ * @param length The length of the sunk ship.
+ */
+void trackerSunk(DensityTracker *tracker, int length);
+
+/**
+ * @brief Finds the candidate cell with the largest density, the first one in row order if there
+ * are several. If open cells are given, only the legal placements covering at least one of them
+ * count, and they are gathered around the open cells alone.
+ * @param tracker The tracker.
+ * @param candidates The cells to choose from.
+ * @param open The cells a placement must cover (the unsunk hits), NULL to count all placements.
+ * @param row Filled with the row of the best cell.
+ * @param col Filled with the column of the best cell.
+ * @return The density of the best cell, 0 if every candidate density is 0 (row and col are then
+ * left unchanged).
+ */
+int trackerBest(const DensityTracker *tracker, const Bitboard *candidates, const Bitboard *open,
+				int *row, int *col);
+
+#endif /* DENSITY_H_ */
@@ -0,0 +1,190 @@
+/**
+ * @file fleet.c
+ * @version 2.0
+ *
+ * @brief The ships placed in a game, chosen at run time.
+ *
+ * @section DESCRIPTION
+ * The lengths are kept sorted from the longest ship to the shortest, so the long ships are
+ * placed while the board is still empty and a fleet is rarely placed again from scratch.
+ */
+// ------------------------------ includes ------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fleet.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def  TRUE 1
+ * @brief a true boolean value.
+ */
+#define TRUE 1
+
+/**
+ * @def FALSE -1
+ * @brief a false boolean value.
+ */
+#define FALSE (-1)
+
+/**
+ * @def COUNT_SEPARATOR 'x'
+ * @brief The character between the length and the count of an item.
+ */
+#define COUNT_SEPARATOR 'x'
+
+/**
+ * @def COMMENT_START '#'
+ * @brief The character starting a comment, up to the end of the line.
+ */
+#define COMMENT_START '#'
+
+/**
+ * @def MAX_FLEET_FILE 65536
+ * @brief The maximal size of a fleet config file.
+ */
+#define MAX_FLEET_FILE 65536
+
+// ------------------------------ globals ----------------------------
+
+/**
+ * The default fleet: an aircraft carrier, a battle cruiser, a missile ship, a submarine and a
+ * battle ship.
+ */
+static const Fleet DEFAULT_FLEET = {5, 5, 17, {5, 4, 3, 3, 2}};
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Returns the default fleet of the game.
+ * @return The default fleet.
+ */
+const Fleet *defaultFleet(void)
+{
+	return &DEFAULT_FLEET;
+}
+
+/**
+ * @brief Reads a non negative number.
+ * @param text The text, advanced past the digits.
+ * @param value Filled with the number.
+ * @return TRUE if the text starts with a digit, FALSE otherwise.
+ */
+static int readNumber(const char **text, int *value)
+{
+	long number = 0;
+	if (**text < '0' || **text > '9')
+	{
+		return FALSE;
+	}
+	while (**text >= '0' && **text <= '9')
+	{
+		number = number * 10 + (**text - '0');
+		if (number > MAX_FLEET_SHIPS)
+		{
+			return FALSE;
+		}
+		(*text)++;
+	}
+	*value = (int) number;
+	return TRUE;
+}
+
+/**
+ * @brief Orders ship lengths from the longest to the shortest.
+ * @param a The first length.
+ * @param b The second length.
+ * @return The order of the lengths, as qsort expects.
+ */
+static int longerFirst(const void *a, const void *b)
+{
+	return (int) *(const uint8_t *) b - (int) *(const uint8_t *) a;
+}
+
+/**
+ * @brief Reads a fleet from its text description.
+ * @param text The fleet description.
+ * @param fleet Filled with the fleet.
+ * @return TRUE (1) if the text describes a fleet, FALSE otherwise.
+ */
+int parseFleet(const char *text, Fleet *fleet)
+{
+	int length, count;
+	fleet->shipsNum = 0;
+	fleet->maxLength = 0;
+	fleet->cells = 0;
+	while (*text != '\0')
+	{
+		if (*text == COMMENT_START)
+		{
+			text += strcspn(text, "\n");
+			continue;
+		}
+		if (*text == ',' || *text == ' ' || *text == '\t' || *text == '\n' || *text == '\r')
+		{
+			text++;
+			continue;
+		}
+		count = 1;
+		if (readNumber(&text, &length) == FALSE || length < 1 || length > MAX_FLEET_LENGTH ||
+			(*text == COUNT_SEPARATOR && (text++, readNumber(&text, &count) == FALSE)) ||
+			count < 1 || fleet->shipsNum + count > MAX_FLEET_SHIPS)
+		{
+			return FALSE;
+		}
+		fleet->cells += length * count;
+		for (; count > 0; count--)
+		{
+			fleet->lengths[fleet->shipsNum++] = (uint8_t) length;
+		}
+		fleet->maxLength = length > fleet->maxLength ? length : fleet->maxLength;
+	}
+	if (fleet->shipsNum == 0)
+	{
+		return FALSE;
+	}
+	qsort(fleet->lengths, (size_t) fleet->shipsNum, sizeof(uint8_t), longerFirst);
+	return TRUE;
+}
+
+/**
+ * @brief Reads a fleet from a config file holding its text description.
+ * @param path The config file path.
+ * @param fleet Filled with the fleet.
+ * @return TRUE (1) if the file describes a fleet, FALSE otherwise.
+ */
+int loadFleetFile(const char *path, Fleet *fleet)
+{
+	char *text = (char *) malloc(MAX_FLEET_FILE + 1);
+	FILE *file = fopen(path, "r");
+	size_t length;
+	int status = FALSE;
+	if (text != NULL && file != NULL)
+	{
+		length = fread(text, 1, MAX_FLEET_FILE + 1, file);
+		text[length <= MAX_FLEET_FILE ? length : MAX_FLEET_FILE] = '\0';
+		status = length <= MAX_FLEET_FILE ? parseFleet(text, fleet) : FALSE;
+	}
+	if (file != NULL)
+	{
+		fclose(file);
+	}
+	free(text);
+	return status;
+}
+
+/**
+ * @brief Counts the ships of every length in a fleet.
+ * @param fleet The fleet.
+ * @param counts Filled with the number of ships of every length, from 0 to MAX_FLEET_LENGTH.
+ */
+void fleetCounts(const Fleet *fleet, int counts[])
+{
+	int i;
+	memset(counts, 0, (MAX_FLEET_LENGTH + 1) * sizeof(int));
+	for (i = 0; i < fleet->shipsNum; i++)
+	{
+		counts[fleet->lengths[i]]++;
+	}
+}
@@ -0,0 +1,83 @@
+/**
+ * @file fleet.h
+ * @version 2.0
+ *
+ * @brief The ships placed in a game, chosen at run time.
+ *
+ * @section DESCRIPTION
+ * A fleet is the list of the ship lengths of a game. It is read from a short text, on the
+ * command line or in a config file, made of items separated by commas, spaces or new lines.
+ * An item is a length ("4"), or a length and a positive count ("3x2" for two ships of length 3).
+ * Everything from a '#' to the end of the line is a comment. The default fleet is "5,4,3,3,2".
+ */
+#ifndef FLEET_H_
+#define FLEET_H_
+
+// ------------------------------ includes ------------------------------
+#include <stdint.h>
+#include "bitboard.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def MAX_FLEET_SHIPS 676
+ * @brief The maximal number of ships in a fleet (ships of length 1 on every cell of the largest
+ * board).
+ */
+#define MAX_FLEET_SHIPS (BITBOARD_MAX_SIZE * BITBOARD_MAX_SIZE)
+
+/**
+ * @def MAX_FLEET_LENGTH 26
+ * @brief The maximal length of a ship.
+ */
+#define MAX_FLEET_LENGTH BITBOARD_MAX_SIZE
+
+// ------------------------------ structs ----------------------------
+
+/**
+ * a structure describing a fleet. includes the following attributes:
+ * shipsNum - the number of ships.
+ * maxLength - the length of the longest ship.
+ * cells - the number of cells all the ships take.
+ * lengths - the length of every ship, the longest first (they are placed in this order).
+ */
+typedef struct Fleet
+{
+	int shipsNum;
+	int maxLength;
+	int cells;
+	uint8_t lengths[MAX_FLEET_SHIPS];
+} Fleet;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Returns the default fleet of the game.
+ * @return The default fleet.
+ */
+const Fleet *defaultFleet(void);
+
+/**
+ * @brief Reads a fleet from its text description.
+ * @param text The fleet description.
+ * @param fleet Filled with the fleet.
+ * @return TRUE (1) if the text describes a fleet, FALSE otherwise.
+ */
+int parseFleet(const char *text, Fleet *fleet);
+
+/**
+ * @brief Reads a fleet from a config file holding its text description.
+ * @param path The config file path.
+ * @param fleet Filled with the fleet.
+ * @return TRUE (1) if the file describes a fleet, FALSE otherwise.
+ */
+int loadFleetFile(const char *path, Fleet *fleet);
+
+/**
+ * @brief Counts the ships of every length in a fleet.
+ * @param fleet The fleet.
+ * @param counts Filled with the number of ships of every length, from 0 to MAX_FLEET_LENGTH.
+ */
+void fleetCounts(const Fleet *fleet, int counts[]);
+
+#endif /* FLEET_H_ */
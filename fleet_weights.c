@@ -0,0 +1,316 @@
+/**
+ * @file fleet_weights.c
+ * @version 2.0
+ *
+ * @brief A weighted placement table of a fleet, sampled in O(1) with an alias table per ship.
+ *
+ * @section DESCRIPTION
+ * The alias tables are built with Vose's method: every slot keeps its own share of a draw up to
+ * its weight and hands the rest to a single heavier slot, so a draw is one table lookup and one
+ * comparison.
+ */
+// ------------------------------ includes ------------------------------
+#include <stdio.h>
+#include <string.h>
+#include "fleet_weights.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def  TRUE 1
+ * @brief a true boolean value.
+ */
+#define TRUE 1
+
+/**
+ * @def FALSE -1
+ * @brief a false boolean value.
+ */
+#define FALSE (-1)
+
+/**
+ * @def MAX_LINE_LENGTH 256
+ * @brief The maximal length of a line of a table file.
+ */
+#define MAX_LINE_LENGTH 256
+
+/**
+ * @def SIZE_KEY "size"
+ * @brief The first word of the line holding the board size.
+ */
+#define SIZE_KEY "size"
+
+/**
+ * @def FLEET_KEY "fleet"
+ * @brief The first word of the line holding the fleet.
+ */
+#define FLEET_KEY "fleet"
+
+/**
+ * @def COMMENT_START '#'
+ * @brief The character starting a comment line.
+ */
+#define COMMENT_START '#'
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Checks that a ship location fits the board.
+ * @param size The board size.
+ * @param length The ship length.
+ * @param angle 0 for vertical, 1 for horizontal.
+ * @param row The row of the first cell of the ship.
+ * @param col The column of the first cell of the ship.
+ * @return Non zero if the ship fits the board.
+ */
+static int slotFits(int size, int length, int angle, int row, int col)
+{
+	return row >= 0 && col >= 0 && row + (angle == 0 ? length : 1) <= size &&
+		   col + (angle == 0 ? 1 : length) <= size;
+}
+
+/**
+ * @brief Checks that a fleet may be weighted on a board.
+ * @param size The board size.
+ * @param fleet The fleet.
+ * @return Non zero if the fleet fits.
+ */
+static int fleetFits(int size, const Fleet *fleet)
+{
+	return size >= 1 && size <= BITBOARD_MAX_SIZE && fleet->shipsNum >= 1 &&
+		   fleet->shipsNum <= WEIGHTS_MAX_SHIPS && fleet->maxLength <= size;
+}
+
+/**
+ * @brief Builds the alias table of a single ship (Vose's method).
+ * @param table The alias table.
+ * @param weights The weight of every slot.
+ * @param slotsNum The number of slots.
+ * @return TRUE (1) on success, FALSE if no slot has a weight.
+ */
+static int buildAlias(ShipAlias *table, const float weights[], int slotsNum)
+{
+	double scaled[WEIGHTS_MAX_SLOTS], total = 0;
+	int small[WEIGHTS_MAX_SLOTS], large[WEIGHTS_MAX_SLOTS];
+	int i, s, l, smallNum = 0, largeNum = 0;
+	for (i = 0; i < slotsNum; i++)
+	{
+		total += weights[i];
+	}
+	if (!(total > 0))
+	{
+		return FALSE;
+	}
+	table->slotsNum = slotsNum;
+	for (i = 0; i < slotsNum; i++)
+	{
+		scaled[i] = weights[i] * (double) slotsNum / total;
+		table->alias[i] = (uint16_t) i;
+		if (scaled[i] < 1)
+		{
+			small[smallNum++] = i;
+		}
+		else
+		{
+			large[largeNum++] = i;
+		}
+	}
+	while (smallNum > 0 && largeNum > 0)
+	{
+		s = small[--smallNum];
+		l = large[--largeNum];
+		table->threshold[s] = (uint32_t) (scaled[s] * 4294967296.0);
+		table->alias[s] = (uint16_t) l;
+		scaled[l] += scaled[s] - 1;
+		if (scaled[l] < 1)
+		{
+			small[smallNum++] = l;
+		}
+		else
+		{
+			large[largeNum++] = l;
+		}
+	}
+	while (largeNum > 0)
+	{
+		table->threshold[large[--largeNum]] = UINT32_MAX;
+	}
+	while (smallNum > 0)
+	{
+		table->threshold[small[--smallNum]] = UINT32_MAX;
+	}
+	return TRUE;
+}
+
+/**
+ * @brief Starts a table giving every slot that fits the board the same weight, the
+ * distribution of the uniform placement of a single ship on an empty board.
+ * @param weights The table, its alias tables are built.
+ * @param size The board size.
+ * @param fleet The fleet, of at most WEIGHTS_MAX_SHIPS ships that fit the board.
+ * @return TRUE (1) on success, FALSE if the fleet does not fit the table.
+ */
+int uniformFleetWeights(FleetWeights *weights, int size, const Fleet *fleet)
+{
+	int i, slot;
+	if (!fleetFits(size, fleet))
+	{
+		return FALSE;
+	}
+	weights->size = size;
+	weights->fleet = *fleet;
+	for (i = 0; i < fleet->shipsNum; i++)
+	{
+		for (slot = 0; slot < 2 * size * size; slot++)
+		{
+			weights->weights[i][slot] = 1;
+		}
+	}
+	return buildFleetWeights(weights);
+}
+
+/**
+ * @brief Builds the alias table of every ship from its weights. The weights of the slots that
+ * do not fit the board are cleared first.
+ * @param weights The table.
+ * @return TRUE (1) on success, FALSE if a ship has no slot with a weight.
+ */
+int buildFleetWeights(FleetWeights *weights)
+{
+	int i, angle, row, col, size = weights->size;
+	for (i = 0; i < weights->fleet.shipsNum; i++)
+	{
+		for (angle = 0; angle < 2; angle++)
+		{
+			for (row = 0; row < size; row++)
+			{
+				for (col = 0; col < size; col++)
+				{
+					if (!slotFits(size, weights->fleet.lengths[i], angle, row, col) ||
+						!(weights->weights[i][weightsSlot(size, angle, row, col)] > 0))
+					{
+						weights->weights[i][weightsSlot(size, angle, row, col)] = 0;
+					}
+				}
+			}
+		}
+		if (buildAlias(&weights->tables[i], weights->weights[i], 2 * size * size) == FALSE)
+		{
+			return FALSE;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * @brief Saves a table as text.
+ * @param path The file path.
+ * @param weights The table.
+ * @return TRUE (1) on success, FALSE if the file could not be written.
+ */
+int saveFleetWeights(const char *path, const FleetWeights *weights)
+{
+	FILE *file = fopen(path, "w");
+	int i, slot, size = weights->size, cells = size * size, status = TRUE;
+	if (file == NULL)
+	{
+		return FALSE;
+	}
+	fprintf(file, "%c ship angle row col weight\n%s %d\n%s ", COMMENT_START, SIZE_KEY, size,
+			FLEET_KEY);
+	for (i = 0; i < weights->fleet.shipsNum; i++)
+	{
+		fprintf(file, "%s%d", i > 0 ? "," : "", weights->fleet.lengths[i]);
+	}
+	fprintf(file, "\n");
+	for (i = 0; i < weights->fleet.shipsNum; i++)
+	{
+		for (slot = 0; slot < 2 * cells; slot++)
+		{
+			if (weights->weights[i][slot] > 0)
+			{
+				fprintf(file, "%d %d %d %d %.9g\n", i, slot / cells, slot % cells / size,
+						slot % size, weights->weights[i][slot]);
+			}
+		}
+	}
+	if (ferror(file))
+	{
+		status = FALSE;
+	}
+	if (fclose(file) != 0)
+	{
+		status = FALSE;
+	}
+	return status;
+}
+
+/**
+ * @brief Reads a single line of a table file.
+ * @param line The line.
+ * @param weights The table read so far, its size is 0 until the size line is read and its fleet
+ * has no ships until the fleet line is read.
+ * @return TRUE (1) if the line is valid, FALSE otherwise.
+ */
+static int readWeightsLine(const char *line, FleetWeights *weights)
+{
+	int ship, angle, row, col, extra;
+	float weight;
+	line += strspn(line, " \t");
+	if (*line == COMMENT_START || *line == '\n' || *line == '\r' || *line == '\0')
+	{
+		return TRUE;
+	}
+	if (strncmp(line, SIZE_KEY, strlen(SIZE_KEY)) == 0)
+	{
+		return sscanf(line + strlen(SIZE_KEY), "%d %n", &weights->size, &extra) == 1 &&
+			   line[strlen(SIZE_KEY) + extra] == '\0' && weights->size >= 1 &&
+			   weights->size <= BITBOARD_MAX_SIZE ? TRUE : FALSE;
+	}
+	if (strncmp(line, FLEET_KEY, strlen(FLEET_KEY)) == 0)
+	{
+		return parseFleet(line + strlen(FLEET_KEY), &weights->fleet) == TRUE &&
+			   weights->size > 0 && fleetFits(weights->size, &weights->fleet) ? TRUE : FALSE;
+	}
+	if (weights->fleet.shipsNum == 0 ||
+		sscanf(line, "%d %d %d %d %f %n", &ship, &angle, &row, &col, &weight, &extra) != 5 ||
+		line[extra] != '\0' || ship < 0 || ship >= weights->fleet.shipsNum ||
+		(angle != 0 && angle != 1) ||
+		!slotFits(weights->size, weights->fleet.lengths[ship], angle, row, col) ||
+		!(weight >= 0 && weight < 1e30f))
+	{
+		return FALSE;
+	}
+	weights->weights[ship][weightsSlot(weights->size, angle, row, col)] = weight;
+	return TRUE;
+}
+
+/**
+ * @brief Loads a table saved by saveFleetWeights and builds its alias tables.
+ * @param path The file path.
+ * @param weights Filled with the table.
+ * @return TRUE (1) on success, FALSE if the file could not be read or is not a valid table.
+ */
+int loadFleetWeights(const char *path, FleetWeights *weights)
+{
+	char line[MAX_LINE_LENGTH];
+	FILE *file = fopen(path, "r");
+	int status = TRUE;
+	if (file == NULL)
+	{
+		return FALSE;
+	}
+	weights->size = 0;
+	weights->fleet.shipsNum = 0;
+	memset(weights->weights, 0, sizeof(weights->weights));
+	while (status == TRUE && fgets(line, MAX_LINE_LENGTH, file) != NULL)
+	{
+		status = readWeightsLine(line, weights);
+	}
+	if (ferror(file) || weights->fleet.shipsNum == 0)
+	{
+		status = FALSE;
+	}
+	fclose(file);
+	return status == TRUE ? buildFleetWeights(weights) : FALSE;
+}
@@ -0,0 +1,136 @@
+/**
+ * @file fleet_weights.h
+ * @version 2.0
+ *
+ * @brief A weighted placement table of a fleet, sampled in O(1) with an alias table per ship.
+ *
+ * @section DESCRIPTION
+ * Instead of a uniformly random free slot, every ship of the fleet may be placed at a slot
+ * drawn from its own weights, one weight for every slot of a board of the table size. The slot
+ * of a ship is (angle * size + row) * size + col, with the angle 0 for vertical and 1 for
+ * horizontal, so every ship has 2 * size * size slots and the slots that do not fit the board
+ * weigh 0. A ship is drawn with a single random number from its alias table (Vose), so drawing
+ * a slot costs the same whatever the weights are.
+ * A table is saved as text: a "size" line, a "fleet" line in the fleet description format (see
+ * fleet.h) and a "ship angle row col weight" line for every slot with a weight, e.g.
+ *     size 10
+ *     fleet 5,4,3,3,2
+ *     0 0 3 7 0.0125
+ */
+#ifndef FLEET_WEIGHTS_H_
+#define FLEET_WEIGHTS_H_
+
+// ------------------------------ includes ------------------------------
+#include <stdint.h>
+#include "bitboard.h"
+#include "fleet.h"
+#include "rng.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def WEIGHTS_MAX_SHIPS 32
+ * @brief The maximal number of ships of a weighted fleet.
+ */
+#define WEIGHTS_MAX_SHIPS 32
+
+/**
+ * @def WEIGHTS_MAX_SLOTS 1352
+ * @brief The number of slots of a ship on the largest board, both angles.
+ */
+#define WEIGHTS_MAX_SLOTS (2 * BITBOARD_MAX_SIZE * BITBOARD_MAX_SIZE)
+
+// ------------------------------ structs ----------------------------
+
+/**
+ * a structure holding the alias table of a single ship. includes the following attributes:
+ * slotsNum - the number of slots, 2 * size * size.
+ * threshold - for every slot, the chance (out of 2^32) that a draw landing on it keeps it.
+ * alias - for every slot, the slot a draw landing on it takes otherwise.
+ */
+typedef struct ShipAlias
+{
+	int slotsNum;
+	uint32_t threshold[WEIGHTS_MAX_SLOTS];
+	uint16_t alias[WEIGHTS_MAX_SLOTS];
+} ShipAlias;
+
+/**
+ * a structure holding the weighted placement table of a fleet. includes the following
+ * attributes:
+ * size - the board size.
+ * fleet - the fleet, the ships in their placing order.
+ * weights - the weight of every slot of every ship, not normalized.
+ * tables - the alias table of every ship, built from the weights by buildFleetWeights.
+ */
+typedef struct FleetWeights
+{
+	int size;
+	Fleet fleet;
+	float weights[WEIGHTS_MAX_SHIPS][WEIGHTS_MAX_SLOTS];
+	ShipAlias tables[WEIGHTS_MAX_SHIPS];
+} FleetWeights;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Returns the slot of a ship location.
+ * @param size The board size.
+ * @param angle 0 for vertical, 1 for horizontal.
+ * @param row The row of the first cell of the ship.
+ * @param col The column of the first cell of the ship.
+ * @return The slot.
+ */
+static inline int weightsSlot(int size, int angle, int row, int col)
+{
+	return (angle * size + row) * size + col;
+}
+
+/**
+ * @brief Draws the slot of a ship from its alias table, with a single random number.
+ * @param table The alias table of the ship.
+ * @param rng The random numbers generator.
+ * @return The slot.
+ */
+static inline int weightedSlot(const ShipAlias *table, Rng *rng)
+{
+	uint64_t bits = rngNext(rng);
+	uint32_t index = (uint32_t) (((bits & 0xffffffffULL) * (uint64_t) table->slotsNum) >> 32);
+	return (uint32_t) (bits >> 32) < table->threshold[index] ? (int) index : table->alias[index];
+}
+
+/**
+ * @brief Starts a table giving every slot that fits the board the same weight, the
+ * distribution of the uniform placement of a single ship on an empty board.
+ * @param weights The table, its alias tables are built.
+ * @param size The board size.
+ * @param fleet The fleet, of at most WEIGHTS_MAX_SHIPS ships that fit the board.
+ * @return TRUE (1) on success, FALSE if the fleet does not fit the table.
+ */
+int uniformFleetWeights(FleetWeights *weights, int size, const Fleet *fleet);
+
+/**
+ * @brief Builds the alias table of every ship from its weights. The weights of the slots that
+ * do not fit the board are cleared first.
+ * @param weights The table.
+ * @return TRUE (1) on success, FALSE if a ship has no slot with a weight.
+ */
+int buildFleetWeights(FleetWeights *weights);
+
+/**
+ * @brief Saves a table as text.
+ * @param path The file path.
+ * @param weights The table.
+ * @return TRUE (1) on success, FALSE if the file could not be written.
+ */
+int saveFleetWeights(const char *path, const FleetWeights *weights);
+
+/**
+ * @brief Loads a table saved by saveFleetWeights and builds its alias tables.
+ * @param path The file path.
+ * @param weights Filled with the table.
+ * @return TRUE (1) on success, FALSE if the file could not be read or is not a valid table.
+ */
+int loadFleetWeights(const char *path, FleetWeights *weights);
+
+#endif /* FLEET_WEIGHTS_H_ */
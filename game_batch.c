@@ -0,0 +1,234 @@
+/**
+ * @file game_batch.c
+ * @version 2.0
+ *
+ * @brief Advancing many games at once, one shot per game per step.
+ *
+ * @section DESCRIPTION
+ * The per game arrays are laid out with the lane as the fastest index, so the cells a step
+ * touches in different games never share an address: a step gathers the row and ship id under
+ * every shot, computes the results and the new shots and lives with vector operations, and
+ * scatters them back to the same places. The lanes are processed LANE_VECTOR_LANES at a time,
+ * the width of the 16 byte vectors every x86-64 processor has (wider generic vectors are split
+ * to scalar code by the compiler wherever the target lacks them). An idle or out of bounds lane
+ * shoots nowhere, it reads and writes back row 0 of its own game unchanged.
+ */
+// ------------------------------ includes ------------------------------
+#include <stdlib.h>
+#include <string.h>
+#include "game_batch.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def BATCH_ALIGNMENT 64
+ * @brief The alignment of a batch (a cache line).
+ */
+#define BATCH_ALIGNMENT 64
+
+/**
+ * @def LANE_VECTOR_LANES 4
+ * @brief The number of lanes of a vector.
+ */
+#define LANE_VECTOR_LANES 4
+
+/**
+ * @def GATHER(table, index)
+ * @brief Loads the entries of a table at the indices in the lanes of a LaneArray, into a vector.
+ * The vector is built from the loaded values directly (rather than stored lane by lane and read
+ * back whole, which stalls the load).
+ */
+#define GATHER(table, index) ((LaneVector) {(table)[(index).lanes[0]], (table)[(index).lanes[1]], \
+											(table)[(index).lanes[2]], (table)[(index).lanes[3]]})
+
+// ------------------------------ structs ----------------------------
+
+/**
+ * a vector holding one 32 bit lane for LANE_VECTOR_LANES games of a batch.
+ */
+typedef uint32_t LaneVector __attribute__((vector_size(LANE_VECTOR_LANES * sizeof(uint32_t))));
+
+/**
+ * a vector holding one signed 32 bit lane for LANE_VECTOR_LANES games of a batch, for the
+ * comparisons the basic vector instructions only have in signed form.
+ */
+typedef int32_t LaneIntVector __attribute__((vector_size(LANE_VECTOR_LANES * sizeof(int32_t))));
+
+/**
+ * a lane vector that can also be read and written one lane at a time, for the loads and
+ * stores that have no vector form. includes the following attributes:
+ * vector - the lanes as a vector.
+ * lanes - the lanes as an array.
+ */
+typedef union LaneArray
+{
+	LaneVector vector;
+	uint32_t lanes[LANE_VECTOR_LANES];
+} LaneArray;
+
+// ------------------------------ globals ----------------------------
+
+/**
+ * The index of every lane of a vector.
+ */
+static const LaneVector LANE_INDEX = {0, 1, 2, 3};
+
+/**
+ * A vector of ones.
+ */
+static const LaneVector LANE_ONES = {1, 1, 1, 1};
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Creates a batch with every lane idle.
+ * @param size The board size of all the games.
+ * @return The new batch, NULL if the allocation failed.
+ */
+GameBatch *newGameBatch(int size)
+{
+	size_t bytes = (sizeof(GameBatch) + BATCH_ALIGNMENT - 1) / BATCH_ALIGNMENT * BATCH_ALIGNMENT;
+	GameBatch *batch = (GameBatch *) aligned_alloc(BATCH_ALIGNMENT, bytes);
+	if (batch == NULL)
+	{
+		return NULL;
+	}
+	memset(batch, 0, sizeof(GameBatch));
+	batch->size = size;
+	return batch;
+}
+
+/**
+ * @brief Loads a game with a placed fleet and no shots into an idle lane (see resetGame).
+ * @param batch The batch.
+ * @param lane The lane.
+ * @param game The game, it stays in use until its lane is finished or dropped.
+ */
+void batchLoad(GameBatch *batch, int lane, Game *game)
+{
+	const ShipTable *ships = &game->ships;
+	int i, k, row, col;
+	for (i = 0; i < batch->size; i++)
+	{
+		batch->shipRows[i][lane] = bbRow(&game->board.ships, i);
+		batch->shotRows[i][lane] = 0;
+	}
+	for (i = 0; i < game->shipsNum; i++)
+	{
+		batch->lives[i][lane] = ships->length[i];
+		for (k = 0; k < ships->length[i]; k++)
+		{
+			row = ships->row[i] + (ships->angle[i] == VERTICAL ? k : 0);
+			col = ships->col[i] + (ships->angle[i] == VERTICAL ? 0 : k);
+			batch->shipIds[row * BITBOARD_MAX_SIZE + col][lane] = (uint16_t) i;
+		}
+	}
+	batch->games[lane] = game;
+	batch->shipsNum[lane] = (uint32_t) game->shipsNum;
+	batch->deadShips[lane] = 0;
+	batch->activeLanes[lane] = ~0U;
+	batch->active |= 1U << lane;
+}
+
+/**
+ * @brief Takes a game out of its lane before it is finished, leaving the lane idle.
+ * @param batch The batch.
+ * @param lane The lane.
+ */
+void batchDrop(GameBatch *batch, int lane)
+{
+	batch->games[lane] = NULL;
+	batch->activeLanes[lane] = 0;
+	batch->active &= ~(1U << lane);
+}
+
+/**
+ * @brief Fires one shot in the game of every active lane, all of them together.
+ * @param batch The batch.
+ * @param rows The row of the shot of every lane.
+ * @param cols The column of the shot of every lane.
+ * @param results Filled with the result of the shot of every lane, as returned by fireShot
+ * (SHOT_INVALID for the idle lanes).
+ * @return The mask of the lanes whose last ship was sunk by this step, they are left idle.
+ */
+uint32_t batchStep(GameBatch *batch, const uint32_t rows[GAME_BATCH_LANES],
+				   const uint32_t cols[GAME_BATCH_LANES], uint32_t results[GAME_BATCH_LANES])
+{
+	uint32_t *shotRows = (uint32_t *) batch->shotRows;
+	const uint32_t *shipRows = (const uint32_t *) batch->shipRows;
+	const uint16_t *shipIds = (const uint16_t *) batch->shipIds;
+	uint8_t *lives = (uint8_t *) batch->lives;
+	LaneVector row, col, active, valid, bit, ships, shots, ids, left, dead, shipsNum;
+	LaneVector fresh, hit, sunk, result, done;
+	LaneIntVector bound = (LaneIntVector) LANE_ONES * batch->size;
+	LaneArray slot, cell, lane;
+	uint32_t finished = 0;
+	int base, l;
+	for (base = 0; base < GAME_BATCH_LANES; base += LANE_VECTOR_LANES)
+	{
+		memcpy(&row, rows + base, sizeof(LaneVector));
+		memcpy(&col, cols + base, sizeof(LaneVector));
+		memcpy(&active, batch->activeLanes + base, sizeof(LaneVector));
+		valid = (LaneVector) ((LaneIntVector) (row | col) >= 0) &
+				(LaneVector) ((LaneIntVector) row < bound) &
+				(LaneVector) ((LaneIntVector) col < bound) & active;
+		row &= valid;
+		col &= valid;
+		slot.vector = row * GAME_BATCH_LANES + LANE_INDEX + base;
+		cell.vector = (row * BITBOARD_MAX_SIZE + col) * GAME_BATCH_LANES + LANE_INDEX + base;
+		lane.vector = col;
+		bit = (LaneVector) {1U << lane.lanes[0], 1U << lane.lanes[1], 1U << lane.lanes[2],
+							1U << lane.lanes[3]};
+		ships = GATHER(shipRows, slot);
+		shots = GATHER(shotRows, slot);
+		ids = GATHER(shipIds, cell);
+		fresh = (LaneVector) ((shots & bit) == 0) & valid;
+		hit = ~(LaneVector) ((ships & bit) == 0) & fresh;
+		lane.vector = shots | (bit & fresh);
+		for (l = 0; l < LANE_VECTOR_LANES; l++)
+		{
+			shotRows[slot.lanes[l]] = lane.lanes[l];
+		}
+		cell.vector = ids * GAME_BATCH_LANES + LANE_INDEX + base;
+		left = GATHER(lives, cell) - (hit & LANE_ONES);
+		lane.vector = left;
+		for (l = 0; l < LANE_VECTOR_LANES; l++)
+		{
+			lives[cell.lanes[l]] = (uint8_t) lane.lanes[l];
+		}
+		sunk = (LaneVector) (left == 0) & hit;
+		memcpy(&dead, batch->deadShips + base, sizeof(LaneVector));
+		memcpy(&shipsNum, batch->shipsNum + base, sizeof(LaneVector));
+		dead -= sunk;
+		memcpy(batch->deadShips + base, &dead, sizeof(LaneVector));
+		result = (~valid & SHOT_INVALID) | (valid & ~fresh & SHOT_ALREADY) |
+				 (fresh & ~hit & SHOT_MISS) | (hit & ~sunk & SHOT_HIT) | (sunk & (ids + SHOT_SUNK));
+		memcpy(results + base, &result, sizeof(LaneVector));
+		done = (LaneVector) (dead == shipsNum) & sunk;
+		active &= ~done;
+		memcpy(batch->activeLanes + base, &active, sizeof(LaneVector));
+		lane.vector = done;
+		for (l = 0; l < LANE_VECTOR_LANES; l++)
+		{
+			finished |= (lane.lanes[l] & 1U) << (base + l);
+		}
+	}
+	for (l = 0; l < GAME_BATCH_LANES; l++)
+	{
+		if (finished & (1U << l))
+		{
+			batch->games[l] = NULL;
+		}
+	}
+	batch->active &= ~finished;
+	return finished;
+}
+
+/**
+ * @brief Frees a batch. The games loaded into it are not freed.
+ * @param batch The batch.
+ */
+void freeGameBatch(GameBatch *batch)
+{
+	free(batch);
+}
@@ -0,0 +1,104 @@
+/**
+ * @file game_batch.h
+ * @version 2.0
+ *
+ * @brief Advancing many games at once, one shot per game per step.
+ *
+ * @section DESCRIPTION
+ * A batch holds GAME_BATCH_LANES games side by side, in a struct of arrays layout: every row of
+ * the ships and shots masks, every ship id and every ship lives counter is an array with one
+ * lane for every game. A step takes one shot for every game and resolves them together with
+ * vector operations (bounds, repeated shots, hits, lives and sinks), the only per lane work
+ * being the loads and stores of the lanes own cells.
+ * A lane whose fleet is sunk is reported by the step and left idle until a new game is loaded
+ * into it, so the caller can keep every lane busy from a queue of games.
+ */
+#ifndef GAME_BATCH_H_
+#define GAME_BATCH_H_
+
+// ------------------------------ includes ------------------------------
+#include <stdint.h>
+#include "battleships.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def GAME_BATCH_LANES 16
+ * @brief The number of games advanced together.
+ */
+#define GAME_BATCH_LANES 16
+
+// ------------------------------ structs ----------------------------
+
+/**
+ * a structure holding the games of a batch. every array has one entry (lane) for every game.
+ * includes the following attributes:
+ * size - the board size of all the games.
+ * active - bit l is set while lane l holds a game in play.
+ * games - the game block loaded into every lane, holding its fleet (NULL for an idle lane).
+ * activeLanes - all ones in the lanes holding a game in play, 0 in the others.
+ * shipsNum - the number of ships of the game of every lane.
+ * deadShips - the number of sunk ships of the game of every lane.
+ * shipRows - for every board row, the ship cells of that row in every game.
+ * shotRows - for every board row, the cells of that row already shot in every game.
+ * lives - for every ship index, the cells not hit yet of that ship in every game.
+ * shipIds - for every cell (row times BITBOARD_MAX_SIZE plus column), the index of the ship
+ * taking it in every game, only meaningful on the ship cells.
+ */
+typedef struct GameBatch
+{
+	int size;
+	uint32_t active;
+	Game *games[GAME_BATCH_LANES];
+	_Alignas(64) uint32_t activeLanes[GAME_BATCH_LANES];
+	uint32_t shipsNum[GAME_BATCH_LANES];
+	uint32_t deadShips[GAME_BATCH_LANES];
+	uint32_t shipRows[BITBOARD_MAX_SIZE][GAME_BATCH_LANES];
+	uint32_t shotRows[BITBOARD_MAX_SIZE][GAME_BATCH_LANES];
+	uint8_t lives[MAX_FLEET_SHIPS][GAME_BATCH_LANES];
+	uint16_t shipIds[BITBOARD_MAX_SIZE * BITBOARD_MAX_SIZE][GAME_BATCH_LANES];
+} GameBatch;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Creates a batch with every lane idle.
+ * @param size The board size of all the games.
+ * @return The new batch, NULL if the allocation failed.
+ */
+GameBatch *newGameBatch(int size);
+
+/**
+ * @brief Loads a game with a placed fleet and no shots into an idle lane (see resetGame).
+ * @param batch The batch.
+ * @param lane The lane.
+ * @param game The game, it stays in use until its lane is finished or dropped.
+ */
+void batchLoad(GameBatch *batch, int lane, Game *game);
+
+/**
+ * @brief Takes a game out of its lane before it is finished, leaving the lane idle.
+ * @param batch The batch.
+ * @param lane The lane.
+ */
+void batchDrop(GameBatch *batch, int lane);
+
+/**
+ * @brief Fires one shot in the game of every active lane, all of them together.
+ * @param batch The batch.
+ * @param rows The row of the shot of every lane.
+ * @param cols The column of the shot of every lane.
+ * @param results Filled with the result of the shot of every lane, as returned by fireShot
+ * (SHOT_INVALID for the idle lanes).
+ * @return The mask of the lanes whose last ship was sunk by this step, they are left idle.
+ */
+uint32_t batchStep(GameBatch *batch, const uint32_t rows[GAME_BATCH_LANES],
+				   const uint32_t cols[GAME_BATCH_LANES], uint32_t results[GAME_BATCH_LANES]);
+
+/**
+ * @brief Frees a batch. The games loaded into it are not freed.
+ * @param batch The batch.
+ */
+void freeGameBatch(GameBatch *batch);
+
+#endif /* GAME_BATCH_H_ */
@@ -0,0 +1,132 @@
+/**
+ * @file game_pool.c
+ * @version 2.0
+ *
+ * @brief A pool of game blocks reused across many games.
+ *
+ * @section DESCRIPTION
+ * The slab holds capacity game blocks of gameBlockSize bytes each, one after the other, so every
+ * block starts on a cache line. The free blocks are kept in a stack, the last block released is
+ * the first one acquired again while it is still warm in the cache.
+ */
+// ------------------------------ includes ------------------------------
+#include <stdlib.h>
+#include "game_pool.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def  TRUE 1
+ * @brief a true boolean value.
+ */
+#define TRUE 1
+
+/**
+ * @def FALSE -1
+ * @brief a false boolean value.
+ */
+#define FALSE (-1)
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Creates a pool of games with the given board size and fleet.
+ * @param size The board size of all the games.
+ * @param fleet The fleet of all the games, it must outlive the pool.
+ * @param capacity The number of games the pool holds.
+ * @return The new pool, NULL if the allocation failed.
+ */
+GamePool *newGamePool(int size, const Fleet *fleet, int capacity)
+{
+	GamePool *pool = (GamePool *) malloc(sizeof(GamePool));
+	Game *game;
+	int i;
+	if (pool == NULL)
+	{
+		return NULL;
+	}
+	pool->blockSize = gameBlockSize(fleet->shipsNum);
+	pool->capacity = capacity;
+	pool->slab = (unsigned char *) aligned_alloc(GAME_ALIGNMENT, pool->blockSize * capacity);
+	pool->freeList = (Game **) malloc(capacity * sizeof(Game *));
+	if (pool->slab == NULL || pool->freeList == NULL)
+	{
+		freeGamePool(pool);
+		return NULL;
+	}
+	for (i = 0; i < capacity; i++)
+	{
+		game = (Game *) (pool->slab + pool->blockSize * (capacity - 1 - i));
+		initGame(game, size, fleet);
+		pool->freeList[i] = game;
+	}
+	pool->freeNum = capacity;
+	return pool;
+}
+
+/**
+ * @brief Makes every game of the pool draw its fleet from a weighted placement table (see
+ * useFleetWeights). Call it while all the games are free.
+ * @param pool The pool.
+ * @param weights The table, it must outlive the pool, NULL for the uniform placement.
+ * @return TRUE on success, FALSE if the table is not of the board size and fleet of the pool.
+ */
+int poolUseWeights(GamePool *pool, const FleetWeights *weights)
+{
+	int i, status = TRUE;
+	for (i = 0; i < pool->freeNum; i++)
+	{
+		if (useFleetWeights(&pool->freeList[i]->board, pool->freeList[i]->fleet, weights) != TRUE)
+		{
+			status = FALSE;
+		}
+	}
+	return status;
+}
+
+/**
+ * @brief Takes a free game from the pool and starts a new game in it.
+ * @param pool The pool.
+ * @param rng The random numbers generator placing the fleet.
+ * @return The game, NULL if the pool is empty or the fleet could not be placed.
+ */
+Game *poolAcquire(GamePool *pool, Rng *rng)
+{
+	Game *game;
+	if (pool->freeNum == 0)
+	{
+		return NULL;
+	}
+	game = pool->freeList[--pool->freeNum];
+	if (resetGame(game, rng) != TRUE)
+	{
+		pool->freeList[pool->freeNum++] = game;
+		return NULL;
+	}
+	return game;
+}
+
+/**
+ * @brief Returns a game to the pool.
+ * @param pool The pool.
+ * @param game A game acquired from this pool.
+ */
+void poolRelease(GamePool *pool, Game *game)
+{
+	pool->freeList[pool->freeNum++] = game;
+}
+
+/**
+ * @brief Frees a pool and all of its games.
+ * @param pool The pool.
+ */
+void freeGamePool(GamePool *pool)
+{
+	if (pool == NULL)
+	{
+		return;
+	}
+	free(pool->slab);
+	free(pool->freeList);
+	free(pool);
+}
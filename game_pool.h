@@ -0,0 +1,79 @@
+/**
+ * @file game_pool.h
+ * @version 2.0
+ *
+ * @brief A pool of game blocks reused across many games.
+ *
+ * @section DESCRIPTION
+ * All the games of a pool live in one cache aligned slab allocated when the pool is created.
+ * Acquiring a game resets a free block and places a new fleet in it, releasing it puts the block
+ * back, so a loop of games makes no allocator calls.
+ */
+#ifndef GAME_POOL_H_
+#define GAME_POOL_H_
+
+// ------------------------------ includes ------------------------------
+#include <stddef.h>
+#include "battleships.h"
+
+// ------------------------------ structs ----------------------------
+
+/**
+ * a structure describing a pool of games. includes the following attributes:
+ * slab - the memory of all the game blocks.
+ * blockSize - the size of a single game block.
+ * capacity - the number of game blocks.
+ * freeNum - the number of free game blocks.
+ * freeList - a stack of the free game blocks.
+ */
+typedef struct GamePool
+{
+	unsigned char *slab;
+	size_t blockSize;
+	int capacity;
+	int freeNum;
+	Game **freeList;
+} GamePool;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Creates a pool of games with the given board size and fleet.
+ * @param size The board size of all the games.
+ * @param fleet The fleet of all the games, it must outlive the pool.
+ * @param capacity The number of games the pool holds.
+ * @return The new pool, NULL if the allocation failed.
+ */
+GamePool *newGamePool(int size, const Fleet *fleet, int capacity);
+
+/**
+ * @brief Makes every game of the pool draw its fleet from a weighted placement table (see
+ * useFleetWeights). Call it while all the games are free.
+ * @param pool The pool.
+ * @param weights The table, it must outlive the pool, NULL for the uniform placement.
+ * @return TRUE (1) on success, FALSE if the table is not of the board size and fleet of the pool.
+ */
+int poolUseWeights(GamePool *pool, const FleetWeights *weights);
+
+/**
+ * @brief Takes a free game from the pool and starts a new game in it.
+ * @param pool The pool.
+ * @param rng The random numbers generator placing the fleet.
+ * @return The game, NULL if the pool is empty or the fleet could not be placed.
+ */
+Game *poolAcquire(GamePool *pool, Rng *rng);
+
+/**
+ * @brief Returns a game to the pool.
+ * @param pool The pool.
+ * @param game A game acquired from this pool.
+ */
+void poolRelease(GamePool *pool, Game *game);
+
+/**
+ * @brief Frees a pool and all of its games.
+ * @param pool The pool.
+ */
+void freeGamePool(GamePool *pool);
+
+#endif /* GAME_POOL_H_ */
@@ -0,0 +1,562 @@
+/**
+ * @file game_server.c
+ * @version 2.0
+ *
+ * @brief A server hosting many independent games over a Unix domain socket or loopback TCP.
+ *
+ * @section DESCRIPTION
+ * Every event loop owns its sessions from the accept to the close, so the loops share nothing
+ * but the listening socket and never lock. A session answers the complete lines of its input as
+ * long as its output buffer has room for another answer, and stops reading while the client does
+ * not read the answers, so a slow client costs only its own buffers.
+ */
+// ------------------------------ includes ------------------------------
+#define _GNU_SOURCE /* accept4 */
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "game_pool.h"
+#include "game_server.h"
+#include "move_reader.h"
+#include "shot_messages.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def MEMORY_ERROR 2
+ * @brief the integer returned if one of the pointers is NULL .
+ */
+#define MEMORY_ERROR 2
+
+/**
+ * @def SESSION_CLOSED -1
+ * @brief returned by the session handlers when the session must be closed.
+ */
+#define SESSION_CLOSED (-1)
+
+/**
+ * @def MAX_EVENTS 256
+ * @brief The number of events an event loop takes from the kernel at once.
+ */
+#define MAX_EVENTS 256
+
+/**
+ * @def STOP_CHECK_MS 100
+ * @brief The longest time an idle event loop waits before checking whether to stop.
+ */
+#define STOP_CHECK_MS 100
+
+/**
+ * @def LISTEN_BACKLOG 4096
+ * @brief The number of connections the kernel queues before they are accepted.
+ */
+#define LISTEN_BACKLOG 4096
+
+/**
+ * @def LOOPBACK_ADDRESS 0x7f000001
+ * @brief The loopback address (127.0.0.1) the TCP server listens on.
+ */
+#define LOOPBACK_ADDRESS 0x7f000001U
+
+/**
+ * @def MAX_ANSWER_SIZE 64
+ * @brief The output room needed to answer a move (the longest answer and the game over line).
+ */
+#define MAX_ANSWER_SIZE 64
+
+// ------------------------------ structs ----------------------------
+
+/**
+ * a structure describing a session. includes the following attributes:
+ * fd - the connection socket.
+ * events - the events the session is registered for.
+ * game - the game of the session.
+ * next - the next free session, while the session is free.
+ * inputLength - the number of bytes in the input buffer.
+ * outputStart - the first byte of the output buffer not written yet.
+ * outputLength - the number of bytes in the output buffer.
+ * input - the bytes read and not answered yet, a partial line at most once answered.
+ * output - the answers not written yet.
+ */
+typedef struct Session
+{
+	int fd;
+	uint32_t events;
+	Game *game;
+	struct Session *next;
+	size_t inputLength;
+	size_t outputStart;
+	size_t outputLength;
+	char input[SESSION_INPUT_SIZE];
+	char output[SESSION_OUTPUT_SIZE];
+} Session;
+
+/**
+ * a structure describing an event loop. includes the following attributes:
+ * config - the server description.
+ * listener - the listening socket.
+ * epoll - the epoll instance of the loop.
+ * rng - the random numbers generator placing the fleets of the loop's games.
+ * pool - the game blocks of the loop.
+ * sessions - the sessions of the loop.
+ * freeSessions - a stack of the free sessions.
+ * stats - the totals of the loop.
+ * status - 0 on success, MEMORY_ERROR or SERVER_ERROR if the loop failed.
+ * started - non zero if the loop runs on its own thread, which must be joined.
+ * thread - the loop thread.
+ */
+typedef struct EventLoop
+{
+	const ServerConfig *config;
+	int listener;
+	int epoll;
+	Rng rng;
+	GamePool *pool;
+	Session *sessions;
+	Session *freeSessions;
+	ServerStats stats;
+	int status;
+	int started;
+	pthread_t thread;
+} EventLoop;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Opens the listening socket of a server.
+ * @param config The server description.
+ * @return The socket, -1 on failure (errno is set).
+ */
+int openServerSocket(const ServerConfig *config)
+{
+	struct sockaddr_un local;
+	struct sockaddr_in inet;
+	int fd, on = 1;
+	if (config->path != NULL)
+	{
+		if (strlen(config->path) >= sizeof(local.sun_path))
+		{
+			errno = ENAMETOOLONG;
+			return -1;
+		}
+		memset(&local, 0, sizeof(local));
+		local.sun_family = AF_UNIX;
+		strcpy(local.sun_path, config->path);
+		fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		unlink(config->path);
+		if (fd >= 0 && bind(fd, (struct sockaddr *) &local, sizeof(local)) != 0)
+		{
+			close(fd);
+			return -1;
+		}
+	}
+	else
+	{
+		memset(&inet, 0, sizeof(inet));
+		inet.sin_family = AF_INET;
+		inet.sin_port = htons((uint16_t) config->port);
+		inet.sin_addr.s_addr = htonl(LOOPBACK_ADDRESS);
+		fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if (fd >= 0 && (setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) != 0 ||
+						bind(fd, (struct sockaddr *) &inet, sizeof(inet)) != 0))
+		{
+			close(fd);
+			return -1;
+		}
+	}
+	if (fd >= 0 && listen(fd, LISTEN_BACKLOG) != 0)
+	{
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/**
+ * @brief Appends a message to the output of a session.
+ * @param session The session, with room for the message.
+ * @param message The message.
+ * @param length The message length.
+ */
+static void answer(Session *session, const char *message, size_t length)
+{
+	memcpy(session->output + session->outputLength, message, length);
+	session->outputLength += length;
+}
+
+/**
+ * @brief Plays a single line of a session and appends the answer to its output.
+ * @param loop The event loop.
+ * @param session The session, with MAX_ANSWER_SIZE bytes of output room.
+ * @param line The line, without the line end.
+ * @param length The line length.
+ * @return 0 on success, SESSION_CLOSED if the client typed exit or a new game could not be
+ * placed.
+ */
+int answerMove(EventLoop *loop, Session *session, const char *line, size_t length)
+{
+	const char *message;
+	int row, col, result;
+	switch (scanMove(line, length, &row, &col))
+	{
+		case MOVE_EXIT:
+			return SESSION_CLOSED;
+		case MOVE_READ:
+			result = fireShot(session->game, row, col);
+			break;
+		default:
+			result = SHOT_INVALID;
+			break;
+	}
+	loop->stats.moves++;
+	message = shotMessage(result);
+	answer(session, message, strlen(message));
+	if (SHOT_IS_SUNK(result) && session->game->deadShips == session->game->shipsNum)
+	{
+		answer(session, GAME_OVER_MESSAGE, sizeof(GAME_OVER_MESSAGE) - 1);
+		loop->stats.games++;
+		poolRelease(loop->pool, session->game);
+		session->game = poolAcquire(loop->pool, &loop->rng);
+		if (session->game == NULL)
+		{
+			return SESSION_CLOSED;
+		}
+	}
+	return 0;
+}
+
+/**
+ * @brief Answers the complete lines of a session's input while its output has room, and keeps
+ * the rest of the input for later.
+ * @param loop The event loop.
+ * @param session The session.
+ * @return 0 on success, SESSION_CLOSED if the session ended or sent a line longer than its
+ * input buffer.
+ */
+int answerLines(EventLoop *loop, Session *session)
+{
+	char *line = session->input, *end = session->input + session->inputLength, *newline;
+	while (session->outputLength + MAX_ANSWER_SIZE <= SESSION_OUTPUT_SIZE &&
+		   (newline = (char *) memchr(line, '\n', (size_t) (end - line))) != NULL)
+	{
+		if (answerMove(loop, session, line, (size_t) (newline - line)) != 0)
+		{
+			return SESSION_CLOSED;
+		}
+		line = newline + 1;
+	}
+	session->inputLength = (size_t) (end - line);
+	if (line != session->input)
+	{
+		memmove(session->input, line, session->inputLength);
+	}
+	if (session->inputLength == SESSION_INPUT_SIZE &&
+		memchr(session->input, '\n', SESSION_INPUT_SIZE) == NULL)
+	{
+		return SESSION_CLOSED;
+	}
+	return 0;
+}
+
+/**
+ * @brief Writes as much of a session's output as the socket takes.
+ * @param session The session.
+ * @return 0 on success, SESSION_CLOSED if the connection failed.
+ */
+int flushSession(Session *session)
+{
+	ssize_t written;
+	while (session->outputStart < session->outputLength)
+	{
+		written = write(session->fd, session->output + session->outputStart,
+						session->outputLength - session->outputStart);
+		if (written < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (written < 0)
+		{
+			return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : SESSION_CLOSED;
+		}
+		session->outputStart += (size_t) written;
+	}
+	session->outputStart = 0;
+	session->outputLength = 0;
+	return 0;
+}
+
+/**
+ * @brief Closes a session and returns it and its game to the loop's pools.
+ * @param loop The event loop.
+ * @param session The session.
+ */
+void closeSession(EventLoop *loop, Session *session)
+{
+	close(session->fd);
+	if (session->game != NULL)
+	{
+		poolRelease(loop->pool, session->game);
+	}
+	session->game = NULL;
+	session->fd = -1;
+	session->next = loop->freeSessions;
+	loop->freeSessions = session;
+}
+
+/**
+ * @brief Registers a session for reading while its buffers have room, and for writing while it
+ * has output the socket did not take yet.
+ * @param loop The event loop.
+ * @param session The session.
+ * @return 0 on success, SESSION_CLOSED if the registration failed.
+ */
+int updateEvents(EventLoop *loop, Session *session)
+{
+	struct epoll_event event;
+	uint32_t events = 0;
+	if (session->outputStart > 0)
+	{
+		memmove(session->output, session->output + session->outputStart,
+				session->outputLength - session->outputStart);
+		session->outputLength -= session->outputStart;
+		session->outputStart = 0;
+	}
+	if (session->outputLength > 0)
+	{
+		events |= EPOLLOUT;
+	}
+	if (session->outputLength + MAX_ANSWER_SIZE <= SESSION_OUTPUT_SIZE &&
+		session->inputLength < SESSION_INPUT_SIZE)
+	{
+		events |= EPOLLIN;
+	}
+	if (events == session->events)
+	{
+		return 0;
+	}
+	event.events = events;
+	event.data.ptr = session;
+	session->events = events;
+	return epoll_ctl(loop->epoll, EPOLL_CTL_MOD, session->fd, &event) == 0 ? 0 : SESSION_CLOSED;
+}
+
+/**
+ * @brief Handles the events of a session: reads what the client sent, answers the complete
+ * lines and writes the answers.
+ * @param loop The event loop.
+ * @param session The session.
+ * @param events The events the kernel reported.
+ */
+void serveSession(EventLoop *loop, Session *session, uint32_t events)
+{
+	ssize_t got = 0;
+	int status = 0;
+	if ((events & EPOLLIN) && session->inputLength < SESSION_INPUT_SIZE)
+	{
+		do
+		{
+			got = read(session->fd, session->input + session->inputLength,
+					   SESSION_INPUT_SIZE - session->inputLength);
+		} while (got < 0 && errno == EINTR);
+		if (got == 0 || (got < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+		{
+			status = SESSION_CLOSED;
+		}
+		session->inputLength += got > 0 ? (size_t) got : 0;
+	}
+	else if ((events & (EPOLLERR | EPOLLHUP)) && !(events & EPOLLIN))
+	{
+		status = SESSION_CLOSED;
+	}
+	if (status == 0 && (events & EPOLLOUT))
+	{
+		status = flushSession(session);
+	}
+	if (status == 0)
+	{
+		status = answerLines(loop, session);
+	}
+	if (status == 0)
+	{
+		status = flushSession(session);
+	}
+	if (status == 0)
+	{
+		status = updateEvents(loop, session);
+	}
+	if (status != 0)
+	{
+		closeSession(loop, session);
+	}
+}
+
+/**
+ * @brief Accepts the pending connections, each into a free session with a new game.
+ * Connections beyond the loop's sessions are closed at once.
+ * @param loop The event loop.
+ */
+void acceptSessions(EventLoop *loop)
+{
+	struct epoll_event event;
+	Session *session;
+	int fd, on = 1;
+	while ((fd = accept4(loop->listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+	{
+		session = loop->freeSessions;
+		if (session == NULL)
+		{
+			loop->stats.rejected++;
+			close(fd);
+			continue;
+		}
+		if (loop->config->path == NULL)
+		{
+			setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+		}
+		loop->freeSessions = session->next;
+		session->game = poolAcquire(loop->pool, &loop->rng);
+		session->fd = fd;
+		session->events = EPOLLIN;
+		session->inputLength = 0;
+		session->outputStart = 0;
+		session->outputLength = 0;
+		event.events = EPOLLIN;
+		event.data.ptr = session;
+		if (session->game == NULL || epoll_ctl(loop->epoll, EPOLL_CTL_ADD, fd, &event) != 0)
+		{
+			closeSession(loop, session);
+			continue;
+		}
+		loop->stats.sessions++;
+	}
+}
+
+/**
+ * @brief The body of an event loop thread, serving its sessions until the server stops. A loop
+ * which could not start stops the whole server. Everything the loop needs is allocated once,
+ * serving makes no allocator calls.
+ * @param arg The event loop.
+ * @return NULL.
+ */
+void *loopMain(void *arg)
+{
+	EventLoop *loop = (EventLoop *) arg;
+	const ServerConfig *config = loop->config;
+	struct epoll_event events[MAX_EVENTS], event;
+	int i, ready;
+	loop->pool = newGamePool(config->boardSize, config->fleet, config->sessions);
+	loop->sessions = (Session *) calloc((size_t) config->sessions, sizeof(Session));
+	loop->epoll = epoll_create1(EPOLL_CLOEXEC);
+	for (i = 0; loop->sessions != NULL && i < config->sessions; i++)
+	{
+		loop->sessions[i].fd = -1;
+	}
+	if (loop->pool == NULL || loop->sessions == NULL)
+	{
+		loop->status = MEMORY_ERROR;
+	}
+	event.events = EPOLLIN | EPOLLEXCLUSIVE;
+	event.data.ptr = NULL;
+	if (loop->status == 0 &&
+		(loop->epoll < 0 || epoll_ctl(loop->epoll, EPOLL_CTL_ADD, loop->listener, &event) != 0))
+	{
+		loop->status = SERVER_ERROR;
+	}
+	for (i = config->sessions - 1; loop->status == 0 && i >= 0; i--)
+	{
+		loop->sessions[i].next = loop->freeSessions;
+		loop->freeSessions = &loop->sessions[i];
+	}
+	if (loop->status != 0)
+	{
+		*config->stop = 1;
+	}
+	while (loop->status == 0 && !*config->stop)
+	{
+		ready = epoll_wait(loop->epoll, events, MAX_EVENTS, STOP_CHECK_MS);
+		for (i = 0; i < ready; i++)
+		{
+			if (events[i].data.ptr == NULL)
+			{
+				acceptSessions(loop);
+			}
+			else
+			{
+				serveSession(loop, (Session *) events[i].data.ptr, events[i].events);
+			}
+		}
+	}
+	for (i = 0; loop->sessions != NULL && i < config->sessions; i++)
+	{
+		if (loop->sessions[i].fd >= 0)
+		{
+			closeSession(loop, &loop->sessions[i]);
+		}
+	}
+	if (loop->epoll >= 0)
+	{
+		close(loop->epoll);
+	}
+	free(loop->sessions);
+	freeGamePool(loop->pool);
+	return NULL;
+}
+
+/**
+ * @brief Runs the event loops of a server on a listening socket until config->stop is set.
+ * @param config The server description.
+ * @param listener The listening socket, from openServerSocket.
+ * @param stats Filled with the totals of the run.
+ * @return 0 on success, MEMORY_ERROR (2) if an allocation failed, SERVER_ERROR if an event loop
+ * could not be created or its thread could not be started (the server then stops).
+ */
+int runServer(const ServerConfig *config, int listener, ServerStats *stats)
+{
+	int i, status = 0, count = config->threads;
+	EventLoop *loops;
+	memset(stats, 0, sizeof(ServerStats));
+	count = count < 1 ? 1 : (count > MAX_SERVER_THREADS ? MAX_SERVER_THREADS : count);
+	loops = (EventLoop *) calloc((size_t) count, sizeof(EventLoop));
+	if (loops == NULL)
+	{
+		return MEMORY_ERROR;
+	}
+	for (i = 0; i < count; i++)
+	{
+		loops[i].config = config;
+		loops[i].listener = listener;
+		loops[i].epoll = -1;
+		rngSeed(&loops[i].rng, config->seed, (uint64_t) i);
+	}
+	for (i = 1; i < count; i++)
+	{
+		loops[i].started = pthread_create(&loops[i].thread, NULL, loopMain, &loops[i]) == 0;
+		if (!loops[i].started)
+		{
+			loops[i].status = SERVER_ERROR;
+			*config->stop = 1;
+		}
+	}
+	loopMain(&loops[0]);
+	for (i = 0; i < count; i++)
+	{
+		if (loops[i].started)
+		{
+			pthread_join(loops[i].thread, NULL);
+		}
+		status = loops[i].status != 0 ? loops[i].status : status;
+		stats->sessions += loops[i].stats.sessions;
+		stats->moves += loops[i].stats.moves;
+		stats->games += loops[i].stats.games;
+		stats->rejected += loops[i].stats.rejected;
+	}
+	free(loops);
+	return status;
+}
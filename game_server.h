@@ -0,0 +1,111 @@
+/**
+ * @file game_server.h
+ * @version 2.0
+ *
+ * @brief A server hosting many independent games over a Unix domain socket or loopback TCP.
+ *
+ * @section DESCRIPTION
+ * Every connection is a session playing its own game. The client sends one move per line, in
+ * the console format ("a 5", the row letter and the column number) or "exit", and the server
+ * answers every move with one line holding the console message of the shot. When the last ship
+ * sinks the answer is followed by a "Game over" line, and the session goes on with a new game.
+ * The server runs one epoll event loop per worker thread. All the loops wait on the same
+ * listening socket (EPOLLEXCLUSIVE wakes a single one per connection), and a connection stays
+ * on the loop that accepted it. Sockets are non blocking, and every session keeps a small input
+ * buffer for partial lines and an output buffer for the answers the client did not read yet.
+ * The sessions and their game blocks come from pools allocated once per loop.
+ */
+#ifndef GAME_SERVER_H_
+#define GAME_SERVER_H_
+
+// ------------------------------ includes ------------------------------
+#include <signal.h>
+#include <stdint.h>
+#include "battleships.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def SERVER_ERROR 4
+ * @brief the integer returned if the server socket could not be opened.
+ */
+#define SERVER_ERROR 4
+
+/**
+ * @def MAX_SERVER_THREADS 256
+ * @brief The maximal number of event loops of a server.
+ */
+#define MAX_SERVER_THREADS 256
+
+/**
+ * @def SESSION_INPUT_SIZE 256
+ * @brief The size of the buffer holding the unanswered input of a session.
+ */
+#define SESSION_INPUT_SIZE 256
+
+/**
+ * @def SESSION_OUTPUT_SIZE 2048
+ * @brief The size of the buffer holding the answers a session's client did not read yet.
+ */
+#define SESSION_OUTPUT_SIZE 2048
+
+// ------------------------------ structs ----------------------------
+
+/**
+ * a structure describing a server. includes the following attributes:
+ * boardSize - the board size of every game.
+ * fleet - the fleet placed in every game.
+ * seed - the master seed of the random numbers, every loop draws from its own stream.
+ * threads - the number of event loops.
+ * sessions - the maximal number of sessions of every loop.
+ * path - the Unix domain socket path, NULL to listen on loopback TCP.
+ * port - the TCP port.
+ * stop - set to non zero (e.g. from a signal handler) to stop the server.
+ */
+typedef struct ServerConfig
+{
+	int boardSize;
+	const Fleet *fleet;
+	uint64_t seed;
+	int threads;
+	int sessions;
+	const char *path;
+	int port;
+	volatile sig_atomic_t *stop;
+} ServerConfig;
+
+/**
+ * a structure holding the totals of a server run. includes the following attributes:
+ * sessions - the number of sessions accepted.
+ * moves - the number of moves answered.
+ * games - the number of games won.
+ * rejected - the number of connections closed because no session was free.
+ */
+typedef struct ServerStats
+{
+	long sessions;
+	long moves;
+	long games;
+	long rejected;
+} ServerStats;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Opens the listening socket of a server.
+ * @param config The server description.
+ * @return The socket, -1 on failure (errno is set).
+ */
+int openServerSocket(const ServerConfig *config);
+
+/**
+ * @brief Runs the event loops of a server on a listening socket until config->stop is set.
+ * @param config The server description.
+ * @param listener The listening socket, from openServerSocket.
+ * @param stats Filled with the totals of the run.
+ * @return 0 on success, MEMORY_ERROR (2) if an allocation failed, SERVER_ERROR if an event loop
+ * could not be created or its thread could not be started (the server then stops).
+ */
+int runServer(const ServerConfig *config, int listener, ServerStats *stats);
+
+#endif /* GAME_SERVER_H_ */
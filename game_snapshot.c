@@ -0,0 +1,324 @@
+/**
+ * @file game_snapshot.c
+ * @version 2.0
+ *
+ * @brief Fixed size binary snapshots of running games, for checkpointing.
+ *
+ * @section DESCRIPTION
+ * Taking and restoring a snapshot copies the shots bitboard, the ship table and the generator
+ * state with a memcpy each. Restoring also marks the ships on the board again (a few row masks
+ * per ship) and derives the hits as the shots that fall on a ship, so no text or variable length
+ * data is ever parsed. Only what the board cannot tell is taken from the record as is: the shots
+ * are masked to the board, and the lives of the ships and the number of sunk ships are counted
+ * again from the hits, so a corrupt record cannot leave a ship that never sinks.
+ */
+// ------------------------------ includes ------------------------------
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "game_snapshot.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def  TRUE 1
+ * @brief the value returned on success.
+ */
+#define TRUE 1
+
+/**
+ * @def FALSE -1
+ * @brief the value returned on failure.
+ */
+#define FALSE (-1)
+
+/**
+ * @def SNAPSHOT_MODE 0644
+ * @brief The permissions of a new snapshot file.
+ */
+#define SNAPSHOT_MODE 0644
+
+_Static_assert(sizeof(GameSnapshot) == SNAPSHOT_SIZE, "snapshot records must be packed");
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Marks the ships of a restored ship table on the board masks and ship ids.
+ * @param board The board, with no ships.
+ * @param ships The ship table.
+ * @param count The number of ships.
+ * @return TRUE if every ship is on the board and no two ships overlap, FALSE otherwise.
+ */
+static int markShips(Board *board, const ShipTable *ships, int count)
+{
+	int i, j, row, col, length, vertical, size = board->size;
+	uint32_t bits;
+	uint16_t *cell;
+	for (i = 0; i < count; i++)
+	{
+		row = ships->row[i];
+		col = ships->col[i];
+		length = ships->length[i];
+		vertical = ships->angle[i] == VERTICAL;
+		if (length < 1 || (!vertical && ships->angle[i] != HORIZONTAL) ||
+			(vertical ? row + length > size || col >= size : row >= size || col + length > size))
+		{
+			return FALSE;
+		}
+		bits = vertical ? 1U << col : (uint32_t) (((1ULL << length) - 1) << col);
+		cell = &board->shipIds[row][col];
+		for (j = 0; j < (vertical ? length : 1); j++)
+		{
+			if (bbRow(&board->ships, row + j) & bits)
+			{
+				return FALSE;
+			}
+			bbOrRow(&board->ships, row + j, bits);
+		}
+		for (j = 0; j < length; j++)
+		{
+			cell[vertical ? j * BITBOARD_MAX_SIZE : j] = (uint16_t) i;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * @brief Counts the lives of every ship of a restored game, and its sunk ships, from the hits.
+ * @param game The game, with its ships marked and its hits set.
+ */
+static void countLives(Game *game)
+{
+	const Bitboard *hits = &game->board.hits;
+	const ShipTable *ships = &game->ships;
+	int i, j, lives, length;
+	uint32_t bits;
+	game->deadShips = 0;
+	for (i = 0; i < game->shipsNum; i++)
+	{
+		length = ships->length[i];
+		if (ships->angle[i] == VERTICAL)
+		{
+			for (j = 0, lives = 0; j < length; j++)
+			{
+				lives += !bbTest(hits, ships->row[i] + j, ships->col[i]);
+			}
+		}
+		else
+		{
+			bits = (uint32_t) (((1ULL << length) - 1) << ships->col[i]);
+			lives = length - __builtin_popcount(bbRow(hits, ships->row[i]) & bits);
+		}
+		ships->lives[i] = (uint8_t) lives;
+		game->deadShips += lives == 0;
+	}
+}
+
+/**
+ * @brief Takes a snapshot of a game.
+ * @param game The game.
+ * @param rng The random numbers generator of the game, NULL to keep a zero state.
+ * @param snapshot Filled with the snapshot.
+ * @return TRUE on success, FALSE if the game has more than SNAPSHOT_MAX_SHIPS ships.
+ */
+int snapshotGame(const Game *game, const Rng *rng, GameSnapshot *snapshot)
+{
+	int count = game->shipsNum;
+	if (count > SNAPSHOT_MAX_SHIPS)
+	{
+		return FALSE;
+	}
+	snapshot->magic = SNAPSHOT_MAGIC;
+	snapshot->size = (uint8_t) game->board.size;
+	snapshot->shipsNum = (uint8_t) count;
+	snapshot->deadShips = (uint8_t) game->deadShips;
+	snapshot->reserved = 0;
+	if (rng != NULL)
+	{
+		memcpy(snapshot->rng, rng->state, sizeof(snapshot->rng));
+	}
+	else
+	{
+		memset(snapshot->rng, 0, sizeof(snapshot->rng));
+	}
+	memcpy(snapshot->shots, game->board.shots.words, sizeof(snapshot->shots));
+	memcpy(snapshot->shipData, game->shipData, (size_t) (SNAPSHOT_SHIP_FIELDS * count));
+	memset(snapshot->shipData + SNAPSHOT_SHIP_FIELDS * count, 0,
+		   (size_t) (SNAPSHOT_SHIP_FIELDS * (SNAPSHOT_MAX_SHIPS - count)));
+	return TRUE;
+}
+
+/**
+ * @brief Reads the fleet of a snapshot, so a game block can be made for it.
+ * @param snapshot The snapshot.
+ * @param fleet Filled with the fleet, the ships in the order of the snapshot.
+ * @return TRUE on success, FALSE if the snapshot is not valid.
+ */
+int snapshotFleet(const GameSnapshot *snapshot, Fleet *fleet)
+{
+	const uint8_t *lengths = snapshot->shipData + 2 * snapshot->shipsNum;
+	int i;
+	if (snapshot->magic != SNAPSHOT_MAGIC || snapshot->shipsNum < 1 ||
+		snapshot->shipsNum > SNAPSHOT_MAX_SHIPS)
+	{
+		return FALSE;
+	}
+	fleet->shipsNum = snapshot->shipsNum;
+	fleet->maxLength = 0;
+	fleet->cells = 0;
+	for (i = 0; i < fleet->shipsNum; i++)
+	{
+		if (lengths[i] < 1 || lengths[i] > MAX_FLEET_LENGTH)
+		{
+			return FALSE;
+		}
+		fleet->lengths[i] = lengths[i];
+		fleet->maxLength = lengths[i] > fleet->maxLength ? lengths[i] : fleet->maxLength;
+		fleet->cells += lengths[i];
+	}
+	return TRUE;
+}
+
+/**
+ * @brief Restores a snapshot into a game block of the same board size and number of ships,
+ * without any allocation.
+ * @param game The game, e.g. from newGame or a pool, with the fleet of the snapshot.
+ * @param rng Set to the generator state of the snapshot, NULL if not needed.
+ * @param snapshot The snapshot.
+ * @return TRUE on success, FALSE if the snapshot does not fit the game block or its ships
+ * overlap or leave the board (the game is then left with no ships). The shots outside the board
+ * are dropped, and the lives and the sunk ships of the record are replaced by the ones the hits
+ * give.
+ */
+int restoreGame(Game *game, Rng *rng, const GameSnapshot *snapshot)
+{
+	Board *board = &game->board;
+	Bitboard shots;
+	int i, count = snapshot->shipsNum;
+	if (snapshot->magic != SNAPSHOT_MAGIC || snapshot->size != board->size ||
+		count != game->shipsNum)
+	{
+		return FALSE;
+	}
+	memcpy(shots.words, snapshot->shots, sizeof(snapshot->shots));
+	bbClear(&board->shots);
+	for (i = 0; i < board->size; i++)
+	{
+		bbOrRow(&board->shots, i, bbRow(&shots, i) & bbRowMask(board->size));
+	}
+	memcpy(game->shipData, snapshot->shipData, (size_t) (SNAPSHOT_SHIP_FIELDS * count));
+	bbClear(&board->ships);
+	if (markShips(board, &game->ships, count) == FALSE)
+	{
+		bbClear(&board->ships);
+		return FALSE;
+	}
+	for (i = 0; i < BITBOARD_WORDS; i++)
+	{
+		board->hits.words[i] = board->ships.words[i] & board->shots.words[i];
+	}
+	countLives(game);
+	if (rng != NULL)
+	{
+		memcpy(rng->state, snapshot->rng, sizeof(snapshot->rng));
+	}
+	return TRUE;
+}
+
+/**
+ * @brief Opens a snapshot file for appending, creating it if needed.
+ * @param path The file path.
+ * @return The file descriptor, -1 on failure.
+ */
+int openSnapshots(const char *path)
+{
+	return open(path, O_WRONLY | O_CREAT | O_APPEND, SNAPSHOT_MODE);
+}
+
+/**
+ * @brief Appends snapshots to an open file.
+ * @param fd The file descriptor, from openSnapshots.
+ * @param snapshots The snapshots.
+ * @param count The number of snapshots.
+ * @return 0 on success, SNAPSHOT_ERROR if the snapshots could not be written.
+ */
+int writeSnapshots(int fd, const GameSnapshot *snapshots, size_t count)
+{
+	const unsigned char *data = (const unsigned char *) snapshots;
+	size_t left = count * sizeof(GameSnapshot);
+	ssize_t written;
+	while (left > 0)
+	{
+		written = write(fd, data, left);
+		if (written < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (written <= 0)
+		{
+			return SNAPSHOT_ERROR;
+		}
+		data += written;
+		left -= (size_t) written;
+	}
+	return 0;
+}
+
+/**
+ * @brief Maps a whole snapshot file to memory for reading.
+ * @param path The file path.
+ * @param file Filled with the mapping.
+ * @return 0 on success, SNAPSHOT_ERROR otherwise.
+ */
+int mapSnapshots(const char *path, SnapshotFile *file)
+{
+	struct stat info;
+	void *data;
+	int fd = open(path, O_RDONLY);
+	file->snapshots = NULL;
+	file->count = 0;
+	file->length = 0;
+	if (fd < 0)
+	{
+		return SNAPSHOT_ERROR;
+	}
+	if (fstat(fd, &info) != 0)
+	{
+		close(fd);
+		return SNAPSHOT_ERROR;
+	}
+	if (info.st_size < (off_t) sizeof(GameSnapshot))
+	{
+		close(fd);
+		return 0;
+	}
+	data = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+	{
+		return SNAPSHOT_ERROR;
+	}
+	madvise(data, (size_t) info.st_size, MADV_SEQUENTIAL);
+	file->snapshots = (const GameSnapshot *) data;
+	file->count = (size_t) info.st_size / sizeof(GameSnapshot);
+	file->length = (size_t) info.st_size;
+	return 0;
+}
+
+/**
+ * @brief Unmaps a file mapped by mapSnapshots.
+ * @param file The mapped file.
+ */
+void unmapSnapshots(SnapshotFile *file)
+{
+	if (file->snapshots != NULL)
+	{
+		munmap((void *) file->snapshots, file->length);
+	}
+	file->snapshots = NULL;
+	file->count = 0;
+	file->length = 0;
+}
@@ -0,0 +1,155 @@
+/**
+ * @file game_snapshot.h
+ * @version 2.0
+ *
+ * @brief Fixed size binary snapshots of running games, for checkpointing.
+ *
+ * @section DESCRIPTION
+ * A snapshot keeps the whole state of a game with up to SNAPSHOT_MAX_SHIPS ships, and the state
+ * of the random numbers generator driving it, in a SNAPSHOT_SIZE bytes record laid out as the
+ * game itself: the shots bitboard words and the ship table arrays are copied as they are, and
+ * the ships and hits masks are rebuilt from the ships on restore. A snapshot file is a plain
+ * array of records in the byte order of the machine that wrote it, so it is appended with one
+ * write per batch of records and read back by mapping it.
+ */
+#ifndef GAME_SNAPSHOT_H_
+#define GAME_SNAPSHOT_H_
+
+// ------------------------------ includes ------------------------------
+#include <stddef.h>
+#include <stdint.h>
+#include "battleships.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def SNAPSHOT_MAGIC 0x4e535342
+ * @brief The first bytes of every snapshot ("BSSN").
+ */
+#define SNAPSHOT_MAGIC 0x4e535342U
+
+/**
+ * @def SNAPSHOT_MAX_SHIPS 16
+ * @brief The maximal number of ships of a game that can be snapshot.
+ */
+#define SNAPSHOT_MAX_SHIPS 16
+
+/**
+ * @def SNAPSHOT_SHIP_FIELDS 5
+ * @brief The number of ship table arrays (row, col, length, angle and lives).
+ */
+#define SNAPSHOT_SHIP_FIELDS 5
+
+/**
+ * @def SNAPSHOT_SIZE 224
+ * @brief The size of a snapshot record.
+ */
+#define SNAPSHOT_SIZE 224
+
+/**
+ * @def SNAPSHOT_ERROR 6
+ * @brief the integer returned if snapshots could not be written or read.
+ */
+#define SNAPSHOT_ERROR 6
+
+// ------------------------------ structs ----------------------------
+
+/**
+ * a structure holding a snapshot of a game. includes the following attributes:
+ * magic - SNAPSHOT_MAGIC.
+ * size - the board size.
+ * shipsNum - the number of ships.
+ * deadShips - the number of sunk ships.
+ * reserved - 0.
+ * rng - the state of the random numbers generator of the game.
+ * shots - the words of the shots bitboard.
+ * shipData - the ship table arrays, shipsNum bytes each, one after the other as in a game block.
+ */
+typedef struct GameSnapshot
+{
+	uint32_t magic;
+	uint8_t size;
+	uint8_t shipsNum;
+	uint8_t deadShips;
+	uint8_t reserved;
+	uint64_t rng[4];
+	uint64_t shots[BITBOARD_WORDS];
+	uint8_t shipData[SNAPSHOT_SHIP_FIELDS * SNAPSHOT_MAX_SHIPS];
+} GameSnapshot;
+
+/**
+ * a structure describing a snapshot file mapped to memory. includes the following attributes:
+ * snapshots - the records.
+ * count - the number of whole records (a partly written record at the end is ignored).
+ * length - the mapping size.
+ */
+typedef struct SnapshotFile
+{
+	const GameSnapshot *snapshots;
+	size_t count;
+	size_t length;
+} SnapshotFile;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Takes a snapshot of a game.
+ * @param game The game.
+ * @param rng The random numbers generator of the game, NULL to keep a zero state.
+ * @param snapshot Filled with the snapshot.
+ * @return TRUE (1) on success, FALSE if the game has more than SNAPSHOT_MAX_SHIPS ships.
+ */
+int snapshotGame(const Game *game, const Rng *rng, GameSnapshot *snapshot);
+
+/**
+ * @brief Reads the fleet of a snapshot, so a game block can be made for it.
+ * @param snapshot The snapshot.
+ * @param fleet Filled with the fleet, the ships in the order of the snapshot.
+ * @return TRUE (1) on success, FALSE if the snapshot is not valid.
+ */
+int snapshotFleet(const GameSnapshot *snapshot, Fleet *fleet);
+
+/**
+ * @brief Restores a snapshot into a game block of the same board size and number of ships,
+ * without any allocation.
+ * @param game The game, e.g. from newGame or a pool, with the fleet of the snapshot.
+ * @param rng Set to the generator state of the snapshot, NULL if not needed.
+ * @param snapshot The snapshot.
+ * @return TRUE (1) on success, FALSE if the snapshot does not fit the game block or its ships
+ * overlap or leave the board (the game is then left with no ships). The shots outside the board
+ * are dropped, and the lives and the sunk ships of the record are replaced by the ones the hits
+ * give.
+ */
+int restoreGame(Game *game, Rng *rng, const GameSnapshot *snapshot);
+
+/**
+ * @brief Opens a snapshot file for appending, creating it if needed.
+ * @param path The file path.
+ * @return The file descriptor, -1 on failure.
+ */
+int openSnapshots(const char *path);
+
+/**
+ * @brief Appends snapshots to an open file.
+ * @param fd The file descriptor, from openSnapshots.
+ * @param snapshots The snapshots.
+ * @param count The number of snapshots.
+ * @return 0 on success, SNAPSHOT_ERROR if the snapshots could not be written.
+ */
+int writeSnapshots(int fd, const GameSnapshot *snapshots, size_t count);
+
+/**
+ * @brief Maps a whole snapshot file to memory for reading.
+ * @param path The file path.
+ * @param file Filled with the mapping.
+ * @return 0 on success, SNAPSHOT_ERROR otherwise.
+ */
+int mapSnapshots(const char *path, SnapshotFile *file);
+
+/**
+ * @brief Unmaps a file mapped by mapSnapshots.
+ * @param file The mapped file.
+ */
+void unmapSnapshots(SnapshotFile *file);
+
+#endif /* GAME_SNAPSHOT_H_ */
@@ -0,0 +1,301 @@
+/**
+ * @file instrument.c
+ * @version 2.0
+ *
+ * @brief Optional counters and latency histograms of the engine hot paths.
+ *
+ * @section DESCRIPTION
+ * The blocks of the threads are linked in a list when they are first used and are never freed,
+ * so the summary still holds the measures of the threads that already ended. SIGUSR1 is blocked
+ * before main starts, so every later thread inherits the mask, and a thread of its own waits for
+ * it with sigwait: the summary is never printed from a signal handler, and the dumps on a signal
+ * and on exit take turns on a lock. Without -DINSTRUMENT this file compiles to nothing.
+ */
+#ifdef INSTRUMENT
+
+// ------------------------------ includes ------------------------------
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "instrument.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def DUMP_LENGTH 4096
+ * @brief The size of the summary buffer.
+ */
+#define DUMP_LENGTH 4096
+
+/**
+ * @def NANOS_PER_SECOND 1000000000
+ * @brief The number of nanoseconds in a second.
+ */
+#define NANOS_PER_SECOND 1000000000ULL
+
+// ------------------------------ globals ----------------------------
+
+/**
+ * The block of the current thread, NULL until its first measure.
+ */
+__thread InstrumentStats *gInstrumentStats = NULL;
+
+/**
+ * Guards the list of blocks.
+ */
+static pthread_mutex_t gBlocksLock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * The blocks of all the threads.
+ */
+static InstrumentStats *gBlocks = NULL;
+
+/**
+ * Guards the static summary buffers, shared by the dump on SIGUSR1 and the dump on exit.
+ */
+static pthread_mutex_t gDumpLock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * The clock ticks and the monotonic time when the program started, to convert the ticks to
+ * nanoseconds.
+ */
+static uint64_t gStartTicks = 0, gStartNanos = 0;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Reads the monotonic clock.
+ * @return The time in nanoseconds.
+ */
+static uint64_t monotonicNanos(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * NANOS_PER_SECOND + (uint64_t) now.tv_nsec;
+}
+
+/**
+ * @brief The thread printing the summary whenever SIGUSR1 arrives.
+ * @param signals The signal set holding SIGUSR1, blocked in every thread.
+ * @return Never returns.
+ */
+static void *dumpOnSignal(void *signals)
+{
+	int signal;
+	while (1)
+	{
+		if (sigwait((const sigset_t *) signals, &signal) == 0)
+		{
+			instrumentDump(STDERR_FILENO);
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @brief Prints the summary when the process exits.
+ */
+static void dumpOnExit(void)
+{
+	instrumentDump(STDERR_FILENO);
+}
+
+/**
+ * @brief Registers the summary on exit, blocks SIGUSR1 and starts the thread waiting for it, and
+ * starts the clock conversion, when the program starts.
+ */
+__attribute__((constructor)) static void instrumentStart(void)
+{
+	static sigset_t signals;
+	pthread_t waiter;
+	gStartTicks = instrumentClock();
+	gStartNanos = monotonicNanos();
+	atexit(dumpOnExit);
+	sigemptyset(&signals);
+	sigaddset(&signals, SIGUSR1);
+	if (pthread_sigmask(SIG_BLOCK, &signals, NULL) != 0)
+	{
+		return;
+	}
+	if (pthread_create(&waiter, NULL, dumpOnSignal, &signals) != 0)
+	{
+		pthread_sigmask(SIG_UNBLOCK, &signals, NULL);
+		return;
+	}
+	pthread_detach(waiter);
+}
+
+/**
+ * @brief Allocates and registers the block of the current thread.
+ * @return The block.
+ */
+InstrumentStats *instrumentRegister(void)
+{
+	static InstrumentStats lost;
+	InstrumentStats *stats = (InstrumentStats *) calloc(1, sizeof(InstrumentStats));
+	if (stats == NULL)
+	{
+		return &lost;
+	}
+	pthread_mutex_lock(&gBlocksLock);
+	stats->next = gBlocks;
+	gBlocks = stats;
+	pthread_mutex_unlock(&gBlocksLock);
+	gInstrumentStats = stats;
+	return stats;
+}
+
+/**
+ * @brief Returns the smallest value of a histogram bucket.
+ * @param bucket The bucket index.
+ * @return The value.
+ */
+static uint64_t bucketValue(int bucket)
+{
+	int shift;
+	if (bucket < HDR_SUB_BUCKETS)
+	{
+		return (uint64_t) bucket;
+	}
+	shift = bucket / HDR_SUB_BUCKETS - 1;
+	return (uint64_t) (bucket % HDR_SUB_BUCKETS + HDR_SUB_BUCKETS) << shift;
+}
+
+/**
+ * @brief Finds the value below which the given part of a histogram's values lie.
+ * @param histogram The histogram.
+ * @param part The part of the values, between 0 and 1.
+ * @return The smallest value of the bucket holding that value.
+ */
+static uint64_t hdrPercentile(const HdrHistogram *histogram, double part)
+{
+	uint64_t seen = 0;
+	int bucket;
+	for (bucket = 0; bucket < HDR_BUCKETS; bucket++)
+	{
+		seen += histogram->buckets[bucket];
+		if (seen > 0 && (double) seen >= part * (double) histogram->count)
+		{
+			return bucketValue(bucket);
+		}
+	}
+	return histogram->max;
+}
+
+/**
+ * @brief Adds the values of a histogram to another.
+ * @param total The histogram added to.
+ * @param part The histogram added.
+ */
+static void hdrMerge(HdrHistogram *total, const HdrHistogram *part)
+{
+	int bucket;
+	total->count += part->count;
+	total->total += part->total;
+	total->max = part->max > total->max ? part->max : total->max;
+	for (bucket = 0; bucket < HDR_BUCKETS; bucket++)
+	{
+		total->buckets[bucket] += part->buckets[bucket];
+	}
+}
+
+/**
+ * @brief Formats a latency histogram as a line of the summary.
+ * @param out The buffer.
+ * @param length The space left in the buffer.
+ * @param name The histogram name.
+ * @param histogram The histogram, in clock ticks.
+ * @param ticksPerNano The number of clock ticks in a nanosecond.
+ * @return The length of the line.
+ */
+static int formatLatency(char *out, size_t length, const char *name,
+						 const HdrHistogram *histogram, double ticksPerNano)
+{
+	double count = histogram->count > 0 ? (double) histogram->count : 1.0;
+	return snprintf(out, length, "instrument: %s ns: count %llu mean %.1f p50 %.0f p90 %.0f "
+								 "p99 %.0f p99.9 %.0f max %.0f\n", name,
+					(unsigned long long) histogram->count,
+					(double) histogram->total / count / ticksPerNano,
+					(double) hdrPercentile(histogram, 0.5) / ticksPerNano,
+					(double) hdrPercentile(histogram, 0.9) / ticksPerNano,
+					(double) hdrPercentile(histogram, 0.99) / ticksPerNano,
+					(double) hdrPercentile(histogram, 0.999) / ticksPerNano,
+					(double) histogram->max / ticksPerNano);
+}
+
+/**
+ * @brief Prints the summary of all the threads.
+ * @param fd The file descriptor written to.
+ */
+void instrumentDump(int fd)
+{
+	static InstrumentStats total;
+	static char buffer[DUMP_LENGTH];
+	const InstrumentStats *stats;
+	double ticksPerNano = 1.0;
+	size_t length = 0;
+	int i, ships = 0;
+	pthread_mutex_lock(&gDumpLock);
+	memset(&total, 0, sizeof(total));
+	pthread_mutex_lock(&gBlocksLock);
+	for (stats = gBlocks; stats != NULL; stats = stats->next)
+	{
+		for (i = 0; i < INSTRUMENT_OUTCOMES; i++)
+		{
+			total.shots[i] += stats->shots[i];
+		}
+		for (i = 0; i < INSTRUMENT_SHIPS; i++)
+		{
+			total.shipRetries[i] += stats->shipRetries[i];
+		}
+		total.fleets += stats->fleets;
+		total.fleetAttempts += stats->fleetAttempts;
+		hdrMerge(&total.turns, &stats->turns);
+		hdrMerge(&total.setups, &stats->setups);
+	}
+	pthread_mutex_unlock(&gBlocksLock);
+#if defined(__x86_64__) || defined(__i386__)
+	if (monotonicNanos() > gStartNanos)
+	{
+		ticksPerNano = (double) (instrumentClock() - gStartTicks) /
+					   (double) (monotonicNanos() - gStartNanos);
+	}
+#endif
+	length += (size_t) snprintf(buffer + length, DUMP_LENGTH - length,
+								"instrument: shots: miss %llu hit %llu already %llu invalid %llu "
+								"sunk %llu\n", (unsigned long long) total.shots[0],
+								(unsigned long long) total.shots[1],
+								(unsigned long long) total.shots[2],
+								(unsigned long long) total.shots[3],
+								(unsigned long long) total.shots[4]);
+	length += (size_t) snprintf(buffer + length, DUMP_LENGTH - length,
+								"instrument: fleets: %llu attempts %llu\n",
+								(unsigned long long) total.fleets,
+								(unsigned long long) total.fleetAttempts);
+	for (i = 0; i < INSTRUMENT_SHIPS; i++)
+	{
+		ships = total.shipRetries[i] > 0 ? i + 1 : ships;
+	}
+	length += (size_t) snprintf(buffer + length, DUMP_LENGTH - length, "instrument: ship retries:");
+	for (i = 0; i < ships; i++)
+	{
+		length += (size_t) snprintf(buffer + length, DUMP_LENGTH - length, " %llu",
+									(unsigned long long) total.shipRetries[i]);
+	}
+	length += (size_t) snprintf(buffer + length, DUMP_LENGTH - length, ships ? "\n" : " none\n");
+	length += (size_t) formatLatency(buffer + length, DUMP_LENGTH - length, "turn", &total.turns,
+									 ticksPerNano);
+	length += (size_t) formatLatency(buffer + length, DUMP_LENGTH - length, "setup", &total.setups,
+									 ticksPerNano);
+	if (write(fd, buffer, length < DUMP_LENGTH ? length : DUMP_LENGTH - 1) < 0)
+	{
+		pthread_mutex_unlock(&gDumpLock);
+		return;
+	}
+	pthread_mutex_unlock(&gDumpLock);
+}
+
+#endif /* INSTRUMENT */
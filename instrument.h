@@ -0,0 +1,266 @@
+/**
+ * @file instrument.h
+ * @version 2.0
+ *
+ * @brief Optional counters and latency histograms of the engine hot paths.
+ *
+ * @section DESCRIPTION
+ * The engine marks its hot paths with the INSTRUMENT_ macros below. They expand to nothing unless
+ * the code is compiled with -DINSTRUMENT (make INSTRUMENT=1 after a make clean), so the default
+ * build runs exactly the code it ran before. An instrumented build counts the placement retries of
+ * every ship index and the shots of every outcome, and records the latency of every turn (fireShot,
+ * shoot, and a whole salvo of fireSalvo) and of every fleet placement (resetGame, placeFleet) into
+ * HDR style histograms: HDR_SUB_BUCKETS linear buckets for every power of two, so every value is
+ * kept with a relative error below 1 / HDR_SUB_BUCKETS. The latencies are read from the TSC on x86
+ * (and converted to nanoseconds against the monotonic clock when the summary is printed), and from
+ * clock_gettime elsewhere.
+ * Every thread records into its own block, so no counter is shared between cores. The summary of
+ * all the blocks is printed to stderr on exit, and whenever the process receives SIGUSR1 (by a
+ * thread waiting for it, not from a signal handler).
+ */
+#ifndef INSTRUMENT_H_
+#define INSTRUMENT_H_
+
+// ------------------------------ includes ------------------------------
+#include <stdint.h>
+#include <time.h>
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def HDR_SUB_BITS 5
+ * @brief The number of bits of a value kept exactly by a histogram bucket.
+ */
+#define HDR_SUB_BITS 5
+
+/**
+ * @def HDR_SUB_BUCKETS 32
+ * @brief The number of linear buckets of every power of two.
+ */
+#define HDR_SUB_BUCKETS (1 << HDR_SUB_BITS)
+
+/**
+ * @def HDR_BUCKETS 1920
+ * @brief The number of buckets of a histogram, covering every 64 bit value.
+ */
+#define HDR_BUCKETS ((64 - HDR_SUB_BITS) * HDR_SUB_BUCKETS + HDR_SUB_BUCKETS)
+
+/**
+ * @def INSTRUMENT_SHIPS 32
+ * @brief The number of ship indices with their own retries counter, the retries of the later
+ * ships are counted on the last one.
+ */
+#define INSTRUMENT_SHIPS 32
+
+/**
+ * @def INSTRUMENT_OUTCOMES 5
+ * @brief The number of shot outcomes counted: miss, hit, already shot, invalid and sunk.
+ */
+#define INSTRUMENT_OUTCOMES 5
+
+// ------------------------------ structs ----------------------------
+
+/**
+ * a structure holding an HDR style histogram. includes the following attributes:
+ * count - the number of values recorded.
+ * total - the sum of the values.
+ * max - the largest value.
+ * buckets - the number of values in every bucket (see hdrBucket).
+ */
+typedef struct HdrHistogram
+{
+	uint64_t count;
+	uint64_t total;
+	uint64_t max;
+	uint64_t buckets[HDR_BUCKETS];
+} HdrHistogram;
+
+/**
+ * a structure holding the measures of a single thread. includes the following attributes:
+ * next - the block of the next thread.
+ * shots - the number of shots of every outcome.
+ * shipRetries - the number of times every ship index found no free slot, restarting the fleet.
+ * fleets - the number of fleet placements.
+ * fleetAttempts - the number of attempts of all the fleet placements.
+ * turns - the latency of every shot or salvo, in clock ticks.
+ * setups - the latency of every fleet placement, in clock ticks.
+ */
+typedef struct InstrumentStats
+{
+	struct InstrumentStats *next;
+	uint64_t shots[INSTRUMENT_OUTCOMES];
+	uint64_t shipRetries[INSTRUMENT_SHIPS];
+	uint64_t fleets;
+	uint64_t fleetAttempts;
+	HdrHistogram turns;
+	HdrHistogram setups;
+} InstrumentStats;
+
+// ------------------------------ functions ----------------------------
+
+#ifdef INSTRUMENT
+
+/**
+ * The block of the current thread, NULL until its first measure.
+ */
+extern __thread InstrumentStats *gInstrumentStats;
+
+/**
+ * @brief Allocates and registers the block of the current thread.
+ * @return The block.
+ */
+InstrumentStats *instrumentRegister(void);
+
+/**
+ * @brief Prints the summary of all the threads.
+ * @param fd The file descriptor written to.
+ */
+void instrumentDump(int fd);
+
+/**
+ * @brief Reads the clock the latencies are measured with: the TSC on x86, the monotonic clock
+ * in nanoseconds elsewhere.
+ * @return The clock ticks.
+ */
+static inline uint64_t instrumentClock(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __builtin_ia32_rdtsc();
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * 1000000000ULL + (uint64_t) now.tv_nsec;
+#endif
+}
+
+/**
+ * @brief Returns the block of the current thread.
+ * @return The block.
+ */
+static inline InstrumentStats *instrumentStats(void)
+{
+	InstrumentStats *stats = gInstrumentStats;
+	return stats != NULL ? stats : instrumentRegister();
+}
+
+/**
+ * @brief Returns the bucket of a value: values below HDR_SUB_BUCKETS have a bucket each, larger
+ * values are bucketed by their highest HDR_SUB_BITS + 1 bits.
+ * @param value The value.
+ * @return The bucket index.
+ */
+static inline int hdrBucket(uint64_t value)
+{
+	int shift;
+	if (value < HDR_SUB_BUCKETS)
+	{
+		return (int) value;
+	}
+	shift = 63 - __builtin_clzll(value) - HDR_SUB_BITS;
+	return (shift + 1) * HDR_SUB_BUCKETS + (int) (value >> shift) - HDR_SUB_BUCKETS;
+}
+
+/**
+ * @brief Records a value into a histogram.
+ * @param histogram The histogram.
+ * @param value The value.
+ */
+static inline void hdrRecord(HdrHistogram *histogram, uint64_t value)
+{
+	histogram->count++;
+	histogram->total += value;
+	histogram->max = value > histogram->max ? value : histogram->max;
+	histogram->buckets[hdrBucket(value)]++;
+}
+
+/**
+ * @brief Records a shot and its latency.
+ * @param start The clock when the shot started.
+ * @param result The shot result.
+ */
+static inline void instrumentTurn(uint64_t start, int result)
+{
+	InstrumentStats *stats = instrumentStats();
+	hdrRecord(&stats->turns, instrumentClock() - start);
+	stats->shots[result < INSTRUMENT_OUTCOMES ? result : INSTRUMENT_OUTCOMES - 1]++;
+}
+
+/**
+ * @brief Records a salvo as a single turn, and the outcome of every shot of it.
+ * @param start The clock when the salvo started.
+ * @param shots The number of shots of the salvo.
+ * @param hits The number of shots that hit a ship, including the ones that sunk it.
+ * @param sunk The number of ships the salvo sunk.
+ */
+static inline void instrumentSalvo(uint64_t start, int shots, int hits, int sunk)
+{
+	InstrumentStats *stats = instrumentStats();
+	hdrRecord(&stats->turns, instrumentClock() - start);
+	stats->shots[0] += (uint64_t) (shots - hits);
+	stats->shots[1] += (uint64_t) (hits - sunk);
+	stats->shots[INSTRUMENT_OUTCOMES - 1] += (uint64_t) sunk;
+}
+
+/**
+ * @brief Records a fleet placement and its latency.
+ * @param start The clock when the placement started.
+ * @param attempts The number of times the fleet was placed from scratch.
+ */
+static inline void instrumentSetup(uint64_t start, int attempts)
+{
+	InstrumentStats *stats = instrumentStats();
+	hdrRecord(&stats->setups, instrumentClock() - start);
+	stats->fleets++;
+	stats->fleetAttempts += (uint64_t) attempts;
+}
+
+/**
+ * @brief Records a ship that found no free slot.
+ * @param index The ship index in its fleet.
+ */
+static inline void instrumentShipRetry(int index)
+{
+	instrumentStats()->shipRetries[index < INSTRUMENT_SHIPS ? index : INSTRUMENT_SHIPS - 1]++;
+}
+
+/**
+ * @def INSTRUMENT_CLOCK(name)
+ * @brief Declares a variable holding the clock, at the start of a measured path.
+ */
+#define INSTRUMENT_CLOCK(name) uint64_t name = instrumentClock()
+
+/**
+ * @def INSTRUMENT_TURN(start, result)
+ * @brief Records a shot started at the given clock.
+ */
+#define INSTRUMENT_TURN(start, result) instrumentTurn(start, result)
+
+/**
+ * @def INSTRUMENT_SALVO(start, shots, hits, sunk)
+ * @brief Records a salvo started at the given clock.
+ */
+#define INSTRUMENT_SALVO(start, shots, hits, sunk) instrumentSalvo(start, shots, hits, sunk)
+
+/**
+ * @def INSTRUMENT_SETUP(start, attempts)
+ * @brief Records a fleet placement started at the given clock.
+ */
+#define INSTRUMENT_SETUP(start, attempts) instrumentSetup(start, attempts)
+
+/**
+ * @def INSTRUMENT_SHIP_RETRY(index)
+ * @brief Records a ship that found no free slot.
+ */
+#define INSTRUMENT_SHIP_RETRY(index) instrumentShipRetry(index)
+
+#else
+
+#define INSTRUMENT_CLOCK(name) ((void) 0)
+#define INSTRUMENT_TURN(start, result) ((void) 0)
+#define INSTRUMENT_SALVO(start, shots, hits, sunk) ((void) 0)
+#define INSTRUMENT_SETUP(start, attempts) ((void) 0)
+#define INSTRUMENT_SHIP_RETRY(index) ((void) 0)
+
+#endif /* INSTRUMENT */
+
+#endif /* INSTRUMENT_H_ */
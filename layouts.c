@@ -0,0 +1,182 @@
+/**
+ * @file layouts.c
+ * @version 2.0
+ *
+ * @brief Built in ways of laying out a fleet, for the games between two built in players.
+ *
+ * @section DESCRIPTION
+ * The layout strategies available are:
+ * random - the engine placement: every ship takes a uniformly random free slot.
+ * apart  - no two ships touch, not even at a corner.
+ * edges  - at least half of the ships (rounded up) have a cell on the edge of the board.
+ */
+// ------------------------------ includes ------------------------------
+#include <string.h>
+#include "layouts.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def  TRUE 1
+ * @brief the value returned on success.
+ */
+#define TRUE 1
+
+/**
+ * @def FALSE -1
+ * @brief the value returned on failure.
+ */
+#define FALSE (-1)
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Places the fleet with the engine placement.
+ * @param game The game.
+ * @param rng The random numbers generator.
+ * @return TRUE if the fleet was placed, FALSE otherwise.
+ */
+static int randomLayout(Game *game, Rng *rng)
+{
+	return resetGame(game, rng);
+}
+
+/**
+ * @brief Checks that no two ships of a game touch, not even at a corner.
+ * @param game The game, with its fleet placed.
+ * @return TRUE if the ships are apart, FALSE otherwise.
+ */
+static int shipsApart(const Game *game)
+{
+	const Board *board = &game->board;
+	int row, col, i, j, size = board->size;
+	for (row = 0; row < size; row++)
+	{
+		for (col = 0; col < size; col++)
+		{
+			if (!bbTest(&board->ships, row, col))
+			{
+				continue;
+			}
+			for (i = row > 0 ? row - 1 : row; i <= row + 1 && i < size; i++)
+			{
+				for (j = col > 0 ? col - 1 : col; j <= col + 1 && j < size; j++)
+				{
+					if (bbTest(&board->ships, i, j) &&
+						board->shipIds[i][j] != board->shipIds[row][col])
+					{
+						return FALSE;
+					}
+				}
+			}
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * @brief Counts the ships of a game that have a cell on the edge of the board.
+ * @param game The game, with its fleet placed.
+ * @return The number of ships.
+ */
+static int edgeShips(const Game *game)
+{
+	const ShipTable *ships = &game->ships;
+	int i, count = 0, last = game->board.size - 1;
+	for (i = 0; i < game->shipsNum; i++)
+	{
+		count += ships->row[i] == 0 || ships->col[i] == 0 ||
+				 (ships->angle[i] == VERTICAL ?
+				  ships->row[i] + ships->length[i] - 1 == last || ships->col[i] == last :
+				  ships->col[i] + ships->length[i] - 1 == last || ships->row[i] == last);
+	}
+	return count;
+}
+
+/**
+ * @brief Draws engine layouts until no two ships touch.
+ * @param game The game.
+ * @param rng The random numbers generator.
+ * @return TRUE if the fleet was placed, FALSE otherwise.
+ */
+static int apartLayout(Game *game, Rng *rng)
+{
+	int attempt;
+	for (attempt = 0; attempt < LAYOUT_ATTEMPTS; attempt++)
+	{
+		if (resetGame(game, rng) != TRUE)
+		{
+			return FALSE;
+		}
+		if (shipsApart(game) == TRUE)
+		{
+			break;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * @brief Draws engine layouts until at least half of the ships are on the edge of the board.
+ * @param game The game.
+ * @param rng The random numbers generator.
+ * @return TRUE if the fleet was placed, FALSE otherwise.
+ */
+static int edgesLayout(Game *game, Rng *rng)
+{
+	int attempt;
+	for (attempt = 0; attempt < LAYOUT_ATTEMPTS; attempt++)
+	{
+		if (resetGame(game, rng) != TRUE)
+		{
+			return FALSE;
+		}
+		if (2 * edgeShips(game) >= game->shipsNum)
+		{
+			break;
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * The built in layout strategies.
+ */
+static const LayoutStrategy LAYOUTS[] =
+		{
+		{"random", randomLayout},
+		{"apart", apartLayout},
+		{"edges", edgesLayout}
+		};
+
+/**
+ * @brief Finds a built in layout strategy by its name.
+ * @param name The strategy name ("random", "apart" or "edges").
+ * @return The strategy, NULL if there is no strategy with this name.
+ */
+const LayoutStrategy *findLayout(const char *name)
+{
+	size_t i;
+	for (i = 0; i < sizeof(LAYOUTS) / sizeof(LAYOUTS[0]); i++)
+	{
+		if (strcmp(LAYOUTS[i].name, name) == 0)
+		{
+			return &LAYOUTS[i];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @brief Lists the built in layout strategies.
+ * @param index The index of the strategy.
+ * @return The strategy, NULL if the index is past the last strategy.
+ */
+const LayoutStrategy *layoutAt(int index)
+{
+	if (index < 0 || (size_t) index >= sizeof(LAYOUTS) / sizeof(LAYOUTS[0]))
+	{
+		return NULL;
+	}
+	return &LAYOUTS[index];
+}
@@ -0,0 +1,56 @@
+/**
+ * @file layouts.h
+ * @version 2.0
+ *
+ * @brief Built in ways of laying out a fleet, for the games between two built in players.
+ *
+ * @section DESCRIPTION
+ * A layout strategy places the whole fleet of a game on its cleared board. Every strategy draws
+ * its layouts from the engine placement (resetGame), keeping the first layout that has the
+ * wanted shape, so the ship table, the masks and the ship ids always match the engine exactly.
+ */
+#ifndef LAYOUTS_H_
+#define LAYOUTS_H_
+
+// ------------------------------ includes ------------------------------
+#include "battleships.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def LAYOUT_ATTEMPTS 1000
+ * @brief The number of layouts a strategy draws before it keeps the last one, whatever its
+ * shape.
+ */
+#define LAYOUT_ATTEMPTS 1000
+
+// ------------------------------ structs ----------------------------
+
+/**
+ * a structure describing a layout strategy. includes the following attributes:
+ * name - the name used to pick the strategy.
+ * place - places the fleet of a game on its cleared board, returning TRUE (1) on success.
+ */
+typedef struct LayoutStrategy
+{
+	const char *name;
+	int (*place)(Game *game, Rng *rng);
+} LayoutStrategy;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Finds a built in layout strategy by its name.
+ * @param name The strategy name ("random", "apart" or "edges").
+ * @return The strategy, NULL if there is no strategy with this name.
+ */
+const LayoutStrategy *findLayout(const char *name);
+
+/**
+ * @brief Lists the built in layout strategies.
+ * @param index The index of the strategy.
+ * @return The strategy, NULL if the index is past the last strategy.
+ */
+const LayoutStrategy *layoutAt(int index);
+
+#endif /* LAYOUTS_H_ */
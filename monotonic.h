@@ -0,0 +1,26 @@
+/**
+ * @file monotonic.h
+ * @version 2.0
+ *
+ * @brief The monotonic clock the tools and the simulations time themselves with.
+ */
+#ifndef MONOTONIC_H_
+#define MONOTONIC_H_
+
+// ------------------------------ includes ------------------------------
+#include <time.h>
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Returns a monotonic time stamp.
+ * @return The time in seconds.
+ */
+static inline double monotonicSeconds(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+#endif /* MONOTONIC_H_ */
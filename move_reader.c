@@ -0,0 +1,381 @@
+/**
+ * @file move_reader.c
+ * @version 2.0
+ *
+ * @brief Reading the board size and the moves of a game from a script or a stream, in place.
+ *
+ * @section DESCRIPTION
+ * A mapped script is scanned as one block. A stream keeps a single block buffer: when a word
+ * runs into the end of the buffer, the bytes not scanned yet are moved to its start and the rest
+ * of the buffer is filled with the next read.
+ */
+// ------------------------------ includes ------------------------------
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "move_reader.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def EXIT_STR "exit"
+ * @brief the word ending the game.
+ */
+#define EXIT_STR "exit"
+
+/**
+ * @def FIRST_ROW_LETTER 'a'
+ * @brief The letter of the first row.
+ */
+#define FIRST_ROW_LETTER 'a'
+
+/**
+ * @def ROW_LETTERS 26
+ * @brief The number of row letters, after which the rows go on with two letters.
+ */
+#define ROW_LETTERS 26
+
+/**
+ * @def IS_BLANK(c)
+ * @brief Checks whether a character separates words (as the whitespace of scanf).
+ */
+#define IS_BLANK(c) ((c) == ' ' || ((c) >= '\t' && (c) <= '\r'))
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Opens a reader mapping a whole script file.
+ * @param reader The reader.
+ * @param path The script path.
+ * @return 0 on success, -1 if the script could not be opened or mapped (errno is set).
+ */
+int openMoveScript(MoveReader *reader, const char *path)
+{
+	struct stat info;
+	void *mapping;
+	int fd = open(path, O_RDONLY);
+	memset(reader, 0, sizeof(MoveReader));
+	reader->fd = -1;
+	reader->ended = 1;
+	if (fd < 0)
+	{
+		return -1;
+	}
+	if (fstat(fd, &info) != 0)
+	{
+		close(fd);
+		return -1;
+	}
+	if (info.st_size == 0)
+	{
+		close(fd);
+		return 0;
+	}
+	mapping = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED)
+	{
+		return -1;
+	}
+	madvise(mapping, (size_t) info.st_size, MADV_SEQUENTIAL);
+	reader->mapping = mapping;
+	reader->data = (const char *) mapping;
+	reader->length = (size_t) info.st_size;
+	return 0;
+}
+
+/**
+ * @brief Opens a reader reading a stream block by block.
+ * @param reader The reader.
+ * @param fd The stream, e.g. STDIN_FILENO. It is not closed by the reader.
+ * @return 0 on success, -1 if the allocation failed.
+ */
+int openMoveStream(MoveReader *reader, int fd)
+{
+	memset(reader, 0, sizeof(MoveReader));
+	reader->fd = fd;
+	reader->buffer = (char *) malloc(MOVE_READER_BLOCK);
+	reader->data = reader->buffer;
+	return reader->buffer == NULL ? -1 : 0;
+}
+
+/**
+ * @brief Keeps the bytes of a stream not scanned yet at the start of the buffer and fills the
+ * rest of it with the next read. The standard output is flushed first, so a prompt printed
+ * without a newline is shown before the read blocks.
+ * @param reader The reader, of a stream that did not end.
+ */
+static void refill(MoveReader *reader)
+{
+	size_t kept = reader->length - reader->offset;
+	ssize_t got;
+	memmove(reader->buffer, reader->buffer + reader->offset, kept);
+	reader->offset = 0;
+	reader->length = kept;
+	fflush(stdout);
+	do
+	{
+		got = read(reader->fd, reader->buffer + kept, MOVE_READER_BLOCK - kept);
+	} while (got < 0 && errno == EINTR);
+	if (got <= 0)
+	{
+		reader->ended = 1;
+		return;
+	}
+	reader->length += (size_t) got;
+}
+
+/**
+ * @brief Finds the next word of the input, in place.
+ * @param reader The reader.
+ * @param word Set to the first character of the word.
+ * @param length Set to the word length.
+ * @return MOVE_READ, or MOVE_END if the input ended.
+ */
+static int nextWord(MoveReader *reader, const char **word, size_t *length)
+{
+	size_t start, end;
+	while (1)
+	{
+		start = reader->offset;
+		while (start < reader->length && IS_BLANK(reader->data[start]))
+		{
+			start++;
+		}
+		end = start;
+		while (end < reader->length && !IS_BLANK(reader->data[end]))
+		{
+			end++;
+		}
+		reader->offset = start;
+		if ((end < reader->length || reader->ended || (start == 0 && end == MOVE_READER_BLOCK)) &&
+			end > start)
+		{
+			*word = reader->data + start;
+			*length = end - start;
+			reader->offset = end;
+			return MOVE_READ;
+		}
+		if (reader->ended)
+		{
+			return MOVE_END;
+		}
+		refill(reader);
+	}
+}
+
+/**
+ * @brief Reads the row of a move, letters as printed on the board going on past 'z' like
+ * spreadsheet columns ('aa' follows 'z'), or a number counting from 1.
+ * @param text The row word, not necessarily null terminated.
+ * @param length The word length.
+ * @return The row index, -1 if the word is not a row.
+ */
+int scanRow(const char *text, size_t length)
+{
+	const char *end = text + length;
+	long row = 0;
+	int numeric = length > 0 && text[0] >= '0' && text[0] <= '9';
+	if (length == 0)
+	{
+		return -1;
+	}
+	for (; text < end; text++)
+	{
+		if (numeric && *text >= '0' && *text <= '9')
+		{
+			row = row * 10 + (*text - '0');
+		}
+		else if (!numeric && *text >= FIRST_ROW_LETTER && *text < FIRST_ROW_LETTER + ROW_LETTERS)
+		{
+			row = row * ROW_LETTERS + (*text - FIRST_ROW_LETTER + 1);
+		}
+		else
+		{
+			return -1;
+		}
+		if (row > INT_MAX)
+		{
+			return -1;
+		}
+	}
+	return (int) row - 1;
+}
+
+/**
+ * @brief Reads a word as a number with an optional sign.
+ * @param text The word.
+ * @param length The word length.
+ * @return The number, -1 if the word is not a number in the int range.
+ */
+static int scanNumber(const char *text, size_t length)
+{
+	const char *end = text + length;
+	long value = 0;
+	int sign = 1;
+	if (text < end && (*text == '-' || *text == '+'))
+	{
+		sign = *text++ == '-' ? -1 : 1;
+	}
+	if (text == end)
+	{
+		return -1;
+	}
+	for (; text < end; text++)
+	{
+		if (*text < '0' || *text > '9')
+		{
+			return -1;
+		}
+		value = value * 10 + (*text - '0');
+		if (value > INT_MAX)
+		{
+			return -1;
+		}
+	}
+	return (int) (sign * value);
+}
+
+/**
+ * @brief Checks whether a word is the word ending the game.
+ * @param word The word.
+ * @param length The word length.
+ * @return Non zero if the word is EXIT_STR.
+ */
+static int isExit(const char *word, size_t length)
+{
+	return length == sizeof(EXIT_STR) - 1 && memcmp(word, EXIT_STR, length) == 0;
+}
+
+/**
+ * @brief Reads a column word, a number counting from 1.
+ * @param word The word.
+ * @param length The word length.
+ * @return The column index, -1 if the word is not a column.
+ */
+static int scanColumn(const char *word, size_t length)
+{
+	int value = scanNumber(word, length);
+	return value > 0 ? value - 1 : -1;
+}
+
+/**
+ * @brief Finds the next word of a line held in memory.
+ * @param line The line.
+ * @param length The line length.
+ * @param offset The first byte not scanned yet, moved past the word.
+ * @param word Set to the first character of the word.
+ * @return The word length, 0 if the line has no more words.
+ */
+static size_t lineWord(const char *line, size_t length, size_t *offset, const char **word)
+{
+	size_t start = *offset, end;
+	while (start < length && IS_BLANK(line[start]))
+	{
+		start++;
+	}
+	end = start;
+	while (end < length && !IS_BLANK(line[end]))
+	{
+		end++;
+	}
+	*word = line + start;
+	*offset = end;
+	return end - start;
+}
+
+/**
+ * @brief Reads the next word of the input as a number.
+ * @param reader The reader.
+ * @param value Set to the number, -1 if the word is not a number in the int range.
+ * @return MOVE_READ, or MOVE_END if the input ended.
+ */
+int readNumber(MoveReader *reader, int *value)
+{
+	const char *word;
+	size_t length;
+	if (nextWord(reader, &word, &length) != MOVE_READ)
+	{
+		return MOVE_END;
+	}
+	*value = scanNumber(word, length);
+	return MOVE_READ;
+}
+
+/**
+ * @brief Reads the next move, a row word and a column number counting from 1.
+ * @param reader The reader.
+ * @param row Set to the row index, -1 if the row word is not a row.
+ * @param col Set to the column index, -1 if the column word is not a number.
+ * @return MOVE_READ, MOVE_EXIT if the row word is "exit", or MOVE_END if the input ended.
+ */
+int readMove(MoveReader *reader, int *row, int *col)
+{
+	const char *word;
+	size_t length;
+	if (nextWord(reader, &word, &length) != MOVE_READ)
+	{
+		return MOVE_END;
+	}
+	if (isExit(word, length))
+	{
+		return MOVE_EXIT;
+	}
+	*row = scanRow(word, length);
+	if (nextWord(reader, &word, &length) != MOVE_READ)
+	{
+		return MOVE_END;
+	}
+	*col = scanColumn(word, length);
+	return MOVE_READ;
+}
+
+/**
+ * @brief Reads a move held in a single line, e.g. a line of a server session, with the words of
+ * readMove.
+ * @param line The line, not necessarily null terminated.
+ * @param length The line length.
+ * @param row Set to the row index, -1 if the row word is not a row.
+ * @param col Set to the column index, -1 if the column word is not a number.
+ * @return MOVE_READ, MOVE_EXIT if the line is "exit", or MOVE_END if the line does not hold
+ * exactly a row word and a column word.
+ */
+int scanMove(const char *line, size_t length, int *row, int *col)
+{
+	const char *rowWord, *colWord, *extra;
+	size_t offset = 0, rowLength, colLength;
+	rowLength = lineWord(line, length, &offset, &rowWord);
+	colLength = lineWord(line, length, &offset, &colWord);
+	if (lineWord(line, length, &offset, &extra) != 0 || rowLength == 0)
+	{
+		return MOVE_END;
+	}
+	if (colLength == 0)
+	{
+		return isExit(rowWord, rowLength) ? MOVE_EXIT : MOVE_END;
+	}
+	*row = scanRow(rowWord, rowLength);
+	*col = scanColumn(colWord, colLength);
+	return MOVE_READ;
+}
+
+/**
+ * @brief Releases a reader's mapping or buffer.
+ * @param reader The reader.
+ */
+void closeMoveReader(MoveReader *reader)
+{
+	if (reader->mapping != NULL)
+	{
+		munmap(reader->mapping, reader->length);
+	}
+	free(reader->buffer);
+	memset(reader, 0, sizeof(MoveReader));
+	reader->fd = -1;
+}
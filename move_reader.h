@@ -0,0 +1,131 @@
+/**
+ * @file move_reader.h
+ * @version 2.0
+ *
+ * @brief Reading the board size and the moves of a game from a script or a stream, in place.
+ *
+ * @section DESCRIPTION
+ * The input is a sequence of whitespace separated words, as typed in the console: the board
+ * size, then a row and a column for every move, or "exit". A reader either maps a whole script
+ * file, or reads a stream (e.g. stdin) in MOVE_READER_BLOCK bytes blocks. The words are scanned
+ * where they lie in the mapping or the block, with no per word library calls and no copies, so
+ * the only copy of a streamed word is the rare one split between two blocks.
+ */
+#ifndef MOVE_READER_H_
+#define MOVE_READER_H_
+
+// ------------------------------ includes ------------------------------
+#include <stddef.h>
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def MOVE_READER_BLOCK 65536
+ * @brief The size of the blocks read from a stream, and the longest word of a stream.
+ */
+#define MOVE_READER_BLOCK 65536
+
+/**
+ * @def MOVE_READ 0
+ * @brief A word or a move was read.
+ */
+#define MOVE_READ 0
+
+/**
+ * @def MOVE_EXIT 1
+ * @brief The player typed exit.
+ */
+#define MOVE_EXIT 1
+
+/**
+ * @def MOVE_END 2
+ * @brief The input ended (or failed) before a whole move.
+ */
+#define MOVE_END 2
+
+// ------------------------------ structs ----------------------------
+
+/**
+ * a structure describing a reader. includes the following attributes:
+ * fd - the stream read, -1 for a mapped script.
+ * data - the mapped script, or the block buffer of a stream.
+ * length - the number of bytes in data.
+ * offset - the first byte of data not scanned yet.
+ * ended - non zero once the stream has no more bytes.
+ * mapping - the mapped script (NULL for a stream or an empty script).
+ * buffer - the block buffer of a stream.
+ */
+typedef struct MoveReader
+{
+	int fd;
+	const char *data;
+	size_t length;
+	size_t offset;
+	int ended;
+	void *mapping;
+	char *buffer;
+} MoveReader;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Opens a reader mapping a whole script file.
+ * @param reader The reader.
+ * @param path The script path.
+ * @return 0 on success, -1 if the script could not be opened or mapped (errno is set).
+ */
+int openMoveScript(MoveReader *reader, const char *path);
+
+/**
+ * @brief Opens a reader reading a stream block by block.
+ * @param reader The reader.
+ * @param fd The stream, e.g. STDIN_FILENO. It is not closed by the reader.
+ * @return 0 on success, -1 if the allocation failed.
+ */
+int openMoveStream(MoveReader *reader, int fd);
+
+/**
+ * @brief Reads the row of a move, letters as printed on the board going on past 'z' like
+ * spreadsheet columns ('aa' follows 'z'), or a number counting from 1.
+ * @param text The row word, not necessarily null terminated.
+ * @param length The word length.
+ * @return The row index, -1 if the word is not a row.
+ */
+int scanRow(const char *text, size_t length);
+
+/**
+ * @brief Reads the next word of the input as a number.
+ * @param reader The reader.
+ * @param value Set to the number, -1 if the word is not a number in the int range.
+ * @return MOVE_READ, or MOVE_END if the input ended.
+ */
+int readNumber(MoveReader *reader, int *value);
+
+/**
+ * @brief Reads the next move, a row word and a column number counting from 1.
+ * @param reader The reader.
+ * @param row Set to the row index, -1 if the row word is not a row.
+ * @param col Set to the column index, -1 if the column word is not a number.
+ * @return MOVE_READ, MOVE_EXIT if the row word is "exit", or MOVE_END if the input ended.
+ */
+int readMove(MoveReader *reader, int *row, int *col);
+
+/**
+ * @brief Reads a move held in a single line, e.g. a line of a server session, with the words of
+ * readMove.
+ * @param line The line, not necessarily null terminated.
+ * @param length The line length.
+ * @param row Set to the row index, -1 if the row word is not a row.
+ * @param col Set to the column index, -1 if the column word is not a number.
+ * @return MOVE_READ, MOVE_EXIT if the line is "exit", or MOVE_END if the line does not hold
+ * exactly a row word and a column word.
+ */
+int scanMove(const char *line, size_t length, int *row, int *col);
+
+/**
+ * @brief Releases a reader's mapping or buffer.
+ * @param reader The reader.
+ */
+void closeMoveReader(MoveReader *reader);
+
+#endif /* MOVE_READER_H_ */
@@ -0,0 +1,106 @@
+/**
+ * @file placement.c
+ * @version 2.0
+ *
+ * @brief The in range placements of every ship length, computed once for every board size.
+ *
+ * @section DESCRIPTION
+ * The tables live in static memory, one for every size. A table is built under a lock and then
+ * published with a release store of its ready flag, the callers that find the flag set read the
+ * table with no lock at all.
+ */
+// ------------------------------ includes ------------------------------
+#include <pthread.h>
+#include <stdatomic.h>
+#include "placement.h"
+
+// ------------------------------ globals ----------------------------
+
+/**
+ * The placement tables, indexed by the board size.
+ */
+static PlacementTable tables[BITBOARD_MAX_SIZE + 1];
+
+/**
+ * Non zero once the table of a size is built.
+ */
+static atomic_int ready[BITBOARD_MAX_SIZE + 1];
+
+/**
+ * The lock held while a table is built.
+ */
+static pthread_mutex_t buildLock = PTHREAD_MUTEX_INITIALIZER;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Returns the number of placements of a ship covering a cell, along a single line.
+ * @param index The index of the cell on the line.
+ * @param size The length of the line.
+ * @param length The ship length.
+ * @return The number of placements.
+ */
+static int lineCoverage(int index, int size, int length)
+{
+	int first = index - length + 1 > 0 ? index - length + 1 : 0;
+	int last = index < size - length ? index : size - length;
+	return last >= first ? last - first + 1 : 0;
+}
+
+/**
+ * @brief Fills the placement table of a board size.
+ * @param table The table.
+ * @param size The board size.
+ */
+static void buildTable(PlacementTable *table, int size)
+{
+	int length, r, c;
+	table->size = size;
+	for (length = 1; length <= size; length++)
+	{
+		bbClear(&table->starts[length][PLACEMENT_VERTICAL]);
+		bbClear(&table->starts[length][PLACEMENT_HORIZONTAL]);
+		for (r = 0; r < size; r++)
+		{
+			bbOrRow(&table->starts[length][PLACEMENT_HORIZONTAL], r,
+					bbRowMask(size - length + 1));
+			if (r + length <= size)
+			{
+				bbOrRow(&table->starts[length][PLACEMENT_VERTICAL], r, bbRowMask(size));
+			}
+			for (c = 0; c < size; c++)
+			{
+				table->coverage[length][r][c] = (uint16_t) (lineCoverage(c, size, length) +
+															lineCoverage(r, size, length));
+			}
+		}
+		table->slots[length][PLACEMENT_VERTICAL] =
+				bbCount(&table->starts[length][PLACEMENT_VERTICAL]);
+		table->slots[length][PLACEMENT_HORIZONTAL] =
+				bbCount(&table->starts[length][PLACEMENT_HORIZONTAL]);
+	}
+}
+
+/**
+ * @brief Returns the placement table of a board size, building it on the first call.
+ * @param size The board size, between 1 and BITBOARD_MAX_SIZE.
+ * @return The table, NULL if the size is out of range.
+ */
+const PlacementTable *placementTable(int size)
+{
+	if (size < 1 || size > BITBOARD_MAX_SIZE)
+	{
+		return NULL;
+	}
+	if (!atomic_load_explicit(&ready[size], memory_order_acquire))
+	{
+		pthread_mutex_lock(&buildLock);
+		if (!atomic_load_explicit(&ready[size], memory_order_relaxed))
+		{
+			buildTable(&tables[size], size);
+			atomic_store_explicit(&ready[size], 1, memory_order_release);
+		}
+		pthread_mutex_unlock(&buildLock);
+	}
+	return &tables[size];
+}
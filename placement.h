@@ -0,0 +1,65 @@
+/**
+ * @file placement.h
+ * @version 2.0
+ *
+ * @brief The in range placements of every ship length, computed once for every board size.
+ *
+ * @section DESCRIPTION
+ * For a given board size the cells a ship of a given length and angle may start at, without
+ * leaving the board, never change. A placement table keeps them as bitboards for every length
+ * and angle, together with the number of placements covering every cell of an empty board, so
+ * placing a ship, testing it against the other ships and counting the placement density of a
+ * new game start from a lookup instead of a scan of the board.
+ * A table is built the first time its size is asked for, and only read afterwards, so it may be
+ * shared by any number of threads.
+ */
+#ifndef PLACEMENT_H_
+#define PLACEMENT_H_
+
+// ------------------------------ includes ------------------------------
+#include <stdint.h>
+#include "bitboard.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def PLACEMENT_VERTICAL 0
+ * @brief The index of the vertical placements of a length.
+ */
+#define PLACEMENT_VERTICAL 0
+
+/**
+ * @def PLACEMENT_HORIZONTAL 1
+ * @brief The index of the horizontal placements of a length.
+ */
+#define PLACEMENT_HORIZONTAL 1
+
+// ------------------------------ structs ----------------------------
+
+/**
+ * a structure holding the in range placements of every ship length on a board of a single
+ * size. includes the following attributes:
+ * size - the board size.
+ * slots - for every length and angle, the number of in range placements.
+ * starts - for every length and angle, the cells an in range placement starts at.
+ * coverage - for every length, the number of in range placements covering every cell (0 out of
+ * the board).
+ */
+typedef struct PlacementTable
+{
+	int size;
+	int slots[BITBOARD_MAX_SIZE + 1][2];
+	Bitboard starts[BITBOARD_MAX_SIZE + 1][2];
+	uint16_t coverage[BITBOARD_MAX_SIZE + 1][BITBOARD_MAX_SIZE][BITBOARD_ROW_BITS];
+} PlacementTable;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Returns the placement table of a board size, building it on the first call.
+ * @param size The board size, between 1 and BITBOARD_MAX_SIZE.
+ * @return The table, NULL if the size is out of range.
+ */
+const PlacementTable *placementTable(int size);
+
+#endif /* PLACEMENT_H_ */
@@ -0,0 +1,1279 @@
+/**
+ * @file posterior.c
+ * @version 2.0
+ *
+ * @brief The exact probability of every cell to hold a ship, given the shots of a game so far.
+ *
+ * @section DESCRIPTION
+ * The legal placements of every ship are listed once as bitboard masks, dropping the ones on a
+ * miss and the ones that disagree with the sunk reports. A partial layout is its ship index and
+ * the bitboard of the cells taken. Its count is the total weight of its completions: the ship
+ * picks one of its placements that fit, weighted by one over its free slots. The last two ships
+ * are counted together from the free starts of the last ship in the layout before them, a
+ * placement of the ship before the last only taking off the starts it crosses; those layouts
+ * are memoized only when ships of the same length come first. The counts of the other levels
+ * are kept in an open addressing table of the thread, which is then scanned level by level to
+ * push the weight of reaching every partial layout to its children; a placement taken from a
+ * partial layout adds (weight of reaching it) * (placement weight) * (count of the child) to its
+ * cells. Before any of it, random paths down the search tree estimate the number of layouts the
+ * query visits, so a query far over the limit is given up at once.
+ */
+// ------------------------------ includes ------------------------------
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include "posterior.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def MEMO_INITIAL_CAPACITY 4096
+ * @brief The number of entries of a new memo table, a power of two.
+ */
+#define MEMO_INITIAL_CAPACITY 4096
+
+/**
+ * @def MEMO_MAX_ENTRIES 524288
+ * @brief The maximal number of layouts a thread memoizes, keeping its table within 128 MB.
+ */
+#define MEMO_MAX_ENTRIES (1 << 19)
+
+/**
+ * @def MEMO_HASH_MULTIPLIER 0x9e3779b97f4a7c15
+ * @brief The odd multiplier mixing the occupancy words into the memo hash.
+ */
+#define MEMO_HASH_MULTIPLIER 0x9e3779b97f4a7c15ULL
+
+/**
+ * @def ESTIMATE_PROBES 256
+ * @brief The number of random paths down the search tree the estimate of a query follows.
+ */
+#define ESTIMATE_PROBES 256
+
+/**
+ * @def ESTIMATE_SEED 2018
+ * @brief The seed of the random paths of the estimate, fixed so a query always gets the same one.
+ */
+#define ESTIMATE_SEED 2018
+
+/**
+ * @def ESTIMATE_MARGIN 2
+ * @brief A query estimated to visit more than ESTIMATE_MARGIN * POSTERIOR_MAX_STATES layouts is
+ * given up at once, leaving room for the error of the estimate.
+ */
+#define ESTIMATE_MARGIN 2
+
+// ------------------------------ structs ----------------------------
+
+/**
+ * a structure describing a legal placement of a ship. includes the following attributes:
+ * mask - the cells of the ship.
+ * row - the row of the first cell.
+ * col - the column of the first cell.
+ * vertical - 1 if the ship goes down the rows, 0 if it goes along the row.
+ * hits - the number of hits the placement covers.
+ */
+typedef struct Placement
+{
+	Bitboard mask;
+	uint8_t row;
+	uint8_t col;
+	uint8_t vertical;
+	uint8_t hits;
+} Placement;
+
+/**
+ * a structure holding a memoized partial layout. includes the following attributes:
+ * occupied - the cells taken by the ships already placed.
+ * level - the number of ships placed, 0 for an empty entry.
+ * count - the total weight of the completions of the layout.
+ * forward - the total weight of reaching the layout from the empty board.
+ */
+typedef struct MemoEntry
+{
+	Bitboard occupied;
+	int level;
+	double count;
+	double forward;
+} MemoEntry;
+
+/**
+ * a structure holding the read only description of a query, shared by the threads. includes
+ * the following attributes:
+ * size - the board size.
+ * words - the number of bitboard words the board rows use.
+ * shipsNum - the number of ships.
+ * uniform - non zero to count every layout once.
+ * lengths - the length of every ship.
+ * remaining - the number of cells of every ship and the ships after it.
+ * hits - the cells that must be covered.
+ * hitsNum - the number of hits.
+ * placements - the legal placements of every ship.
+ * counts - the number of legal placements of every ship.
+ * starts - the start masks of the legal placements of every ship, along the rows and down the
+ * columns of every row.
+ * hitStarts - the start masks of the legal placements of every ship that cover a hit.
+ * index - the index of the legal placement of every ship at every start, -1 if none.
+ * memoTop - the deepest memoized level: the ship before the last if two ships before it share a
+ * length (its layouts are then reached in several orders), the ship before that otherwise.
+ * firstWeight - the weight of every placement of the first ship.
+ * next - the next placement of the first ship to take.
+ * states - the number of layouts visited by all the threads, stopping them past
+ * POSTERIOR_MAX_STATES.
+ */
+typedef struct Solver
+{
+	int size;
+	int words;
+	int shipsNum;
+	int uniform;
+	int lengths[POSTERIOR_MAX_SHIPS];
+	int remaining[POSTERIOR_MAX_SHIPS + 1];
+	Bitboard hits;
+	int hitsNum;
+	Placement *placements[POSTERIOR_MAX_SHIPS];
+	int counts[POSTERIOR_MAX_SHIPS];
+	uint32_t starts[POSTERIOR_MAX_SHIPS][2][BITBOARD_MAX_SIZE];
+	uint32_t hitStarts[POSTERIOR_MAX_SHIPS][2][BITBOARD_MAX_SIZE];
+	int16_t index[POSTERIOR_MAX_SHIPS][2][BITBOARD_MAX_SIZE][BITBOARD_MAX_SIZE];
+	int memoTop;
+	double firstWeight;
+	atomic_int next;
+	atomic_long states;
+} Solver;
+
+/**
+ * a structure describing a solver thread. includes the following attributes:
+ * solver - the query.
+ * entries - the memo table.
+ * capacity - the number of entries of the table, a power of two.
+ * used - the number of memoized layouts.
+ * status - POSTERIOR_OK, or the error that stopped the thread.
+ * total - the total weight of the layouts found by the thread.
+ * cells - the weight of the layouts found by the thread that cover every cell.
+ * lastStarts - the weight of the layouts found by the thread that have the last ship at every
+ * start, along the rows and down the columns, not yet added to the cells.
+ * thread - the thread id.
+ * started - 0 if the thread was created.
+ */
+typedef struct SolverWorker
+{
+	Solver *solver;
+	MemoEntry *entries;
+	long capacity;
+	long used;
+	int status;
+	double total;
+	double cells[BITBOARD_MAX_SIZE][BITBOARD_MAX_SIZE];
+	double lastStarts[2][BITBOARD_MAX_SIZE][BITBOARD_MAX_SIZE];
+	pthread_t thread;
+	int started;
+} SolverWorker;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Starts the observations of a new game, with no shots.
+ * @param query The observations.
+ * @param size The board size.
+ * @param fleet The fleet, it must outlive the query.
+ * @param uniform Non zero to count every consistent layout once.
+ */
+void posteriorReset(PosteriorQuery *query, int size, const Fleet *fleet, int uniform)
+{
+	query->size = size;
+	query->fleet = fleet;
+	query->uniform = uniform;
+	bbClear(&query->misses);
+	bbClear(&query->hits);
+	query->sunkNum = 0;
+}
+
+/**
+ * @brief Adds the result of a shot to the observations.
+ * @param query The observations.
+ * @param row The row of the shot.
+ * @param col The column of the shot.
+ * @param result The shot result, as returned by fireShot.
+ * @param sunkLength The length of the sunk ship if the shot sunk one.
+ */
+void posteriorObserve(PosteriorQuery *query, int row, int col, int result, int sunkLength)
+{
+	if (result == SHOT_MISS)
+	{
+		bbSet(&query->misses, row, col);
+	}
+	else if (result == SHOT_HIT)
+	{
+		bbSet(&query->hits, row, col);
+	}
+	else if (SHOT_IS_SUNK(result))
+	{
+		bbSet(&query->hits, row, col);
+		if (query->sunkNum < POSTERIOR_MAX_SHIPS)
+		{
+			query->sunk[query->sunkNum].row = row;
+			query->sunk[query->sunkNum].col = col;
+			query->sunk[query->sunkNum].length = sunkLength;
+		}
+		query->sunkNum++;
+	}
+}
+
+/**
+ * @brief Counts the set bits of a word with a few multiplies instead of the library call
+ * __builtin_popcount makes on a target without a popcount instruction.
+ * @param bits The word.
+ * @return The number of set bits.
+ */
+static inline int countBits(uint64_t bits)
+{
+	bits -= (bits >> 1) & 0x5555555555555555ULL;
+	bits = (bits & 0x3333333333333333ULL) + ((bits >> 2) & 0x3333333333333333ULL);
+	bits = (bits + (bits >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+	return (int) ((bits * 0x0101010101010101ULL) >> 56);
+}
+
+/**
+ * @brief Finds the starts of the slots a ship of the given length may take on a board with some
+ * cells taken, as placeShips draws them (a ship of length 1 only has slots along the rows).
+ * @param solver The query.
+ * @param occupied The cells taken.
+ * @param length The ship length.
+ * @param starts Filled with the start masks along the rows and down the columns of every row.
+ * @return The number of slots.
+ */
+static int freeStarts(const Solver *solver, const Bitboard *occupied, int length,
+					  uint32_t starts[][BITBOARD_MAX_SIZE])
+{
+	uint32_t freeRows[BITBOARD_MAX_SIZE], across, down;
+	int i, k, size = solver->size, slots = 0;
+	for (i = 0; i < size; i++)
+	{
+		freeRows[i] = ~bbRow(occupied, i) & bbRowMask(size);
+	}
+	for (i = 0; i < size; i++)
+	{
+		across = freeRows[i];
+		down = length > 1 && i + length <= size ? freeRows[i] : 0;
+		for (k = 1; k < length; k++)
+		{
+			across &= freeRows[i] >> k;
+		}
+		for (k = 1; k < length && down != 0; k++)
+		{
+			down &= freeRows[i + k];
+		}
+		starts[0][i] = across;
+		starts[1][i] = down;
+		slots += countBits((uint64_t) across << BITBOARD_ROW_BITS | down);
+	}
+	return slots;
+}
+
+/**
+ * @brief Checks that the cells of a board are disjoint from a placement.
+ * @param solver The query.
+ * @param occupied The cells taken.
+ * @param placement The placement.
+ * @return 1 if no cell of the placement is taken, 0 otherwise.
+ */
+static inline int fits(const Solver *solver, const Bitboard *occupied, const Placement *placement)
+{
+	uint64_t common = 0;
+	int i;
+	for (i = 0; i < solver->words; i++)
+	{
+		common |= occupied->words[i] & placement->mask.words[i];
+	}
+	return common == 0;
+}
+
+/**
+ * @brief Counts the hits not covered by the ships placed.
+ * @param solver The query.
+ * @param occupied The cells taken.
+ * @return The number of uncovered hits.
+ */
+static inline int uncoveredHits(const Solver *solver, const Bitboard *occupied)
+{
+	int i, count = 0;
+	for (i = 0; i < solver->words; i++)
+	{
+		count += countBits(solver->hits.words[i] & ~occupied->words[i]);
+	}
+	return count;
+}
+
+/**
+ * @brief Adds a weight to the cells of a placement.
+ * @param cells The cell weights.
+ * @param length The ship length.
+ * @param placement The placement.
+ * @param weight The weight added.
+ */
+static inline void addCells(double cells[][BITBOARD_MAX_SIZE], int length,
+							const Placement *placement, double weight)
+{
+	int k;
+	for (k = 0; k < length; k++)
+	{
+		cells[placement->row + (placement->vertical ? k : 0)]
+			 [placement->col + (placement->vertical ? 0 : k)] += weight;
+	}
+}
+
+/**
+ * @brief Returns the weight of every placement of a ship from a partial layout.
+ * @param solver The query.
+ * @param occupied The cells taken.
+ * @param level The ship index.
+ * @return One over the free slots of the ship, 1 in uniform mode.
+ */
+static double placementWeight(const Solver *solver, const Bitboard *occupied, int level)
+{
+	uint32_t starts[2][BITBOARD_MAX_SIZE];
+	int slots;
+	if (solver->uniform)
+	{
+		return 1.0;
+	}
+	slots = freeStarts(solver, occupied, solver->lengths[level], starts);
+	return slots > 0 ? 1.0 / slots : 0.0;
+}
+
+/**
+ * @brief Hashes a partial layout.
+ * @param solver The query.
+ * @param level The number of ships placed.
+ * @param occupied The cells taken.
+ * @return The hash.
+ */
+static inline uint64_t memoHash(const Solver *solver, int level, const Bitboard *occupied)
+{
+	uint64_t hash = (uint64_t) level;
+	int i;
+	for (i = 0; i < solver->words; i++)
+	{
+		hash = (hash ^ occupied->words[i]) * MEMO_HASH_MULTIPLIER;
+		hash ^= hash >> 32;
+	}
+	return hash;
+}
+
+/**
+ * @brief Finds the memo entry of a partial layout, or the empty entry it would take.
+ * @param worker The thread.
+ * @param level The number of ships placed.
+ * @param occupied The cells taken.
+ * @return The entry.
+ */
+static MemoEntry *memoSlot(SolverWorker *worker, int level, const Bitboard *occupied)
+{
+	const Solver *solver = worker->solver;
+	long mask = worker->capacity - 1;
+	long index = (long) (memoHash(solver, level, occupied) & (uint64_t) mask);
+	MemoEntry *entry;
+	int i, same;
+	while (1)
+	{
+		entry = &worker->entries[index];
+		if (entry->level == 0)
+		{
+			return entry;
+		}
+		if (entry->level == level)
+		{
+			same = 1;
+			for (i = 0; i < solver->words && same; i++)
+			{
+				same = entry->occupied.words[i] == occupied->words[i];
+			}
+			if (same)
+			{
+				return entry;
+			}
+		}
+		index = (index + 1) & mask;
+	}
+}
+
+/**
+ * @brief Doubles the memo table, keeping its entries.
+ * @param worker The thread.
+ * @return POSTERIOR_OK, or POSTERIOR_MEMORY_ERROR (the old table is then kept).
+ */
+static int growMemo(SolverWorker *worker)
+{
+	MemoEntry *old = worker->entries, *entry;
+	long i, capacity = worker->capacity;
+	worker->entries = (MemoEntry *) calloc((size_t) (2 * capacity), sizeof(MemoEntry));
+	if (worker->entries == NULL)
+	{
+		worker->entries = old;
+		return POSTERIOR_MEMORY_ERROR;
+	}
+	worker->capacity = 2 * capacity;
+	for (i = 0; i < capacity; i++)
+	{
+		if (old[i].level != 0)
+		{
+			entry = memoSlot(worker, old[i].level, &old[i].occupied);
+			*entry = old[i];
+		}
+	}
+	free(old);
+	return POSTERIOR_OK;
+}
+
+/**
+ * @brief Counts the partial layouts the thread visits, stopping the thread if the threads
+ * together visited POSTERIOR_MAX_STATES layouts.
+ * @param worker The thread.
+ * @param layouts The number of layouts visited.
+ * @return 1 if the layouts may be solved, 0 if the thread stopped.
+ */
+static int visitLayouts(SolverWorker *worker, long layouts)
+{
+	if (atomic_fetch_add_explicit(&worker->solver->states, layouts, memory_order_relaxed) +
+		layouts > POSTERIOR_MAX_STATES)
+	{
+		worker->status = POSTERIOR_TOO_LARGE;
+		return 0;
+	}
+	return 1;
+}
+
+/**
+ * @brief Memoizes the count of a partial layout, within the budget of the query and the room of
+ * the table.
+ * @param worker The thread.
+ * @param level The number of ships placed.
+ * @param occupied The cells taken.
+ * @param count The count.
+ */
+static void memoize(SolverWorker *worker, int level, const Bitboard *occupied, double count)
+{
+	MemoEntry *entry;
+	if (!visitLayouts(worker, 1))
+	{
+		return;
+	}
+	if (worker->used >= MEMO_MAX_ENTRIES)
+	{
+		worker->status = POSTERIOR_TOO_LARGE;
+		return;
+	}
+	if (2 * (worker->used + 1) > worker->capacity &&
+		(worker->status = growMemo(worker)) != POSTERIOR_OK)
+	{
+		return;
+	}
+	entry = memoSlot(worker, level, occupied);
+	entry->occupied = *occupied;
+	entry->level = level;
+	entry->count = count;
+	entry->forward = 0.0;
+	worker->used++;
+}
+
+/**
+ * @brief Lists the placements of the last ship that complete a partial layout leaving some hits
+ * uncovered: the ones through the first uncovered hit that fit and cover every uncovered hit.
+ * @param solver The query.
+ * @param occupied The cells taken by the other ships.
+ * @param uncovered The number of uncovered hits, at least 1.
+ * @param found Filled with the placements, room for 2 * the length of the last ship.
+ * @return The number of placements.
+ */
+static int hitPlacements(const Solver *solver, const Bitboard *occupied, int uncovered,
+						 const Placement *found[])
+{
+	int i, k, vertical, row, col, index, count = 0;
+	int level = solver->shipsNum - 1, length = solver->lengths[level];
+	const Placement *placement;
+	uint64_t word = 0;
+	for (i = 0; word == 0; i++)
+	{
+		word = solver->hits.words[i] & ~occupied->words[i];
+	}
+	row = 2 * (i - 1) + __builtin_ctzll(word) / BITBOARD_ROW_BITS;
+	col = __builtin_ctzll(word) % BITBOARD_ROW_BITS;
+	for (vertical = 0; vertical < 2; vertical++)
+	{
+		for (k = 0; k < length; k++)
+		{
+			if ((vertical ? row : col) < k)
+			{
+				break;
+			}
+			index = solver->index[level][vertical][row - (vertical ? k : 0)]
+								 [col - (vertical ? 0 : k)];
+			if (index < 0)
+			{
+				continue;
+			}
+			placement = &solver->placements[level][index];
+			if (placement->hits == uncovered && fits(solver, occupied, placement))
+			{
+				found[count++] = placement;
+			}
+		}
+	}
+	return count;
+}
+
+/**
+ * @brief Counts the placements of the last ship through the first hit a partial layout leaves
+ * uncovered, adding their weight to the cells of the thread if asked to.
+ * @param worker The thread.
+ * @param occupied The cells taken by the other ships, leaving some hits uncovered.
+ * @param uncovered The number of uncovered hits.
+ * @param weight The weight of every placement of the last ship.
+ * @param forward The weight of reaching the layout, added to the thread if positive.
+ * @return The weight of the completions.
+ */
+static double lastThroughHit(SolverWorker *worker, const Bitboard *occupied, int uncovered,
+							 double weight, double forward)
+{
+	const Solver *solver = worker->solver;
+	const Placement *found[2 * BITBOARD_MAX_SIZE];
+	int i, count = hitPlacements(solver, occupied, uncovered, found);
+	for (i = 0; i < count && forward > 0.0; i++)
+	{
+		addCells(worker->cells, solver->lengths[solver->shipsNum - 1], found[i], forward * weight);
+	}
+	return weight * (double) count;
+}
+
+/**
+ * @brief Counts the placements of the last ship that complete a partial layout, adding their
+ * weight to the thread if asked to. With every hit covered the free legal starts are counted a
+ * row at a time, otherwise only the placements through the first uncovered hit are tried.
+ * @param worker The thread.
+ * @param occupied The cells taken by the other ships.
+ * @param forward The weight of reaching the layout, added to the thread if positive.
+ * @return The weight of the completions.
+ */
+static double lastShip(SolverWorker *worker, const Bitboard *occupied, double forward)
+{
+	const Solver *solver = worker->solver;
+	int vertical, row, slots, uncovered, count = 0;
+	int level = solver->shipsNum - 1, length = solver->lengths[level];
+	uint32_t starts[2][BITBOARD_MAX_SIZE], bits;
+	double weight;
+	uncovered = uncoveredHits(solver, occupied);
+	if (uncovered > length)
+	{
+		return 0.0;
+	}
+	slots = freeStarts(solver, occupied, length, starts);
+	weight = solver->uniform ? 1.0 : slots > 0 ? 1.0 / slots : 0.0;
+	if (uncovered > 0)
+	{
+		return lastThroughHit(worker, occupied, uncovered, weight, forward);
+	}
+	for (vertical = 0; vertical < 2; vertical++)
+	{
+		for (row = 0; row < solver->size; row++)
+		{
+			bits = starts[vertical][row] & solver->starts[level][vertical][row];
+			count += countBits(bits);
+			for (; forward > 0.0 && bits != 0; bits &= bits - 1)
+			{
+				worker->lastStarts[vertical][row][__builtin_ctz(bits)] += forward * weight;
+			}
+		}
+	}
+	return weight * (double) count;
+}
+
+/**
+ * @brief Finds the starts of the last ship a placement crosses, along the rows or down the
+ * columns: the start masks of the rows from first to end all share the returned mask.
+ * @param placement The placement.
+ * @param length The length of its ship.
+ * @param last The length of the last ship.
+ * @param vertical 1 for the starts down the columns, 0 for the starts along the rows.
+ * @param first Set to the first row of the crossed starts.
+ * @param end Set to the last row of the crossed starts.
+ * @return The mask of the crossed starts in every row.
+ */
+static inline uint32_t crossedStarts(const Placement *placement, int length, int last,
+									 int vertical, int *first, int *end)
+{
+	int low = placement->col - (vertical ? 0 : last - 1);
+	int high = placement->col + (placement->vertical ? 0 : length - 1);
+	*first = placement->row - (vertical ? last - 1 : 0);
+	*first = *first < 0 ? 0 : *first;
+	*end = placement->row + (placement->vertical ? length - 1 : 0);
+	low = low < 0 ? 0 : low;
+	return ((uint32_t) 2 << high) - ((uint32_t) 1 << low);
+}
+
+/**
+ * @brief Counts the starts of the last ship a placement removes from a partial layout.
+ * @param placement The placement.
+ * @param length The length of its ship.
+ * @param last The length of the last ship.
+ * @param open The free starts of the last ship in the layout.
+ * @param legal The free legal starts of the last ship in the layout.
+ * @param removed Filled with the number of free starts and of free legal starts crossed.
+ */
+static inline void removedStarts(const Placement *placement, int length, int last,
+								 uint32_t open[][BITBOARD_MAX_SIZE],
+								 uint32_t legal[][BITBOARD_MAX_SIZE], int removed[2])
+{
+	int vertical, row, first, end;
+	uint32_t mask;
+	removed[0] = removed[1] = 0;
+	for (vertical = 0; vertical < 2; vertical++)
+	{
+		mask = crossedStarts(placement, length, last, vertical, &first, &end);
+		for (row = first; row <= end; row++)
+		{
+			removed[0] += countBits(open[vertical][row] & mask);
+			removed[1] += countBits(legal[vertical][row] & mask);
+		}
+	}
+}
+
+/**
+ * @brief Takes a weight off the free legal starts of the last ship a placement crosses.
+ * @param worker The thread.
+ * @param placement The placement.
+ * @param length The length of its ship.
+ * @param last The length of the last ship.
+ * @param legal The free legal starts of the last ship in the layout.
+ * @param weight The weight taken off.
+ */
+static void dropCrossed(SolverWorker *worker, const Placement *placement, int length, int last,
+						uint32_t legal[][BITBOARD_MAX_SIZE], double weight)
+{
+	int vertical, row, first, end;
+	uint32_t mask, bits;
+	for (vertical = 0; vertical < 2; vertical++)
+	{
+		mask = crossedStarts(placement, length, last, vertical, &first, &end);
+		for (row = first; row <= end; row++)
+		{
+			for (bits = legal[vertical][row] & mask; bits != 0; bits &= bits - 1)
+			{
+				worker->lastStarts[vertical][row][__builtin_ctz(bits)] -= weight;
+			}
+		}
+	}
+}
+
+/**
+ * @brief Counts the completions of a partial layout by the last two ships, adding their weight
+ * to the thread if asked to. The free starts of the last ship are found once for the layout: a
+ * placement of the ship before it only removes the starts it crosses, so the slots and the
+ * completions it leaves are counted from the few rows it touches. With forward weights, the
+ * weight of every such placement is added to all the free legal starts at once and taken off
+ * the ones it crosses. The same goes for the layouts leaving hits uncovered: a placement on no
+ * hit keeps the placements of the last ship through them, less the ones it crosses.
+ * The layout and its children count against the budget of the query in the count pass, which is
+ * the only pass with three ships.
+ * @param worker The thread.
+ * @param occupied The cells taken by the other ships.
+ * @param forward The weight of reaching the layout, added to the thread if positive.
+ * @return The weight of the completions.
+ */
+static double lastPair(SolverWorker *worker, const Bitboard *occupied, double forward)
+{
+	const Solver *solver = worker->solver;
+	int level = solver->shipsNum - 2, length = solver->lengths[level];
+	int last = solver->lengths[level + 1];
+	uint32_t starts[2][BITBOARD_MAX_SIZE], open[2][BITBOARD_MAX_SIZE];
+	uint32_t legal[2][BITBOARD_MAX_SIZE], bits;
+	int i, j, vertical, row, slots, openSlots, openCount = 0, uncovered, left, removed[2];
+	int throughNum = 0, kept;
+	long children = 0;
+	const Placement *placement, *through[2 * BITBOARD_MAX_SIZE];
+	double throughWeight[2 * BITBOARD_MAX_SIZE];
+	Bitboard child;
+	double weight, lastWeight, count, reach, total = 0.0, shared = 0.0;
+	uncovered = uncoveredHits(solver, occupied);
+	if (uncovered > solver->remaining[level])
+	{
+		return 0.0;
+	}
+	if (uncovered > 0 && uncovered <= last)
+	{
+		throughNum = hitPlacements(solver, occupied, uncovered, through);
+		memset(throughWeight, 0, sizeof(throughWeight));
+	}
+	slots = freeStarts(solver, occupied, length, starts);
+	weight = solver->uniform ? 1.0 : slots > 0 ? 1.0 / slots : 0.0;
+	reach = forward * weight;
+	openSlots = freeStarts(solver, occupied, last, open);
+	for (vertical = 0; vertical < 2; vertical++)
+	{
+		for (row = 0; row < solver->size; row++)
+		{
+			legal[vertical][row] = open[vertical][row] & solver->starts[level + 1][vertical][row];
+			openCount += countBits(legal[vertical][row]);
+		}
+	}
+	for (vertical = 0; vertical < 2; vertical++)
+	{
+		for (row = 0; row < solver->size; row++)
+		{
+			bits = starts[vertical][row] &
+				   (uncovered > last ? solver->hitStarts : solver->starts)[level][vertical][row];
+			for (; bits != 0; bits &= bits - 1)
+			{
+				placement = &solver->placements[level]
+						[solver->index[level][vertical][row][__builtin_ctz(bits)]];
+				left = uncovered - placement->hits;
+				if (left > last)
+				{
+					continue;
+				}
+				children++;
+				removedStarts(placement, length, last, open, legal, removed);
+				lastWeight = solver->uniform ? 1.0 : openSlots > removed[0] ?
+							 1.0 / (openSlots - removed[0]) : 0.0;
+				if (left == 0)
+				{
+					count = lastWeight * (double) (openCount - removed[1]);
+					if (reach > 0.0 && count > 0.0)
+					{
+						shared += reach * lastWeight;
+						dropCrossed(worker, placement, length, last, legal, reach * lastWeight);
+					}
+				}
+				else if (placement->hits == 0)
+				{
+					for (i = kept = 0; i < throughNum; i++)
+					{
+						if (fits(solver, &placement->mask, through[i]))
+						{
+							kept++;
+							throughWeight[i] += reach * lastWeight;
+						}
+					}
+					count = lastWeight * (double) kept;
+				}
+				else
+				{
+					for (j = 0; j < solver->words; j++)
+					{
+						child.words[j] = occupied->words[j] | placement->mask.words[j];
+					}
+					count = lastThroughHit(worker, &child, left, lastWeight, reach);
+				}
+				if (reach > 0.0 && count > 0.0)
+				{
+					addCells(worker->cells, length, placement, reach * count);
+				}
+				total += count;
+			}
+		}
+	}
+	if ((forward <= 0.0 || solver->shipsNum == 3) && !visitLayouts(worker, 1 + children))
+	{
+		return 0.0;
+	}
+	for (i = 0; i < throughNum && reach > 0.0; i++)
+	{
+		addCells(worker->cells, last, through[i], throughWeight[i]);
+	}
+	for (vertical = 0; vertical < 2 && shared > 0.0; vertical++)
+	{
+		for (row = 0; row < solver->size; row++)
+		{
+			for (bits = legal[vertical][row]; bits != 0; bits &= bits - 1)
+			{
+				worker->lastStarts[vertical][row][__builtin_ctz(bits)] += shared;
+			}
+		}
+	}
+	return weight * total;
+}
+
+/**
+ * @brief Counts the weight of the completions of a partial layout.
+ * @param worker The thread.
+ * @param level The number of ships placed, at least 1 and below the last ship.
+ * @param occupied The cells taken.
+ * @return The weight, 0 if the thread stopped.
+ */
+static double countLayouts(SolverWorker *worker, int level, const Bitboard *occupied)
+{
+	const Solver *solver = worker->solver;
+	const Placement *placement;
+	uint32_t starts[2][BITBOARD_MAX_SIZE], bits;
+	MemoEntry *entry;
+	Bitboard child;
+	double count = 0.0;
+	int j, vertical, row, slots, uncovered;
+	if (worker->status != POSTERIOR_OK)
+	{
+		return 0.0;
+	}
+	uncovered = uncoveredHits(solver, occupied);
+	if (uncovered > solver->remaining[level])
+	{
+		return 0.0;
+	}
+	if (level > solver->memoTop)
+	{
+		return lastPair(worker, occupied, 0.0);
+	}
+	entry = memoSlot(worker, level, occupied);
+	if (entry->level != 0)
+	{
+		return entry->count;
+	}
+	if (level == solver->shipsNum - 2)
+	{
+		count = lastPair(worker, occupied, 0.0);
+		memoize(worker, level, occupied, count);
+		return count;
+	}
+	child = *occupied;
+	slots = freeStarts(solver, occupied, solver->lengths[level], starts);
+	for (vertical = 0; vertical < 2; vertical++)
+	{
+		for (row = 0; row < solver->size; row++)
+		{
+			bits = starts[vertical][row] &
+				   (uncovered > solver->remaining[level + 1] ? solver->hitStarts :
+					solver->starts)[level][vertical][row];
+			for (; bits != 0; bits &= bits - 1)
+			{
+				placement = &solver->placements[level]
+						[solver->index[level][vertical][row][__builtin_ctz(bits)]];
+				for (j = 0; j < solver->words; j++)
+				{
+					child.words[j] = occupied->words[j] | placement->mask.words[j];
+				}
+				count += countLayouts(worker, level + 1, &child);
+			}
+		}
+	}
+	count *= solver->uniform ? 1.0 : slots > 0 ? 1.0 / slots : 0.0;
+	memoize(worker, level, occupied, count);
+	return count;
+}
+
+/**
+ * @brief Pushes the weight of reaching a memoized layout to its children, adding the weight of
+ * the layouts through every placement of the next ship to its cells.
+ * @param worker The thread.
+ * @param from The memoized layout, with a positive count.
+ */
+static void pushForward(SolverWorker *worker, const MemoEntry *from)
+{
+	const Solver *solver = worker->solver;
+	int i, j, level = from->level, length = solver->lengths[level];
+	const Placement *placement = solver->placements[level];
+	double weight = from->forward * placementWeight(solver, &from->occupied, level), count;
+	MemoEntry *entry;
+	Bitboard child;
+	child = from->occupied;
+	for (i = 0; i < solver->counts[level]; i++, placement++)
+	{
+		if (!fits(solver, &from->occupied, placement))
+		{
+			continue;
+		}
+		for (j = 0; j < solver->words; j++)
+		{
+			child.words[j] = from->occupied.words[j] | placement->mask.words[j];
+		}
+		if (level + 1 > solver->memoTop)
+		{
+			count = lastPair(worker, &child, weight);
+		}
+		else
+		{
+			entry = memoSlot(worker, level + 1, &child);
+			if (entry->level == 0 || entry->count <= 0.0)
+			{
+				continue;
+			}
+			entry->forward += weight;
+			count = entry->count;
+		}
+		addCells(worker->cells, length, placement, weight * count);
+	}
+}
+
+/**
+ * @brief The solver thread: takes placements of the first ship until none is left, counting
+ * their completions, then pushes the weights forward through its memo table.
+ * @param arg The thread description.
+ * @return NULL.
+ */
+static void *solverMain(void *arg)
+{
+	SolverWorker *worker = (SolverWorker *) arg;
+	Solver *solver = worker->solver;
+	const Placement *placement;
+	Placement last;
+	MemoEntry *entry;
+	double count, weight = solver->firstWeight;
+	long i;
+	int index, level;
+	while (worker->status == POSTERIOR_OK &&
+		   (index = atomic_fetch_add_explicit(&solver->next, 1, memory_order_relaxed)) <
+		   solver->counts[0])
+	{
+		placement = &solver->placements[0][index];
+		if (solver->shipsNum == 1)
+		{
+			count = uncoveredHits(solver, &placement->mask) == 0 ? 1.0 : 0.0;
+		}
+		else if (solver->shipsNum == 2)
+		{
+			count = lastShip(worker, &placement->mask, weight);
+		}
+		else if (solver->shipsNum == 3)
+		{
+			count = lastPair(worker, &placement->mask, weight);
+		}
+		else
+		{
+			count = countLayouts(worker, 1, &placement->mask);
+			if (count > 0.0 && worker->status == POSTERIOR_OK)
+			{
+				memoSlot(worker, 1, &placement->mask)->forward += weight;
+			}
+		}
+		worker->total += weight * count;
+		addCells(worker->cells, solver->lengths[0], placement, weight * count);
+	}
+	for (level = 1; level <= solver->memoTop && worker->status == POSTERIOR_OK; level++)
+	{
+		for (i = 0; i < worker->capacity; i++)
+		{
+			entry = &worker->entries[i];
+			if (entry->level != level || entry->count <= 0.0 || entry->forward <= 0.0)
+			{
+				continue;
+			}
+			if (level == solver->shipsNum - 2)
+			{
+				lastPair(worker, &entry->occupied, entry->forward);
+			}
+			else
+			{
+				pushForward(worker, entry);
+			}
+		}
+	}
+	for (last.vertical = 0; last.vertical < 2; last.vertical++)
+	{
+		for (last.row = 0; last.row < solver->size; last.row++)
+		{
+			for (last.col = 0; last.col < solver->size; last.col++)
+			{
+				if (worker->lastStarts[last.vertical][last.row][last.col] != 0.0)
+				{
+					addCells(worker->cells, solver->lengths[solver->shipsNum - 1], &last,
+							 worker->lastStarts[last.vertical][last.row][last.col]);
+				}
+			}
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @brief Lists the placements of a ship that agree with the observations: none is on a miss,
+ * a placement entirely on hits holds exactly one sunk cell of its length, any other holds none.
+ * @param query The observations.
+ * @param length The ship length.
+ * @param placements Filled with the placements, room for 2 * size * size.
+ * @param starts Filled with the start masks of the placements.
+ * @param hitStarts Filled with the start masks of the placements that cover a hit.
+ * @param index Filled with the index of the placement at every start, -1 if none.
+ * @return The number of placements.
+ */
+static int listPlacements(const PosteriorQuery *query, int length, Placement *placements,
+						  uint32_t starts[][BITBOARD_MAX_SIZE],
+						  uint32_t hitStarts[][BITBOARD_MAX_SIZE],
+						  int16_t index[][BITBOARD_MAX_SIZE][BITBOARD_MAX_SIZE])
+{
+	int row, col, k, vertical, sunk, matching, hits, count = 0, size = query->size;
+	Placement *placement;
+	for (vertical = 0; vertical <= (length > 1); vertical++)
+	{
+		for (row = 0; row + (vertical ? length : 1) <= size; row++)
+		{
+			for (col = 0; col + (vertical ? 1 : length) <= size; col++)
+			{
+				placement = &placements[count];
+				bbClear(&placement->mask);
+				for (k = hits = 0; k < length; k++)
+				{
+					bbSet(&placement->mask, row + (vertical ? k : 0), col + (vertical ? 0 : k));
+					hits += bbTest(&query->hits, row + (vertical ? k : 0),
+								   col + (vertical ? 0 : k));
+				}
+				if (bbIntersects(&placement->mask, &query->misses))
+				{
+					continue;
+				}
+				sunk = matching = 0;
+				for (k = 0; k < query->sunkNum && k < POSTERIOR_MAX_SHIPS; k++)
+				{
+					if (bbTest(&placement->mask, query->sunk[k].row, query->sunk[k].col))
+					{
+						sunk++;
+						matching += query->sunk[k].length == length;
+					}
+				}
+				for (k = 0; k < BITBOARD_WORDS; k++)
+				{
+					if (placement->mask.words[k] & ~query->hits.words[k])
+					{
+						break;
+					}
+				}
+				if (k == BITBOARD_WORDS ? sunk != 1 || matching != 1 : sunk != 0)
+				{
+					continue;
+				}
+				placement->row = (uint8_t) row;
+				placement->col = (uint8_t) col;
+				placement->vertical = (uint8_t) vertical;
+				placement->hits = (uint8_t) hits;
+				starts[vertical][row] |= 1U << col;
+				hitStarts[vertical][row] |= hits > 0 ? 1U << col : 0U;
+				index[vertical][row][col] = (int16_t) count;
+				count++;
+			}
+		}
+	}
+	return count;
+}
+
+/**
+ * @brief Estimates the number of partial layouts a query visits before solving it, following
+ * ESTIMATE_PROBES random paths down the search tree of the count pass: a path meeting d1, d2, ...
+ * children on its way down stands for d1 layouts of the first level, d1 * d2 of the second and so
+ * on (Knuth's estimate of the size of a backtracking tree). A memoized level merges the orders
+ * of the ships of the same length placed, so its paths are divided by the number of such orders.
+ * @param solver The query.
+ * @return The estimated number of layouts, the last ship excluded.
+ */
+static double estimateStates(const Solver *solver)
+{
+	int16_t children[2 * BITBOARD_MAX_SIZE * BITBOARD_MAX_SIZE];
+	uint32_t starts[2][BITBOARD_MAX_SIZE], bits;
+	const Placement *placement;
+	Bitboard occupied;
+	Rng rng;
+	double paths, total = 0.0, orders[POSTERIOR_MAX_SHIPS + 1];
+	int probe, level, vertical, row, j, index, uncovered, childrenNum, same;
+	orders[0] = 1.0;
+	for (level = 0; level < solver->shipsNum; level++)
+	{
+		for (j = same = 0; j <= level; j++)
+		{
+			same += solver->lengths[j] == solver->lengths[level];
+		}
+		orders[level + 1] = orders[level] * same;
+	}
+	rngSeed(&rng, ESTIMATE_SEED, 0);
+	for (probe = 0; probe < ESTIMATE_PROBES; probe++)
+	{
+		bbClear(&occupied);
+		uncovered = solver->hitsNum;
+		paths = 1.0;
+		for (level = 0; level < solver->shipsNum - 1; level++)
+		{
+			freeStarts(solver, &occupied, solver->lengths[level], starts);
+			childrenNum = 0;
+			for (vertical = 0; vertical < 2; vertical++)
+			{
+				for (row = 0; row < solver->size; row++)
+				{
+					bits = starts[vertical][row] &
+						   (uncovered > solver->remaining[level + 1] ? solver->hitStarts :
+							solver->starts)[level][vertical][row];
+					for (; bits != 0; bits &= bits - 1)
+					{
+						index = solver->index[level][vertical][row][__builtin_ctz(bits)];
+						if (uncovered - solver->placements[level][index].hits <=
+							solver->remaining[level + 1])
+						{
+							children[childrenNum++] = (int16_t) index;
+						}
+					}
+				}
+			}
+			if (childrenNum == 0)
+			{
+				break;
+			}
+			paths *= childrenNum;
+			total += paths / orders[level + 1 < solver->memoTop ? level + 1 :
+									solver->memoTop > 0 ? solver->memoTop : 0];
+			index = children[rngBelow(&rng, (uint32_t) childrenNum)];
+			placement = &solver->placements[level][index];
+			for (j = 0; j < solver->words; j++)
+			{
+				occupied.words[j] |= placement->mask.words[j];
+			}
+			uncovered -= placement->hits;
+		}
+	}
+	return total / ESTIMATE_PROBES;
+}
+
+/**
+ * @brief Frees the placements of a solver.
+ * @param solver The solver.
+ */
+static void freeSolver(Solver *solver)
+{
+	int i;
+	for (i = 0; i < solver->shipsNum; i++)
+	{
+		free(solver->placements[i]);
+	}
+}
+
+/**
+ * @brief Prepares the read only description of a query.
+ * @param query The observations.
+ * @param solver Filled with the description.
+ * @return POSTERIOR_OK, POSTERIOR_TOO_LARGE or POSTERIOR_MEMORY_ERROR.
+ */
+static int prepareSolver(const PosteriorQuery *query, Solver *solver)
+{
+	const Fleet *fleet = query->fleet;
+	Bitboard empty;
+	int i, j;
+	memset(solver, 0, sizeof(Solver));
+	memset(solver->index, -1, sizeof(solver->index));
+	if (fleet->shipsNum < 1 || fleet->shipsNum > POSTERIOR_MAX_SHIPS ||
+		query->sunkNum > POSTERIOR_MAX_SHIPS || query->size < 1 ||
+		query->size > BITBOARD_MAX_SIZE)
+	{
+		return POSTERIOR_TOO_LARGE;
+	}
+	solver->size = query->size;
+	solver->words = (query->size + 1) / 2;
+	solver->shipsNum = fleet->shipsNum;
+	solver->uniform = query->uniform;
+	solver->hits = query->hits;
+	solver->hitsNum = bbCount(&query->hits);
+	for (i = fleet->shipsNum - 1; i >= 0; i--)
+	{
+		solver->lengths[i] = fleet->lengths[i];
+		solver->remaining[i] = solver->remaining[i + 1] + fleet->lengths[i];
+		solver->placements[i] = (Placement *) malloc(2 * query->size * query->size *
+													 sizeof(Placement));
+		if (solver->placements[i] == NULL)
+		{
+			freeSolver(solver);
+			return POSTERIOR_MEMORY_ERROR;
+		}
+		solver->counts[i] = listPlacements(query, fleet->lengths[i], solver->placements[i],
+										   solver->starts[i], solver->hitStarts[i],
+										   solver->index[i]);
+	}
+	solver->memoTop = solver->shipsNum - 3;
+	for (i = 1; i <= solver->shipsNum - 3; i++)
+	{
+		for (j = 0; j < i; j++)
+		{
+			solver->memoTop = solver->lengths[i] == solver->lengths[j] ? solver->shipsNum - 2 :
+							  solver->memoTop;
+		}
+	}
+	bbClear(&empty);
+	solver->firstWeight = placementWeight(solver, &empty, 0);
+	atomic_init(&solver->next, 0);
+	atomic_init(&solver->states, 0);
+	return POSTERIOR_OK;
+}
+
+/**
+ * @brief Computes the probability of every cell to hold a ship.
+ * @param query The observations.
+ * @param threads The number of threads sharing the placements of the first ship.
+ * @param posterior Filled with the result.
+ * @return POSTERIOR_OK, POSTERIOR_INCONSISTENT, POSTERIOR_TOO_LARGE or POSTERIOR_MEMORY_ERROR.
+ */
+int solvePosterior(const PosteriorQuery *query, int threads, Posterior *posterior)
+{
+	Solver solver;
+	SolverWorker *workers;
+	int i, row, col, status = prepareSolver(query, &solver);
+	memset(posterior, 0, sizeof(Posterior));
+	if (status != POSTERIOR_OK)
+	{
+		return status;
+	}
+	if (estimateStates(&solver) > ESTIMATE_MARGIN * POSTERIOR_MAX_STATES)
+	{
+		freeSolver(&solver);
+		return POSTERIOR_TOO_LARGE;
+	}
+	threads = threads < 1 ? 1 : threads > solver.counts[0] ? solver.counts[0] : threads;
+	workers = (SolverWorker *) calloc((size_t) (threads > 0 ? threads : 1), sizeof(SolverWorker));
+	if (workers == NULL)
+	{
+		freeSolver(&solver);
+		return POSTERIOR_MEMORY_ERROR;
+	}
+	for (i = 0; i < threads; i++)
+	{
+		workers[i].solver = &solver;
+		workers[i].capacity = MEMO_INITIAL_CAPACITY;
+		workers[i].entries = (MemoEntry *) calloc(MEMO_INITIAL_CAPACITY, sizeof(MemoEntry));
+		workers[i].status = workers[i].entries == NULL ? POSTERIOR_MEMORY_ERROR : POSTERIOR_OK;
+		workers[i].started = -1;
+		if (workers[i].status == POSTERIOR_OK && i > 0)
+		{
+			workers[i].started = pthread_create(&workers[i].thread, NULL, solverMain, &workers[i]);
+			workers[i].status = workers[i].started == 0 ? POSTERIOR_OK : POSTERIOR_MEMORY_ERROR;
+		}
+	}
+	if (threads > 0 && workers[0].status == POSTERIOR_OK)
+	{
+		solverMain(&workers[0]);
+	}
+	for (i = 0; i < threads; i++)
+	{
+		if (workers[i].started == 0)
+		{
+			pthread_join(workers[i].thread, NULL);
+		}
+		status = status == POSTERIOR_OK ? workers[i].status : status;
+		posterior->total += workers[i].total;
+		for (row = 0; row < query->size; row++)
+		{
+			for (col = 0; col < query->size; col++)
+			{
+				posterior->cells[row][col] += workers[i].cells[row][col];
+			}
+		}
+		free(workers[i].entries);
+	}
+	free(workers);
+	freeSolver(&solver);
+	posterior->states = atomic_load(&solver.states);
+	posterior->states = posterior->states < POSTERIOR_MAX_STATES ? posterior->states :
+						POSTERIOR_MAX_STATES;
+	if (status == POSTERIOR_OK && posterior->total <= 0.0)
+	{
+		status = POSTERIOR_INCONSISTENT;
+	}
+	for (row = 0; row < query->size && status == POSTERIOR_OK; row++)
+	{
+		for (col = 0; col < query->size; col++)
+		{
+			posterior->cells[row][col] /= posterior->total;
+		}
+	}
+	return status;
+}
@@ -0,0 +1,157 @@
+/**
+ * @file posterior.h
+ * @version 2.0
+ *
+ * @brief The exact probability of every cell to hold a ship, given the shots of a game so far.
+ *
+ * @section DESCRIPTION
+ * The solver enumerates every layout of the fleet consistent with the observations: no ship on
+ * a miss, every hit covered, every sunk ship entirely hit and of the reported length, and no
+ * other ship entirely hit. By default every layout is weighted by the probability that the
+ * placement of battleships.c produces it (every ship takes one of its free slots uniformly, in
+ * fleet order), so the result is the true posterior of a game of this engine. In uniform mode
+ * every layout counts once. The order of the shots is not used.
+ * The ships are placed in fleet order by backtracking over bitboards. The number of completions
+ * of a partial layout only depends on the next ship and the cells taken, so it is memoized on
+ * (ship index, occupancy), and a second pass pushes the weight of every partial layout forward
+ * to sum, for every placement, the weight of the layouts using it. The last two ships are
+ * counted together without a memo entry, the last ship from the free starts of the layout
+ * before them, unless ships of the same length come first and the layouts of the ship before
+ * the last are reached in several orders.
+ * The cost is the number of partial layouts visited, the last ship excluded, which falls quickly as
+ * the shots rule placements out. A query visits at most POSTERIOR_MAX_STATES of them, all the
+ * threads together. The placements of the first ship are shared between the threads and every
+ * thread keeps its own memo, so the layouts the memos share are visited once per thread and a query
+ * near the limit may need fewer threads. The number is estimated before solving, and a query
+ * estimated well over the limit is POSTERIOR_TOO_LARGE at once. On a 10x10 board with the classic
+ * fleet, a query 12 or more shots into a game of the density shooter takes under half a second of a
+ * single core, a query near the limit under a second, and an earlier query usually fails within a
+ * millisecond.
+ */
+#ifndef POSTERIOR_H_
+#define POSTERIOR_H_
+
+// ------------------------------ includes ------------------------------
+#include "battleships.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def POSTERIOR_MAX_SHIPS 16
+ * @brief The maximal number of ships of a fleet the solver accepts.
+ */
+#define POSTERIOR_MAX_SHIPS 16
+
+/**
+ * @def POSTERIOR_MAX_STATES 4194304
+ * @brief The maximal number of partial layouts a query visits, all the threads together.
+ */
+#define POSTERIOR_MAX_STATES (1 << 22)
+
+/**
+ * @def POSTERIOR_OK 0
+ * @brief The posterior was computed.
+ */
+#define POSTERIOR_OK 0
+
+/**
+ * @def POSTERIOR_INCONSISTENT 1
+ * @brief No layout of the fleet is consistent with the observations.
+ */
+#define POSTERIOR_INCONSISTENT 1
+
+/**
+ * @def POSTERIOR_TOO_LARGE 2
+ * @brief The query has too many partial layouts (an early game on a large board), or too many
+ * ships.
+ */
+#define POSTERIOR_TOO_LARGE 2
+
+/**
+ * @def POSTERIOR_MEMORY_ERROR 3
+ * @brief The solver could not allocate its memory or start its threads.
+ */
+#define POSTERIOR_MEMORY_ERROR 3
+
+// ------------------------------ structs ----------------------------
+
+/**
+ * a structure describing a sunk ship as the player learns it. includes the following
+ * attributes:
+ * row - the row of the shot that sunk it.
+ * col - the column of the shot that sunk it.
+ * length - the length of the ship.
+ */
+typedef struct SunkShip
+{
+	int row;
+	int col;
+	int length;
+} SunkShip;
+
+/**
+ * a structure holding the observations of a game. includes the following attributes:
+ * size - the board size.
+ * fleet - the fleet placed on the board.
+ * uniform - non zero to count every consistent layout once, zero to weight the layouts by the
+ * probability of the placement.
+ * misses - the shots that hit no ship.
+ * hits - the shots that hit a ship, sunk or not.
+ * sunkNum - the number of sunk ships.
+ * sunk - the sunk ships.
+ */
+typedef struct PosteriorQuery
+{
+	int size;
+	const Fleet *fleet;
+	int uniform;
+	Bitboard misses;
+	Bitboard hits;
+	int sunkNum;
+	SunkShip sunk[POSTERIOR_MAX_SHIPS];
+} PosteriorQuery;
+
+/**
+ * a structure holding the result of a query. includes the following attributes:
+ * total - the total weight of the consistent layouts (their number in uniform mode).
+ * states - the number of partial layouts visited, at most POSTERIOR_MAX_STATES.
+ * cells - the probability of every cell to hold a ship.
+ */
+typedef struct Posterior
+{
+	double total;
+	long states;
+	double cells[BITBOARD_MAX_SIZE][BITBOARD_MAX_SIZE];
+} Posterior;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Starts the observations of a new game, with no shots.
+ * @param query The observations.
+ * @param size The board size.
+ * @param fleet The fleet, it must outlive the query.
+ * @param uniform Non zero to count every consistent layout once.
+ */
+void posteriorReset(PosteriorQuery *query, int size, const Fleet *fleet, int uniform);
+
+/**
+ * @brief Adds the result of a shot to the observations.
+ * @param query The observations.
+ * @param row The row of the shot.
+ * @param col The column of the shot.
+ * @param result The shot result, as returned by fireShot.
+ * @param sunkLength The length of the sunk ship if the shot sunk one.
+ */
+void posteriorObserve(PosteriorQuery *query, int row, int col, int result, int sunkLength);
+
+/**
+ * @brief Computes the probability of every cell to hold a ship.
+ * @param query The observations.
+ * @param threads The number of threads sharing the placements of the first ship.
+ * @param posterior Filled with the result.
+ * @return POSTERIOR_OK, POSTERIOR_INCONSISTENT, POSTERIOR_TOO_LARGE or POSTERIOR_MEMORY_ERROR.
+ */
+int solvePosterior(const PosteriorQuery *query, int threads, Posterior *posterior);
+
+#endif /* POSTERIOR_H_ */
@@ -0,0 +1,378 @@
+/**
+ * @file renderer.c
+ * @version 2.0
+ *
+ * @brief Drawing the player's view of the board with a single write per frame.
+ *
+ * @section DESCRIPTION
+ * A frame is built row by row from the shots and hits masks straight into the buffer, with no
+ * formatted output calls. In diff mode the first frame clears the screen, draws the board at the
+ * top and limits the scrolling region to the lines below it. A later frame XORs the masks with
+ * the ones of the last frame, and for every changed cell saves the cursor, moves it to the cell,
+ * draws it and restores the cursor.
+ */
+// ------------------------------ includes ------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "renderer.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def EMPTY_CELL '_'
+ * @brief An empty cell in the board.
+ */
+#define EMPTY_CELL '_'
+
+/**
+ * @def MISS_CELL 'o'
+ * @brief A mark for a shot that missed, as printed to the player.
+ */
+#define MISS_CELL 'o'
+
+/**
+ * @def HIT_CELL 'x'
+ * @brief A mark for a shot that hit a ship, as printed to the player.
+ */
+#define HIT_CELL 'x'
+
+/**
+ * @def START_LETTER 97
+ * @brief The first letter to be printed in the boar's row indexes.
+ */
+#define START_LETTER 97
+
+/**
+ * @def CELL_UPDATE_LENGTH 16
+ * @brief The maximal length of the escape sequences drawing a single changed cell.
+ */
+#define CELL_UPDATE_LENGTH 16
+
+/**
+ * @def SETUP_LENGTH 64
+ * @brief The maximal length of the escape sequences around a full frame in diff mode.
+ */
+#define SETUP_LENGTH 64
+
+/**
+ * @def CLEAR_SCREEN "\033[H\033[2J"
+ * @brief Moves the cursor home and clears the screen.
+ */
+#define CLEAR_SCREEN "\033[H\033[2J"
+
+/**
+ * @def SAVE_CURSOR "\0337"
+ * @brief Saves the cursor position.
+ */
+#define SAVE_CURSOR "\0337"
+
+/**
+ * @def RESTORE_CURSOR "\0338"
+ * @brief Restores the saved cursor position.
+ */
+#define RESTORE_CURSOR "\0338"
+
+/**
+ * @def RESET_SCROLL_REGION "\033[r"
+ * @brief Lets the whole screen scroll again.
+ */
+#define RESET_SCROLL_REGION "\033[r"
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Appends a string to a buffer.
+ * @param out The end of the buffer.
+ * @param str The string.
+ * @return The new end of the buffer.
+ */
+static char *appendString(char *out, const char *str)
+{
+	size_t length = strlen(str);
+	memcpy(out, str, length);
+	return out + length;
+}
+
+/**
+ * @brief Appends the decimal digits of a non negative number to a buffer.
+ * @param out The end of the buffer.
+ * @param value The number.
+ * @return The new end of the buffer.
+ */
+static char *appendNumber(char *out, int value)
+{
+	char digits[12];
+	int count = 0;
+	do
+	{
+		digits[count++] = (char) ('0' + value % 10);
+		value /= 10;
+	} while (value > 0);
+	while (count > 0)
+	{
+		*out++ = digits[--count];
+	}
+	return out;
+}
+
+/**
+ * @brief Returns the mark of a cell as printed to the player.
+ * @param shots The shots row.
+ * @param hits The hits row.
+ * @param col The column of the cell.
+ * @return The cell mark.
+ */
+static char cellMark(uint32_t shots, uint32_t hits, int col)
+{
+	if ((hits >> col) & 1U)
+	{
+		return HIT_CELL;
+	}
+	return ((shots >> col) & 1U) ? MISS_CELL : EMPTY_CELL;
+}
+
+/**
+ * @brief Writes a full frame of the board, in the format of printBoard, to a buffer.
+ * @param out The buffer, at least FRAME_MAX_LENGTH bytes.
+ * @param board The board.
+ * @param size The board size, a constant in every kernel.
+ * @return The length of the frame.
+ */
+BITBOARD_KERNEL size_t formatFrameSized(char *out, const Board *board, int size)
+{
+	char *end = out;
+	uint32_t shots, hits;
+	int i, j;
+	for (i = 0; i < size; i++)
+	{
+		*end++ = ',';
+		end = appendNumber(end, i + 1);
+	}
+	*end++ = '\n';
+	for (i = 0; i < size; i++)
+	{
+		shots = bbRow(&board->shots, i);
+		hits = bbRow(&board->hits, i);
+		*end++ = (char) (START_LETTER + i);
+		for (j = 0; j < size; j++)
+		{
+			*end++ = ' ';
+			*end++ = cellMark(shots, hits, j);
+		}
+		*end++ = '\n';
+	}
+	return (size_t) (end - out);
+}
+
+/**
+ * @def DEFINE_FRAME_KERNEL(size)
+ * @brief Defines the frame kernel of a single board size.
+ */
+#define DEFINE_FRAME_KERNEL(size) \
+	static size_t formatFrame##size(char *out, const Board *board) \
+	{ \
+		return formatFrameSized(out, board, size); \
+	}
+
+BITBOARD_KERNEL_SIZES(DEFINE_FRAME_KERNEL)
+
+/**
+ * @brief The frame kernel of the board sizes with no kernel of their own.
+ * @param out The buffer, at least FRAME_MAX_LENGTH bytes.
+ * @param board The board.
+ * @return The length of the frame.
+ */
+static size_t formatFrameAnySize(char *out, const Board *board)
+{
+	return formatFrameSized(out, board, board->size);
+}
+
+/**
+ * @def FRAME_KERNEL_ENTRY(size)
+ * @brief The dispatch table entry of a single board size.
+ */
+#define FRAME_KERNEL_ENTRY(size) formatFrame##size,
+
+/**
+ * The frame kernels of every board size from BITBOARD_MIN_KERNEL_SIZE to BITBOARD_MAX_SIZE.
+ */
+static size_t (*const FRAME_KERNELS[])(char *out, const Board *board) =
+		{BITBOARD_KERNEL_SIZES(FRAME_KERNEL_ENTRY)};
+
+/**
+ * @brief Returns the frame kernel of a board size.
+ * @param size The board size.
+ * @return The kernel.
+ */
+static size_t (*frameKernel(int size))(char *out, const Board *board)
+{
+	if (size < BITBOARD_MIN_KERNEL_SIZE || size > BITBOARD_MAX_SIZE)
+	{
+		return formatFrameAnySize;
+	}
+	return FRAME_KERNELS[size - BITBOARD_MIN_KERNEL_SIZE];
+}
+
+/**
+ * @brief Writes a full frame of the board, in the format of printBoard, to a buffer.
+ * @param out The buffer, at least FRAME_MAX_LENGTH bytes.
+ * @param board The board.
+ * @return The length of the frame.
+ */
+size_t formatFrame(char *out, const Board *board)
+{
+	return frameKernel(board->size)(out, board);
+}
+
+/**
+ * @brief Creates a renderer for boards of the given size.
+ * @param size The board size.
+ * @param diffMode Non zero to draw only the changed cells after the first frame.
+ * @return The new renderer, NULL if the allocation failed.
+ */
+Renderer *newRenderer(int size, int diffMode)
+{
+	Renderer *renderer = (Renderer *) malloc(sizeof(Renderer));
+	if (renderer == NULL)
+	{
+		return NULL;
+	}
+	renderer->size = size;
+	renderer->formatFrame = frameKernel(size);
+	renderer->diffMode = diffMode;
+	renderer->drawn = 0;
+	renderer->length = 0;
+	renderer->capacity = FRAME_MAX_LENGTH + SETUP_LENGTH +
+						 (size_t) size * (size_t) size * CELL_UPDATE_LENGTH;
+	renderer->buffer = (char *) malloc(renderer->capacity);
+	if (renderer->buffer == NULL)
+	{
+		free(renderer);
+		return NULL;
+	}
+	return renderer;
+}
+
+/**
+ * @brief Builds a diff frame, drawing only the cells changed since the last frame.
+ * @param renderer The renderer.
+ * @param board The board.
+ * @return The new end of the buffer.
+ */
+static char *renderChanges(Renderer *renderer, const Board *board)
+{
+	char *end = renderer->buffer;
+	uint32_t shots, hits, changed;
+	int i, j;
+	for (i = 0; i < renderer->size; i++)
+	{
+		shots = bbRow(&board->shots, i);
+		hits = bbRow(&board->hits, i);
+		changed = (shots ^ bbRow(&renderer->lastShots, i)) | (hits ^ bbRow(&renderer->lastHits, i));
+		while (changed != 0)
+		{
+			j = __builtin_ctz(changed);
+			changed &= changed - 1;
+			end = appendString(end, SAVE_CURSOR "\033[");
+			end = appendNumber(end, i + 2);
+			*end++ = ';';
+			end = appendNumber(end, 2 * j + 3);
+			*end++ = 'H';
+			*end++ = cellMark(shots, hits, j);
+			end = appendString(end, RESTORE_CURSOR);
+		}
+	}
+	return end;
+}
+
+/**
+ * @brief Builds the next frame of the board in the renderer buffer, without writing it.
+ * @param renderer The renderer.
+ * @param board The board.
+ * @return The length of the frame.
+ */
+size_t renderFrame(Renderer *renderer, const Board *board)
+{
+	char *end = renderer->buffer;
+	if (!renderer->diffMode)
+	{
+		renderer->length = renderer->formatFrame(end, board);
+		return renderer->length;
+	}
+	if (renderer->drawn)
+	{
+		end = renderChanges(renderer, board);
+	}
+	else
+	{
+		end = appendString(end, CLEAR_SCREEN);
+		end += renderer->formatFrame(end, board);
+		end = appendString(end, "\033[");
+		end = appendNumber(end, renderer->size + 2);
+		end = appendString(end, "r\033[");
+		end = appendNumber(end, renderer->size + 2);
+		end = appendString(end, ";1H");
+		renderer->drawn = 1;
+	}
+	renderer->lastShots = board->shots;
+	renderer->lastHits = board->hits;
+	renderer->length = (size_t) (end - renderer->buffer);
+	return renderer->length;
+}
+
+/**
+ * @brief Writes a whole buffer to a file descriptor.
+ * @param fd The file descriptor.
+ * @param buffer The buffer.
+ * @param length The length of the buffer.
+ */
+static void writeAll(int fd, const char *buffer, size_t length)
+{
+	ssize_t written;
+	while (length > 0)
+	{
+		written = write(fd, buffer, length);
+		if (written <= 0)
+		{
+			return;
+		}
+		buffer += written;
+		length -= (size_t) written;
+	}
+}
+
+/**
+ * @brief Builds the next frame of the board and writes it to a file descriptor with a single
+ * write. The standard output is flushed first, so the frame follows the messages printed before.
+ * @param renderer The renderer.
+ * @param board The board.
+ * @param fd The file descriptor.
+ */
+void renderBoard(Renderer *renderer, const Board *board, int fd)
+{
+	renderFrame(renderer, board);
+	fflush(stdout);
+	writeAll(fd, renderer->buffer, renderer->length);
+}
+
+/**
+ * @brief Gives the terminal back (the whole screen scrolls again) and frees the renderer.
+ * @param renderer The renderer.
+ * @param fd The file descriptor the renderer wrote to.
+ */
+void closeRenderer(Renderer *renderer, int fd)
+{
+	if (renderer == NULL)
+	{
+		return;
+	}
+	if (renderer->diffMode && renderer->drawn)
+	{
+		fflush(stdout);
+		writeAll(fd, RESET_SCROLL_REGION, strlen(RESET_SCROLL_REGION));
+	}
+	free(renderer->buffer);
+	free(renderer);
+}
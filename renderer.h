@@ -0,0 +1,97 @@
+/**
+ * @file renderer.h
+ * @version 2.0
+ *
+ * @brief Drawing the player's view of the board with a single write per frame.
+ *
+ * @section DESCRIPTION
+ * A renderer builds every frame in one reusable buffer and writes it with a single system call.
+ * In diff mode the board is drawn once at the top of the terminal, the lines below it scroll
+ * the game messages, and every later frame only moves the cursor (ANSI escape sequences) to the
+ * cells that changed since the last frame.
+ */
+#ifndef RENDERER_H_
+#define RENDERER_H_
+
+// ------------------------------ includes ------------------------------
+#include <stddef.h>
+#include "battleships.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def FRAME_MAX_LENGTH 1536
+ * @brief The maximal length of a full frame (the header and the rows of the largest board).
+ */
+#define FRAME_MAX_LENGTH 1536
+
+// ------------------------------ structs ----------------------------
+
+/**
+ * a structure describing a board renderer. includes the following attributes:
+ * size - the board size.
+ * formatFrame - writes a full frame, compiled for the board size.
+ * diffMode - non zero if only the changed cells are drawn after the first frame.
+ * drawn - non zero once the first frame was drawn in diff mode.
+ * lastShots - the shots drawn in the last frame.
+ * lastHits - the hits drawn in the last frame.
+ * length - the length of the frame in the buffer.
+ * capacity - the size of the buffer.
+ * buffer - the frame buffer.
+ */
+typedef struct Renderer
+{
+	int size;
+	size_t (*formatFrame)(char *out, const Board *board);
+	int diffMode;
+	int drawn;
+	Bitboard lastShots;
+	Bitboard lastHits;
+	size_t length;
+	size_t capacity;
+	char *buffer;
+} Renderer;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Writes a full frame of the board, in the format of printBoard, to a buffer.
+ * @param out The buffer, at least FRAME_MAX_LENGTH bytes.
+ * @param board The board.
+ * @return The length of the frame.
+ */
+size_t formatFrame(char *out, const Board *board);
+
+/**
+ * @brief Creates a renderer for boards of the given size.
+ * @param size The board size.
+ * @param diffMode Non zero to draw only the changed cells after the first frame.
+ * @return The new renderer, NULL if the allocation failed.
+ */
+Renderer *newRenderer(int size, int diffMode);
+
+/**
+ * @brief Builds the next frame of the board in the renderer buffer, without writing it.
+ * @param renderer The renderer.
+ * @param board The board.
+ * @return The length of the frame.
+ */
+size_t renderFrame(Renderer *renderer, const Board *board);
+
+/**
+ * @brief Builds the next frame of the board and writes it to a file descriptor with a single
+ * write. The standard output is flushed first, so the frame follows the messages printed before.
+ * @param renderer The renderer.
+ * @param board The board.
+ * @param fd The file descriptor.
+ */
+void renderBoard(Renderer *renderer, const Board *board, int fd);
+
+/**
+ * @brief Gives the terminal back (the whole screen scrolls again) and frees the renderer.
+ * @param renderer The renderer.
+ * @param fd The file descriptor the renderer wrote to.
+ */
+void closeRenderer(Renderer *renderer, int fd);
+
+#endif /* RENDERER_H_ */
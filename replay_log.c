@@ -0,0 +1,330 @@
+/**
+ * @file replay_log.c
+ * @version 2.0
+ *
+ * @brief A compact, append only binary log of complete games.
+ *
+ * @section DESCRIPTION
+ * A writer packs the games into a block buffer and writes every full block with a single
+ * write. The log is opened with O_APPEND, so the blocks of several writers sharing it never
+ * interleave. A reader maps the whole log and walks it in place, without copying or parsing
+ * any text.
+ */
+// ------------------------------ includes ------------------------------
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "replay_log.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def FNV_OFFSET 2166136261
+ * @brief The initial value of the FNV-1a hash.
+ */
+#define FNV_OFFSET 2166136261U
+
+/**
+ * @def FNV_PRIME 16777619
+ * @brief The multiplier of the FNV-1a hash.
+ */
+#define FNV_PRIME 16777619U
+
+/**
+ * @def LOG_MODE 0644
+ * @brief The permissions of a new log.
+ */
+#define LOG_MODE 0644
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Stores a number in little endian order.
+ * @param out The bytes.
+ * @param value The number.
+ * @param bytes The number of bytes.
+ */
+static void putNumber(unsigned char *out, uint64_t value, int bytes)
+{
+	int i;
+	for (i = 0; i < bytes; i++)
+	{
+		out[i] = (unsigned char) (value >> (8 * i));
+	}
+}
+
+/**
+ * @brief Loads a number stored in little endian order.
+ * @param in The bytes.
+ * @param bytes The number of bytes.
+ * @return The number.
+ */
+static uint64_t getNumber(const unsigned char *in, int bytes)
+{
+	uint64_t value = 0;
+	int i;
+	for (i = bytes - 1; i >= 0; i--)
+	{
+		value = (value << 8) | in[i];
+	}
+	return value;
+}
+
+/**
+ * @brief Computes the FNV-1a hash of a buffer.
+ * @param data The buffer.
+ * @param length The buffer size.
+ * @return The hash.
+ */
+static uint32_t checksum(const unsigned char *data, size_t length)
+{
+	uint32_t hash = FNV_OFFSET;
+	size_t i;
+	for (i = 0; i < length; i++)
+	{
+		hash = (hash ^ data[i]) * FNV_PRIME;
+	}
+	return hash;
+}
+
+/**
+ * @brief Opens a log for appending, creating it if needed.
+ * @param path The log path.
+ * @return The file descriptor, -1 on failure.
+ */
+int openLog(const char *path)
+{
+	return open(path, O_WRONLY | O_CREAT | O_APPEND, LOG_MODE);
+}
+
+/**
+ * @brief Creates a writer appending blocks to an open log.
+ * @param fd The log file descriptor, from openLog.
+ * @return The new writer, NULL if the allocation failed.
+ */
+LogWriter *newLogWriter(int fd)
+{
+	LogWriter *writer = (LogWriter *) malloc(sizeof(LogWriter));
+	if (writer == NULL)
+	{
+		return NULL;
+	}
+	writer->fd = fd;
+	writer->length = 0;
+	writer->games = 0;
+	return writer;
+}
+
+/**
+ * @brief Writes the games in the writer as one block, with a single write.
+ * @param writer The writer.
+ * @return 0 on success, LOG_ERROR if the block could not be written.
+ */
+int flushLog(LogWriter *writer)
+{
+	unsigned char *header = writer->buffer;
+	size_t total = LOG_HEADER_SIZE + writer->length;
+	if (writer->games == 0)
+	{
+		return 0;
+	}
+	putNumber(header, LOG_MAGIC, 4);
+	putNumber(header + 4, LOG_VERSION, 2);
+	putNumber(header + 6, 0, 2);
+	putNumber(header + 8, writer->length, 4);
+	putNumber(header + 12, writer->games, 4);
+	putNumber(header + 16, checksum(header + LOG_HEADER_SIZE, writer->length), 4);
+	writer->length = 0;
+	writer->games = 0;
+	return write(writer->fd, header, total) == (ssize_t) total ? 0 : LOG_ERROR;
+}
+
+/**
+ * @brief Adds a finished game to the writer, writing the current block first if the game does
+ * not fit in it.
+ * @param writer The writer.
+ * @param seed The master seed of the batch.
+ * @param index The index of the game in the batch.
+ * @param game The game, with its fleet.
+ * @param moves The (row, col) byte pairs of the shots, in order.
+ * @param shotsNum The number of shots.
+ * @return 0 on success, LOG_ERROR if a block could not be written.
+ */
+int logGame(LogWriter *writer, uint64_t seed, uint32_t index, const Game *game,
+			const unsigned char *moves, int shotsNum)
+{
+	size_t size = LOG_GAME_HEADER_SIZE + (size_t) game->shipsNum * LOG_SHIP_SIZE +
+				  (size_t) shotsNum * LOG_SHOT_SIZE;
+	unsigned char *out;
+	int i;
+	if (writer->length + size > LOG_BLOCK_PAYLOAD && flushLog(writer) != 0)
+	{
+		return LOG_ERROR;
+	}
+	out = writer->buffer + LOG_HEADER_SIZE + writer->length;
+	putNumber(out, seed, 8);
+	putNumber(out + 8, index, 4);
+	out[12] = (unsigned char) game->board.size;
+	out[13] = 0;
+	putNumber(out + 14, (uint64_t) game->shipsNum, 2);
+	putNumber(out + 16, (uint64_t) shotsNum, 2);
+	out += LOG_GAME_HEADER_SIZE;
+	for (i = 0; i < game->shipsNum; i++, out += LOG_SHIP_SIZE)
+	{
+		out[0] = game->ships.row[i];
+		out[1] = game->ships.col[i];
+		out[2] = game->ships.length[i];
+		out[3] = game->ships.angle[i];
+	}
+	for (i = 0; i < shotsNum * LOG_SHOT_SIZE; i++)
+	{
+		out[i] = moves[i];
+	}
+	writer->length += size;
+	writer->games++;
+	return 0;
+}
+
+/**
+ * @brief Writes the last block of a writer and frees it. The log itself stays open.
+ * @param writer The writer.
+ * @return 0 on success, LOG_ERROR if the last block could not be written.
+ */
+int closeLogWriter(LogWriter *writer)
+{
+	int status;
+	if (writer == NULL)
+	{
+		return 0;
+	}
+	status = flushLog(writer);
+	free(writer);
+	return status;
+}
+
+/**
+ * @brief Maps a whole log to memory for reading.
+ * @param path The log path.
+ * @param log Filled with the mapping.
+ * @return 0 on success, LOG_ERROR otherwise.
+ */
+int mapLog(const char *path, LogFile *log)
+{
+	struct stat info;
+	void *data;
+	int fd = open(path, O_RDONLY);
+	log->data = NULL;
+	log->length = 0;
+	if (fd < 0)
+	{
+		return LOG_ERROR;
+	}
+	if (fstat(fd, &info) != 0)
+	{
+		close(fd);
+		return LOG_ERROR;
+	}
+	if (info.st_size == 0)
+	{
+		close(fd);
+		return 0;
+	}
+	data = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+	{
+		return LOG_ERROR;
+	}
+	madvise(data, (size_t) info.st_size, MADV_SEQUENTIAL);
+	log->data = (const unsigned char *) data;
+	log->length = (size_t) info.st_size;
+	return 0;
+}
+
+/**
+ * @brief Unmaps a log mapped by mapLog.
+ * @param log The mapped log.
+ */
+void unmapLog(LogFile *log)
+{
+	if (log->data != NULL)
+	{
+		munmap((void *) log->data, log->length);
+	}
+	log->data = NULL;
+	log->length = 0;
+}
+
+/**
+ * @brief Reads the block at an offset of a mapped log and checks its checksum.
+ * @param log The mapped log.
+ * @param offset The block offset, advanced to the next block.
+ * @param block Filled with the block.
+ * @return LOG_BLOCK_OK, LOG_BLOCK_CORRUPT, LOG_BLOCK_END or LOG_BLOCK_TRUNCATED.
+ */
+int readBlock(const LogFile *log, size_t *offset, LogBlock *block)
+{
+	const unsigned char *header = log->data + *offset;
+	size_t left = log->length - *offset;
+	if (left == 0)
+	{
+		return LOG_BLOCK_END;
+	}
+	if (left < LOG_HEADER_SIZE || getNumber(header, 4) != LOG_MAGIC ||
+		getNumber(header + 4, 2) != LOG_VERSION)
+	{
+		return LOG_BLOCK_TRUNCATED;
+	}
+	block->length = (size_t) getNumber(header + 8, 4);
+	block->games = (uint32_t) getNumber(header + 12, 4);
+	block->payload = header + LOG_HEADER_SIZE;
+	if (block->length > left - LOG_HEADER_SIZE)
+	{
+		return LOG_BLOCK_TRUNCATED;
+	}
+	*offset += LOG_HEADER_SIZE + block->length;
+	if (checksum(block->payload, block->length) != (uint32_t) getNumber(header + 16, 4))
+	{
+		return LOG_BLOCK_CORRUPT;
+	}
+	return LOG_BLOCK_OK;
+}
+
+/**
+ * @brief Reads the game at an offset of a block payload.
+ * @param block The block.
+ * @param offset The game offset in the payload, advanced to the next game.
+ * @param game Filled with the game.
+ * @return 1 if a game was read, 0 at the end of the payload, -1 if the game does not fit the
+ * payload.
+ */
+int readGame(const LogBlock *block, size_t *offset, LogGame *game)
+{
+	const unsigned char *in = block->payload + *offset;
+	size_t left = block->length - *offset, size;
+	if (left == 0)
+	{
+		return 0;
+	}
+	if (left < LOG_GAME_HEADER_SIZE)
+	{
+		return -1;
+	}
+	game->seed = getNumber(in, 8);
+	game->index = (uint32_t) getNumber(in + 8, 4);
+	game->size = in[12];
+	game->shipsNum = (int) getNumber(in + 14, 2);
+	game->shotsNum = (int) getNumber(in + 16, 2);
+	size = LOG_GAME_HEADER_SIZE + (size_t) game->shipsNum * LOG_SHIP_SIZE +
+		   (size_t) game->shotsNum * LOG_SHOT_SIZE;
+	if (size > left)
+	{
+		return -1;
+	}
+	game->ships = in + LOG_GAME_HEADER_SIZE;
+	game->shots = game->ships + (size_t) game->shipsNum * LOG_SHIP_SIZE;
+	*offset += size;
+	return 1;
+}
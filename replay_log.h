@@ -0,0 +1,249 @@
+/**
+ * @file replay_log.h
+ * @version 2.0
+ *
+ * @brief A compact, append only binary log of complete games.
+ *
+ * @section DESCRIPTION
+ * A log is a sequence of independent blocks, so logs can be appended to and concatenated. Every
+ * block starts with a LOG_HEADER_SIZE bytes header (all numbers little endian):
+ *   magic (4 bytes) - LOG_MAGIC.
+ *   version (2 bytes) - LOG_VERSION.
+ *   flags (2 bytes) - reserved, 0.
+ *   length (4 bytes) - the number of payload bytes after the header.
+ *   games (4 bytes) - the number of games in the payload.
+ *   checksum (4 bytes) - the FNV-1a hash of the payload.
+ * The payload holds the games one after the other:
+ *   seed (8 bytes) - the master seed of the batch the game was played in.
+ *   index (4 bytes) - the index of the game in its batch.
+ *   size (1 byte) - the board size.
+ *   reserved (1 byte) - 0.
+ *   ships (2 bytes) - the number of ships.
+ *   shots (2 bytes) - the number of shots.
+ *   one (row, col, length, angle) byte quadruple for every ship.
+ *   one (row, col) byte pair for every shot.
+ */
+#ifndef REPLAY_LOG_H_
+#define REPLAY_LOG_H_
+
+// ------------------------------ includes ------------------------------
+#include <stddef.h>
+#include <stdint.h>
+#include "battleships.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def LOG_MAGIC 0x474c5342
+ * @brief The first bytes of every block ("BSLG").
+ */
+#define LOG_MAGIC 0x474c5342U
+
+/**
+ * @def LOG_VERSION 2
+ * @brief The version of the block format (version 2 counts the ships of a game in 2 bytes).
+ */
+#define LOG_VERSION 2
+
+/**
+ * @def LOG_HEADER_SIZE 20
+ * @brief The size of a block header.
+ */
+#define LOG_HEADER_SIZE 20
+
+/**
+ * @def LOG_GAME_HEADER_SIZE 18
+ * @brief The size of the fixed part of a game record.
+ */
+#define LOG_GAME_HEADER_SIZE 18
+
+/**
+ * @def LOG_SHIP_SIZE 4
+ * @brief The size of a ship in a game record.
+ */
+#define LOG_SHIP_SIZE 4
+
+/**
+ * @def LOG_SHOT_SIZE 2
+ * @brief The size of a shot in a game record.
+ */
+#define LOG_SHOT_SIZE 2
+
+/**
+ * @def LOG_BLOCK_PAYLOAD 65536
+ * @brief The payload size a writer fills before it writes a block.
+ */
+#define LOG_BLOCK_PAYLOAD 65536
+
+/**
+ * @def LOG_ERROR 4
+ * @brief the integer returned if the log could not be written or read.
+ */
+#define LOG_ERROR 4
+
+/**
+ * @def LOG_BLOCK_OK 0
+ * @brief A block was read and its checksum matches.
+ */
+#define LOG_BLOCK_OK 0
+
+/**
+ * @def LOG_BLOCK_CORRUPT 1
+ * @brief A block was read but its checksum does not match, its games must not be used.
+ */
+#define LOG_BLOCK_CORRUPT 1
+
+/**
+ * @def LOG_BLOCK_END 2
+ * @brief No block is left.
+ */
+#define LOG_BLOCK_END 2
+
+/**
+ * @def LOG_BLOCK_TRUNCATED 3
+ * @brief The rest of the log is not a whole block, the reading stops.
+ */
+#define LOG_BLOCK_TRUNCATED 3
+
+// ------------------------------ structs ----------------------------
+
+/**
+ * a structure collecting games into blocks and appending them to a log. includes the following
+ * attributes:
+ * fd - the log file descriptor, opened with O_APPEND so writers may share it.
+ * length - the payload bytes in the buffer.
+ * games - the number of games in the buffer.
+ * buffer - the block being built, header first.
+ */
+typedef struct LogWriter
+{
+	int fd;
+	size_t length;
+	uint32_t games;
+	unsigned char buffer[LOG_HEADER_SIZE + LOG_BLOCK_PAYLOAD];
+} LogWriter;
+
+/**
+ * a structure describing a log mapped to memory. includes the following attributes:
+ * data - the log bytes.
+ * length - the log size.
+ */
+typedef struct LogFile
+{
+	const unsigned char *data;
+	size_t length;
+} LogFile;
+
+/**
+ * a structure describing a block of a mapped log. includes the following attributes:
+ * payload - the games of the block.
+ * length - the payload size.
+ * games - the number of games in the block.
+ */
+typedef struct LogBlock
+{
+	const unsigned char *payload;
+	size_t length;
+	uint32_t games;
+} LogBlock;
+
+/**
+ * a structure describing a game read from a block, pointing into the mapped log. includes the
+ * following attributes:
+ * seed - the master seed of the batch the game was played in.
+ * index - the index of the game in its batch.
+ * size - the board size.
+ * shipsNum - the number of ships.
+ * shotsNum - the number of shots.
+ * ships - the (row, col, length, angle) quadruples of the ships.
+ * shots - the (row, col) pairs of the shots.
+ */
+typedef struct LogGame
+{
+	uint64_t seed;
+	uint32_t index;
+	int size;
+	int shipsNum;
+	int shotsNum;
+	const unsigned char *ships;
+	const unsigned char *shots;
+} LogGame;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Opens a log for appending, creating it if needed.
+ * @param path The log path.
+ * @return The file descriptor, -1 on failure.
+ */
+int openLog(const char *path);
+
+/**
+ * @brief Creates a writer appending blocks to an open log.
+ * @param fd The log file descriptor, from openLog.
+ * @return The new writer, NULL if the allocation failed.
+ */
+LogWriter *newLogWriter(int fd);
+
+/**
+ * @brief Adds a finished game to the writer, writing the current block first if the game does
+ * not fit in it.
+ * @param writer The writer.
+ * @param seed The master seed of the batch.
+ * @param index The index of the game in the batch.
+ * @param game The game, with its fleet.
+ * @param moves The (row, col) byte pairs of the shots, in order.
+ * @param shotsNum The number of shots.
+ * @return 0 on success, LOG_ERROR if a block could not be written.
+ */
+int logGame(LogWriter *writer, uint64_t seed, uint32_t index, const Game *game,
+			const unsigned char *moves, int shotsNum);
+
+/**
+ * @brief Writes the games in the writer as one block, with a single write.
+ * @param writer The writer.
+ * @return 0 on success, LOG_ERROR if the block could not be written.
+ */
+int flushLog(LogWriter *writer);
+
+/**
+ * @brief Writes the last block of a writer and frees it. The log itself stays open.
+ * @param writer The writer.
+ * @return 0 on success, LOG_ERROR if the last block could not be written.
+ */
+int closeLogWriter(LogWriter *writer);
+
+/**
+ * @brief Maps a whole log to memory for reading.
+ * @param path The log path.
+ * @param log Filled with the mapping.
+ * @return 0 on success, LOG_ERROR otherwise.
+ */
+int mapLog(const char *path, LogFile *log);
+
+/**
+ * @brief Unmaps a log mapped by mapLog.
+ * @param log The mapped log.
+ */
+void unmapLog(LogFile *log);
+
+/**
+ * @brief Reads the block at an offset of a mapped log and checks its checksum.
+ * @param log The mapped log.
+ * @param offset The block offset, advanced to the next block.
+ * @param block Filled with the block.
+ * @return LOG_BLOCK_OK, LOG_BLOCK_CORRUPT, LOG_BLOCK_END or LOG_BLOCK_TRUNCATED.
+ */
+int readBlock(const LogFile *log, size_t *offset, LogBlock *block);
+
+/**
+ * @brief Reads the game at an offset of a block payload.
+ * @param block The block.
+ * @param offset The game offset in the payload, advanced to the next game.
+ * @param game Filled with the game.
+ * @return 1 if a game was read, 0 at the end of the payload, -1 if the game does not fit the
+ * payload.
+ */
+int readGame(const LogBlock *block, size_t *offset, LogGame *game);
+
+#endif /* REPLAY_LOG_H_ */
@@ -0,0 +1,105 @@
+/**
+ * @file rng.c
+ * @version 2.0
+ *
+ * @brief A small, seedable pseudo random number generator (xoshiro256**).
+ *
+ * @section DESCRIPTION
+ * The state is filled from the seed and the stream index with splitmix64, as recommended by
+ * the xoshiro authors. Bounded integers use a multiply and shift with a rejection step, so they
+ * are exactly uniform.
+ */
+// ------------------------------ includes ------------------------------
+#include "rng.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def GOLDEN_GAMMA 0x9e3779b97f4a7c15
+ * @brief The splitmix64 increment, also used to spread the stream indexes.
+ */
+#define GOLDEN_GAMMA 0x9e3779b97f4a7c15ULL
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Advances a splitmix64 state and returns its next output.
+ * @param x The splitmix64 state.
+ * @return The next output.
+ */
+static uint64_t splitMix64(uint64_t *x)
+{
+	uint64_t z = (*x += GOLDEN_GAMMA);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+/**
+ * @brief Rotates a word to the left.
+ * @param x The word.
+ * @param k The number of bits to rotate by.
+ * @return The rotated word.
+ */
+static inline uint64_t rotl(uint64_t x, int k)
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * @brief Seeds a generator. Different streams of the same seed give unrelated numbers.
+ * @param rng The generator.
+ * @param seed The seed.
+ * @param stream The stream index.
+ */
+void rngSeed(Rng *rng, uint64_t seed, uint64_t stream)
+{
+	uint64_t x = seed, mix;
+	int i;
+	mix = splitMix64(&x);
+	x ^= mix + stream * GOLDEN_GAMMA;
+	for (i = 0; i < 4; i++)
+	{
+		rng->state[i] = splitMix64(&x);
+	}
+}
+
+/**
+ * @brief Returns the next 64 random bits.
+ * @param rng The generator.
+ * @return The random bits.
+ */
+uint64_t rngNext(Rng *rng)
+{
+	uint64_t *s = rng->state;
+	uint64_t result = rotl(s[1] * 5, 7) * 9;
+	uint64_t t = s[1] << 17;
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rotl(s[3], 45);
+	return result;
+}
+
+/**
+ * @brief Returns a uniformly random integer lower then a bound.
+ * @param rng The generator.
+ * @param bound The bound, bigger then 0.
+ * @return The random integer, between 0 and bound - 1.
+ */
+uint32_t rngBelow(Rng *rng, uint32_t bound)
+{
+	uint64_t product = (rngNext(rng) >> 32) * bound;
+	uint32_t threshold;
+	if ((uint32_t) product < bound)
+	{
+		threshold = -bound % bound;
+		while ((uint32_t) product < threshold)
+		{
+			product = (rngNext(rng) >> 32) * bound;
+		}
+	}
+	return (uint32_t) (product >> 32);
+}
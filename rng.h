@@ -0,0 +1,53 @@
+/**
+ * @file rng.h
+ * @version 2.0
+ *
+ * @brief A small, seedable pseudo random number generator (xoshiro256**).
+ *
+ * @section DESCRIPTION
+ * Every generator keeps its own state, so each thread or each batch of games can own an
+ * independent stream, and the same seed always gives the same numbers.
+ */
+#ifndef RNG_H_
+#define RNG_H_
+
+// ------------------------------ includes ------------------------------
+#include <stdint.h>
+
+// ------------------------------ structs ----------------------------
+
+/**
+ * a structure holding the state of a random numbers generator.
+ * state - the xoshiro256** state, never all zero.
+ */
+typedef struct Rng
+{
+	uint64_t state[4];
+} Rng;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Seeds a generator. Different streams of the same seed give unrelated numbers.
+ * @param rng The generator.
+ * @param seed The seed.
+ * @param stream The stream index.
+ */
+void rngSeed(Rng *rng, uint64_t seed, uint64_t stream);
+
+/**
+ * @brief Returns the next 64 random bits.
+ * @param rng The generator.
+ * @return The random bits.
+ */
+uint64_t rngNext(Rng *rng);
+
+/**
+ * @brief Returns a uniformly random integer lower then a bound.
+ * @param rng The generator.
+ * @param bound The bound, bigger then 0.
+ * @return The random integer, between 0 and bound - 1.
+ */
+uint32_t rngBelow(Rng *rng, uint32_t bound);
+
+#endif /* RNG_H_ */
@@ -0,0 +1,77 @@
+/**
+ * @file shot_messages.h
+ * @version 2.0
+ *
+ * @brief The messages answering the moves of a player, shared by the console and the server.
+ */
+#ifndef SHOT_MESSAGES_H_
+#define SHOT_MESSAGES_H_
+
+// ------------------------------ includes ------------------------------
+#include "battleships.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def SUNK_MESSAGE "Hit and sunk.\n"
+ * @brief the message answering a shot that hit a ship and made her sunk.
+ */
+#define SUNK_MESSAGE "Hit and sunk.\n"
+
+/**
+ * @def HIT_MESSAGE "Hit!\n"
+ * @brief the message answering a shot that hit a ship.
+ */
+#define HIT_MESSAGE "Hit!\n"
+
+/**
+ * @def ALREADY_HIT_MESSAGE "Already been Hit.\n"
+ * @brief the message answering a shot at a cell the player already shot.
+ */
+#define ALREADY_HIT_MESSAGE "Already been Hit.\n"
+
+/**
+ * @def INVALID_MOVE_MESSAGE "invalid Move, try again\n"
+ * @brief the message answering an invalid move.
+ */
+#define INVALID_MOVE_MESSAGE "invalid Move, try again\n"
+
+/**
+ * @def MISS_MESSAGE "Miss\n"
+ * @brief the message answering a shot that did not hit a ship.
+ */
+#define MISS_MESSAGE "Miss\n"
+
+/**
+ * @def GAME_OVER_MESSAGE "Game over\n"
+ * @brief the message following the answer to the shot sinking the last ship.
+ */
+#define GAME_OVER_MESSAGE "Game over\n"
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Returns the message answering a shot.
+ * @param result The shot result, as returned by fireShot or shoot.
+ * @return The message.
+ */
+static inline const char *shotMessage(int result)
+{
+	if (SHOT_IS_SUNK(result))
+	{
+		return SUNK_MESSAGE;
+	}
+	switch (result)
+	{
+		case SHOT_MISS:
+			return MISS_MESSAGE;
+		case SHOT_HIT:
+			return HIT_MESSAGE;
+		case SHOT_ALREADY:
+			return ALREADY_HIT_MESSAGE;
+		default:
+			return INVALID_MOVE_MESSAGE;
+	}
+}
+
+#endif /* SHOT_MESSAGES_H_ */
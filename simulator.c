@@ -0,0 +1,474 @@
+/**
+ * @file simulator.c
+ * @version 2.0
+ *
+ * @brief Plays complete games between a built in shooter and a random fleet, without printing.
+ *
+ * @section DESCRIPTION
+ * Every game places a new random fleet on a cleared board and lets the shooter fire until the
+ * whole fleet is sunk. Nothing is printed during the games, the caller gets the number of shots
+ * every game took.
+ * A batch is split to chunks of games. Chunk i always draws its numbers from stream i of the
+ * master seed, whichever worker plays it, and the statistics are sums, so merging the workers
+ * results gives the same numbers for any number of threads and any schedule.
+ * In batch mode every worker keeps GAME_BATCH_LANES games in play and fires one shot in all of
+ * them per step, loading the next game of its chunks into a lane as soon as the lane's game
+ * ends. Game i then draws its numbers from stream i of the master seed, so batch results depend
+ * only on the master seed too, but differ from the results of the one game at a time mode.
+ */
+// ------------------------------ includes ------------------------------
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include "game_batch.h"
+#include "game_pool.h"
+#include "monotonic.h"
+#include "replay_log.h"
+#include "simulator.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def  TRUE 1
+ * @brief a true boolean value.
+ */
+#define TRUE 1
+
+/**
+ * @def MEMORY_ERROR 2
+ * @brief the integer returned if one of the pointers is NULL .
+ */
+#define MEMORY_ERROR 2
+
+/**
+ * @def CACHE_LINE 64
+ * @brief The size of a cache line, keeping the work queues of different workers apart.
+ */
+#define CACHE_LINE 64
+
+// ------------------------------ structs ----------------------------
+
+/**
+ * a structure holding the chunks of work of a single worker. includes the following attributes:
+ * next - the next chunk to take, advanced by the owner and by the thieves alike.
+ * end - the first chunk after the worker's share.
+ */
+typedef struct WorkQueue
+{
+	_Alignas(CACHE_LINE) atomic_long next;
+	long end;
+} WorkQueue;
+
+/**
+ * a structure describing a worker thread. includes the following attributes:
+ * config - the batch description.
+ * queues - the work queues of all the workers.
+ * index - the index of the worker.
+ * count - the number of workers.
+ * stats - the statistics of the games the worker played.
+ * log - the writer of the worker's replay log blocks, NULL for no log.
+ * moves - the shots of the current game, kept for the log.
+ * next - the next game to load into the batch (batch mode).
+ * end - the first game after the chunk being loaded into the batch (batch mode).
+ * status - 0 on success, MEMORY_ERROR or LOG_ERROR if the worker failed.
+ * started - non zero if the worker runs on its own thread, which must be joined.
+ * thread - the worker thread.
+ */
+typedef struct Worker
+{
+	const SimConfig *config;
+	WorkQueue *queues;
+	int index;
+	int count;
+	SimStats stats;
+	LogWriter *log;
+	unsigned char moves[2 * MAX_GAME_SHOTS];
+	long next;
+	long end;
+	int status;
+	int started;
+	pthread_t thread;
+} Worker;
+
+/**
+ * a structure describing the game in play in a lane of a batch. includes the following
+ * attributes:
+ * rng - the random numbers generator of the game.
+ * shooter - the shooter of the game.
+ * game - the game block, NULL while the lane is idle.
+ * index - the index of the game in the simulation batch.
+ * shots - the number of shots fired so far.
+ * moves - the shots fired so far, kept for the log.
+ */
+typedef struct Lane
+{
+	Rng rng;
+	Shooter shooter;
+	Game *game;
+	long index;
+	int shots;
+	unsigned char moves[2 * MAX_GAME_SHOTS];
+} Lane;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Plays a single game with a placed fleet and no shots, until every ship is sunk.
+ * @param game The game.
+ * @param shooter The shooter, reset for the board.
+ * @param moves Filled with the (row, col) byte pair of every shot, NULL if not needed.
+ * @return The number of shots the shooter needed to win.
+ */
+int playGame(Game *game, Shooter *shooter, unsigned char *moves)
+{
+	int row, col, result, shots = 0;
+	while (game->deadShips < game->shipsNum && shots < MAX_GAME_SHOTS)
+	{
+		shooterNextShot(shooter, &row, &col);
+		if (moves != NULL)
+		{
+			moves[2 * shots] = (unsigned char) row;
+			moves[2 * shots + 1] = (unsigned char) col;
+		}
+		result = fireShot(game, row, col);
+		if (SHOT_IS_SUNK(result))
+		{
+			shooterObserve(shooter, row, col, SHOT_SUNK,
+						   game->ships.length[SHOT_SUNK_SHIP(result)]);
+		}
+		else
+		{
+			shooterObserve(shooter, row, col, result, 0);
+		}
+		shots++;
+	}
+	return shots;
+}
+
+/**
+ * @brief Adds the statistics of one batch to another.
+ * @param total The statistics to add to.
+ * @param part The statistics to add.
+ */
+void mergeStats(SimStats *total, const SimStats *part)
+{
+	int i;
+	total->games += part->games;
+	total->shots += part->shots;
+	for (i = 0; i <= MAX_GAME_SHOTS; i++)
+	{
+		total->histogram[i] += part->histogram[i];
+	}
+}
+
+/**
+ * @brief Takes the next chunk of work, first from the worker's own queue and then from the
+ * queues of the other workers.
+ * @param worker The worker.
+ * @return The chunk index, -1 if no work is left.
+ */
+static long takeChunk(Worker *worker)
+{
+	int i;
+	long chunk;
+	WorkQueue *queue;
+	for (i = 0; i < worker->count; i++)
+	{
+		queue = &worker->queues[(worker->index + i) % worker->count];
+		if (atomic_load_explicit(&queue->next, memory_order_relaxed) >= queue->end)
+		{
+			continue;
+		}
+		chunk = atomic_fetch_add_explicit(&queue->next, 1, memory_order_relaxed);
+		if (chunk < queue->end)
+		{
+			return chunk;
+		}
+	}
+	return -1;
+}
+
+/**
+ * @brief Plays the games of a single chunk.
+ * @param worker The worker.
+ * @param chunk The chunk index.
+ * @param pool The worker's pool of games.
+ * @param shooter A shooter to play with.
+ * @return 0 on success, MEMORY_ERROR if the fleet could not be placed, LOG_ERROR if the log
+ * could not be written.
+ */
+static int playChunk(Worker *worker, long chunk, GamePool *pool, Shooter *shooter)
+{
+	const SimConfig *config = worker->config;
+	long game = chunk * SIM_CHUNK_GAMES, end = game + SIM_CHUNK_GAMES;
+	Game *state;
+	Rng rng;
+	int shots;
+	rngSeed(&rng, config->seed, (uint64_t) chunk);
+	if (end > config->games)
+	{
+		end = config->games;
+	}
+	for (; game < end; game++)
+	{
+		state = poolAcquire(pool, &rng);
+		if (state == NULL)
+		{
+			return MEMORY_ERROR;
+		}
+		shooterReset(shooter, config->strategy, config->boardSize, config->fleet, &rng);
+		shots = playGame(state, shooter, worker->log != NULL ? worker->moves : NULL);
+		if (worker->log != NULL &&
+			logGame(worker->log, config->seed, (uint32_t) game, state, worker->moves, shots) != 0)
+		{
+			poolRelease(pool, state);
+			return LOG_ERROR;
+		}
+		poolRelease(pool, state);
+		worker->stats.games++;
+		worker->stats.shots += shots;
+		worker->stats.histogram[shots]++;
+	}
+	return 0;
+}
+
+/**
+ * @brief Loads the next game of the worker into an idle lane of its batch, taking a new chunk
+ * when the current one is all loaded.
+ * @param worker The worker.
+ * @param pool The worker's pool of games.
+ * @param batch The worker's batch.
+ * @param index The index of the lane.
+ * @param lane The lane.
+ * @return 0 on success or if no work is left (the lane stays idle), MEMORY_ERROR if the fleet
+ * could not be placed.
+ */
+static int fillLane(Worker *worker, GamePool *pool, GameBatch *batch, int index, Lane *lane)
+{
+	const SimConfig *config = worker->config;
+	long chunk;
+	lane->game = NULL;
+	if (worker->next >= worker->end)
+	{
+		chunk = takeChunk(worker);
+		if (chunk < 0)
+		{
+			return 0;
+		}
+		worker->next = chunk * SIM_CHUNK_GAMES;
+		worker->end = worker->next + SIM_CHUNK_GAMES;
+		worker->end = worker->end > config->games ? config->games : worker->end;
+	}
+	lane->index = worker->next++;
+	rngSeed(&lane->rng, config->seed, (uint64_t) lane->index);
+	lane->game = poolAcquire(pool, &lane->rng);
+	if (lane->game == NULL)
+	{
+		return MEMORY_ERROR;
+	}
+	shooterReset(&lane->shooter, config->strategy, config->boardSize, config->fleet, &lane->rng);
+	lane->shots = 0;
+	batchLoad(batch, index, lane->game);
+	return 0;
+}
+
+/**
+ * @brief Records a game that left its lane and returns its block to the pool.
+ * @param worker The worker.
+ * @param pool The worker's pool of games.
+ * @param lane The lane.
+ * @return 0 on success, LOG_ERROR if the log could not be written.
+ */
+static int finishLane(Worker *worker, GamePool *pool, Lane *lane)
+{
+	int status = 0;
+	if (worker->log != NULL && logGame(worker->log, worker->config->seed, (uint32_t) lane->index,
+									   lane->game, lane->moves, lane->shots) != 0)
+	{
+		status = LOG_ERROR;
+	}
+	poolRelease(pool, lane->game);
+	lane->game = NULL;
+	worker->stats.games++;
+	worker->stats.shots += lane->shots;
+	worker->stats.histogram[lane->shots]++;
+	return status;
+}
+
+/**
+ * @brief Plays all the games left for the worker, GAME_BATCH_LANES at once: every step asks
+ * the shooter of every lane for a shot, fires all of them with one batch step and refills the
+ * lanes whose games ended.
+ * @param worker The worker.
+ * @param pool The worker's pool of games, with a block for every lane.
+ * @return 0 on success, MEMORY_ERROR if an allocation failed or the fleet could not be placed,
+ * LOG_ERROR if the log could not be written.
+ */
+static int playBatch(Worker *worker, GamePool *pool)
+{
+	GameBatch *batch = newGameBatch(worker->config->boardSize);
+	Lane *lanes = (Lane *) malloc(GAME_BATCH_LANES * sizeof(Lane)), *lane;
+	uint32_t rows[GAME_BATCH_LANES], cols[GAME_BATCH_LANES], results[GAME_BATCH_LANES];
+	uint32_t playing, finished;
+	int l, row, col, status = 0;
+	if (batch == NULL || lanes == NULL)
+	{
+		freeGameBatch(batch);
+		free(lanes);
+		return MEMORY_ERROR;
+	}
+	for (l = 0; l < GAME_BATCH_LANES && status == 0; l++)
+	{
+		status = fillLane(worker, pool, batch, l, &lanes[l]);
+	}
+	while (status == 0 && batch->active != 0)
+	{
+		playing = batch->active;
+		for (l = 0, lane = lanes; l < GAME_BATCH_LANES; l++, lane++)
+		{
+			rows[l] = 0;
+			cols[l] = 0;
+			if (playing & (1U << l))
+			{
+				shooterNextShot(&lane->shooter, &row, &col);
+				rows[l] = (uint32_t) row;
+				cols[l] = (uint32_t) col;
+				lane->moves[2 * lane->shots] = (unsigned char) row;
+				lane->moves[2 * lane->shots + 1] = (unsigned char) col;
+				lane->shots++;
+			}
+		}
+		finished = batchStep(batch, rows, cols, results);
+		for (l = 0, lane = lanes; l < GAME_BATCH_LANES && status == 0; l++, lane++)
+		{
+			if (!(playing & (1U << l)))
+			{
+				continue;
+			}
+			if (SHOT_IS_SUNK(results[l]))
+			{
+				shooterObserve(&lane->shooter, (int) rows[l], (int) cols[l], SHOT_SUNK,
+							   lane->game->ships.length[SHOT_SUNK_SHIP(results[l])]);
+			}
+			else
+			{
+				shooterObserve(&lane->shooter, (int) rows[l], (int) cols[l], (int) results[l], 0);
+			}
+			if (!(finished & (1U << l)) && lane->shots < MAX_GAME_SHOTS)
+			{
+				continue;
+			}
+			if (!(finished & (1U << l)))
+			{
+				batchDrop(batch, l);
+			}
+			status = finishLane(worker, pool, lane);
+			if (status == 0)
+			{
+				status = fillLane(worker, pool, batch, l, lane);
+			}
+		}
+	}
+	for (l = 0; l < GAME_BATCH_LANES; l++)
+	{
+		if (lanes[l].game != NULL)
+		{
+			poolRelease(pool, lanes[l].game);
+		}
+	}
+	freeGameBatch(batch);
+	free(lanes);
+	return status;
+}
+
+/**
+ * @brief The body of a worker thread, playing chunks until no work is left. Everything the
+ * worker needs is allocated once, the games themselves make no allocator calls.
+ * @param arg The worker.
+ * @return NULL.
+ */
+static void *workerMain(void *arg)
+{
+	Worker *worker = (Worker *) arg;
+	GamePool *pool = newGamePool(worker->config->boardSize, worker->config->fleet,
+								 worker->config->batch ? GAME_BATCH_LANES : 1);
+	Shooter *shooter = (Shooter *) malloc(sizeof(Shooter));
+	long chunk;
+	worker->log = worker->config->logFd >= 0 ? newLogWriter(worker->config->logFd) : NULL;
+	worker->status = (pool == NULL || shooter == NULL ||
+					  (worker->config->logFd >= 0 && worker->log == NULL) ||
+					  poolUseWeights(pool, worker->config->weights) != TRUE) ? MEMORY_ERROR : 0;
+	if (worker->status == 0 && worker->config->batch)
+	{
+		worker->status = playBatch(worker, pool);
+	}
+	while (worker->status == 0 && !worker->config->batch && (chunk = takeChunk(worker)) >= 0)
+	{
+		worker->status = playChunk(worker, chunk, pool, shooter);
+	}
+	if (closeLogWriter(worker->log) != 0 && worker->status == 0)
+	{
+		worker->status = LOG_ERROR;
+	}
+	freeGamePool(pool);
+	free(shooter);
+	return NULL;
+}
+
+/**
+ * @brief Plays a batch of games on all the worker threads and gathers their statistics.
+ * The games are split to chunks of SIM_CHUNK_GAMES, each worker plays its own share of chunks
+ * and then steals chunks from the others. The results depend only on the master seed.
+ * @param config The batch description.
+ * @param stats Filled with the batch results.
+ * @return 0 on success, MEMORY_ERROR (2) if an allocation failed or the fleet could not be placed
+ * (or drawn from the weighted placement table), LOG_ERROR (4) if the replay log could not be
+ * written.
+ */
+int runSimulation(const SimConfig *config, SimStats *stats)
+{
+	int i, status = 0, count = config->threads;
+	long chunks = (config->games + SIM_CHUNK_GAMES - 1) / SIM_CHUNK_GAMES;
+	double start = monotonicSeconds();
+	WorkQueue *queues;
+	Worker *workers;
+	memset(stats, 0, sizeof(SimStats));
+	count = count < 1 ? 1 : (count > MAX_SIM_THREADS ? MAX_SIM_THREADS : count);
+	queues = (WorkQueue *) aligned_alloc(CACHE_LINE, count * sizeof(WorkQueue));
+	workers = (Worker *) calloc(count, sizeof(Worker));
+	if (queues == NULL || workers == NULL)
+	{
+		free(queues);
+		free(workers);
+		return MEMORY_ERROR;
+	}
+	for (i = 0; i < count; i++)
+	{
+		atomic_init(&queues[i].next, chunks * i / count);
+		queues[i].end = chunks * (i + 1) / count;
+		workers[i].config = config;
+		workers[i].queues = queues;
+		workers[i].index = i;
+		workers[i].count = count;
+	}
+	for (i = 1; i < count; i++)
+	{
+		workers[i].started = pthread_create(&workers[i].thread, NULL, workerMain,
+											&workers[i]) == 0;
+	}
+	workerMain(&workers[0]);
+	for (i = 0; i < count; i++)
+	{
+		if (workers[i].started)
+		{
+			pthread_join(workers[i].thread, NULL);
+		}
+		status = workers[i].status != 0 ? workers[i].status : status;
+		mergeStats(stats, &workers[i].stats);
+	}
+	stats->seconds = monotonicSeconds() - start;
+	free(queues);
+	free(workers);
+	return status;
+}
@@ -0,0 +1,107 @@
+/**
+ * @file simulator.h
+ * @version 2.0
+ *
+ * @brief Plays complete games between a built in shooter and a random fleet, without printing.
+ */
+#ifndef SIMULATOR_H_
+#define SIMULATOR_H_
+
+// ------------------------------ includes ------------------------------
+#include "strategies.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def SIM_CHUNK_GAMES 64
+ * @brief The number of games in a chunk of work. Every chunk has its own random stream, so the
+ * results do not depend on the thread playing it.
+ */
+#define SIM_CHUNK_GAMES 64
+
+/**
+ * @def MAX_SIM_THREADS 256
+ * @brief The maximal number of worker threads of a simulation.
+ */
+#define MAX_SIM_THREADS 256
+
+/**
+ * @def MAX_GAME_SHOTS 676
+ * @brief The maximal number of shots a game can take (every cell of the largest board).
+ */
+#define MAX_GAME_SHOTS (BITBOARD_MAX_SIZE * BITBOARD_MAX_SIZE)
+
+// ------------------------------ structs ----------------------------
+
+/**
+ * a structure describing a simulation batch. includes the following attributes:
+ * boardSize - the board size of every game.
+ * games - the number of games to play.
+ * strategy - the strategy of the shooter.
+ * fleet - the fleet placed in every game.
+ * seed - the master seed of the random numbers.
+ * threads - the number of worker threads.
+ * logFd - the replay log every game is appended to (see replay_log.h), -1 for no log.
+ * batch - non zero to play GAME_BATCH_LANES games at once on every worker (see game_batch.h).
+ * weights - the weighted placement table the fleets are drawn from (see fleet_weights.h), NULL
+ * for the uniform placement.
+ */
+typedef struct SimConfig
+{
+	int boardSize;
+	long games;
+	const ShooterStrategy *strategy;
+	const Fleet *fleet;
+	uint64_t seed;
+	int threads;
+	int logFd;
+	int batch;
+	const FleetWeights *weights;
+} SimConfig;
+
+/**
+ * a structure holding the results of a simulation batch. includes the following attributes:
+ * games - the number of games played.
+ * shots - the total number of shots fired.
+ * histogram - the number of games won after every possible number of shots.
+ * seconds - the wall clock time the batch took.
+ */
+typedef struct SimStats
+{
+	long games;
+	long shots;
+	long histogram[MAX_GAME_SHOTS + 1];
+	double seconds;
+} SimStats;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Plays a single game with a placed fleet and no shots, until every ship is sunk.
+ * @param game The game.
+ * @param shooter The shooter, reset for the board.
+ * @param moves Filled with the (row, col) byte pair of every shot, NULL if not needed.
+ * @return The number of shots the shooter needed to win.
+ */
+int playGame(Game *game, Shooter *shooter, unsigned char *moves);
+
+/**
+ * @brief Adds the statistics of one batch to another.
+ * @param total The statistics to add to.
+ * @param part The statistics to add.
+ */
+void mergeStats(SimStats *total, const SimStats *part);
+
+/**
+ * @brief Plays a batch of games on all the worker threads and gathers their statistics.
+ * The games are split to chunks of SIM_CHUNK_GAMES, each worker plays its own share of chunks
+ * and then steals chunks from the others. The results depend only on the master seed.
+ * @param config The batch description.
+ * @param stats Filled with the batch results.
+ * @return 0 on success, MEMORY_ERROR (2) if an allocation failed or the fleet could not be placed
+ * (or drawn from the weighted placement table), LOG_ERROR (4) if the replay log could not be
+ * written.
+ */
+int runSimulation(const SimConfig *config, SimStats *stats);
+
+#endif /* SIMULATOR_H_ */
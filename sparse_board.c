@@ -0,0 +1,433 @@
+/**
+ * @file sparse_board.c
+ * @version 2.0
+ *
+ * @brief Boards far larger than a bitboard, with memory growing only with the ships and shots.
+ *
+ * @section DESCRIPTION
+ * Both spatial indexes are open addressing hash tables with linear probing, keyed by a non zero
+ * 64 bit number built from the coordinates and grown to twice their size when half full. A ship
+ * is placed by drawing a uniformly random in bounds slot and drawing again while it touches
+ * another ship, which keeps the choice uniform among the free slots.
+ */
+// ------------------------------ includes ------------------------------
+#include <stdlib.h>
+#include <string.h>
+#include "sparse_board.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def  TRUE 1
+ * @brief a true boolean value.
+ */
+#define TRUE 1
+
+/**
+ * @def FALSE -1
+ * @brief a false boolean value.
+ */
+#define FALSE (-1)
+
+/**
+ * @def INITIAL_CAPACITY 64
+ * @brief The initial number of slots of a hash table and of ships of a board.
+ */
+#define INITIAL_CAPACITY 64
+
+/**
+ * @def MAX_PLACE_ATTEMPTS 1000
+ * @brief The number of random slots drawn for a ship before giving up.
+ */
+#define MAX_PLACE_ATTEMPTS 1000
+
+/**
+ * @def HASH_MULTIPLIER 0x9e3779b97f4a7c15
+ * @brief The multiplier spreading the keys over the hash table slots.
+ */
+#define HASH_MULTIPLIER 0x9e3779b97f4a7c15ULL
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Prepares an empty hash table.
+ * @param index The table.
+ * @param valueSize The size of a value.
+ * @return 0 on success, FALSE if the allocation failed.
+ */
+static int initIndex(SparseIndex *index, size_t valueSize)
+{
+	index->valueSize = valueSize;
+	index->count = 0;
+	index->capacity = INITIAL_CAPACITY;
+	index->keys = (uint64_t *) calloc(INITIAL_CAPACITY, sizeof(uint64_t));
+	index->values = (unsigned char *) calloc(INITIAL_CAPACITY, valueSize);
+	return (index->keys == NULL || index->values == NULL) ? FALSE : 0;
+}
+
+/**
+ * @brief Returns the first slot to probe for a key.
+ * @param index The table.
+ * @param key The key.
+ * @return The slot.
+ */
+static size_t firstSlot(const SparseIndex *index, uint64_t key)
+{
+	uint64_t hash = key * HASH_MULTIPLIER;
+	return (size_t) (hash ^ (hash >> 32)) & (index->capacity - 1);
+}
+
+/**
+ * @brief Finds the value of a key.
+ * @param index The table.
+ * @param key The key, not 0.
+ * @return The value, NULL if the key is not in the table.
+ */
+static void *findValue(const SparseIndex *index, uint64_t key)
+{
+	size_t slot = firstSlot(index, key);
+	while (index->keys[slot] != 0)
+	{
+		if (index->keys[slot] == key)
+		{
+			return index->values + slot * index->valueSize;
+		}
+		slot = (slot + 1) & (index->capacity - 1);
+	}
+	return NULL;
+}
+
+/**
+ * @brief Doubles the number of slots of a table and moves every key to its new slot.
+ * @param index The table.
+ * @return 0 on success, FALSE if the allocation failed (the table is then unchanged).
+ */
+static int growIndex(SparseIndex *index)
+{
+	SparseIndex grown = *index;
+	size_t i, slot;
+	grown.capacity = index->capacity * 2;
+	grown.keys = (uint64_t *) calloc(grown.capacity, sizeof(uint64_t));
+	grown.values = (unsigned char *) calloc(grown.capacity, grown.valueSize);
+	if (grown.keys == NULL || grown.values == NULL)
+	{
+		free(grown.keys);
+		free(grown.values);
+		return FALSE;
+	}
+	for (i = 0; i < index->capacity; i++)
+	{
+		if (index->keys[i] == 0)
+		{
+			continue;
+		}
+		slot = firstSlot(&grown, index->keys[i]);
+		while (grown.keys[slot] != 0)
+		{
+			slot = (slot + 1) & (grown.capacity - 1);
+		}
+		grown.keys[slot] = index->keys[i];
+		memcpy(grown.values + slot * grown.valueSize, index->values + i * index->valueSize,
+			   index->valueSize);
+	}
+	free(index->keys);
+	free(index->values);
+	*index = grown;
+	return 0;
+}
+
+/**
+ * @brief Finds the value of a key, adding the key with a zeroed value if it is not in the table.
+ * @param index The table.
+ * @param key The key, not 0.
+ * @return The value, NULL if the allocation failed.
+ */
+static void *insertValue(SparseIndex *index, uint64_t key)
+{
+	size_t slot;
+	void *value = findValue(index, key);
+	if (value != NULL)
+	{
+		return value;
+	}
+	if (2 * (index->count + 1) > index->capacity && growIndex(index) != 0)
+	{
+		return NULL;
+	}
+	slot = firstSlot(index, key);
+	while (index->keys[slot] != 0)
+	{
+		slot = (slot + 1) & (index->capacity - 1);
+	}
+	index->keys[slot] = key;
+	index->count++;
+	return index->values + slot * index->valueSize;
+}
+
+/**
+ * @brief Returns the hash key of the tile holding a cell.
+ * @param row The cell row.
+ * @param col The cell column.
+ * @return The tile key.
+ */
+static uint64_t tileKey(int row, int col)
+{
+	return ((uint64_t) (row / SPARSE_TILE) << 32 | (uint64_t) (col / SPARSE_TILE)) + 1;
+}
+
+/**
+ * @brief Returns the bit of a cell in the masks of its tile.
+ * @param row The cell row.
+ * @param col The cell column.
+ * @return The cell bit.
+ */
+static uint64_t tileBit(int row, int col)
+{
+	return 1ULL << ((row % SPARSE_TILE) * SPARSE_TILE + col % SPARSE_TILE);
+}
+
+/**
+ * @brief Returns the hash key of a cell.
+ * @param board The board.
+ * @param row The cell row.
+ * @param col The cell column.
+ * @return The cell key.
+ */
+static uint64_t cellKey(const SparseBoard *board, int row, int col)
+{
+	return (uint64_t) row * (uint64_t) board->size + (uint64_t) col + 1;
+}
+
+/**
+ * @brief Creates a sparse board with no ships and no shots.
+ * @param size The board size.
+ * @return The new board, NULL if the allocation failed.
+ */
+SparseBoard *newSparseBoard(int size)
+{
+	SparseBoard *board = (SparseBoard *) calloc(1, sizeof(SparseBoard));
+	if (board == NULL)
+	{
+		return NULL;
+	}
+	board->size = size;
+	board->shipsCapacity = INITIAL_CAPACITY;
+	board->ships = (Ship *) malloc(INITIAL_CAPACITY * sizeof(Ship));
+	if (board->ships == NULL || initIndex(&board->tiles, sizeof(SparseTile)) != 0 ||
+		initIndex(&board->cells, sizeof(uint32_t)) != 0)
+	{
+		freeSparseBoard(board);
+		return NULL;
+	}
+	return board;
+}
+
+/**
+ * @brief Checks whether a ship located in the board bounds touches a ship of the board.
+ * @param board The board.
+ * @param ship The ship.
+ * @return TRUE if one of the ship cells is taken, FALSE otherwise.
+ */
+static int isTaken(const SparseBoard *board, const Ship *ship)
+{
+	const SparseTile *tile;
+	int k, row, col;
+	for (k = 0; k < ship->length; k++)
+	{
+		row = ship->row + (ship->angle == VERTICAL ? k : 0);
+		col = ship->col + (ship->angle == HORIZONTAL ? k : 0);
+		tile = (const SparseTile *) findValue(&board->tiles, tileKey(row, col));
+		if (tile != NULL && (tile->ships & tileBit(row, col)))
+		{
+			return TRUE;
+		}
+	}
+	return FALSE;
+}
+
+/**
+ * @brief Adds a free ship to the board and marks its cells in both indexes.
+ * @param board The board.
+ * @param ship The ship.
+ * @return TRUE on success, FALSE if the allocation failed.
+ */
+static int addShip(SparseBoard *board, const Ship *ship)
+{
+	SparseTile *tile;
+	uint32_t *owner;
+	Ship *grown;
+	int k, row, col;
+	if (board->shipsNum == board->shipsCapacity)
+	{
+		grown = (Ship *) realloc(board->ships, 2 * board->shipsCapacity * sizeof(Ship));
+		if (grown == NULL)
+		{
+			return FALSE;
+		}
+		board->ships = grown;
+		board->shipsCapacity *= 2;
+	}
+	for (k = 0; k < ship->length; k++)
+	{
+		row = ship->row + (ship->angle == VERTICAL ? k : 0);
+		col = ship->col + (ship->angle == HORIZONTAL ? k : 0);
+		tile = (SparseTile *) insertValue(&board->tiles, tileKey(row, col));
+		owner = (uint32_t *) insertValue(&board->cells, cellKey(board, row, col));
+		if (tile == NULL || owner == NULL)
+		{
+			return FALSE;
+		}
+		tile->ships |= tileBit(row, col);
+		*owner = (uint32_t) board->shipsNum;
+	}
+	board->ships[board->shipsNum++] = *ship;
+	return TRUE;
+}
+
+/**
+ * @brief Places a ship of the given length at a uniformly random free slot of the board.
+ * @param board The board.
+ * @param length The ship length.
+ * @param rng The random numbers generator.
+ * @return TRUE (1) if the ship was placed, FALSE if no free slot was found or the allocation
+ * failed.
+ */
+int sparsePlaceShip(SparseBoard *board, int length, Rng *rng)
+{
+	Ship ship;
+	int attempt;
+	uint32_t span;
+	if (length < 1 || length > board->size)
+	{
+		return FALSE;
+	}
+	span = (uint32_t) (board->size - length + 1);
+	ship.length = length;
+	ship.lives = length;
+	for (attempt = 0; attempt < MAX_PLACE_ATTEMPTS; attempt++)
+	{
+		ship.angle = (int) rngBelow(rng, 2);
+		if (ship.angle == VERTICAL)
+		{
+			ship.row = (int) rngBelow(rng, span);
+			ship.col = (int) rngBelow(rng, (uint32_t) board->size);
+		}
+		else
+		{
+			ship.row = (int) rngBelow(rng, (uint32_t) board->size);
+			ship.col = (int) rngBelow(rng, span);
+		}
+		if (isTaken(board, &ship) == FALSE)
+		{
+			return addShip(board, &ship);
+		}
+	}
+	return FALSE;
+}
+
+/**
+ * @brief Places copies of a fleet on the board.
+ * @param board The board.
+ * @param fleet The fleet.
+ * @param fleets The number of copies of the fleet.
+ * @param rng The random numbers generator.
+ * @return TRUE (1) if every ship was placed, FALSE otherwise.
+ */
+int sparsePlaceFleets(SparseBoard *board, const Fleet *fleet, int fleets, Rng *rng)
+{
+	int i, copy;
+	for (copy = 0; copy < fleets; copy++)
+	{
+		for (i = 0; i < fleet->shipsNum; i++)
+		{
+			if (sparsePlaceShip(board, fleet->lengths[i], rng) == FALSE)
+			{
+				return FALSE;
+			}
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * @brief Fires a single shot at the board without printing anything.
+ * @param board The board.
+ * @param row The row of the shot.
+ * @param col The column of the shot.
+ * @return SHOT_MISS, SHOT_HIT, SHOT_SUNK_RESULT of the sunk ship index, SHOT_ALREADY if the cell
+ * was already shot and SHOT_INVALID if the cell is out of the board bounds or the allocation
+ * failed.
+ */
+int sparseShoot(SparseBoard *board, int row, int col)
+{
+	SparseTile *tile;
+	Ship *ship;
+	uint64_t bit;
+	if (row < 0 || row >= board->size || col < 0 || col >= board->size)
+	{
+		return SHOT_INVALID;
+	}
+	bit = tileBit(row, col);
+	tile = (SparseTile *) insertValue(&board->tiles, tileKey(row, col));
+	if (tile == NULL)
+	{
+		return SHOT_INVALID;
+	}
+	if (tile->shots & bit)
+	{
+		return SHOT_ALREADY;
+	}
+	tile->shots |= bit;
+	if (!(tile->ships & bit))
+	{
+		return SHOT_MISS;
+	}
+	tile->hits |= bit;
+	ship = &board->ships[*(uint32_t *) findValue(&board->cells, cellKey(board, row, col))];
+	if (--ship->lives > 0)
+	{
+		return SHOT_HIT;
+	}
+	board->deadShips++;
+	return SHOT_SUNK_RESULT((int) (ship - board->ships));
+}
+
+/**
+ * @brief Checks whether every ship of the board was sunk.
+ * @param board The board.
+ * @return TRUE (1) if all the ships are sunk, FALSE otherwise.
+ */
+int sparseGameOver(const SparseBoard *board)
+{
+	return board->deadShips == board->shipsNum ? TRUE : FALSE;
+}
+
+/**
+ * @brief Returns the number of bytes the board holds.
+ * @param board The board.
+ * @return The memory size.
+ */
+size_t sparseMemory(const SparseBoard *board)
+{
+	return sizeof(SparseBoard) + (size_t) board->shipsCapacity * sizeof(Ship) +
+		   board->tiles.capacity * (sizeof(uint64_t) + board->tiles.valueSize) +
+		   board->cells.capacity * (sizeof(uint64_t) + board->cells.valueSize);
+}
+
+/**
+ * @brief Frees a sparse board.
+ * @param board The board.
+ */
+void freeSparseBoard(SparseBoard *board)
+{
+	if (board == NULL)
+	{
+		return;
+	}
+	free(board->ships);
+	free(board->tiles.keys);
+	free(board->tiles.values);
+	free(board->cells.keys);
+	free(board->cells.values);
+	free(board);
+}
@@ -0,0 +1,149 @@
+/**
+ * @file sparse_board.h
+ * @version 2.0
+ *
+ * @brief Boards far larger than a bitboard, with memory growing only with the ships and shots.
+ *
+ * @section DESCRIPTION
+ * A sparse board never allocates its area. The cells are grouped in SPARSE_TILE x SPARSE_TILE
+ * tiles, and only the tiles holding a ship cell or a shot are kept, in a hash table keyed by the
+ * tile coordinates. Each tile holds three bit masks (ships, shots and hits), so placement
+ * collision checks and shot lookups are one or two hash probes. A second hash table maps every
+ * ship cell to the index of its ship, it is only looked up when a shot hits.
+ */
+#ifndef SPARSE_BOARD_H_
+#define SPARSE_BOARD_H_
+
+// ------------------------------ includes ------------------------------
+#include <stddef.h>
+#include <stdint.h>
+#include "battleships.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def SPARSE_MAX_SIZE 1000000
+ * @brief The maximal size (height and width) of a sparse board.
+ */
+#define SPARSE_MAX_SIZE 1000000
+
+/**
+ * @def SPARSE_TILE 8
+ * @brief The height and width of a tile, so a tile mask is a single 64 bit word.
+ */
+#define SPARSE_TILE 8
+
+// ------------------------------ structs ----------------------------
+
+/**
+ * a structure describing the cells of a single tile. includes the following attributes:
+ * ships - the cells taken by the ships, bit 8 * i + j for row i and column j of the tile.
+ * shots - the cells the player already shot at.
+ * hits - the shots that hit a ship.
+ */
+typedef struct SparseTile
+{
+	uint64_t ships;
+	uint64_t shots;
+	uint64_t hits;
+} SparseTile;
+
+/**
+ * a structure describing an open addressing hash table. includes the following attributes:
+ * keys - the keys, 0 for an empty slot.
+ * values - the values, valueSize bytes each.
+ * valueSize - the size of a value.
+ * count - the number of keys in the table.
+ * capacity - the number of slots, a power of two.
+ */
+typedef struct SparseIndex
+{
+	uint64_t *keys;
+	unsigned char *values;
+	size_t valueSize;
+	size_t count;
+	size_t capacity;
+} SparseIndex;
+
+/**
+ * a structure describing a sparse board. includes the following attributes:
+ * size - the board size (as the height and width are equal).
+ * shipsNum - the number of ships on the board.
+ * shipsCapacity - the size of the ships array.
+ * deadShips - the number of sunk ships.
+ * ships - the ships on the board.
+ * tiles - the tiles holding a ship cell or a shot, by tile coordinates.
+ * cells - the index of the ship taking every ship cell, by cell coordinates.
+ */
+typedef struct SparseBoard
+{
+	int size;
+	int shipsNum;
+	int shipsCapacity;
+	int deadShips;
+	Ship *ships;
+	SparseIndex tiles;
+	SparseIndex cells;
+} SparseBoard;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Creates a sparse board with no ships and no shots.
+ * @param size The board size.
+ * @return The new board, NULL if the allocation failed.
+ */
+SparseBoard *newSparseBoard(int size);
+
+/**
+ * @brief Places a ship of the given length at a uniformly random free slot of the board.
+ * @param board The board.
+ * @param length The ship length.
+ * @param rng The random numbers generator.
+ * @return TRUE (1) if the ship was placed, FALSE if no free slot was found or the allocation
+ * failed.
+ */
+int sparsePlaceShip(SparseBoard *board, int length, Rng *rng);
+
+/**
+ * @brief Places copies of a fleet on the board.
+ * @param board The board.
+ * @param fleet The fleet.
+ * @param fleets The number of copies of the fleet.
+ * @param rng The random numbers generator.
+ * @return TRUE (1) if every ship was placed, FALSE otherwise.
+ */
+int sparsePlaceFleets(SparseBoard *board, const Fleet *fleet, int fleets, Rng *rng);
+
+/**
+ * @brief Fires a single shot at the board without printing anything.
+ * @param board The board.
+ * @param row The row of the shot.
+ * @param col The column of the shot.
+ * @return SHOT_MISS, SHOT_HIT, SHOT_SUNK_RESULT of the sunk ship index, SHOT_ALREADY if the cell
+ * was already shot and SHOT_INVALID if the cell is out of the board bounds or the allocation
+ * failed.
+ */
+int sparseShoot(SparseBoard *board, int row, int col);
+
+/**
+ * @brief Checks whether every ship of the board was sunk.
+ * @param board The board.
+ * @return TRUE (1) if all the ships are sunk, FALSE otherwise.
+ */
+int sparseGameOver(const SparseBoard *board);
+
+/**
+ * @brief Returns the number of bytes the board holds.
+ * @param board The board.
+ * @return The memory size.
+ */
+size_t sparseMemory(const SparseBoard *board);
+
+/**
+ * @brief Frees a sparse board.
+ * @param board The board.
+ */
+void freeSparseBoard(SparseBoard *board);
+
+#endif /* SPARSE_BOARD_H_ */
@@ -0,0 +1,482 @@
+/**
+ * @file strategies.c
+ * @version 2.0
+ *
+ * @brief Built in shooters playing the game without a human player.
+ *
+ * @section DESCRIPTION
+ * The shooters available are:
+ * random  - shoots at a uniformly random cell that was not shot yet.
+ * hunt    - shoots randomly until it hits, then shoots the neighbours of every hit.
+ * density - shoots the cell covered by the largest number of placements of the ships still
+ *           afloat, counting only placements through unsunk hits while there are such hits.
+ *           The counters are updated after every shot by a density tracker.
+ * book    - the density strategy, taking its first shots from an opening book (see book.h)
+ *           instead of computing them. The book is mapped once, from the file named by the
+ *           BOOK_PATH_ENV environment variable or DEFAULT_BOOK_PATH, when the first book shooter
+ *           is reset. Without a book, or past it, the strategy is the density strategy.
+ */
+// ------------------------------ includes ------------------------------
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "strategies.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def CELL(row, col)
+ * @brief Packs a cell to a single integer.
+ */
+#define CELL(row, col) ((row) * BITBOARD_ROW_BITS + (col))
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Picks a uniformly random cell among the cells the shooter did not shoot yet.
+ * @param shooter The shooter.
+ * @param row Filled with the row of the shot.
+ * @param col Filled with the column of the shot.
+ * @param size The board size, a constant in every kernel.
+ */
+BITBOARD_KERNEL void randomShotSized(Shooter *shooter, int *row, int *col, int size)
+{
+	uint32_t rowMask = bbRowMask(size), bits;
+	int i, count, rank;
+	rank = (int) rngBelow(shooter->rng,
+						 (uint32_t) (size * size - bbCountRows(&shooter->shots, size)));
+	for (i = 0; i < size; i++)
+	{
+		bits = ~bbRow(&shooter->shots, i) & rowMask;
+		count = __builtin_popcount(bits);
+		if (rank < count)
+		{
+			while (rank-- > 0)
+			{
+				bits &= bits - 1;
+			}
+			*row = i;
+			*col = __builtin_ctz(bits);
+			return;
+		}
+		rank -= count;
+	}
+}
+
+/**
+ * @def DEFINE_RANDOM_SHOT(size)
+ * @brief Defines the random shot kernel of a single board size.
+ */
+#define DEFINE_RANDOM_SHOT(size) \
+	static void randomShot##size(Shooter *shooter, int *row, int *col) \
+	{ \
+		randomShotSized(shooter, row, col, size); \
+	}
+
+BITBOARD_KERNEL_SIZES(DEFINE_RANDOM_SHOT)
+
+/**
+ * @brief The random shot kernel of the board sizes with no kernel of their own.
+ * @param shooter The shooter.
+ * @param row Filled with the row of the shot.
+ * @param col Filled with the column of the shot.
+ */
+static void randomShotAnySize(Shooter *shooter, int *row, int *col)
+{
+	randomShotSized(shooter, row, col, shooter->size);
+}
+
+/**
+ * @def RANDOM_SHOT_ENTRY(size)
+ * @brief The dispatch table entry of a single board size.
+ */
+#define RANDOM_SHOT_ENTRY(size) randomShot##size,
+
+/**
+ * The random shot kernels of every board size from BITBOARD_MIN_KERNEL_SIZE to
+ * BITBOARD_MAX_SIZE.
+ */
+static void (*const RANDOM_SHOTS[])(Shooter *shooter, int *row, int *col) =
+		{BITBOARD_KERNEL_SIZES(RANDOM_SHOT_ENTRY)};
+
+/**
+ * @brief Picks a uniformly random cell among the cells the shooter did not shoot yet, with the
+ * kernel of the board size.
+ * @param shooter The shooter.
+ * @param row Filled with the row of the shot.
+ * @param col Filled with the column of the shot.
+ */
+void randomShot(Shooter *shooter, int *row, int *col)
+{
+	shooter->randomShot(shooter, row, col);
+}
+
+/**
+ * @brief Shoots the neighbours of the hits in the targets stack, and randomly when it is empty.
+ * @param shooter The shooter.
+ * @param row Filled with the row of the shot.
+ * @param col Filled with the column of the shot.
+ */
+void huntShot(Shooter *shooter, int *row, int *col)
+{
+	int cell;
+	while (shooter->targetsNum > 0)
+	{
+		cell = shooter->targets[--shooter->targetsNum];
+		if (!bbTest(&shooter->shots, cell / BITBOARD_ROW_BITS, cell % BITBOARD_ROW_BITS))
+		{
+			*row = cell / BITBOARD_ROW_BITS;
+			*col = cell % BITBOARD_ROW_BITS;
+			return;
+		}
+	}
+	shooter->randomShot(shooter, row, col);
+}
+
+/**
+ * @brief Finds the shot of the density strategy, if it does not have to draw a random cell.
+ * While there are unsunk hits only the placements through them count, if none is left (a sunk
+ * ship was guessed on the wrong cells) all the placements count. The cells of sunk ships do not
+ * block placements, as the shooter can only guess which hits they took.
+ * @param shooter The shooter, reset with the density or the book strategy.
+ * @param row Filled with the row of the shot.
+ * @param col Filled with the column of the shot.
+ * @return The density of the shot cell, 0 if the strategy would draw a random cell.
+ */
+int bestDensityShot(const Shooter *shooter, int *row, int *col)
+{
+	Bitboard open, unshot;
+	int i, best;
+	for (i = 0; i < BITBOARD_WORDS; i++)
+	{
+		open.words[i] = shooter->hits.words[i] & ~shooter->sunk.words[i];
+		unshot.words[i] = ~shooter->shots.words[i];
+	}
+	if (bbCount(&open) > 0 &&
+		(best = trackerBest(&shooter->tracker, &unshot, &open, row, col)) > 0)
+	{
+		return best;
+	}
+	return trackerBest(&shooter->tracker, &unshot, NULL, row, col);
+}
+
+/**
+ * @brief Shoots the unshot cell covered by the largest number of ship placements (see
+ * bestDensityShot), and randomly if no placement is left.
+ * @param shooter The shooter.
+ * @param row Filled with the row of the shot.
+ * @param col Filled with the column of the shot.
+ */
+void densityShot(Shooter *shooter, int *row, int *col)
+{
+	if (bestDensityShot(shooter, row, col) == 0)
+	{
+		shooter->randomShot(shooter, row, col);
+	}
+}
+
+/**
+ * @brief Starts following the density of the whole fleet.
+ * @param shooter The shooter.
+ */
+void densityReset(Shooter *shooter)
+{
+	trackerReset(&shooter->tracker, shooter->size, shooter->remaining, shooter->maxLength);
+}
+
+/**
+ * @brief Updates the density after a shot: a miss removes the placements through it and a sunk
+ * ship removes the weight of its length.
+ * @param shooter The shooter.
+ * @param row The row of the shot.
+ * @param col The column of the shot.
+ * @param result The shot result.
+ * @param sunkLength The length of the sunk ship if the result is SHOT_SUNK.
+ */
+void densityObserve(Shooter *shooter, int row, int col, int result, int sunkLength)
+{
+	if (result == SHOT_MISS)
+	{
+		trackerMiss(&shooter->tracker, row, col);
+	}
+	else if (result == SHOT_SUNK)
+	{
+		trackerSunk(&shooter->tracker, sunkLength);
+	}
+}
+
+/**
+ * The opening book of the book strategy.
+ */
+static OpeningBook gBook;
+
+/**
+ * Maps the opening book once.
+ */
+static pthread_once_t gBookOnce = PTHREAD_ONCE_INIT;
+
+/**
+ * @brief Maps the opening book named by BOOK_PATH_ENV, or DEFAULT_BOOK_PATH. The book is left
+ * empty if the file is missing or wrong.
+ */
+static void loadBook(void)
+{
+	const char *path = getenv(BOOK_PATH_ENV);
+	openBook(path != NULL ? path : DEFAULT_BOOK_PATH, &gBook);
+}
+
+/**
+ * @brief Takes the shot of the opening book while the shots so far are in it, and the shot of
+ * the density strategy otherwise.
+ * @param shooter The shooter.
+ * @param row Filled with the row of the shot.
+ * @param col Filled with the column of the shot.
+ */
+void bookShot(Shooter *shooter, int *row, int *col)
+{
+	int cell;
+	if (shooter->bookNode >= 0)
+	{
+		cell = shooter->book[shooter->bookNode];
+		if (cell != BOOK_NO_SHOT && cell / BITBOARD_ROW_BITS < shooter->size &&
+			cell % BITBOARD_ROW_BITS < shooter->size &&
+			!bbTest(&shooter->shots, cell / BITBOARD_ROW_BITS, cell % BITBOARD_ROW_BITS))
+		{
+			*row = cell / BITBOARD_ROW_BITS;
+			*col = cell % BITBOARD_ROW_BITS;
+			return;
+		}
+		shooter->bookNode = -1;
+	}
+	densityShot(shooter, row, col);
+}
+
+/**
+ * @brief Starts following the density of the whole fleet and the opening tree of the board size
+ * and fleet.
+ * @param shooter The shooter.
+ */
+void bookReset(Shooter *shooter)
+{
+	densityReset(shooter);
+	pthread_once(&gBookOnce, loadBook);
+	shooter->book = findOpening(&gBook, shooter->size,
+								bookFleetKey(shooter->remaining, shooter->maxLength),
+								&shooter->bookNodes);
+	shooter->bookNode = shooter->book != NULL && shooter->bookNodes > 0 ? 0 : -1;
+}
+
+/**
+ * @brief Updates the density after a shot and follows the opening tree: a miss or a hit goes to
+ * the matching child of the node, a sunk ship leaves the book.
+ * @param shooter The shooter.
+ * @param row The row of the shot.
+ * @param col The column of the shot.
+ * @param result The shot result.
+ * @param sunkLength The length of the sunk ship if the result is SHOT_SUNK.
+ */
+void bookObserve(Shooter *shooter, int row, int col, int result, int sunkLength)
+{
+	int next;
+	densityObserve(shooter, row, col, result, sunkLength);
+	if (shooter->bookNode >= 0)
+	{
+		next = 2 * shooter->bookNode + (result == SHOT_MISS ? 1 : 2);
+		shooter->bookNode = result == SHOT_SUNK || next >= shooter->bookNodes ? -1 : next;
+	}
+}
+
+/**
+ * The built in strategies.
+ */
+static const ShooterStrategy STRATEGIES[] =
+		{
+		{"random", randomShot, NULL, NULL},
+		{"hunt", huntShot, NULL, NULL},
+		{"density", densityShot, densityReset, densityObserve},
+		{"book", bookShot, bookReset, bookObserve}
+		};
+
+/**
+ * @brief Finds a built in strategy by its name.
+ * @param name The strategy name ("random", "hunt", "density" or "book").
+ * @return The strategy, NULL if there is no strategy with this name.
+ */
+const ShooterStrategy *findStrategy(const char *name)
+{
+	size_t i;
+	for (i = 0; i < sizeof(STRATEGIES) / sizeof(STRATEGIES[0]); i++)
+	{
+		if (strcmp(STRATEGIES[i].name, name) == 0)
+		{
+			return &STRATEGIES[i];
+		}
+	}
+	return NULL;
+}
+
+/**
+ * @brief Lists the built in strategies.
+ * @param index The index of the strategy.
+ * @return The strategy, NULL if the index is past the last strategy.
+ */
+const ShooterStrategy *strategyAt(int index)
+{
+	if (index < 0 || (size_t) index >= sizeof(STRATEGIES) / sizeof(STRATEGIES[0]))
+	{
+		return NULL;
+	}
+	return &STRATEGIES[index];
+}
+
+/**
+ * @brief Prepares a shooter for a new game.
+ * @param shooter The shooter.
+ * @param strategy The strategy picking the shots.
+ * @param size The board size.
+ * @param fleet The fleet the shooter fires at.
+ * @param rng The random numbers generator used by the shooter.
+ */
+void shooterReset(Shooter *shooter, const ShooterStrategy *strategy, int size, const Fleet *fleet,
+				  Rng *rng)
+{
+	shooter->strategy = strategy;
+	shooter->rng = rng;
+	shooter->size = size;
+	shooter->maxLength = fleet->maxLength;
+	shooter->randomShot = randomShotAnySize;
+	if (size >= BITBOARD_MIN_KERNEL_SIZE && size <= BITBOARD_MAX_SIZE)
+	{
+		shooter->randomShot = RANDOM_SHOTS[size - BITBOARD_MIN_KERNEL_SIZE];
+	}
+	bbClear(&shooter->shots);
+	bbClear(&shooter->hits);
+	bbClear(&shooter->sunk);
+	fleetCounts(fleet, shooter->remaining);
+	shooter->targetsNum = 0;
+	if (strategy->reset != NULL)
+	{
+		strategy->reset(shooter);
+	}
+}
+
+/**
+ * @brief Picks the next cell to shoot at. The cell was never shot by this shooter.
+ * @param shooter The shooter.
+ * @param row Filled with the row of the shot.
+ * @param col Filled with the column of the shot.
+ */
+void shooterNextShot(Shooter *shooter, int *row, int *col)
+{
+	shooter->strategy->nextShot(shooter, row, col);
+}
+
+/**
+ * @brief Counts the unsunk hits in a straight line from a cell (the cell excluded).
+ * @param shooter The shooter.
+ * @param row The row of the cell.
+ * @param col The column of the cell.
+ * @param dRow The row step.
+ * @param dCol The column step.
+ * @return The number of consecutive unsunk hits.
+ */
+int hitRun(const Shooter *shooter, int row, int col, int dRow, int dCol)
+{
+	int count = 0;
+	row += dRow;
+	col += dCol;
+	while (row >= 0 && col >= 0 && row < shooter->size && col < shooter->size &&
+		   bbTest(&shooter->hits, row, col) && !bbTest(&shooter->sunk, row, col))
+	{
+		count++;
+		row += dRow;
+		col += dCol;
+	}
+	return count;
+}
+
+/**
+ * @brief Marks the cells of a ship that was just sunk. The ship takes the last shot and lies on
+ * a straight run of unsunk hits, the run which fits the ship length best is picked. If no run
+ * is long enough only the last shot is marked.
+ * @param shooter The shooter.
+ * @param row The row of the last shot.
+ * @param col The column of the last shot.
+ * @param length The length of the sunk ship.
+ */
+void markSunk(Shooter *shooter, int row, int col, int length)
+{
+	int before[2], after[2], angle, start, k;
+	before[0] = hitRun(shooter, row, col, -1, 0);
+	after[0] = hitRun(shooter, row, col, 1, 0);
+	before[1] = hitRun(shooter, row, col, 0, -1);
+	after[1] = hitRun(shooter, row, col, 0, 1);
+	angle = 1;
+	if (before[0] + after[0] + 1 >= length &&
+		(before[1] + after[1] + 1 < length || before[0] + after[0] + 1 == length))
+	{
+		angle = 0;
+	}
+	if (before[angle] + after[angle] + 1 < length)
+	{
+		bbSet(&shooter->sunk, row, col);
+		return;
+	}
+	start = before[angle] < length - 1 ? before[angle] : length - 1;
+	for (k = 0; k < length; k++)
+	{
+		if (angle == 0)
+		{
+			bbSet(&shooter->sunk, row - start + k, col);
+		}
+		else
+		{
+			bbSet(&shooter->sunk, row, col - start + k);
+		}
+	}
+}
+
+/**
+ * @brief Lets the shooter learn the result of its last shot.
+ * @param shooter The shooter.
+ * @param row The row of the shot.
+ * @param col The column of the shot.
+ * @param result The shot result (SHOT_MISS, SHOT_HIT or SHOT_SUNK).
+ * @param sunkLength The length of the sunk ship if the result is SHOT_SUNK.
+ */
+void shooterObserve(Shooter *shooter, int row, int col, int result, int sunkLength)
+{
+	if (shooter->strategy->observe != NULL)
+	{
+		shooter->strategy->observe(shooter, row, col, result, sunkLength);
+	}
+	bbSet(&shooter->shots, row, col);
+	if (result == SHOT_HIT || result == SHOT_SUNK)
+	{
+		bbSet(&shooter->hits, row, col);
+	}
+	if (result == SHOT_SUNK)
+	{
+		shooter->remaining[sunkLength]--;
+		markSunk(shooter, row, col, sunkLength);
+	}
+	else if (result == SHOT_HIT && shooter->targetsNum + 4 <= MAX_TARGETS)
+	{
+		if (row > 0)
+		{
+			shooter->targets[shooter->targetsNum++] = CELL(row - 1, col);
+		}
+		if (col > 0)
+		{
+			shooter->targets[shooter->targetsNum++] = CELL(row, col - 1);
+		}
+		if (row < shooter->size - 1)
+		{
+			shooter->targets[shooter->targetsNum++] = CELL(row + 1, col);
+		}
+		if (col < shooter->size - 1)
+		{
+			shooter->targets[shooter->targetsNum++] = CELL(row, col + 1);
+		}
+	}
+}
@@ -0,0 +1,156 @@
+/**
+ * @file strategies.h
+ * @version 2.0
+ *
+ * @brief Built in shooters playing the game without a human player.
+ *
+ * @section DESCRIPTION
+ * A shooter keeps everything it learned about the board from its own shots (misses, hits and
+ * sunk ships) and picks the next cell to shoot at according to its strategy.
+ */
+#ifndef STRATEGIES_H_
+#define STRATEGIES_H_
+
+// ------------------------------ includes ------------------------------
+#include "battleships.h"
+#include "book.h"
+#include "density.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def MAX_SHIP_LENGTH 26
+ * @brief The length of the longest ship a fleet may hold.
+ */
+#define MAX_SHIP_LENGTH MAX_FLEET_LENGTH
+
+/**
+ * @def MAX_TARGETS 4 * 26 * 26
+ * @brief The maximal number of cells waiting in the target stack of a shooter.
+ */
+#define MAX_TARGETS (4 * BITBOARD_MAX_SIZE * BITBOARD_MAX_SIZE)
+
+// ------------------------------ structs ----------------------------
+
+typedef struct Shooter Shooter;
+
+/**
+ * a structure describing a shooting strategy. includes the following attributes:
+ * name - the name used to pick the strategy.
+ * nextShot - picks the next cell to shoot at from the shooter knowledge.
+ * reset - prepares the strategy own state for a new game, NULL if it has none.
+ * observe - updates the strategy own state after a shot, NULL if it has none.
+ */
+typedef struct ShooterStrategy
+{
+	const char *name;
+	void (*nextShot)(Shooter *shooter, int *row, int *col);
+	void (*reset)(Shooter *shooter);
+	void (*observe)(Shooter *shooter, int row, int col, int result, int sunkLength);
+} ShooterStrategy;
+
+/**
+ * a structure describing a shooter. includes the following attributes:
+ * strategy - the strategy picking the shots.
+ * rng - the random numbers generator of the shooter.
+ * size - the board size.
+ * maxLength - the length of the longest ship of the fleet.
+ * randomShot - picks a random unshot cell, compiled for the board size.
+ * shots - the cells already shot.
+ * hits - the shots that hit a ship.
+ * sunk - the hit cells known to belong to sunk ships.
+ * remaining - the number of ships still afloat for every ship length.
+ * targets - a stack of cells worth shooting at (the row times BITBOARD_ROW_BITS plus the column).
+ * targetsNum - the number of cells in the targets stack.
+ * tracker - the placement density of the ships afloat, followed by the density strategy.
+ * book - the opening tree of the board size and fleet followed by the book strategy, NULL if
+ * there is none (see book.h).
+ * bookNodes - the number of nodes of the opening tree.
+ * bookNode - the node of the shots so far, -1 once they left the book.
+ */
+struct Shooter
+{
+	const ShooterStrategy *strategy;
+	Rng *rng;
+	int size;
+	int maxLength;
+	void (*randomShot)(Shooter *shooter, int *row, int *col);
+	Bitboard shots;
+	Bitboard hits;
+	Bitboard sunk;
+	int remaining[MAX_SHIP_LENGTH + 1];
+	int targets[MAX_TARGETS];
+	int targetsNum;
+	DensityTracker tracker;
+	const uint16_t *book;
+	int bookNodes;
+	int bookNode;
+};
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @def BOOK_PATH_ENV "BATTLESHIPS_BOOK"
+ * @brief The environment variable holding the path of the opening book of the book strategy.
+ */
+#define BOOK_PATH_ENV "BATTLESHIPS_BOOK"
+
+/**
+ * @def DEFAULT_BOOK_PATH "openings.book"
+ * @brief The opening book of the book strategy when BOOK_PATH_ENV is not set.
+ */
+#define DEFAULT_BOOK_PATH "openings.book"
+
+/**
+ * @brief Finds a built in strategy by its name.
+ * @param name The strategy name ("random", "hunt", "density" or "book").
+ * @return The strategy, NULL if there is no strategy with this name.
+ */
+const ShooterStrategy *findStrategy(const char *name);
+
+/**
+ * @brief Lists the built in strategies.
+ * @param index The index of the strategy.
+ * @return The strategy, NULL if the index is past the last strategy.
+ */
+const ShooterStrategy *strategyAt(int index);
+
+/**
+ * @brief Prepares a shooter for a new game.
+ * @param shooter The shooter.
+ * @param strategy The strategy picking the shots.
+ * @param size The board size.
+ * @param fleet The fleet the shooter fires at.
+ * @param rng The random numbers generator used by the shooter.
+ */
+void shooterReset(Shooter *shooter, const ShooterStrategy *strategy, int size, const Fleet *fleet,
+				  Rng *rng);
+
+/**
+ * @brief Picks the next cell to shoot at. The cell was never shot by this shooter.
+ * @param shooter The shooter.
+ * @param row Filled with the row of the shot.
+ * @param col Filled with the column of the shot.
+ */
+void shooterNextShot(Shooter *shooter, int *row, int *col);
+
+/**
+ * @brief Lets the shooter learn the result of its last shot.
+ * @param shooter The shooter.
+ * @param row The row of the shot.
+ * @param col The column of the shot.
+ * @param result The shot result (SHOT_MISS, SHOT_HIT or SHOT_SUNK).
+ * @param sunkLength The length of the sunk ship if the result is SHOT_SUNK.
+ */
+void shooterObserve(Shooter *shooter, int row, int col, int result, int sunkLength);
+
+/**
+ * @brief Finds the shot of the density strategy, if it does not have to draw a random cell.
+ * @param shooter The shooter, reset with the density or the book strategy.
+ * @param row Filled with the row of the shot.
+ * @param col Filled with the column of the shot.
+ * @return The density of the shot cell, 0 if the strategy would draw a random cell.
+ */
+int bestDensityShot(const Shooter *shooter, int *row, int *col);
+
+#endif /* STRATEGIES_H_ */
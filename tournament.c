@@ -0,0 +1,448 @@
+/**
+ * @file tournament.c
+ * @version 2.0
+ *
+ * @brief Matches between two built in players, each with its own fleet, and round robin
+ * tournaments between many players.
+ *
+ * @section DESCRIPTION
+ * The matches of a tournament are numbered pair by pair, and the workers take chunks of
+ * TOURNAMENT_CHUNK_MATCHES consecutive matches from a shared counter. Every worker keeps two
+ * game blocks and two shooters for all its matches and counts its results on its own, the
+ * counts of the workers are added up at the end.
+ * The ratings are fitted with the minorization-maximization iterations of the Bradley-Terry
+ * model, adding half a win to both players of every pair that met so that a player that never
+ * won (or never lost) still gets a finite rating. The variance of the ratings is the diagonal of
+ * the pseudo inverse of the Fisher information matrix, which has the constant ratings as its
+ * null space.
+ */
+// ------------------------------ includes ------------------------------
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include "monotonic.h"
+#include "tournament.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def  TRUE 1
+ * @brief the value returned on success.
+ */
+#define TRUE 1
+
+/**
+ * @def FALSE -1
+ * @brief the value returned on failure.
+ */
+#define FALSE (-1)
+
+/**
+ * @def MEMORY_ERROR 2
+ * @brief the integer returned if one of the pointers is NULL .
+ */
+#define MEMORY_ERROR 2
+
+/**
+ * @def MAX_PAIRS 496
+ * @brief The maximal number of pairs of players of a tournament.
+ */
+#define MAX_PAIRS (MAX_PLAYERS * (MAX_PLAYERS - 1) / 2)
+
+/**
+ * @def PRIOR_WINS 0.5
+ * @brief The wins added to both players of every pair that met, before the ratings are fitted.
+ */
+#define PRIOR_WINS 0.5
+
+/**
+ * @def RATING_ITERATIONS 10000
+ * @brief The maximal number of iterations of the ratings fit.
+ */
+#define RATING_ITERATIONS 10000
+
+/**
+ * @def RATING_TOLERANCE 1e-12
+ * @brief The fit stops when no rating changes by more than this, on the natural log scale.
+ */
+#define RATING_TOLERANCE 1e-12
+
+/**
+ * @def ELO_SCALE 173.7178
+ * @brief The Elo points of a factor e in the odds of winning (400 / ln 10).
+ */
+#define ELO_SCALE (400.0 / M_LN10)
+
+/**
+ * @def CONFIDENCE_Z 1.96
+ * @brief The number of standard deviations of a 95% confidence interval.
+ */
+#define CONFIDENCE_Z 1.96
+
+// ------------------------------ structs ----------------------------
+
+/**
+ * a structure holding the schedule of a tournament, shared by the workers. includes the
+ * following attributes:
+ * config - the tournament description.
+ * pairsNum - the number of pairs of players.
+ * pairs - the two players of every pair.
+ * matches - the total number of matches.
+ * next - the next chunk of matches to take.
+ */
+typedef struct Schedule
+{
+	const TournamentConfig *config;
+	int pairsNum;
+	uint8_t pairs[MAX_PAIRS][2];
+	long matches;
+	atomic_long next;
+} Schedule;
+
+/**
+ * a structure describing a tournament worker thread. includes the following attributes:
+ * schedule - the tournament schedule.
+ * stats - the results of the matches the worker played.
+ * status - 0, or the error that stopped the worker.
+ * thread - the thread id.
+ * started - 1 if the thread was created.
+ */
+typedef struct TournamentWorker
+{
+	Schedule *schedule;
+	TournamentStats stats;
+	int status;
+	pthread_t thread;
+	int started;
+} TournamentWorker;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Places the fleets of both sides and resets their shooters for a new match.
+ * @param sides The two sides, with their player, game and shooter set.
+ * @return TRUE (1) if both fleets were placed, FALSE otherwise.
+ */
+int startMatch(Side sides[2])
+{
+	int i;
+	for (i = 0; i < 2; i++)
+	{
+		if (sides[i].player->layout->place(sides[i].game, &sides[i].rng) != TRUE)
+		{
+			return FALSE;
+		}
+		shooterReset(sides[i].shooter, sides[i].player->shooter, sides[1 - i].game->board.size,
+					 sides[1 - i].game->fleet, &sides[i].rng);
+	}
+	return TRUE;
+}
+
+/**
+ * @brief Plays a started match to its end, the first side firing first.
+ * @param sides The two sides.
+ * @param shots Filled with the number of shots both sides fired.
+ * @return The index of the side that won.
+ */
+int playMatch(Side sides[2], int *shots)
+{
+	int row, col, result, length, turn = 0, fired = 0;
+	Game *target;
+	while (1)
+	{
+		target = sides[1 - turn].game;
+		shooterNextShot(sides[turn].shooter, &row, &col);
+		result = fireShot(target, row, col);
+		length = SHOT_IS_SUNK(result) ? target->ships.length[SHOT_SUNK_SHIP(result)] : 0;
+		shooterObserve(sides[turn].shooter, row, col, SHOT_IS_SUNK(result) ? SHOT_SUNK : result,
+					   length);
+		fired++;
+		if (target->deadShips == target->shipsNum)
+		{
+			*shots = fired;
+			return turn;
+		}
+		turn = 1 - turn;
+	}
+}
+
+/**
+ * @brief Plays a chunk of matches.
+ * @param worker The worker.
+ * @param chunk The chunk index.
+ * @param sides The worker's two sides, with their game and shooter set.
+ * @return 0 on success, MEMORY_ERROR if a fleet could not be placed.
+ */
+static int playChunk(TournamentWorker *worker, long chunk, Side sides[2])
+{
+	const Schedule *schedule = worker->schedule;
+	const TournamentConfig *config = schedule->config;
+	long match, end = (chunk + 1) * TOURNAMENT_CHUNK_MATCHES;
+	int pair, first, winner, shots;
+	end = end < schedule->matches ? end : schedule->matches;
+	for (match = chunk * TOURNAMENT_CHUNK_MATCHES; match < end; match++)
+	{
+		pair = (int) (match / config->rounds);
+		first = (int) (match % config->rounds % 2);
+		sides[0].player = &config->players[schedule->pairs[pair][first]];
+		sides[1].player = &config->players[schedule->pairs[pair][1 - first]];
+		rngSeed(&sides[0].rng, config->seed, 2 * (uint64_t) match);
+		rngSeed(&sides[1].rng, config->seed, 2 * (uint64_t) match + 1);
+		if (startMatch(sides) != TRUE)
+		{
+			return MEMORY_ERROR;
+		}
+		winner = playMatch(sides, &shots);
+		worker->stats.wins[schedule->pairs[pair][winner == 0 ? first : 1 - first]]
+						  [schedule->pairs[pair][winner == 0 ? 1 - first : first]]++;
+		worker->stats.matches++;
+		worker->stats.shots += shots;
+	}
+	return 0;
+}
+
+/**
+ * @brief The worker thread: takes chunks of matches until none is left.
+ * @param arg The worker description.
+ * @return NULL.
+ */
+static void *tournamentWorkerMain(void *arg)
+{
+	TournamentWorker *worker = (TournamentWorker *) arg;
+	Schedule *schedule = worker->schedule;
+	const TournamentConfig *config = schedule->config;
+	long chunk, chunks = (schedule->matches + TOURNAMENT_CHUNK_MATCHES - 1) /
+						 TOURNAMENT_CHUNK_MATCHES;
+	Side sides[2];
+	int i;
+	memset(sides, 0, sizeof(sides));
+	for (i = 0; i < 2; i++)
+	{
+		sides[i].game = newGame(config->boardSize, config->fleet);
+		sides[i].shooter = (Shooter *) malloc(sizeof(Shooter));
+		worker->status = sides[i].game == NULL || sides[i].shooter == NULL ? MEMORY_ERROR :
+						 worker->status;
+	}
+	while (worker->status == 0 &&
+		   (chunk = atomic_fetch_add_explicit(&schedule->next, 1, memory_order_relaxed)) < chunks)
+	{
+		worker->status = playChunk(worker, chunk, sides);
+	}
+	for (i = 0; i < 2; i++)
+	{
+		freeGame(sides[i].game);
+		free(sides[i].shooter);
+	}
+	return NULL;
+}
+
+/**
+ * @brief Adds the results of one worker to the tournament results.
+ * @param total The results to add to.
+ * @param part The results to add.
+ */
+static void mergeResults(TournamentStats *total, const TournamentStats *part)
+{
+	int i, j;
+	total->matches += part->matches;
+	total->shots += part->shots;
+	for (i = 0; i < MAX_PLAYERS; i++)
+	{
+		for (j = 0; j < MAX_PLAYERS; j++)
+		{
+			total->wins[i][j] += part->wins[i][j];
+		}
+	}
+}
+
+/**
+ * @brief Plays a tournament on all the worker threads and gathers the results.
+ * @param config The tournament description.
+ * @param stats Filled with the results.
+ * @return 0 on success, MEMORY_ERROR (2) if an allocation failed or a fleet could not be placed.
+ */
+int runTournament(const TournamentConfig *config, TournamentStats *stats)
+{
+	int i, j, status = 0, count = config->threads;
+	double start = monotonicSeconds();
+	Schedule *schedule = (Schedule *) malloc(sizeof(Schedule));
+	TournamentWorker *workers;
+	memset(stats, 0, sizeof(TournamentStats));
+	count = count < 1 ? 1 : (count > MAX_TOURNAMENT_THREADS ? MAX_TOURNAMENT_THREADS : count);
+	workers = (TournamentWorker *) calloc(count, sizeof(TournamentWorker));
+	if (schedule == NULL || workers == NULL)
+	{
+		free(schedule);
+		free(workers);
+		return MEMORY_ERROR;
+	}
+	schedule->config = config;
+	schedule->pairsNum = 0;
+	for (i = 0; i < config->playersNum; i++)
+	{
+		for (j = i + 1; j < config->playersNum; j++)
+		{
+			schedule->pairs[schedule->pairsNum][0] = (uint8_t) i;
+			schedule->pairs[schedule->pairsNum][1] = (uint8_t) j;
+			schedule->pairsNum++;
+		}
+	}
+	schedule->matches = schedule->pairsNum * config->rounds;
+	atomic_init(&schedule->next, 0);
+	for (i = 0; i < count; i++)
+	{
+		workers[i].schedule = schedule;
+	}
+	for (i = 1; i < count; i++)
+	{
+		workers[i].started = pthread_create(&workers[i].thread, NULL, tournamentWorkerMain,
+											&workers[i]) == 0;
+	}
+	tournamentWorkerMain(&workers[0]);
+	for (i = 0; i < count; i++)
+	{
+		if (workers[i].started)
+		{
+			pthread_join(workers[i].thread, NULL);
+		}
+		status = workers[i].status != 0 ? workers[i].status : status;
+		mergeResults(stats, &workers[i].stats);
+	}
+	stats->seconds = monotonicSeconds() - start;
+	free(schedule);
+	free(workers);
+	return status;
+}
+
+/**
+ * @brief Inverts a square matrix by Gauss-Jordan elimination with partial pivoting.
+ * @param matrix The matrix, destroyed.
+ * @param inverse Filled with the inverse.
+ * @param size The number of rows of the matrix.
+ * @return TRUE on success, FALSE if the matrix is singular.
+ */
+static int invertMatrix(double matrix[][MAX_PLAYERS], double inverse[][MAX_PLAYERS], int size)
+{
+	int i, j, k, pivot;
+	double factor, swap;
+	for (i = 0; i < size; i++)
+	{
+		for (j = 0; j < size; j++)
+		{
+			inverse[i][j] = i == j ? 1.0 : 0.0;
+		}
+	}
+	for (i = 0; i < size; i++)
+	{
+		pivot = i;
+		for (k = i + 1; k < size; k++)
+		{
+			pivot = fabs(matrix[k][i]) > fabs(matrix[pivot][i]) ? k : pivot;
+		}
+		if (matrix[pivot][i] == 0.0)
+		{
+			return FALSE;
+		}
+		for (j = 0; j < size; j++)
+		{
+			swap = matrix[i][j];
+			matrix[i][j] = matrix[pivot][j];
+			matrix[pivot][j] = swap;
+			swap = inverse[i][j];
+			inverse[i][j] = inverse[pivot][j];
+			inverse[pivot][j] = swap;
+		}
+		factor = matrix[i][i];
+		for (j = 0; j < size; j++)
+		{
+			matrix[i][j] /= factor;
+			inverse[i][j] /= factor;
+		}
+		for (k = 0; k < size; k++)
+		{
+			factor = matrix[k][i];
+			for (j = 0; k != i && j < size; j++)
+			{
+				matrix[k][j] -= factor * matrix[i][j];
+				inverse[k][j] -= factor * inverse[i][j];
+			}
+		}
+	}
+	return TRUE;
+}
+
+/**
+ * @brief Rates the players of a tournament from their results.
+ * @param config The tournament description.
+ * @param stats The results.
+ * @param ratings Filled with the rating of every player.
+ */
+void ratePlayers(const TournamentConfig *config, const TournamentStats *stats, Rating *ratings)
+{
+	static double wins[MAX_PLAYERS][MAX_PLAYERS], games[MAX_PLAYERS][MAX_PLAYERS];
+	static double fisher[MAX_PLAYERS][MAX_PLAYERS], covariance[MAX_PLAYERS][MAX_PLAYERS];
+	double strength[MAX_PLAYERS], next[MAX_PLAYERS], won, expected, logMean, change, p;
+	int i, j, iteration, count = config->playersNum;
+	for (i = 0; i < count; i++)
+	{
+		strength[i] = 1.0;
+		ratings[i].matches = 0;
+		ratings[i].wins = 0;
+		for (j = 0; j < count; j++)
+		{
+			games[i][j] = (double) (stats->wins[i][j] + stats->wins[j][i]);
+			wins[i][j] = (double) stats->wins[i][j] + (games[i][j] > 0 ? PRIOR_WINS : 0.0);
+			games[i][j] += games[i][j] > 0 ? 2 * PRIOR_WINS : 0.0;
+			ratings[i].matches += stats->wins[i][j] + stats->wins[j][i];
+			ratings[i].wins += stats->wins[i][j];
+		}
+	}
+	for (iteration = 0; iteration < RATING_ITERATIONS; iteration++)
+	{
+		logMean = 0.0;
+		for (i = 0; i < count; i++)
+		{
+			won = expected = 0.0;
+			for (j = 0; j < count; j++)
+			{
+				won += wins[i][j];
+				expected += games[i][j] / (strength[i] + strength[j]);
+			}
+			next[i] = expected > 0.0 ? won / expected : 1.0;
+			logMean += log(next[i]) / count;
+		}
+		change = 0.0;
+		for (i = 0; i < count; i++)
+		{
+			next[i] = exp(log(next[i]) - logMean);
+			change = fmax(change, fabs(log(next[i]) - log(strength[i])));
+			strength[i] = next[i];
+		}
+		if (change < RATING_TOLERANCE)
+		{
+			break;
+		}
+	}
+	for (i = 0; i < count; i++)
+	{
+		fisher[i][i] = 1.0 / count;
+		for (j = 0; j < count; j++)
+		{
+			p = strength[i] / (strength[i] + strength[j]);
+			fisher[i][j] = i == j ? fisher[i][j] : 1.0 / count - games[i][j] * p * (1.0 - p);
+			fisher[i][i] += i == j ? 0.0 : games[i][j] * p * (1.0 - p);
+		}
+	}
+	if (invertMatrix(fisher, covariance, count) != TRUE)
+	{
+		memset(covariance, 0, sizeof(covariance));
+	}
+	for (i = 0; i < count; i++)
+	{
+		ratings[i].elo = ELO_BASE + ELO_SCALE * log(strength[i]);
+		ratings[i].margin = CONFIDENCE_Z * ELO_SCALE *
+							sqrt(fmax(covariance[i][i] - 1.0 / count, 0.0));
+	}
+}
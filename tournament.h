@@ -0,0 +1,163 @@
+/**
+ * @file tournament.h
+ * @version 2.0
+ *
+ * @brief Matches between two built in players, each with its own fleet, and round robin
+ * tournaments between many players.
+ *
+ * @section DESCRIPTION
+ * A player is a layout strategy (see layouts.h) placing its own fleet and a shooting strategy
+ * (see strategies.h) firing at the fleet of the other player. The two players of a match shoot
+ * in turns, and the first to sink the whole enemy fleet wins.
+ * A tournament plays the same number of matches between every two players, each player firing
+ * first in half of them. Match i always draws its numbers from streams 2i and 2i + 1 of the
+ * master seed, whichever thread plays it, so the results depend only on the master seed.
+ * The ratings are the Bradley-Terry maximum likelihood fit of the win counts on the Elo scale,
+ * with 95% confidence intervals from the Fisher information of the fit.
+ */
+#ifndef TOURNAMENT_H_
+#define TOURNAMENT_H_
+
+// ------------------------------ includes ------------------------------
+#include "layouts.h"
+#include "strategies.h"
+
+// -------------------------- const definitions -------------------------
+
+/**
+ * @def MAX_PLAYERS 32
+ * @brief The maximal number of players of a tournament.
+ */
+#define MAX_PLAYERS 32
+
+/**
+ * @def MAX_TOURNAMENT_THREADS 256
+ * @brief The maximal number of worker threads of a tournament.
+ */
+#define MAX_TOURNAMENT_THREADS 256
+
+/**
+ * @def TOURNAMENT_CHUNK_MATCHES 64
+ * @brief The number of matches a worker takes at once.
+ */
+#define TOURNAMENT_CHUNK_MATCHES 64
+
+/**
+ * @def ELO_BASE 1500
+ * @brief The mean rating of the players of a tournament.
+ */
+#define ELO_BASE 1500.0
+
+// ------------------------------ structs ----------------------------
+
+/**
+ * a structure describing a built in player. includes the following attributes:
+ * layout - the strategy placing the player's fleet.
+ * shooter - the strategy firing at the other player's fleet.
+ */
+typedef struct Player
+{
+	const LayoutStrategy *layout;
+	const ShooterStrategy *shooter;
+} Player;
+
+/**
+ * a structure describing a side of a match. includes the following attributes:
+ * player - the player.
+ * game - the player's own fleet and the shots of the other player at it.
+ * shooter - the shooter of the player, firing at the other side's game.
+ * rng - the random numbers generator of the player's layout and shooter.
+ */
+typedef struct Side
+{
+	const Player *player;
+	Game *game;
+	Shooter *shooter;
+	Rng rng;
+} Side;
+
+/**
+ * a structure describing a tournament. includes the following attributes:
+ * boardSize - the board size of every match.
+ * fleet - the fleet of every player.
+ * playersNum - the number of players.
+ * players - the players.
+ * rounds - the number of matches between every two players.
+ * seed - the master seed of the random numbers.
+ * threads - the number of worker threads.
+ */
+typedef struct TournamentConfig
+{
+	int boardSize;
+	const Fleet *fleet;
+	int playersNum;
+	Player players[MAX_PLAYERS];
+	long rounds;
+	uint64_t seed;
+	int threads;
+} TournamentConfig;
+
+/**
+ * a structure holding the results of a tournament. includes the following attributes:
+ * matches - the number of matches played.
+ * shots - the total number of shots fired by both sides.
+ * wins - the number of matches every player won against every other player.
+ * seconds - the wall clock time the tournament took.
+ */
+typedef struct TournamentStats
+{
+	long matches;
+	long shots;
+	long wins[MAX_PLAYERS][MAX_PLAYERS];
+	double seconds;
+} TournamentStats;
+
+/**
+ * a structure holding the rating of a player. includes the following attributes:
+ * elo - the rating.
+ * margin - the half width of the 95% confidence interval of the rating.
+ * matches - the number of matches the player played.
+ * wins - the number of matches the player won.
+ */
+typedef struct Rating
+{
+	double elo;
+	double margin;
+	long matches;
+	long wins;
+} Rating;
+
+// ------------------------------ functions ----------------------------
+
+/**
+ * @brief Places the fleets of both sides and resets their shooters for a new match.
+ * @param sides The two sides, with their player, game and shooter set.
+ * @return TRUE (1) if both fleets were placed, FALSE otherwise.
+ */
+int startMatch(Side sides[2]);
+
+/**
+ * @brief Plays a started match to its end, the first side firing first.
+ * @param sides The two sides.
+ * @param shots Filled with the number of shots both sides fired.
+ * @return The index of the side that won.
+ */
+int playMatch(Side sides[2], int *shots);
+
+/**
+ * @brief Plays a tournament on all the worker threads and gathers the results.
+ * @param config The tournament description.
+ * @param stats Filled with the results.
+ * @return 0 on success, MEMORY_ERROR (2) if an allocation failed or a fleet could not be placed.
+ */
+int runTournament(const TournamentConfig *config, TournamentStats *stats);
+
+/**
+ * @brief Rates the players of a tournament from their results.
+ * @param config The tournament description.
+ * @param stats The results.
+ * @param ratings Filled with the rating of every player.
+ */
+void ratePlayers(const TournamentConfig *config, const TournamentStats *stats, Rating *ratings);
+
+#endif /* TOURNAMENT_H_ */